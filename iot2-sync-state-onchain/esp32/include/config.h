@@ -5,12 +5,64 @@
 #define WIFI_PASSWORD "00000001"
 
 #define BLOCKFROST_HOST "cardano-preprod.blockfrost.io"
+#define BLOCKFROST_PORT 443
+#define BLOCKFROST_TLS 1               // 0 for a plain-HTTP local stand-in or chain proxy
+#define BLOCKFROST_DNS_TTL_S 300       // lwIP does not expose record TTLs
 #define BLOCKFROST_API_KEY "preprodjRI6DjnaIV5v6XwnUF32Y9RE8LuAnc6n"
 
+// Blockfrost-compatible APIs, primary first: { name, host, port (0 off),
+// tls, auth headers }. A batch the primary is slow to answer is hedged on
+// the second entry, e.g. a self-hosted Blockfrost backend or local indexer:
+//   { "indexer", "192.168.1.20", 3000, 0, "" },
+#define CHAIN_PROVIDERS { \
+    { "blockfrost", BLOCKFROST_HOST, BLOCKFROST_PORT, BLOCKFROST_TLS, "project_id: " BLOCKFROST_API_KEY "\r\n" }, \
+}
+// Hedge delay: p95 of recent first-byte waits, clamped to [MIN, MAX]
+#define HEDGE_MIN_MS 150
+#define HEDGE_MAX_MS 3000
+#define HEDGE_BUDGET_PCT 10            // at most this share of batches hedged
+#define HEDGE_BUDGET_BURST 5           // ... with this many saved up
+#define HEDGE_CROSSCHECK_POLLS 60      // compare providers' tx_hash this often (0 off)
+
 // Asset unit = policy_id + hex(asset_name)
 // "locker_537" in hex = 6c6f636b65725f353337
 #define ASSET_UNIT "b6d522ad80c9442b45b3ddfb4b59766c8465212749f76c11e8a619a76c6f636b65725f353337"
 
 #define POLL_INTERVAL_MS 1000
+#define HISTORY_REPLAY_COUNT 5         // states printed at boot
+
+// preprod: slot = POSIX time - CHAIN_SLOT_ZERO_TIME
+#define CHAIN_SLOT_ZERO_TIME 1655769600
+
+// Wall clock for block_time comparisons
+#define NTP_SERVER_1 "pool.ntp.org"
+#define NTP_SERVER_2 "time.google.com"
+
+// New tx block_time -> detection; breaches are counted in metrics
+#define CHAIN_LATENCY_SLO_MS 15000
+
+// Request gzip/deflate response bodies (toggle at runtime: "gzip on|off")
+#define BLOCKFROST_COMPRESSION 1
+
+// Log records are queued by the loop and written to Serial by a background
+// task: as text lines or, with TELEMETRY_BINARY 1, as COBS frames (decode
+// with tools/tlm_cli). Toggle at runtime: "log binary|text".
+#define TELEMETRY_BINARY 0
+#define TELEMETRY_TASK 1
+#define TELEMETRY_LEVEL 1              // 0 debug, 1 info, 2 warn, 3 error: lower levels compile out
+#define TELEMETRY_RING_BYTES 2048      // power of two; full ring drops records
+
+// Low-power mode for battery/solar monitors: light-sleep until the next
+// deadline instead of busy-looping (toggle at runtime: "sleep on|off")
+#define LOW_POWER_MODE 0
+#define LOW_POWER_MIN_SLEEP_MS 20      // shorter waits stay awake
+#define LOW_POWER_MAX_SLEEP_MS 30000   // wake at least this often
+
+// Current draw per state for the energy estimate (ESP32-C3 ballpark,
+// calibrate against a meter for real figures)
+#define POWER_ACTIVE_UA 85000          // polling: CPU + radio TX/RX
+#define POWER_IDLE_UA 25000            // awake, WiFi in modem sleep
+#define POWER_SLEEP_UA 2000            // automatic light sleep, modem up for DTIM beacons
+#define POWER_SUPPLY_MV 3300
 
 #endif
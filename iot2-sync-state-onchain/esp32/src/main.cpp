@@ -3,26 +3,74 @@
 #include "config.h"
 #include "blockfrost.h"
 #include "datum_parser.h"
+#include "logger.h"
+#include "monitor.h"
+#include "power.h"
+#include "scheduler.h"
+#include "timesync.h"
 
-unsigned long lastPollTime = 0;
+// Everything the loop waits for; the idle time in between can be slept
+DeadlineScheduler scheduler(powerClock, nullptr);
 
-// Check asset state following monitor.ts approach
-void checkAssetState() {
-    AssetStateResult state = fetchAssetState(ASSET_UNIT);
+// Poll the asset and log its state; chain event latency is timed from a new
+// tx's block_time to its detection here
+BlockfrostTransport transport = { ASSET_UNIT };
+LockerDecoder decoder = { 0 };      // 0=testnet
+LogActuator actuator = { 0 };
+Monitor<BlockfrostTransport, LockerDecoder, LogActuator, DeadlineScheduler>
+    monitor(transport, decoder, actuator, scheduler, CHAIN_LATENCY_SLO_MS);
 
-    if (!state.success) {
-        Serial.printf("Asset state error: %s\n", state.error.c_str());
+// Print the newest states of the asset, oldest first. The UTxO lookups
+// are pipelined, so this costs two round trips however long the history.
+void replayHistory() {
+    AssetStateResult history[HISTORY_REPLAY_COUNT];
+    size_t n = fetchAssetHistory(ASSET_UNIT, history, HISTORY_REPLAY_COUNT);
+    if (n == 0) {
+        LOG_WARN("History error: %s", history[0].error.c_str());
         return;
     }
 
-    DatumResult datum = parseDatum(state.inlineDatum, 0); // 0=testnet
+    LOG_INFO("Last %u states (%u round trips):", (unsigned)n, history[0].stats.roundTrips);
+    for (size_t i = n; i-- > 0;) {
+        if (!history[i].success) {
+            LOG_INFO("  %s: %s", history[i].txHash.c_str(), history[i].error.c_str());
+            continue;
+        }
+        DatumResult datum = parseDatum(history[i].inlineDatum, 0); // 0=testnet
+        LOG_INFO("  %s: %s", history[i].txHash.c_str(),
+            !datum.success ? datum.error.c_str() : datum.isLocked ? "LOCKED" : "UNLOCKED");
+    }
+}
+
+// Metrics in Prometheus text format
+void printMetrics() {
+    monitor.detectLatency().writeMetrics(Serial, "chain_to_detection_ms");
+    Serial.printf("clock_synced %d\n", timeSynced() ? 1 : 0);
+    writeBlockfrostMetrics(Serial);
+    writeLoggerMetrics(Serial);
+}
 
-    if (datum.success) {
-        Serial.printf("Authority: %s | Locked: %s\n",
-            datum.authorityAddress.c_str(),
-            datum.isLocked ? "true" : "false");
-    } else {
-        Serial.printf("Datum error: %s\n", datum.error.c_str());
+// Serial console:
+//   "gzip on" / "gzip off"    switch response compression
+//   "sleep on" / "sleep off"  switch low-power mode
+//   "metrics"                 print latency, API and log metrics
+//   "log binary|text"         log as telemetry frames or as text lines
+void handleSerialCommand() {
+    if (!Serial.available()) return;
+
+    String cmd = Serial.readStringUntil('\n');
+    cmd.trim();
+    if (cmd == "gzip on" || cmd == "gzip off") {
+        setBlockfrostCompression(cmd == "gzip on");
+        Serial.printf("Compression: %s\n", blockfrostCompression() ? "on" : "off");
+    } else if (cmd == "sleep on" || cmd == "sleep off") {
+        setLowPower(cmd == "sleep on");
+        Serial.printf("Low-power mode: %s\n", lowPower() ? "on" : "off");
+    } else if (cmd == "metrics") {
+        printMetrics();
+    } else if (cmd == "log binary" || cmd == "log text") {
+        setLogBinary(cmd == "log binary");
+        Serial.printf("Log output: %s\n", logBinary() ? "binary" : "text");
     }
 }
 
@@ -40,24 +88,29 @@ void setup() {
         Serial.print(".");
     }
     Serial.println("\nWiFi OK!");
+    initLogger();
+
+    monitor.begin(POLL_INTERVAL_MS);
 
+    initTimeSync();
     initBlockfrost();
-    checkAssetState();
-    lastPollTime = millis();
+    initPower();
+    replayHistory();
+    monitor.start();
 }
 
 void loop() {
+    handleSerialCommand();
+
     if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("WiFi lost, reconnecting...");
+        LOG_WARN("WiFi lost, reconnecting...");
         WiFi.reconnect();
         delay(5000);
         return;
     }
 
-    if (millis() - lastPollTime >= POLL_INTERVAL_MS) {
-        checkAssetState();
-        lastPollTime = millis();
-    }
+    monitor.service();
 
-    delay(10);
+    serviceLogger();
+    powerIdle(scheduler.msUntilNext());
 }
@@ -0,0 +1,113 @@
+import {
+    DEFAULT_V3_COST_MODEL_LIST,
+    mConStr0,
+    MeshTxBuilder,
+    pubKeyAddress,
+    serializeAddressObj,
+    serializePlutusScript,
+} from '@meshsdk/core';
+
+// --------------------------------------
+//  Re-lock test vector
+// --------------------------------------
+//  Builds the pump's re-lock transaction with MeshTxBuilder, the way
+//  offchain.ts lock() spends an unlocked locker UTxO, from the fixture the
+//  firmware's host check prints. The firmware builds the same tx in C++
+//  (iot3-vending-machines/src/relock_tx.cpp); its check compares the two
+//  bodies byte for byte:
+//
+//    ./relock fixture > fixture.txt                (iot3-vending-machines/)
+//    bun script/relock-vector.ts < fixture.txt > vector.txt
+//    ./relock check vector.txt
+//
+//  Offline: inputs, fee and execution units come from the fixture, so
+//  nothing is fetched or evaluated. Prints the cost model the script data
+//  hash was taken over and the body hex.
+
+const fields: Record<string, string> = {};
+for (const line of (await Bun.stdin.text()).split('\n')) {
+    const space = line.indexOf(' ');
+    if (space > 0) fields[line.slice(0, space)] = line.slice(space + 1).trim();
+}
+
+const outRef = (ref: string) => {
+    const [txHash, index] = ref.split('#');
+    return { txHash: txHash as string, index: Number(index) };
+};
+
+const network = Number(fields.network) as 0 | 1;
+const locker = outRef(fields.locker as string);
+const funding = outRef(fields.funding as string);
+const unit = (fields.policy as string) + (fields.asset_name as string);
+const script = fields.script as string;
+
+const lockerAddress = serializePlutusScript({ code: script, version: 'V3' }, undefined, network).address;
+const authorityAddress = serializeAddressObj(
+    pubKeyAddress(fields.authority_payment as string, fields.authority_stake as string),
+    network,
+);
+const datum = (isLocked: number) =>
+    mConStr0([mConStr0([fields.authority_payment as string, fields.authority_stake as string]), isLocked]);
+const lockerAmount = [
+    { unit: 'lovelace', quantity: fields.locker_lovelace as string },
+    { unit, quantity: '1' },
+];
+const fundingAmount = [{ unit: 'lovelace', quantity: fields.funding_lovelace as string }];
+
+const builder = new MeshTxBuilder({
+    params: {
+        minFeeA: Number(fields.min_fee_a),
+        minFeeB: Number(fields.min_fee_b),
+        collateralPercent: Number(fields.collateral_percent),
+        coinsPerUtxoSize: Number(fields.coins_per_utxo_byte),
+    },
+});
+
+builder
+    .spendingPlutusScriptV3()
+    .txIn(locker.txHash, locker.index, lockerAmount, lockerAddress)
+    .txInInlineDatumPresent()
+    .txInRedeemerValue(mConStr0([]), 'Mesh', {
+        mem: Number(fields.ex_mem),
+        steps: Number(fields.ex_steps),
+    })
+    .txInScript(script)
+    .txOut(lockerAddress, lockerAmount)
+    .txOutInlineDatumValue(datum(1))
+    .txIn(funding.txHash, funding.index, fundingAmount, authorityAddress)
+    .txInCollateral(funding.txHash, funding.index, fundingAmount, authorityAddress)
+    .setTotalCollateral(fields.total_collateral as string)
+    .setCollateralReturnAddress(authorityAddress)
+    .requiredSignerHash(fields.authority_payment as string)
+    .changeAddress(authorityAddress)
+    .setFee(fields.fee as string);
+
+const tx = await builder.complete();
+
+// The body is the first item of the tx array
+const skip = (hex: string, pos: number): number => {
+    const initial = parseInt(hex.slice(pos, pos + 2), 16);
+    const major = initial >> 5;
+    const info = initial & 0x1f;
+    pos += 2;
+    if (info === 31) {
+        while (hex.slice(pos, pos + 2) !== 'ff') pos = skip(hex, pos);
+        return pos + 2;
+    }
+    let arg = info;
+    if (info >= 24) {
+        const n = 1 << (info - 24);
+        arg = parseInt(hex.slice(pos, pos + 2 * n), 16);
+        pos += 2 * n;
+    }
+    if (major === 2 || major === 3) return pos + 2 * arg;
+    if (major === 4 || major === 5) {
+        for (let i = 0; i < (major === 5 ? 2 * arg : arg); i++) pos = skip(hex, pos);
+        return pos;
+    }
+    if (major === 6) return skip(hex, pos);
+    return pos;
+};
+
+console.log(`cost_model ${DEFAULT_V3_COST_MODEL_LIST.join(',')}`);
+console.log(`body ${tx.slice(2, skip(tx, 2))}`);
@@ -0,0 +1,405 @@
+import { createServer, type IncomingMessage, type ServerResponse } from "node:http";
+import { createHash } from "node:crypto";
+import { deflateSync, gzipSync } from "node:zlib";
+
+// --------------------------------------
+//  Local Blockfrost stand-in
+// --------------------------------------
+//  Serves the two endpoints the ESP32 firmware polls, from an in-memory
+//  chain of locker transactions, so firmware changes can be measured
+//  without touching the public API.
+//
+//    GET  /api/v0/assets/{unit}/transactions?order=desc&count=N
+//    GET  /api/v0/txs/{hash}/utxos
+//    GET  /api/v0/blocks/latest
+//    GET  /api/v0/blocks/{height|hash}
+//    GET  /api/v0/mempool/addresses/{address}
+//    GET  /api/v0/mempool/{hash}
+//    POST /control/tx?locked=0|1      append a new lock/unlock tx (own block)
+//    POST /control/submit?locked=0|1  put a lock/unlock tx in the mempool,
+//                                     spending the newest locker tx
+//    POST /control/block?evict=0|1    mint a block with the mempool now, or
+//                                     drop the mempool instead
+//    POST /control/rollback?depth=N&reinclude=0|1
+//                                     replace the newest N blocks with N new
+//                                     ones; their txs are dropped, or put
+//                                     back in the first new block
+//    GET  /control/stats              API requests served, by status, and
+//                                     how many were stalled or mirrored
+//
+//  An empty block is added every BLOCK_MS (default 20000, 0 = only on
+//  /control/tx), so confirmation depth grows as on the real chain. Each
+//  new block takes the pending txs, except that EVICT_PCT percent of them
+//  are dropped (with any pending tx spending them) as a node would evict
+//  an invalid or expired tx.
+//  Honours Accept-Encoding (gzip, deflate) unless GZIP=off, and logs raw
+//  vs on-the-wire body size per response (QUIET=1 turns the log off).
+//  RATE_LIMIT=<req/s> answers 429 like Blockfrost once a project_id has
+//  used up its RATE_BURST requests, refilling at RATE_LIMIT per second.
+//  STALL_PCT percent of API requests on PORT are held for STALL_MS
+//  (default 3000) before being answered, like a provider's slow tail;
+//  MIRROR_PORT serves the same chain without stalls, as a second provider
+//  for the firmware's hedged requests (CHAIN_PROVIDERS).
+//  HISTORY=N starts the chain with N locker txs instead of one, and
+//  WALLET_INPUTS=N gives every tx N wallet inputs instead of one, for
+//  bodies larger than the firmware's inflate window (HISTORY=100 makes a
+//  14 KB transactions page, WALLET_INPUTS=100 a 38 KB UTxO set).
+//
+//  Run:  PORT=3000 GZIP=on bun run script/standin.ts
+//  Then build the firmware with BLOCKFROST_HOST set to this machine's IP,
+//  BLOCKFROST_PORT 3000 and BLOCKFROST_TLS 0.
+
+const PORT = Number(process.env.PORT || 3000);
+const GZIP = (process.env.GZIP || "on") !== "off";
+const LATENCY_MS = Number(process.env.LATENCY_MS || 0);
+const QUIET = process.env.QUIET === "1";
+const RATE_LIMIT = Number(process.env.RATE_LIMIT || 0);
+const RATE_BURST = Number(process.env.RATE_BURST || 500);
+const BLOCK_MS = Number(process.env.BLOCK_MS ?? 20000);
+const EVICT_PCT = Number(process.env.EVICT_PCT || 0);
+const STALL_PCT = Number(process.env.STALL_PCT || 0);
+const STALL_MS = Number(process.env.STALL_MS || 3000);
+const MIRROR_PORT = Number(process.env.MIRROR_PORT || 0);
+const HISTORY = Math.max(1, Number(process.env.HISTORY || 1));
+const WALLET_INPUTS = Math.max(1, Number(process.env.WALLET_INPUTS || 1));
+
+// Authority of the simulated locker (payment + stake key hashes)
+const AUTHORITY_PKH = "6c4f5e8f0b7d2a1c9e3b4a5d6f708192a3b4c5d6e7f8091a2b3c4d5e";
+const AUTHORITY_SKH = "0f1e2d3c4b5a69788796a5b4c3d2e1f00112233445566778899aabbc";
+const SCRIPT_ADDRESS = "addr_test1wrd5mq8wy6zq6g3h7ux8z2yq3hcq0fxvqlwyqg6jxq6d3dsqh3t5m";
+const WALLET_ADDRESS =
+    "addr_test1qpkylt50pd7j58y7wd99he0aqkzd55h2lx7nlvptf6vz8c3jhn5kz3tp6ysr6xw8c5eutdfwl8vmhyyhf3vhkxkqklxqn5rp9w";
+
+type ChainTx = {
+    hash: string;
+    blockHeight: number;
+    blockTime: number;
+    slot: number;
+    locked: boolean;
+    spends?: string;                    // mempool: locker tx it spends
+};
+
+type Block = {
+    hash: string;
+    height: number;
+    time: number;
+    slot: number;
+    txs: ChainTx[];
+};
+
+// Locker txs in chain order, and the blocks holding them
+const chain: ChainTx[] = [];
+const blocks: Block[] = [];
+let forks = 0;
+
+// Pending locker txs, each spending the newest locker tx at submit time
+const mempool: ChainTx[] = [];
+const mempoolStats = { submitted: 0, included: 0, evicted: 0 };
+
+type Bucket = { tokens: number; updated: number };
+const buckets = new Map<string, Bucket>();
+const stats = { requests: 0, byStatus: {} as Record<number, number>, stalled: 0, mirrored: 0 };
+
+// Token bucket per project_id, as Blockfrost limits per project
+const takeToken = (projectId: string) => {
+    if (RATE_LIMIT <= 0) return true;
+    const now = Date.now();
+    const bucket = buckets.get(projectId) ?? { tokens: RATE_BURST, updated: now };
+    bucket.tokens = Math.min(RATE_BURST, bucket.tokens + ((now - bucket.updated) / 1000) * RATE_LIMIT);
+    bucket.updated = now;
+    buckets.set(projectId, bucket);
+    if (bucket.tokens < 1) return false;
+    bucket.tokens -= 1;
+    return true;
+};
+
+export const lockerDatum = (locked: boolean) =>
+    "d8799fd8799f581c" + AUTHORITY_PKH + "581c" + AUTHORITY_SKH + "ff" + (locked ? "01" : "00") + "ff";
+
+// Next block on the tip, holding `txs`
+export const mintBlock = (txs: ChainTx[] = []): Block => {
+    const prev = blocks[blocks.length - 1];
+    const now = Math.floor(Date.now() / 1000);
+    const height = prev ? prev.height + 1 : 3_400_000;
+    const block: Block = {
+        hash: createHash("sha256").update(`${height}:${prev?.hash ?? ""}:${forks}`).digest("hex"),
+        height,
+        time: now,
+        slot: now - 1_655_769_600,      // preprod slot from POSIX time
+        txs,
+    };
+    for (const tx of txs) {
+        tx.blockHeight = block.height;
+        tx.blockTime = block.time;
+        tx.slot = block.slot;
+        chain.push(tx);
+    }
+    blocks.push(block);
+    return block;
+};
+
+export const appendTx = (locked: boolean): ChainTx => {
+    const now = Math.floor(Date.now() / 1000);
+    const tx: ChainTx = {
+        hash: createHash("sha256").update(`locker_537:${chain.length}:${now}:${forks}`).digest("hex"),
+        blockHeight: 0,
+        blockTime: 0,
+        slot: 0,
+        locked,
+    };
+    mintBlock([tx]);
+    return tx;
+};
+
+export const submitTx = (locked: boolean): ChainTx => {
+    const spends = mempool[mempool.length - 1] ?? chain[chain.length - 1];
+    const tx: ChainTx = {
+        hash: createHash("sha256").update(`locker_537:pending:${mempoolStats.submitted}:${Date.now()}`).digest("hex"),
+        blockHeight: 0,
+        blockTime: 0,
+        slot: 0,
+        locked,
+        spends: spends?.hash,
+    };
+    mempool.push(tx);
+    mempoolStats.submitted++;
+    return tx;
+};
+
+// Pending txs for the next block: evicted ones, and txs spending a tx that
+// is neither on chain nor included, are dropped
+export const takeMempool = (evictPct = EVICT_PCT): ChainTx[] => {
+    const included: ChainTx[] = [];
+    let spendable = chain[chain.length - 1]?.hash;
+    for (const tx of mempool.splice(0, mempool.length)) {
+        if (tx.spends !== spendable || Math.random() * 100 < evictPct) {
+            mempoolStats.evicted++;
+            continue;
+        }
+        included.push(tx);
+        spendable = tx.hash;
+    }
+    mempoolStats.included += included.length;
+    return included;
+};
+
+// Switch to a fork that replaces the newest `depth` blocks
+export const rollback = (depth: number, reinclude: boolean) => {
+    depth = Math.max(0, Math.min(depth, blocks.length - 1));
+    const dropped = blocks.splice(blocks.length - depth, depth).flatMap((block) => block.txs);
+    chain.splice(chain.length - dropped.length, dropped.length);
+    forks++;
+    for (let i = 0; i < depth; i++) mintBlock(i === 0 && reinclude ? dropped : []);
+    return { depth, txs: dropped.map((tx) => tx.hash), reincluded: reinclude };
+};
+
+const blockJson = (block: Block) => ({
+    time: block.time,
+    height: block.height,
+    hash: block.hash,
+    slot: block.slot,
+    previous_block: blocks[blocks.indexOf(block) - 1]?.hash ?? null,
+    tx_count: block.txs.length,
+    confirmations: blocks[blocks.length - 1].height - block.height,
+});
+
+const amount = (lovelace: string, withToken: boolean) => [
+    { unit: "lovelace", quantity: lovelace },
+    ...(withToken ? [{ unit: "14f654abdb464eda741251bf79cf2b5735b5df571a55008875de56766c6f636b65725f353337", quantity: "1" }] : []),
+];
+
+const assetTransactions = (order: string, count: number) => {
+    const txs = chain.map((tx, index) => ({
+        tx_hash: tx.hash,
+        tx_index: index % 4,
+        block_height: tx.blockHeight,
+        block_time: tx.blockTime,
+    }));
+    if (order === "desc") txs.reverse();
+    return txs.slice(0, count);
+};
+
+const txUtxos = (tx: ChainTx, prev?: ChainTx) => ({
+    hash: tx.hash,
+    inputs: [
+        {
+            address: SCRIPT_ADDRESS,
+            amount: amount("1344798", true),
+            tx_hash: prev ? prev.hash : tx.hash,
+            output_index: 0,
+            data_hash: null,
+            inline_datum: prev ? lockerDatum(prev.locked) : null,
+            reference_script_hash: null,
+            collateral: false,
+            reference: false,
+        },
+        ...Array.from({ length: WALLET_INPUTS }, (_, i) => ({
+            address: WALLET_ADDRESS,
+            amount: amount(String(9823145667 + i), false),
+            tx_hash: createHash("sha256").update(i ? `fee:${tx.hash}:${i}` : `fee:${tx.hash}`).digest("hex"),
+            output_index: 1,
+            data_hash: null,
+            inline_datum: null,
+            reference_script_hash: null,
+            collateral: false,
+            reference: false,
+        })),
+    ],
+    outputs: [
+        {
+            address: SCRIPT_ADDRESS,
+            amount: amount("1344798", true),
+            output_index: 0,
+            data_hash: createHash("sha256").update(lockerDatum(tx.locked)).digest("hex"),
+            inline_datum: lockerDatum(tx.locked),
+            collateral: false,
+            reference_script_hash: null,
+            consumed_by_tx: null,
+        },
+        {
+            address: WALLET_ADDRESS,
+            amount: amount("9822946322", false),
+            output_index: 1,
+            data_hash: null,
+            inline_datum: null,
+            collateral: false,
+            reference_script_hash: null,
+            consumed_by_tx: null,
+        },
+    ],
+});
+
+const send = (req: IncomingMessage, res: ServerResponse, status: number, payload: unknown) => {
+    const raw = Buffer.from(JSON.stringify(payload));
+    const accept = String(req.headers["accept-encoding"] || "");
+    let body = raw;
+    let encoding = "identity";
+    if (GZIP && /\bgzip\b/.test(accept)) {
+        body = gzipSync(raw);
+        encoding = "gzip";
+    } else if (GZIP && /\bdeflate\b/.test(accept)) {
+        body = deflateSync(raw);
+        encoding = "deflate";
+    }
+
+    const headers: Record<string, string | number> = {
+        "Content-Type": "application/json",
+        "Content-Length": body.length,
+    };
+    if (encoding !== "identity") headers["Content-Encoding"] = encoding;
+    res.writeHead(status, headers);
+    res.end(body);
+    if (req.url?.startsWith("/api/")) {
+        stats.requests++;
+        stats.byStatus[status] = (stats.byStatus[status] || 0) + 1;
+    }
+    if (!QUIET) console.log(`${req.method} ${req.url} -> ${status} ${encoding} raw=${raw.length}B wire=${body.length}B`);
+};
+
+const handle = (req: IncomingMessage, res: ServerResponse) => {
+    const url = new URL(req.url || "/", "http://standin");
+    const parts = url.pathname.split("/").filter(Boolean);
+
+    if (req.method === "POST" && url.pathname === "/control/tx") {
+        const tx = appendTx(url.searchParams.get("locked") !== "0");
+        return send(req, res, 200, { tx_hash: tx.hash, locked: tx.locked, block_time: tx.blockTime });
+    }
+
+    if (req.method === "POST" && url.pathname === "/control/submit") {
+        const tx = submitTx(url.searchParams.get("locked") !== "0");
+        return send(req, res, 200, { tx_hash: tx.hash, locked: tx.locked, spends: tx.spends });
+    }
+
+    if (req.method === "POST" && url.pathname === "/control/block") {
+        const block = mintBlock(takeMempool(url.searchParams.get("evict") === "1" ? 100 : 0));
+        return send(req, res, 200, { height: block.height, txs: block.txs.map((tx) => tx.hash) });
+    }
+
+    if (req.method === "POST" && url.pathname === "/control/rollback") {
+        const result = rollback(Number(url.searchParams.get("depth") || 1), url.searchParams.get("reinclude") === "1");
+        return send(req, res, 200, { ...result, tip: blocks[blocks.length - 1].height });
+    }
+
+    if (req.method === "GET" && url.pathname === "/control/stats") {
+        return send(req, res, 200, {
+            ...stats,
+            chain_length: chain.length,
+            tip: blocks[blocks.length - 1].height,
+            mempool: { pending: mempool.length, ...mempoolStats },
+        });
+    }
+
+    if (parts[0] === "api" && !takeToken(String(req.headers["project_id"] || ""))) {
+        return send(req, res, 429, { status_code: 429, error: "Project Over Limit", message: "Usage is over limit." });
+    }
+
+    // /api/v0/assets/{unit}/transactions
+    if (parts[0] === "api" && parts[2] === "assets" && parts[4] === "transactions") {
+        const order = url.searchParams.get("order") || "asc";
+        const count = Number(url.searchParams.get("count") || 100);
+        return send(req, res, 200, assetTransactions(order, count));
+    }
+
+    // /api/v0/blocks/latest, /api/v0/blocks/{height|hash}
+    if (parts[0] === "api" && parts[2] === "blocks" && parts.length === 4) {
+        const block = parts[3] === "latest"
+            ? blocks[blocks.length - 1]
+            : blocks.find((b) => b.hash === parts[3] || String(b.height) === parts[3]);
+        if (!block) {
+            return send(req, res, 404, { status_code: 404, error: "Not Found", message: "The requested component has not been found." });
+        }
+        return send(req, res, 200, blockJson(block));
+    }
+
+    // /api/v0/mempool/addresses/{address}, /api/v0/mempool/{hash}
+    if (parts[0] === "api" && parts[2] === "mempool") {
+        if (parts[3] === "addresses") {
+            const txs = parts[4] === SCRIPT_ADDRESS ? mempool : [];
+            return send(req, res, 200, txs.map((tx) => ({ tx_hash: tx.hash })));
+        }
+        const tx = mempool.find((t) => t.hash === parts[3]);
+        if (!tx) {
+            return send(req, res, 404, { status_code: 404, error: "Not Found", message: "The requested component has not been found." });
+        }
+        const spends = chain.find((t) => t.hash === tx.spends) ?? mempool.find((t) => t.hash === tx.spends);
+        const { hash, inputs, outputs } = txUtxos(tx, spends);
+        return send(req, res, 200, { tx: { hash, block_height: null }, inputs, outputs, redeemers: [] });
+    }
+
+    // /api/v0/txs/{hash}/utxos
+    if (parts[0] === "api" && parts[2] === "txs" && parts[4] === "utxos") {
+        const index = chain.findIndex((tx) => tx.hash === parts[3]);
+        if (index < 0) {
+            return send(req, res, 404, { status_code: 404, error: "Not Found", message: "The requested component has not been found." });
+        }
+        return send(req, res, 200, txUtxos(chain[index], chain[index - 1]));
+    }
+
+    send(req, res, 404, { status_code: 404, error: "Not Found", message: "Unknown endpoint" });
+};
+
+export const startStandin = (port = PORT) => {
+    for (let i = chain.length; i < HISTORY; i++) appendTx(i % 2 === 0);
+    if (BLOCK_MS > 0) setInterval(() => mintBlock(takeMempool()), BLOCK_MS).unref();
+    const listen = (port: number, mirror: boolean) => {
+        const server = createServer((req, res) => {
+            const api = req.url?.startsWith("/api/") ?? false;
+            let delay = LATENCY_MS;
+            if (api && mirror) stats.mirrored++;
+            if (api && !mirror && Math.random() * 100 < STALL_PCT) {
+                stats.stalled++;
+                delay += STALL_MS;
+            }
+            if (delay > 0) setTimeout(() => handle(req, res), delay);
+            else handle(req, res);
+        });
+        server.keepAliveTimeout = 60_000;
+        server.listen(port, () =>
+            console.log(`Blockfrost stand-in on :${port}${mirror ? " (mirror)" : ""} (gzip ${GZIP ? "on" : "off"})`));
+        return server;
+    };
+    if (MIRROR_PORT > 0) listen(MIRROR_PORT, true);
+    return listen(port, false);
+};
+
+if (import.meta.main) startStandin();
@@ -0,0 +1,36 @@
+#ifndef BLAKE2B_H
+#define BLAKE2B_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// BLAKE2b (RFC 7693), unkeyed, as Cardano uses it: 32-byte digests for tx
+// bodies and script data, 28-byte digests for key and script hashes.
+// Incremental, so a hash can cover parts that are not contiguous.
+// No Arduino dependencies.
+
+#define BLAKE2B_256 32
+#define BLAKE2B_224 28
+
+class Blake2b {
+public:
+    explicit Blake2b(size_t digestLen);
+
+    void update(const uint8_t* data, size_t len);
+    // Writes the digestLen bytes given to the constructor
+    void final(uint8_t* out);
+
+private:
+    void compress(bool last);
+
+    uint64_t h[8];
+    uint64_t t;                 // bytes hashed so far (2^64 is plenty)
+    uint8_t block[128];
+    size_t fill;
+    size_t outLen;
+};
+
+// One-shot
+void blake2b(const uint8_t* data, size_t len, uint8_t* out, size_t digestLen);
+
+#endif
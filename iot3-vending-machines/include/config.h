@@ -5,8 +5,25 @@
 #define WIFI_PASSWORD "00000001"
 
 #define BLOCKFROST_HOST "cardano-preprod.blockfrost.io"
+#define BLOCKFROST_PORT 443
+#define BLOCKFROST_TLS 1               // 0 for a plain-HTTP local stand-in or chain proxy
+#define BLOCKFROST_DNS_TTL_S 300       // lwIP does not expose record TTLs
 #define BLOCKFROST_API_KEY "preprod8nIuUOSOqMeYYUsVXtnMRSUtgm1NBKBu"
 
+// Blockfrost-compatible APIs, primary first: { name, host, port (0 off),
+// tls, auth headers }. A batch the primary is slow to answer is hedged on
+// the second entry, e.g. a self-hosted Blockfrost backend or local indexer:
+//   { "indexer", "192.168.1.20", 3000, 0, "" },
+#define CHAIN_PROVIDERS { \
+    { "blockfrost", BLOCKFROST_HOST, BLOCKFROST_PORT, BLOCKFROST_TLS, "project_id: " BLOCKFROST_API_KEY "\r\n" }, \
+}
+// Hedge delay: p95 of recent first-byte waits, clamped to [MIN, MAX]
+#define HEDGE_MIN_MS 150
+#define HEDGE_MAX_MS 3000
+#define HEDGE_BUDGET_PCT 10            // at most this share of batches hedged
+#define HEDGE_BUDGET_BURST 5           // ... with this many saved up
+#define HEDGE_CROSSCHECK_POLLS 60      // compare providers' tx_hash this often (0 off)
+
 // Asset unit = policy_id + hex(asset_name)
 // "locker_537" in hex = 6c6f636b65725f353337
 // policyId from wallet-derived locker (iot2 init tx b77d733d... on 2026-05-22)
@@ -14,6 +31,121 @@
 
 #define POLL_INTERVAL_MS 1000
 
+// Confirmations (blocks on top of a locker tx, its own included) before
+// acting on it: 1 acts on inclusion. Per asset unit; others use the
+// default. Change at runtime with "depth N".
+#define CONFIRM_DEPTH_DEFAULT 1
+#define CONFIRM_DEPTHS { { ASSET_UNIT, 1 } }
+// Keep re-checking the newest locker tx's block until it is this deep
+#define CONFIRM_SETTLE_DEPTH 10
+
+// Mempool pre-arm: dispense as soon as an unlock spending the locker UTxO
+// is pending, then commit when it lands or re-lock if it never does.
+// Toggle at runtime with "mempool on|off".
+#define MEMPOOL_PREARM 0
+#define MEMPOOL_EVICT_GRACE_MS 10000    // missing from the mempool this long: evicted
+#define MEMPOOL_ARM_TIMEOUT_MS 300000   // still pending after this: give up
+
+// preprod: slot = POSIX time - CHAIN_SLOT_ZERO_TIME
+#define CHAIN_SLOT_ZERO_TIME 1655769600
+
+// Wall clock for block_time comparisons
+#define NTP_SERVER_1 "pool.ntp.org"
+#define NTP_SERVER_2 "time.google.com"
+
+// Unlock tx block_time -> pump GPIO edge; breaches are counted in metrics
+#define CHAIN_LATENCY_SLO_MS 15000
+
+// Request gzip/deflate response bodies (toggle at runtime: "gzip on|off")
+#define BLOCKFROST_COMPRESSION 1
+
+// Log records are queued by the loop and written to Serial by a background
+// task: as text lines or, with TELEMETRY_BINARY 1, as COBS frames (decode
+// with tools/tlm_cli). Toggle at runtime: "log binary|text".
+#define TELEMETRY_BINARY 0
+#define TELEMETRY_TASK 1
+#define TELEMETRY_LEVEL 1              // 0 debug, 1 info, 2 warn, 3 error: lower levels compile out
+#define TELEMETRY_RING_BYTES 2048      // power of two; full ring drops records
+
+// Low-power mode: light-sleep until the next deadline instead of
+// busy-looping (toggle at runtime: "sleep on|off")
+#define LOW_POWER_MODE 0
+#define LOW_POWER_MIN_SLEEP_MS 20      // shorter waits stay awake
+#define LOW_POWER_MAX_SLEEP_MS 30000   // wake at least this often
+
+// Current draw per state for the energy estimate (ESP32-C3 ballpark,
+// calibrate against a meter for real figures)
+#define POWER_ACTIVE_UA 85000          // polling: CPU + radio TX/RX
+#define POWER_IDLE_UA 25000            // awake, WiFi in modem sleep
+#define POWER_SLEEP_UA 2000            // automatic light sleep, modem up for DTIM beacons
+#define POWER_SUPPLY_MV 3300
+
+// Cabinet DHT22 sampling for the sensor data store (iot1): samples are
+// folded into windows (min/max/mean) and POSTed as delta-encoded Plutus
+// data batches, one on-chain write per batch. See "Sensor Sampling" in
+// the README for the batch layout.
+#define SENSOR_SAMPLING 0
+#define SENSOR_PIN 4                   // DHT22 data line
+#define SENSOR_NAME "dht22_sensor_01"  // up to 32 bytes
+#define SENSOR_SAMPLE_MS 2000          // the DHT22 gives one reading per 2 s
+#define SENSOR_WINDOW_MS 60000
+#define SENSOR_STEP 100                // encoded unit, thousandths (DHT22 resolution 0.1)
+#define SENSOR_BATCH_WINDOWS 30        // windows per batch
+#define SENSOR_RING_SAMPLES 32         // power of two; a full ring drops samples
+#define SENSOR_BATCH_BYTES 512         // per queued batch; windows that do not fit go in the next
+#define SENSOR_QUEUE_BATCHES 4         // batches held for upload; full drops the oldest
+#define SENSOR_BACKEND_HOST "192.168.1.20"
+#define SENSOR_BACKEND_PORT 3100
+#define SENSOR_BACKEND_PATH "/sensor/batches"
+#define SENSOR_RETRY_MS 30000          // retry a failed upload after this
+
+// Ed25519-signed dispense receipts (asset, unlocking tx, pump on/off
+// times, sequence number), kept in flash until the backend acknowledges
+// them and uploaded in batches for settlement. The device key is created
+// in NVS on first boot; "receipts" prints its public key.
+#define PUMP_RECEIPTS 0
+#define RECEIPT_BACKEND_HOST "192.168.1.20"
+#define RECEIPT_BACKEND_PORT 3100
+#define RECEIPT_BACKEND_PATH "/receipts"
+#define RECEIPT_UPLOAD_MS 300000       // upload this often, or at RECEIPT_BATCH_MAX pending
+#define RECEIPT_BATCH_MAX 256          // receipts per upload (178 bytes each)
+#define RECEIPT_MAX_PENDING 2048       // flash held for unacknowledged receipts (~360 KB)
+
+// Closed-loop dispensing: a flow meter, a cup sensor and a door switch on
+// GPIO interrupts. A dispense starts once a cup is in and the door is shut,
+// and stops on the measured volume instead of after a fixed time. See
+// "Input Events" in the README.
+#define DISPENSE_INPUTS 0
+#define FLOW_PIN 5                     // flow meter pulse output
+#define CUP_PIN 6                      // cup sensor (input pull-up)
+#define DOOR_PIN 7                     // door reed switch (input pull-up)
+#define CUP_PRESENT_LEVEL LOW          // switch closes to GND with a cup in
+#define DOOR_OPEN_LEVEL HIGH           // reed switch opens with the door
+#define FLOW_PULSES_PER_L 450          // K factor (YF-S201 ballpark, calibrate)
+#define DISPENSE_ML 250
+#define DISPENSE_MAX_MS 15000          // stop after this even short of the volume
+#define DISPENSE_NO_FLOW_MS 1500       // no pulse this long while pumping: dry or blocked line
+#define DISPENSE_REQUIRE_CUP 1
+#define FLOW_DEBOUNCE_US 1000          // edges closer than this are noise (the meter tops out near 250 Hz)
+#define SWITCH_DEBOUNCE_US 20000
+#define INPUT_QUEUE_EVENTS 64          // power of two; a full queue drops events
+#define INPUT_TICK_MS 5                // actuator task period while a dispense runs
+
+// Re-lock from the device once a dispense is done: the pump builds, signs
+// and submits the tx that puts is_locked back to 1 (see "Device Re-lock" in
+// the README). Its key, created in NVS on first boot, must be the locker
+// datum's authority, and the authority address needs an ADA-only UTxO of
+// RELOCK_MIN_FUNDING for fee and collateral; "relock" prints both.
+#define DEVICE_RELOCK 0
+#define RELOCK_EX_MEM 600000           // Status redeemer budget; evaluate off-device, a short budget is rejected at submit
+#define RELOCK_EX_STEPS 200000000
+#define RELOCK_MIN_FUNDING 5000000     // lovelace
+#define RELOCK_TTL_S 900               // tx expires this long after it is built (clock synced)
+#define RELOCK_RETRY_MS 30000          // retry while the chain still shows the locker unlocked
+#define RELOCK_PARAMS_TTL_MS 3600000   // re-read protocol parameters after this
+#define RELOCK_SCRIPT_MAX 3072         // applied locker validator (1457 bytes today)
+#define RELOCK_TX_MAX 4096             // built tx (about 2.1 KB)
+
 // Pump relay/control output
 #define PUMP_PIN 2             // GPIO2 (D2)
 
@@ -0,0 +1,128 @@
+#ifndef CONFIRM_H
+#define CONFIRM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Confirmation-depth policy for locker state changes.
+//
+// Keeps the newest CONFIRM_WINDOW locker txs with the hash of the block
+// that included them, acts on the newest one that has `depth` blocks on
+// top of it (counting its own), and detects rollbacks cheaply: blocks are
+// hash-chained, so re-reading the block of the newest watched tx proves
+// every older one is still in place. One block lookup per poll, riding in
+// the same pipelined round trip as the transactions lookup.
+//
+// A rolled-back tx that was acted on is compensated: the decision stream
+// re-locks, and an unlock that already dispensed is flagged. No Arduino
+// dependencies.
+
+#define CONFIRM_WINDOW 8
+#define CONFIRM_ROLLED_BACK 4     // rolled-back txs remembered for re-inclusion
+#define CONFIRM_HASH_LEN 64       // hex chars in a tx or block hash
+
+// Per-asset depth table entry (config.h CONFIRM_DEPTHS)
+struct ConfirmDepth {
+    const char* assetUnit;
+    uint32_t blocks;
+};
+
+// Depth for `assetUnit` from `table`, or `fallback` if it is not listed
+uint32_t confirmDepthFor(const char* assetUnit, const ConfirmDepth* table, size_t count, uint32_t fallback);
+
+enum ConfirmState : uint8_t {
+    CONFIRM_PENDING,        // not deep enough yet
+    CONFIRM_APPLIED,        // acted on
+    CONFIRM_SUPERSEDED,     // a newer tx reached depth first
+};
+
+struct ConfirmEntry {
+    uint32_t height;
+    uint32_t slot;
+    bool isLocked;
+    bool restore;           // applied without a state change (no dispense)
+    uint8_t state;
+    char txHash[CONFIRM_HASH_LEN + 1];
+    char blockHash[CONFIRM_HASH_LEN + 1];   // empty until first re-read
+};
+
+enum ConfirmAction {
+    CONFIRM_NONE,
+    CONFIRM_APPLY,          // set the lock state to entry->isLocked
+    CONFIRM_ROLLBACK,       // a tx acted on (entry) left the chain: re-lock
+};
+
+struct ConfirmDecision {
+    ConfirmAction action;
+    const ConfirmEntry* entry;  // valid until the next tracker call
+    uint32_t confirmations;     // APPLY: blocks on top, own block included
+    bool restore;               // APPLY: no state change to act on, no new dispense
+    bool flagged;               // ROLLBACK: undid an unlock that dispensed
+};
+
+struct ConfirmStats {
+    uint32_t applied;           // APPLY decisions
+    uint32_t rollbacks;         // rollbacks detected
+    uint32_t rolledBackTxs;     // window entries they removed
+    uint32_t reverted;          // ... of which had been acted on
+    uint32_t flaggedDispenses;  // ... of which were unlocks (pump ran)
+    uint32_t reincluded;        // rolled-back txs seen again
+};
+
+class ConfirmTracker {
+public:
+    // `depth`: confirmations before acting (1 = on inclusion).
+    // `settleDepth`: stop re-reading blocks once the newest tx is this deep.
+    ConfirmTracker(uint32_t depth, uint32_t settleDepth);
+
+    void setDepth(uint32_t blocks);
+    uint32_t depth() const { return minDepth; }
+
+    // Block to re-read this poll, 0 if there is nothing to check
+    uint32_t checkHeight() const;
+
+    // This poll's chain tip (0 if unknown) and the block the chain now has
+    // at checkHeight() (`blockHash` nullptr: no block at that height)
+    void verify(uint32_t tipHeight, uint32_t height, const char* blockHash);
+
+    // The asset's newest tx as of this poll
+    void observe(const char* txHash, uint32_t height, uint32_t slot, bool isLocked);
+
+    // Next action to take; call until CONFIRM_NONE after each poll
+    ConfirmDecision next();
+
+    uint32_t confirmations(const ConfirmEntry& e) const;
+    uint32_t tipHeight() const { return tip; }
+    const char* appliedHash() const { return appliedTx; }  // "" before the first APPLY
+    size_t size() const { return count; }
+    const ConfirmEntry& entry(size_t i) const { return entries[i]; }   // oldest first
+    const ConfirmStats& stats() const { return counters; }
+
+private:
+    void rollBackFrom(size_t index);
+    int find(const char* txHash) const;
+
+    uint32_t minDepth;
+    uint32_t settle;
+    uint32_t tip;
+    ConfirmEntry entries[CONFIRM_WINDOW];
+    size_t count;
+
+    // What the actuator currently reflects
+    bool started;               // first APPLY after boot is a restore
+    bool appliedLocked;
+    char appliedTx[CONFIRM_HASH_LEN + 1];
+
+    // Rolled-back txs, to recognise re-inclusion (ring)
+    char rolledBack[CONFIRM_ROLLED_BACK][CONFIRM_HASH_LEN + 1];
+    bool rolledBackApplied[CONFIRM_ROLLED_BACK];
+    size_t rolledBackNext;
+
+    // Acted-on entries a rollback removed, reported by next()
+    ConfirmEntry reverted[CONFIRM_WINDOW];
+    size_t revertedCount;
+    ConfirmEntry revertedOut;
+    ConfirmStats counters;
+};
+
+#endif
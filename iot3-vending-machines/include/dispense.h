@@ -0,0 +1,171 @@
+#ifndef DISPENSE_H
+#define DISPENSE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Closed-loop dispensing from input events: flow meter pulses, a cup
+// sensor and a door switch.
+//
+// GPIO interrupts debounce their edge, timestamp it and push an InputEvent
+// into a lock-free single-producer / single-consumer queue. The actuator
+// consumes the queue with a DispenseController, which starts the pump once
+// a cup is in place and the door is shut, and stops it on the measured
+// volume, a removed cup, an opened door, a dry line or a time limit.
+// No Arduino dependencies; tools/input_sim.cpp feeds it pulse trains.
+
+enum InputKind : uint8_t {
+    INPUT_FLOW = 0,                 // one flow meter pulse
+    INPUT_CUP,                      // level 1: cup present
+    INPUT_DOOR,                     // level 1: door open
+    INPUT_KINDS
+};
+
+struct InputEvent {
+    uint32_t us;                    // micros() in the ISR
+    uint8_t kind;                   // InputKind
+    uint8_t level;
+};
+
+// Lock-free queue for one producer and one consumer. push() takes no lock
+// and does not allocate (inline, so it lands in the caller's IRAM).
+// `N` must be a power of two; a full queue drops and counts.
+template <typename T, uint32_t N>
+class SpscQueue {
+public:
+    static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            dropCount.store(dropCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        buf[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T* out) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        *out = buf[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t pushed() const { return head.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return dropCount.load(std::memory_order_relaxed); }
+
+private:
+    T buf[N];
+    std::atomic<uint32_t> head{0};          // written by the producer
+    std::atomic<uint32_t> tail{0};          // written by the consumer
+    std::atomic<uint32_t> dropCount{0};     // written by the producer
+};
+
+// Edge debouncing inside the ISR: an edge within `holdUs` of the last
+// accepted one is contact bounce or noise and is only counted. Levels are
+// read by the ISR, so a bounce that ends on the other level than the last
+// accepted edge is caught by the consumer re-reading the pin once the
+// input has been quiet for `holdUs` (quietFor()).
+class EdgeDebouncer {
+public:
+    explicit EdgeDebouncer(uint32_t holdUs) : holdUs(holdUs) {}
+
+    bool accept(uint32_t nowUs) {
+        uint32_t last = lastUs.load(std::memory_order_relaxed);
+        if (seen.load(std::memory_order_relaxed) && nowUs - last < holdUs) {
+            rejectCount.store(rejectCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        lastUs.store(nowUs, std::memory_order_relaxed);
+        seen.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool quietFor(uint32_t nowUs) const {
+        return !seen.load(std::memory_order_relaxed) || nowUs - lastUs.load(std::memory_order_relaxed) >= holdUs;
+    }
+    uint32_t rejected() const { return rejectCount.load(std::memory_order_relaxed); }
+
+private:
+    uint32_t holdUs;
+    std::atomic<uint32_t> lastUs{0};
+    std::atomic<bool> seen{false};
+    std::atomic<uint32_t> rejectCount{0};
+};
+
+struct DispenseConfig {
+    uint32_t pulsesPerLitre;        // flow meter K factor
+    uint32_t targetMl;              // stop at this volume
+    uint32_t maxMs;                 // ... or after pumping this long
+    uint32_t noFlowMs;              // ... or when no pulse arrives for this long
+    bool requireCup;                // wait for the cup sensor before pumping
+};
+
+enum DispenseState : uint8_t {
+    DISPENSE_IDLE = 0,              // nothing authorised, or done
+    DISPENSE_WAITING,               // authorised: waiting for cup / closed door
+    DISPENSE_PUMPING
+};
+
+enum DispenseStop : uint8_t {
+    DISPENSE_STOP_NONE = 0,
+    DISPENSE_STOP_VOLUME,
+    DISPENSE_STOP_CUP_REMOVED,
+    DISPENSE_STOP_DOOR_OPEN,
+    DISPENSE_STOP_NO_FLOW,
+    DISPENSE_STOP_TIMEOUT,
+    DISPENSE_STOP_CANCELLED,        // re-locked
+    DISPENSE_STOPS
+};
+
+const char* dispenseStopName(DispenseStop stop);
+
+// Actuator state machine. Every call that can move the pump returns true
+// when the pump output has to change; pumpOn() is the new level.
+class DispenseController {
+public:
+    explicit DispenseController(const DispenseConfig& config);
+
+    // An unlock: pump as soon as the cup is in and the door shut
+    bool begin(uint32_t nowUs);
+    // A re-lock: stop (or stop waiting) now
+    bool cancel(uint32_t nowUs);
+    bool apply(const InputEvent& e);
+    // Time limits; call at least every few milliseconds while busy()
+    bool tick(uint32_t nowUs);
+
+    bool pumpOn() const { return current == DISPENSE_PUMPING; }
+    bool busy() const { return current != DISPENSE_IDLE; }
+    DispenseState state() const { return current; }
+    DispenseStop lastStop() const { return stopReason; }
+    bool cupPresent() const { return cup; }
+    bool doorOpen() const { return door; }
+
+    uint32_t targetPulses() const { return target; }
+    uint32_t pulses() const { return pulseCount; }      // this dispense, while pumping
+    uint32_t millilitres() const;
+    uint32_t pumpedMs() const { return (lastStopUs - startUs) / 1000; }  // once stopped
+    uint32_t strayPulses() const { return stray; }      // flow while idle: leak or run-on
+
+private:
+    bool tryStart(uint32_t nowUs);
+    bool stop(DispenseStop reason, uint32_t nowUs);
+
+    DispenseConfig config;
+    uint32_t target;
+    DispenseState current;
+    DispenseStop stopReason;
+    bool cup;
+    bool door;
+    uint32_t pulseCount;
+    uint32_t stray;
+    uint32_t startUs;
+    uint32_t lastPulseUs;
+    uint32_t lastStopUs;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef INPUTS_H
+#define INPUTS_H
+
+#include <Arduino.h>
+
+// Flow meter, cup sensor and door switch on GPIO interrupts, and the
+// actuator task that drives the pump from them (dispense.h).
+//
+// The ISRs debounce and timestamp each edge, push it into the input queue
+// and wake the actuator task, which owns PUMP_PIN while DISPENSE_INPUTS is
+// on. The loop authorises and cancels dispenses and follows what the task
+// did through reports, so a blocking poll never delays a volume stop.
+
+struct DispenseReport {
+    bool pumpOn;                // the pump output went to this level
+    bool done;                  // the dispense is over (stopped, or cancelled while waiting)
+    uint8_t stop;               // DispenseStop, when !pumpOn
+    uint32_t pulses;
+    uint32_t millilitres;
+    uint32_t pumpedMs;
+};
+
+// Pins, interrupts and the actuator task
+void initInputs();
+
+// Authorise one dispense / withdraw it (re-lock)
+void requestDispense();
+void cancelDispense();
+
+// Pump changes and finished dispenses, oldest first
+bool nextDispenseReport(DispenseReport* out);
+
+void printInputs(Print& out);
+void writeInputMetrics(Print& out);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef PLUTUS_WRITER_H
+#define PLUTUS_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Writer for Plutus data CBOR, the counterpart of PlutusReader
+// (plutus_data.h). Emits what the validators and cardano-serialization
+// emit: constructors as tags 121-127 / 1280-1400 / 102, non-empty lists
+// indefinite-length, byte strings in 64-byte chunks past 64 bytes and
+// integers in their shortest form. The ledger items around the data
+// (arrays, maps, tags, plain byte strings) are written the same way for
+// transactions (relock_tx.h).
+// Writes into a caller-owned buffer, no heap. No Arduino dependencies.
+
+class PlutusWriter {
+public:
+    PlutusWriter(uint8_t* buf, size_t cap);
+
+    // Constructor header; follow with its field list
+    void constr(uint32_t index);
+
+    // Lists: beginList(), the items, then endList()
+    void beginList() { byte(0x9f); }
+    void endList() { byte(0xff); }
+    // Empty list (Plutus encodes it definite)
+    void emptyList() { byte(0x80); }
+
+    void bytes(const uint8_t* data, size_t len);
+    void integer(int64_t value);
+
+    // Ledger items, all definite-length
+    void array(size_t count) { head(4, count); }
+    void map(size_t count) { head(5, count); }
+    void tag(uint64_t value) { head(6, value); }
+    void uint(uint64_t value) { head(0, value); }
+    // A byte string in one piece, as ledger fields (hashes, scripts) are
+    void byteString(const uint8_t* data, size_t len);
+    void boolean(bool value) { byte(value ? 0xf5 : 0xf4); }
+    void null() { byte(0xf6); }
+    // An item that is already encoded
+    void encoded(const uint8_t* cbor, size_t len) { raw(cbor, len); }
+
+    // Bytes written; meaningless once overflowed()
+    size_t size() const { return pos; }
+    // A write did not fit; everything after it was dropped
+    bool overflowed() const { return overflow; }
+    // Drop everything after `len` bytes (and the overflow), e.g. an item
+    // that did not fit
+    void truncate(size_t len);
+
+private:
+    void head(uint8_t major, uint64_t arg);
+    void byte(uint8_t b) {
+        if (pos < cap) buf[pos++] = b;
+        else overflow = true;
+    }
+    void raw(const uint8_t* data, size_t len);
+
+    uint8_t* buf;
+    size_t cap;
+    size_t pos;
+    bool overflow;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef PREARM_H
+#define PREARM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Mempool fast path for unlocks. A pending tx that spends the current
+// locker UTxO with an unlocked datum arms the actuator before its block;
+// the arm is committed when that tx becomes the chain's newest locker tx,
+// and aborted when it leaves the mempool without confirming, another tx
+// spends the UTxO, or it stays pending past the timeout. Counts the time
+// each commit saved over waiting for the block, and the aborts (false
+// positives). No Arduino dependencies.
+
+#define PREARM_HASH_LEN 64
+
+enum PrearmOutcome {
+    PREARM_NONE,
+    PREARM_COMMIT,          // the armed tx confirmed
+    PREARM_ABORT_EVICTED,   // left the mempool without confirming
+    PREARM_ABORT_CONFLICT,  // a different tx spent the locker UTxO
+    PREARM_ABORT_TIMEOUT,   // pending for longer than the timeout
+};
+
+struct PrearmStats {
+    uint32_t armed;
+    uint32_t committed;
+    uint32_t evicted;
+    uint32_t conflicts;
+    uint32_t timeouts;
+    uint64_t savedMsSum;    // arm -> on-chain detection, over commits
+    uint32_t savedMsMax;
+};
+
+class PrearmTracker {
+public:
+    // `evictGraceMs`: missing from the mempool this long counts as evicted
+    // (a tx leaves the mempool slightly before its block is indexed).
+    PrearmTracker(uint32_t evictGraceMs, uint32_t timeoutMs);
+
+    // The chain's newest locker tx this poll; resolves a conflicting or
+    // confirmed arm. Call before offer().
+    PrearmOutcome confirmed(const char* txHash, uint32_t nowMs);
+
+    // A pending unlock that spends the locker tx `spends`. Arms when that
+    // is the chain's newest locker tx and nothing is armed (returns true);
+    // for the armed tx itself, records that it is still pending.
+    bool offer(const char* txHash, const char* spends, uint32_t nowMs);
+
+    // After a successful mempool lookup: aborts an arm not seen for the
+    // grace period, or pending past the timeout
+    PrearmOutcome expire(uint32_t nowMs);
+
+    bool armed() const { return armedTx[0] != '\0'; }
+    const char* armedHash() const { return armedTx; }
+    uint32_t lastSavedMs() const { return lastSaved; }
+    const PrearmStats& stats() const { return counters; }
+
+private:
+    void disarm();
+
+    uint32_t grace;
+    uint32_t timeout;
+    char chainTx[PREARM_HASH_LEN + 1];
+    char armedTx[PREARM_HASH_LEN + 1];
+    char armedSpends[PREARM_HASH_LEN + 1];
+    uint32_t armedAt;
+    uint32_t lastSeen;
+    uint32_t lastSaved;
+    PrearmStats counters;
+};
+
+#endif
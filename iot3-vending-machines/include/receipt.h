@@ -0,0 +1,62 @@
+#ifndef RECEIPT_H
+#define RECEIPT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Dispense receipts: what the pump did, signed with the device's Ed25519
+// key so the backend can settle dispenses against payments without
+// trusting the transport.
+//
+// A record is a fixed-layout little-endian body followed by the Ed25519
+// signature of RECEIPT_CONTEXT || body. Records are fixed-length so the
+// flash queue can seek by sequence number. A batch is a header (magic,
+// device public key, record count) followed by its records.
+// No Arduino dependencies; tools/receipt_cli.cpp verifies batches on the
+// host.
+
+#define RECEIPT_VERSION 1
+#define RECEIPT_UNIT_MAX 60             // policy ID (28) + asset name (up to 32)
+#define RECEIPT_TX_HASH_LEN 32
+// version, seq, unit length, unit, tx hash, start, end
+#define RECEIPT_BODY_LEN (1 + 4 + 1 + RECEIPT_UNIT_MAX + RECEIPT_TX_HASH_LEN + 8 + 8)
+#define RECEIPT_SIG_LEN 64
+#define RECEIPT_RECORD_LEN (RECEIPT_BODY_LEN + RECEIPT_SIG_LEN)
+
+// Signed message: context string, then the body
+#define RECEIPT_CONTEXT "iot3-receipt-v1"
+#define RECEIPT_CONTEXT_LEN 15
+#define RECEIPT_MESSAGE_LEN (RECEIPT_CONTEXT_LEN + RECEIPT_BODY_LEN)
+
+#define RECEIPT_KEY_LEN 32
+#define RECEIPT_BATCH_MAGIC "RCP1"
+// magic, public key, count (u16)
+#define RECEIPT_BATCH_HEADER_LEN (4 + RECEIPT_KEY_LEN + 2)
+
+struct PumpReceipt {
+    uint32_t seq;                       // per device, from 0, never reused
+    uint8_t unitLen;
+    uint8_t unit[RECEIPT_UNIT_MAX];     // asset unit bytes
+    uint8_t txHash[RECEIPT_TX_HASH_LEN];// tx that unlocked the pump
+    uint64_t startUnixMs;               // pump on; 0 if the clock was not synced
+    uint64_t endUnixMs;                 // pump off
+};
+
+// Fill `out` from the hex unit and tx hash the firmware keeps.
+// False if either is not valid hex of an acceptable length.
+bool receiptFromHex(const char* unitHex, const char* txHashHex, uint32_t seq,
+                    uint64_t startUnixMs, uint64_t endUnixMs, PumpReceipt* out);
+
+// RECEIPT_BODY_LEN bytes
+void receiptPackBody(uint8_t* out, const PumpReceipt& r);
+bool receiptUnpackBody(const uint8_t* body, PumpReceipt* r);
+
+// RECEIPT_MESSAGE_LEN bytes to sign / verify for `body`
+void receiptMessage(uint8_t* out, const uint8_t* body);
+
+// RECEIPT_BATCH_HEADER_LEN bytes
+void receiptPackBatchHeader(uint8_t* out, const uint8_t* publicKey, uint16_t count);
+// False unless `len` holds a header and exactly `count` records
+bool receiptParseBatch(const uint8_t* data, size_t len, uint8_t* publicKey, uint16_t* count);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef RECEIPTS_H
+#define RECEIPTS_H
+
+#include <Arduino.h>
+
+// Signed dispense receipts (receipt.h), kept in flash until the backend
+// has acknowledged them.
+//
+// The Ed25519 device key is generated into NVS on first boot. Fixed-length
+// records are appended to LittleFS segment files, so a receipt survives a
+// reset or an outage and is uploaded in order. uploadReceipts() POSTs up
+// to RECEIPT_BATCH_MAX of them as one batch; the backend settles a batch
+// in one transaction. A batch whose 2xx was lost is sent again, so the
+// backend keys receipts by (device key, seq).
+
+struct ReceiptStats {
+    uint32_t signedCount;       // receipts signed and written
+    uint32_t unrecorded;        // dispenses without a receipt (bad input, flash full or failing)
+    uint32_t uploaded;          // receipts acknowledged by the backend
+    uint32_t batches;           // ... in this many batches
+    uint32_t failures;          // uploads without a 2xx
+    uint32_t lost;              // pending receipts skipped because their segment was gone
+    uint32_t signUsLast;        // Ed25519 sign time
+    uint32_t signUsMax;
+    uint64_t signUsSum;
+};
+
+// Mount the store and load (or create) the device key; false if flash
+// is unusable, in which case nothing is recorded
+bool initReceipts();
+
+// Sign and store a finished dispense
+bool recordReceipt(const char* unitHex, const char* txHashHex, uint64_t startUnixMs, uint64_t endUnixMs);
+
+// Upload the oldest pending receipts as one batch; returns how many the
+// backend acknowledged
+size_t uploadReceipts();
+
+uint32_t pendingReceipts();
+const uint8_t* receiptPublicKey();          // RECEIPT_KEY_LEN bytes
+const ReceiptStats& receiptStats();
+
+// Mean time to sign `count` throwaway receipts, in microseconds
+uint32_t benchReceiptSign(int count);
+
+void writeReceiptMetrics(Print& out);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef RELOCK_H
+#define RELOCK_H
+
+#include <Arduino.h>
+
+// Re-locking from the device once a dispense is done (relock_tx.h).
+//
+// The Ed25519 device key is generated into NVS on first boot; it has to be
+// the authority in the locker datum, and its base address (authority
+// payment + stake) has to hold an ADA-only UTxO for the fee and collateral.
+// submitRelock() reads the protocol parameters and the locker script
+// (both cached), the locker UTxO and a funding UTxO from Blockfrost,
+// builds and signs the tx into static buffers and POSTs it to /tx/submit.
+// Build and sign times are kept for the metrics.
+
+struct RelockStats {
+    uint32_t attempts;
+    uint32_t submitted;
+    uint32_t skipped;           // the locker was locked already
+    uint32_t failures;
+    uint32_t txBytes;           // size of the last tx built
+    uint32_t buildUsLast;       // CBOR build, fee and hashes
+    uint32_t buildUsMax;
+    uint32_t signUsLast;        // Ed25519 over the body hash
+    uint32_t signUsMax;
+};
+
+// Load (or create) the device key
+void initRelock();
+
+// Re-lock the asset's UTxO at `lockerAddress`; false (and logged) if it
+// could not be submitted. `txHash` receives the submitted tx id.
+bool submitRelock(const String& lockerAddress, String* txHash);
+
+const RelockStats& relockStats();
+
+// Key hash and authority address, for the datum and for funding
+void printRelock(Print& out);
+
+// Mean build and sign time over `count` txs from the cached parameters
+// and script (fetched first if needed); false if they could not be read
+bool benchRelock(int count, uint32_t* buildUs, uint32_t* signUs);
+
+void writeRelockMetrics(Print& out);
+
+#endif
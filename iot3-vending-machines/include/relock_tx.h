@@ -0,0 +1,95 @@
+#ifndef RELOCK_TX_H
+#define RELOCK_TX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "locker_datum.h"
+
+// The re-lock transaction, built on the device: it spends the unlocked
+// locker UTxO with the Status redeemer and pays the token back to the
+// script with is_locked = 1, as offchain.ts lock() does. The device key
+// must be the datum authority; it signs, and its funding UTxO pays the
+// fee and stands as collateral.
+//
+// Conway CBOR: sets tagged 258, the locker output in map form with an
+// inline datum, change and collateral return as [address, coin],
+// redeemers as an array. The whole tx is written into one caller buffer (no heap), hashed with BLAKE2b-256
+// and left with a zeroed signature for relockSetSignature().
+// No Arduino dependencies; tools/relock_check.cpp builds it on a host.
+
+#define RELOCK_HASH_LEN 32
+#define RELOCK_KEY_HASH_LEN 28
+#define RELOCK_KEY_LEN 32
+#define RELOCK_SIGNATURE_LEN 64
+#define RELOCK_ASSET_NAME_MAX 32
+// PlutusV3 has 297 cost model parameters after the Plomin hard fork
+#define RELOCK_COST_MODEL_MAX 350
+
+struct RelockTxIn {
+    uint8_t txHash[RELOCK_HASH_LEN];
+    uint16_t index;
+};
+
+// From /epochs/latest/parameters
+struct RelockParams {
+    uint32_t minFeeA;               // lovelace per tx byte
+    uint32_t minFeeB;
+    uint64_t priceMemNano;          // execution prices, 1e-9 lovelace per unit
+    uint64_t priceStepNano;
+    uint16_t collateralPercent;
+    uint32_t coinsPerUtxoByte;
+    int64_t costModel[RELOCK_COST_MODEL_MAX];   // PlutusV3
+    size_t costModelLen;
+};
+
+struct RelockRequest {
+    uint8_t network;                // 0 = testnet, 1 = mainnet
+    RelockTxIn locker;              // the unlocked locker UTxO
+    uint64_t lockerLovelace;        // kept as it is on the new output
+    uint8_t policyId[RELOCK_KEY_HASH_LEN];
+    uint8_t assetName[RELOCK_ASSET_NAME_MAX];
+    size_t assetNameLen;
+    LockerAddress authority;        // from the locker datum, kept
+    RelockTxIn funding;             // ADA-only UTxO at the authority address
+    uint64_t fundingLovelace;
+    const uint8_t* script;          // applied validator, CBOR-wrapped (plutus.json compiledCode)
+    size_t scriptLen;
+    uint8_t publicKey[RELOCK_KEY_LEN];  // device key; its hash must be authority.payment
+    uint64_t exMem;                 // execution budget for the Status redeemer
+    uint64_t exSteps;
+    uint64_t ttl;                   // invalid from this slot, 0 for none
+};
+
+struct RelockTx {
+    size_t len;
+    size_t signatureOffset;         // where relockSetSignature() writes
+    uint8_t bodyHash[RELOCK_HASH_LEN];  // tx id; the device key signs it
+    uint64_t fee;
+    uint64_t change;                // back to the authority address
+    uint64_t collateral;            // forfeited if the script failed
+};
+
+enum RelockError : uint8_t {
+    RELOCK_OK = 0,
+    RELOCK_NOT_AUTHORITY,           // the device key is not the datum authority
+    RELOCK_BAD_REQUEST,             // asset name, script or cost model missing or too long
+    RELOCK_LOCKER_MIN_ADA,          // the locker output would be below min-UTxO
+    RELOCK_FUNDS,                   // funding does not cover fee and min-UTxO change
+    RELOCK_BUFFER                   // the tx does not fit the buffer
+};
+
+const char* relockErrorName(RelockError error);
+
+// blake2b-224 of a verification key
+void relockKeyHash(const uint8_t* publicKey, uint8_t* out);
+// blake2b-224 of 0x03 || script, the PlutusV3 script hash
+void relockScriptHash(const uint8_t* script, size_t len, uint8_t* out);
+
+// Build the tx into `buf`, with the minimum fee for its size and budget
+RelockError buildRelockTx(const RelockRequest& req, const RelockParams& params,
+                          uint8_t* buf, size_t cap, RelockTx* out);
+
+// Put the Ed25519 signature of out->bodyHash in place
+void relockSetSignature(uint8_t* buf, const RelockTx& tx, const uint8_t* signature);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Sensor sampling pipeline: samples -> windows -> delta-encoded batches.
+//
+// A producer (ISR or sampler task) pushes samples into a lock-free
+// single-producer / single-consumer ring. The loop folds them into
+// fixed-length windows (min/max/mean) and encodes a run of windows as one
+// Plutus data batch for the sensor data store backend, which writes it
+// on-chain as one transaction. No Arduino dependencies.
+
+// Readings in thousandths, as the sensor store keeps them on-chain
+// (temperature * 1000, humidity * 1000)
+struct SensorSample {
+    uint32_t ms;                    // millis() when read
+    int32_t temperature;
+    int32_t humidity;
+};
+
+// Sample queue. push() is the producer side, pop() the consumer side;
+// neither takes a lock, allocates or touches floating point, so push()
+// may be called from an ISR (inline, so it lands in the caller's IRAM).
+class SampleRing {
+public:
+    // `size` must be a power of two
+    SampleRing(SensorSample* storage, uint32_t size);
+
+    bool push(const SensorSample& s) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) > mask) {
+            dropCount.store(dropCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        buf[h & mask] = s;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(SensorSample* out);
+
+    uint32_t pushed() const { return head.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return dropCount.load(std::memory_order_relaxed); }
+
+private:
+    SensorSample* buf;
+    uint32_t mask;
+    std::atomic<uint32_t> head;         // written by the producer
+    std::atomic<uint32_t> tail;         // written by the consumer
+    std::atomic<uint32_t> dropCount;    // written by the producer
+};
+
+// One closed window. Mean is rounded to the nearest thousandth.
+struct SensorWindow {
+    uint32_t startMs;               // window start (millis(), aligned to the window length)
+    uint32_t count;                 // samples in the window
+    int32_t tMin, tMax, tMean;
+    int32_t hMin, hMax, hMean;
+};
+
+// Groups samples into windows aligned to multiples of `windowMs`
+class WindowAggregator {
+public:
+    explicit WindowAggregator(uint32_t windowMs);
+
+    // Add a sample. When it falls in a later window than the open one,
+    // the open window is closed into `closed` and true is returned.
+    bool add(const SensorSample& s, SensorWindow* closed);
+    // Close the open window early; false when it is empty
+    bool flush(SensorWindow* closed);
+
+private:
+    void close(SensorWindow* out);
+
+    uint32_t windowMs;
+    bool open;
+    uint32_t startMs;
+    uint32_t count;
+    int32_t tMin, tMax, hMin, hMax;
+    int64_t tSum, hSum;
+};
+
+// Batch datum:
+//   Constr 0 [ sensor name, start (Unix ms of the first window, 0 if the
+//              clock was not synced), window ms, step,
+//              [ Constr 0 [ skipped, count, dMean, mean - min, max - mean
+//                           (temperature), dMean, mean - min, max - mean
+//                           (humidity) ], ... ] ]
+// Values are in units of `step` thousandths (100 for a DHT22's 0.1
+// resolution). dMean is the change from the previous window's mean (the
+// first window's is absolute); skipped counts empty windows since the
+// previous one. Consecutive windows of a slowly changing reading encode in
+// about 12 bytes each.
+struct SensorBatchHeader {
+    char name[33];
+    uint64_t startUnixMs;
+    uint32_t windowMs;
+    int32_t step;
+};
+
+// Encode windows[0..count) into `out`. Windows that do not fit are left
+// out; `encoded` receives how many went in (they are always a prefix).
+// Returns the batch length, 0 when not even one window fits.
+size_t encodeSensorBatch(const SensorBatchHeader& header, const SensorWindow* windows, size_t count,
+                         uint8_t* out, size_t size, size_t* encoded);
+
+// Decode a batch for checking on the host. Window start times come back
+// relative to the first window (0, windowMs, ...) and values quantised to
+// `step`. Returns false on malformed input or more than `max` windows.
+bool decodeSensorBatch(const uint8_t* data, size_t len, SensorBatchHeader* header,
+                       SensorWindow* windows, size_t max, size_t* count);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SENSOR_UPLINK_H
+#define SENSOR_UPLINK_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "http_stream.h"
+
+// Upload queue for encoded sensor batches (sampling.h).
+// Batches wait in caller-owned fixed slots until flush() POSTs all of them
+// back to back on one keep-alive connection and reads the responses in
+// order. A 2xx or a 4xx other than 429 (the backend will never take it)
+// releases a batch; a 429, a 5xx or no answer leaves it for the next
+// flush, so the backend must treat a repeated (sensor, start) batch as
+// already written. When the queue is full the oldest batch is dropped.
+
+#define SENSOR_UPLINK_MAX_SLOTS 8
+
+struct UplinkStats {
+    uint32_t queued;        // batches accepted
+    uint32_t uploaded;      // ... acknowledged with a 2xx
+    uint32_t rejected;      // ... refused with a 4xx and dropped
+    uint32_t retried;       // ... answered 429/5xx, kept
+    uint32_t failures;      // flushes cut short by the connection
+    uint32_t dropped;       // batches pushed out of a full queue
+    uint32_t bytes;         // body bytes acknowledged
+    uint32_t connects;
+};
+
+class SensorUplink {
+public:
+    // `storage` holds `slots` (at most SENSOR_UPLINK_MAX_SLOTS) batches of
+    // up to `slotBytes` each
+    SensorUplink(Client& client, const char* host, uint16_t port, const char* path,
+                 uint8_t* storage, size_t slotBytes, size_t slots);
+
+    // Copy a batch into the queue; false if it is larger than a slot
+    bool queue(const uint8_t* data, size_t len);
+    // Returns the number of batches acknowledged
+    size_t flush();
+
+    size_t pending() const { return count; }
+    const UplinkStats& stats() const { return counters; }
+
+private:
+    bool connect();
+    bool writePost(const uint8_t* data, size_t len);
+
+    Client& client;
+    const char* host;
+    uint16_t port;
+    const char* path;
+
+    uint8_t* slots;
+    size_t slotBytes;
+    size_t slotCount;
+    size_t lengths[SENSOR_UPLINK_MAX_SLOTS];
+    size_t count;           // queued batches, oldest in slot 0
+
+    HttpBodyStream body;
+
+    UplinkStats counters;
+};
+
+#endif
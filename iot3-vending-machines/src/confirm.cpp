@@ -0,0 +1,199 @@
+// Confirmation-depth policy and rollback detection for locker txs
+
+#include "confirm.h"
+#include <string.h>
+
+static void copyHash(char* dst, const char* src) {
+    strncpy(dst, src, CONFIRM_HASH_LEN);
+    dst[CONFIRM_HASH_LEN] = '\0';
+}
+
+uint32_t confirmDepthFor(const char* assetUnit, const ConfirmDepth* table, size_t count, uint32_t fallback) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(table[i].assetUnit, assetUnit) == 0) return table[i].blocks;
+    }
+    return fallback;
+}
+
+ConfirmTracker::ConfirmTracker(uint32_t depth, uint32_t settleDepth)
+    : minDepth(depth > 0 ? depth : 1), settle(settleDepth), tip(0), count(0),
+      started(false), appliedLocked(true), rolledBackNext(0), revertedCount(0) {
+    memset(entries, 0, sizeof(entries));
+    memset(appliedTx, 0, sizeof(appliedTx));
+    memset(rolledBack, 0, sizeof(rolledBack));
+    memset(rolledBackApplied, 0, sizeof(rolledBackApplied));
+    memset(reverted, 0, sizeof(reverted));
+    memset(&revertedOut, 0, sizeof(revertedOut));
+    memset(&counters, 0, sizeof(counters));
+}
+
+void ConfirmTracker::setDepth(uint32_t blocks) {
+    minDepth = blocks > 0 ? blocks : 1;
+}
+
+uint32_t ConfirmTracker::confirmations(const ConfirmEntry& e) const {
+    return tip >= e.height ? tip - e.height + 1 : 1;
+}
+
+uint32_t ConfirmTracker::checkHeight() const {
+    if (count == 0) return 0;
+    const ConfirmEntry& newest = entries[count - 1];
+    if (newest.blockHash[0] == '\0' || confirmations(newest) < settle) return newest.height;
+    return 0;
+}
+
+int ConfirmTracker::find(const char* txHash) const {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(entries[i].txHash, txHash) == 0) return (int)i;
+    }
+    return -1;
+}
+
+// Drop entries[index..] and work out what the actuator has to undo
+void ConfirmTracker::rollBackFrom(size_t index) {
+    if (index >= count) return;
+    counters.rollbacks++;
+
+    for (size_t i = index; i < count; i++) {
+        const ConfirmEntry& e = entries[i];
+        bool acted = e.state == CONFIRM_APPLIED;
+        counters.rolledBackTxs++;
+        copyHash(rolledBack[rolledBackNext], e.txHash);
+        rolledBackApplied[rolledBackNext] = acted || e.restore;
+        rolledBackNext = (rolledBackNext + 1) % CONFIRM_ROLLED_BACK;
+
+        if (!acted) continue;
+        counters.reverted++;
+        // A restore never started the pump, so there is nothing to flag
+        if (!e.isLocked && !e.restore) counters.flaggedDispenses++;
+        if (revertedCount < CONFIRM_WINDOW) reverted[revertedCount++] = e;
+    }
+    count = index;
+
+    // The applied tx is the newest acted-on one, so it went too; the
+    // actuator re-locks on the ROLLBACK decision
+    if (revertedCount > 0) {
+        appliedTx[0] = '\0';
+        appliedLocked = true;
+    }
+}
+
+void ConfirmTracker::verify(uint32_t tipHeight, uint32_t height, const char* blockHash) {
+    if (tipHeight > 0) tip = tipHeight;
+    if (height == 0) return;
+
+    // The first entry in the block that was re-read
+    size_t first = count;
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].height >= height) {
+            first = i;
+            break;
+        }
+    }
+    if (first == count || entries[first].height != height) return;
+
+    if (blockHash == nullptr) {
+        rollBackFrom(first);        // the chain is now shorter than that block
+        return;
+    }
+    for (size_t i = first; i < count && entries[i].height == height; i++) {
+        if (entries[i].blockHash[0] == '\0') {
+            copyHash(entries[i].blockHash, blockHash);
+        } else if (strcmp(entries[i].blockHash, blockHash) != 0) {
+            rollBackFrom(first);
+            return;
+        }
+    }
+}
+
+void ConfirmTracker::observe(const char* txHash, uint32_t height, uint32_t slot, bool isLocked) {
+    if (height > tip) tip = height;
+
+    int known = find(txHash);
+    if (known >= 0) {
+        // The chain's newest locker tx is an older one: the rest are gone
+        size_t before = count;
+        rollBackFrom(known + 1);
+        ConfirmEntry& e = entries[known];
+        if (e.height != height) {
+            // Same tx in a different block: rolled back and re-included
+            if (count == before) counters.rollbacks++;
+            e.height = height;
+            e.slot = slot;
+            e.blockHash[0] = '\0';
+        }
+        return;
+    }
+
+    // A new tx no higher than the newest known one replaces what was there
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].height >= height) {
+            rollBackFrom(i);
+            break;
+        }
+    }
+
+    if (count == CONFIRM_WINDOW) {
+        memmove(&entries[0], &entries[1], sizeof(ConfirmEntry) * (CONFIRM_WINDOW - 1));
+        count--;
+    }
+    ConfirmEntry& e = entries[count++];
+    memset(&e, 0, sizeof(e));
+    e.height = height;
+    e.slot = slot;
+    e.isLocked = isLocked;
+    e.state = CONFIRM_PENDING;
+    copyHash(e.txHash, txHash);
+
+    for (size_t i = 0; i < CONFIRM_ROLLED_BACK; i++) {
+        if (strcmp(rolledBack[i], txHash) == 0) {
+            counters.reincluded++;
+            e.restore = rolledBackApplied[i];
+            rolledBack[i][0] = '\0';
+            break;
+        }
+    }
+}
+
+ConfirmDecision ConfirmTracker::next() {
+    ConfirmDecision d = {CONFIRM_NONE, nullptr, 0, false, false};
+
+    if (revertedCount > 0) {
+        revertedOut = reverted[--revertedCount];
+        d.action = CONFIRM_ROLLBACK;
+        d.entry = &revertedOut;
+        d.flagged = !revertedOut.isLocked && !revertedOut.restore;
+        return d;
+    }
+
+    // The newest tx that is deep enough
+    size_t target = count;
+    for (size_t i = count; i-- > 0;) {
+        if (confirmations(entries[i]) >= minDepth) {
+            target = i;
+            break;
+        }
+    }
+    if (target == count) return d;
+
+    ConfirmEntry& e = entries[target];
+    if (strcmp(e.txHash, appliedTx) == 0) return d;
+
+    // Already acted on (a rollback fell back to it, or it was re-included),
+    // the state found at boot, or the same state as now: nothing to dispense
+    d.restore = !started || e.state == CONFIRM_APPLIED || e.restore || e.isLocked == appliedLocked;
+    if (e.state != CONFIRM_APPLIED) e.restore = d.restore;
+    e.state = CONFIRM_APPLIED;
+    for (size_t i = 0; i < target; i++) {
+        if (entries[i].state == CONFIRM_PENDING) entries[i].state = CONFIRM_SUPERSEDED;
+    }
+    copyHash(appliedTx, e.txHash);
+    appliedLocked = e.isLocked;
+    started = true;
+    counters.applied++;
+
+    d.action = CONFIRM_APPLY;
+    d.entry = &e;
+    d.confirmations = confirmations(e);
+    return d;
+}
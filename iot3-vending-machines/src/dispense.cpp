@@ -0,0 +1,88 @@
+// Dispense state machine: start conditions, volume and safety stops
+
+#include "dispense.h"
+
+const char* dispenseStopName(DispenseStop stop) {
+    switch (stop) {
+    case DISPENSE_STOP_VOLUME: return "volume";
+    case DISPENSE_STOP_CUP_REMOVED: return "cup_removed";
+    case DISPENSE_STOP_DOOR_OPEN: return "door_open";
+    case DISPENSE_STOP_NO_FLOW: return "no_flow";
+    case DISPENSE_STOP_TIMEOUT: return "timeout";
+    case DISPENSE_STOP_CANCELLED: return "cancelled";
+    default: return "none";
+    }
+}
+
+DispenseController::DispenseController(const DispenseConfig& c)
+    : config(c), current(DISPENSE_IDLE), stopReason(DISPENSE_STOP_NONE), cup(false), door(false),
+      pulseCount(0), stray(0), startUs(0), lastPulseUs(0), lastStopUs(0) {
+    // Nearest pulse, at least one
+    target = ((uint64_t)c.targetMl * c.pulsesPerLitre + 500) / 1000;
+    if (target == 0) target = 1;
+}
+
+uint32_t DispenseController::millilitres() const {
+    return config.pulsesPerLitre ? (uint64_t)pulseCount * 1000 / config.pulsesPerLitre : 0;
+}
+
+bool DispenseController::tryStart(uint32_t nowUs) {
+    if (current != DISPENSE_WAITING || door || (config.requireCup && !cup)) return false;
+    current = DISPENSE_PUMPING;
+    startUs = lastStopUs = lastPulseUs = nowUs;
+    return true;
+}
+
+bool DispenseController::stop(DispenseStop reason, uint32_t nowUs) {
+    bool wasPumping = current == DISPENSE_PUMPING;
+    current = DISPENSE_IDLE;
+    stopReason = reason;
+    if (wasPumping) lastStopUs = nowUs;
+    return wasPumping;
+}
+
+bool DispenseController::begin(uint32_t nowUs) {
+    if (current != DISPENSE_IDLE) return false;
+    current = DISPENSE_WAITING;
+    stopReason = DISPENSE_STOP_NONE;
+    pulseCount = 0;
+    startUs = lastStopUs = nowUs;
+    return tryStart(nowUs);
+}
+
+bool DispenseController::cancel(uint32_t nowUs) {
+    if (current == DISPENSE_IDLE) return false;
+    return stop(DISPENSE_STOP_CANCELLED, nowUs);
+}
+
+bool DispenseController::apply(const InputEvent& e) {
+    switch (e.kind) {
+    case INPUT_FLOW:
+        if (current != DISPENSE_PUMPING) {
+            stray++;
+            return false;
+        }
+        pulseCount++;
+        lastPulseUs = e.us;
+        return pulseCount >= target && stop(DISPENSE_STOP_VOLUME, e.us);
+    case INPUT_CUP:
+        if (cup == (e.level != 0)) return false;
+        cup = e.level != 0;
+        if (current == DISPENSE_PUMPING && !cup && config.requireCup) return stop(DISPENSE_STOP_CUP_REMOVED, e.us);
+        return tryStart(e.us);
+    case INPUT_DOOR:
+        if (door == (e.level != 0)) return false;
+        door = e.level != 0;
+        if (current == DISPENSE_PUMPING && door) return stop(DISPENSE_STOP_DOOR_OPEN, e.us);
+        return tryStart(e.us);
+    default:
+        return false;
+    }
+}
+
+bool DispenseController::tick(uint32_t nowUs) {
+    if (current != DISPENSE_PUMPING) return false;
+    if (nowUs - startUs >= config.maxMs * 1000) return stop(DISPENSE_STOP_TIMEOUT, nowUs);
+    if (nowUs - lastPulseUs >= config.noFlowMs * 1000) return stop(DISPENSE_STOP_NO_FLOW, nowUs);
+    return false;
+}
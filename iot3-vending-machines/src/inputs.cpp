@@ -0,0 +1,183 @@
+// GPIO input ISRs, actuator task, ISR -> actuation latency
+
+#include "config.h"
+#include "inputs.h"
+
+#if DISPENSE_INPUTS
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "dispense.h"
+
+enum InputCommand : uint8_t { COMMAND_BEGIN, COMMAND_CANCEL };
+
+// ISR -> task, loop -> task, task -> loop
+static SpscQueue<InputEvent, INPUT_QUEUE_EVENTS> events;
+static SpscQueue<uint8_t, 4> commands;
+static SpscQueue<DispenseReport, 8> reports;
+
+static EdgeDebouncer debouncers[INPUT_KINDS] = {
+    EdgeDebouncer(FLOW_DEBOUNCE_US), EdgeDebouncer(SWITCH_DEBOUNCE_US), EdgeDebouncer(SWITCH_DEBOUNCE_US)
+};
+static const uint8_t inputPins[INPUT_KINDS] = {FLOW_PIN, CUP_PIN, DOOR_PIN};
+static const uint8_t activeLevels[INPUT_KINDS] = {HIGH, CUP_PRESENT_LEVEL, DOOR_OPEN_LEVEL};
+static const char* const kindNames[INPUT_KINDS] = {"flow", "cup", "door"};
+
+static const DispenseConfig dispenseConfig = {
+    FLOW_PULSES_PER_L, DISPENSE_ML, DISPENSE_MAX_MS, DISPENSE_NO_FLOW_MS, DISPENSE_REQUIRE_CUP != 0
+};
+static DispenseController controller(dispenseConfig);
+static TaskHandle_t actuatorHandle = nullptr;
+
+// Edge timestamp -> pump GPIO written, for input-triggered changes
+#define ACTUATION_BUCKETS 8
+static const uint32_t actuationBounds[ACTUATION_BUCKETS] = {
+    50, 100, 250, 500, 1000, 5000, 20000, UINT32_MAX
+};
+static uint32_t actuationBuckets[ACTUATION_BUCKETS];
+static uint32_t actuationCount = 0;
+static uint64_t actuationSumUs = 0;
+static uint32_t actuationMaxUs = 0;
+static uint32_t actuationLastUs = 0;
+
+static uint32_t eventCounts[INPUT_KINDS];
+static uint32_t stopCounts[DISPENSE_STOPS];
+static uint32_t dispensedMl = 0;
+
+static void IRAM_ATTR onEdge(uint8_t kind) {
+    uint32_t now = micros();
+    if (!debouncers[kind].accept(now)) return;
+    events.push({now, kind, (uint8_t)(digitalRead(inputPins[kind]) == activeLevels[kind])});
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(actuatorHandle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void IRAM_ATTR onFlow() { onEdge(INPUT_FLOW); }
+static void IRAM_ATTR onCup() { onEdge(INPUT_CUP); }
+static void IRAM_ATTR onDoor() { onEdge(INPUT_DOOR); }
+
+static void recordActuation(uint32_t us) {
+    size_t b = 0;
+    while (us > actuationBounds[b]) b++;
+    actuationBuckets[b]++;
+    actuationCount++;
+    actuationSumUs += us;
+    actuationLastUs = us;
+    if (us > actuationMaxUs) actuationMaxUs = us;
+}
+
+// Write the pump, then tell the loop. `eventUs` is the triggering edge, 0 if none.
+static void actuate(uint32_t eventUs) {
+    bool on = controller.pumpOn();
+    digitalWrite(PUMP_PIN, on ? HIGH : LOW);
+    if (eventUs != 0) recordActuation(micros() - eventUs);
+
+    DispenseReport r = {on, !controller.busy(), controller.lastStop(), controller.pulses(),
+                        controller.millilitres(), controller.pumpedMs()};
+    if (!on) {
+        stopCounts[r.stop]++;
+        dispensedMl += r.millilitres;
+    }
+    reports.push(r);
+}
+
+// A switch whose last bounce was lost: its level once the input is quiet
+static void reconcileSwitches(uint32_t now) {
+    for (uint8_t kind = INPUT_CUP; kind < INPUT_KINDS; kind++) {
+        if (!debouncers[kind].quietFor(now)) continue;
+        bool level = digitalRead(inputPins[kind]) == activeLevels[kind];
+        bool known = kind == INPUT_CUP ? controller.cupPresent() : controller.doorOpen();
+        if (level != known && controller.apply({now, kind, (uint8_t)level})) actuate(0);
+    }
+}
+
+static void actuatorTask(void*) {
+    for (;;) {
+        // Woken by an edge or a command; ticks while a dispense is running
+        ulTaskNotifyTake(pdTRUE, controller.busy() ? pdMS_TO_TICKS(INPUT_TICK_MS) : portMAX_DELAY);
+
+        uint8_t cmd;
+        while (commands.pop(&cmd)) {
+            uint32_t now = micros();
+            bool waiting = controller.state() == DISPENSE_WAITING;
+            if (cmd == COMMAND_BEGIN) {
+                if (controller.begin(now)) actuate(0);
+            } else if (controller.cancel(now) || waiting) {
+                actuate(0);
+            }
+        }
+        InputEvent e;
+        while (events.pop(&e)) {
+            eventCounts[e.kind]++;
+            if (controller.apply(e)) actuate(e.us);
+        }
+        uint32_t now = micros();
+        reconcileSwitches(now);
+        if (controller.tick(now)) actuate(0);
+    }
+}
+
+void initInputs() {
+    pinMode(FLOW_PIN, INPUT);
+    pinMode(CUP_PIN, INPUT_PULLUP);
+    pinMode(DOOR_PIN, INPUT_PULLUP);
+    xTaskCreate(actuatorTask, "actuator", 3072, nullptr, 5, &actuatorHandle);
+    attachInterrupt(digitalPinToInterrupt(FLOW_PIN), onFlow, RISING);
+    attachInterrupt(digitalPinToInterrupt(CUP_PIN), onCup, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(DOOR_PIN), onDoor, CHANGE);
+    xTaskNotifyGive(actuatorHandle);    // read the switch levels once
+}
+
+static void sendCommand(uint8_t cmd) {
+    commands.push(cmd);
+    xTaskNotifyGive(actuatorHandle);
+}
+
+void requestDispense() {
+    sendCommand(COMMAND_BEGIN);
+}
+
+void cancelDispense() {
+    sendCommand(COMMAND_CANCEL);
+}
+
+bool nextDispenseReport(DispenseReport* out) {
+    return reports.pop(out);
+}
+
+void printInputs(Print& out) {
+    static const char* const states[] = {"idle", "waiting", "pumping"};
+    out.printf("Dispense: %s, cup %s, door %s, %u/%u pulses (%u ml)\n", states[controller.state()],
+        controller.cupPresent() ? "present" : "absent", controller.doorOpen() ? "open" : "shut",
+        controller.pulses(), controller.targetPulses(), controller.millilitres());
+}
+
+void writeInputMetrics(Print& out) {
+    for (int k = 0; k < INPUT_KINDS; k++) {
+        out.printf("input_events_total{input=\"%s\"} %u\n", kindNames[k], eventCounts[k]);
+        out.printf("input_debounce_rejects_total{input=\"%s\"} %u\n", kindNames[k], debouncers[k].rejected());
+    }
+    out.printf("input_events_dropped_total %u\n", events.dropped());
+    for (int s = DISPENSE_STOP_VOLUME; s < DISPENSE_STOPS; s++) {
+        out.printf("dispense_stops_total{reason=\"%s\"} %u\n", dispenseStopName((DispenseStop)s), stopCounts[s]);
+    }
+    out.printf("dispense_ml_total %u\n", dispensedMl);
+    out.printf("flow_stray_pulses_total %u\n", controller.strayPulses());
+
+    out.printf("# TYPE input_to_actuation_us histogram\n");
+    uint32_t cumulative = 0;
+    for (int i = 0; i < ACTUATION_BUCKETS; i++) {
+        cumulative += actuationBuckets[i];
+        if (actuationBounds[i] == UINT32_MAX) {
+            out.printf("input_to_actuation_us_bucket{le=\"+Inf\"} %u\n", cumulative);
+        } else {
+            out.printf("input_to_actuation_us_bucket{le=\"%u\"} %u\n", actuationBounds[i], cumulative);
+        }
+    }
+    out.printf("input_to_actuation_us_sum %llu\n", (unsigned long long)actuationSumUs);
+    out.printf("input_to_actuation_us_count %u\n", actuationCount);
+    out.printf("input_to_actuation_us_max %u\n", actuationMaxUs);
+    out.printf("input_to_actuation_us_last %u\n", actuationLastUs);
+}
+
+#endif
@@ -2,60 +2,551 @@
 #include <WiFi.h>
 #include "config.h"
 #include "blockfrost.h"
+#include "confirm.h"
 #include "datum_parser.h"
+#if DISPENSE_INPUTS
+#include "dispense.h"
+#include "inputs.h"
+#endif
+#include "latency.h"
+#include "logger.h"
+#include "monitor.h"
+#include "power.h"
+#include "prearm.h"
+#if PUMP_RECEIPTS
+#include "receipt.h"
+#include "receipts.h"
+#endif
+#if DEVICE_RELOCK
+#include "relock.h"
+#endif
+#include "scheduler.h"
+#include "timesync.h"
+
+#if SENSOR_SAMPLING
+#include <DHT.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "sampling.h"
+#include "sensor_uplink.h"
+#endif
 
-unsigned long lastPollTime = 0;
 unsigned long pumpOnTime = 0;
 bool pumpState = false;
 bool isLocked = false;
 
 #define PUMP_DURATION_MS 3000
+#define HEAP_LOG_INTERVAL_MS 60000
+
+// Everything the loop waits for; the idle time in between can be slept
+DeadlineScheduler scheduler(powerClock, nullptr);
+int pumpDeadline;
+int heapLogDeadline;
+
+// Chain event latency for unlocks: block_time -> pump GPIO edge (the SLO).
+// The monitor times block_time -> detection.
+LatencyTracker actuationLatency(CHAIN_LATENCY_SLO_MS);
+bool actuationPending = false;
+uint32_t pendingSlot = 0;
+uint32_t pendingChainToDetect = 0;
+unsigned long pendingDetectAt = 0;
+
+// Acts on locker txs once they are CONFIRM_DEPTHS deep, undoes rolled-back ones
+static const ConfirmDepth confirmDepths[] = CONFIRM_DEPTHS;
+ConfirmTracker confirm(
+    confirmDepthFor(ASSET_UNIT, confirmDepths, sizeof(confirmDepths) / sizeof(confirmDepths[0]), CONFIRM_DEPTH_DEFAULT),
+    CONFIRM_SETTLE_DEPTH);
+
+// Dispenses on pending unlocks when enabled; the locker address is learned
+// from the asset's UTxO
+PrearmTracker prearm(MEMPOOL_EVICT_GRACE_MS, MEMPOOL_ARM_TIMEOUT_MS);
+bool mempoolPrearm = MEMPOOL_PREARM;
+String lockerAddress;
+String prearmTx;
+
+// Each poll also fetches the block the confirmation policy re-reads and,
+// when pre-arming, the locker address's mempool
+struct PumpPoll : AssetStateResult {
+    BlockCheck check;
+    MempoolCheck mempool;
+    bool watchMempool;
+};
+
+struct PumpTransport {
+    typedef PumpPoll Result;
+
+    Result fetch();
+    uint32_t dnsRefreshInMs() { return blockfrostDnsRefreshInMs(); }
+    void refreshDns() { refreshBlockfrostDns(); }
+};
+
+// Confirmed and pre-armed locker txs drive the pump
+struct PumpActuator {
+    void onState(const PumpPoll& poll, const DatumResult& datum);
+    void onError(const PumpPoll& poll);
+};
+
+PumpTransport transport;
+LockerDecoder decoder = { 0 };      // 0=testnet
+PumpActuator actuator;
+Monitor<PumpTransport, LockerDecoder, PumpActuator, DeadlineScheduler>
+    monitor(transport, decoder, actuator, scheduler, CHAIN_LATENCY_SLO_MS);
+
+#if DISPENSE_INPUTS
+// Authorised and not yet reported done by the actuator task
+bool dispenseActive = false;
+#endif
+
+#if PUMP_RECEIPTS
+// The running dispense, for its receipt
+String dispenseTx;
+uint64_t dispenseStartMs = 0;
+int receiptDeadline;
+#endif
+
+#if DEVICE_RELOCK
+// Re-lock after a dispense, until the chain shows the locker locked
+int relockDeadline;
+#endif
+
+#if SENSOR_SAMPLING
+// The sampler task reads the DHT22 and pushes into the ring; the loop
+// drains it into windows and batches, and uploads them
+DHT dht(SENSOR_PIN, DHT22);
+SensorSample sampleStorage[SENSOR_RING_SAMPLES];
+SampleRing samples(sampleStorage, SENSOR_RING_SAMPLES);
+volatile uint32_t sensorReadErrors = 0;
+int sampleDeadline;
+int uploadDeadline;
+
+WindowAggregator sensorWindows(SENSOR_WINDOW_MS);
+SensorWindow batchWindows[SENSOR_BATCH_WINDOWS];
+size_t batchCount = 0;
+uint32_t windowsClosed = 0;
+uint32_t batchesEncoded = 0;
+uint32_t batchBytes = 0;
+uint32_t batchedSamples = 0;
+
+WiFiClient sensorClient;
+uint8_t uplinkStorage[SENSOR_QUEUE_BATCHES][SENSOR_BATCH_BYTES];
+SensorUplink uplink(sensorClient, SENSOR_BACKEND_HOST, SENSOR_BACKEND_PORT, SENSOR_BACKEND_PATH,
+                    &uplinkStorage[0][0], SENSOR_BATCH_BYTES, SENSOR_QUEUE_BATCHES);
+
+// On its own period, so a slow poll or upload does not delay readings
+void samplerTask(void*) {
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        float t = dht.readTemperature();
+        float h = dht.readHumidity();       // same reading, cached by the library
+        if (isnan(t) || isnan(h)) {
+            sensorReadErrors = sensorReadErrors + 1;
+        } else {
+            samples.push({(uint32_t)millis(), (int32_t)lroundf(t * 1000), (int32_t)lroundf(h * 1000)});
+        }
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(SENSOR_SAMPLE_MS));
+    }
+}
+
+// Encode the collected windows (as many as fit) and queue them for upload
+void closeSensorBatch() {
+    SensorBatchHeader header = {};
+    strncpy(header.name, SENSOR_NAME, sizeof(header.name) - 1);
+    header.windowMs = SENSOR_WINDOW_MS;
+    header.step = SENSOR_STEP;
+    if (timeSynced()) header.startUnixMs = wallClockMs() - (millis() - batchWindows[0].startMs);
+
+    uint8_t buf[SENSOR_BATCH_BYTES];
+    size_t encoded;
+    size_t len = encodeSensorBatch(header, batchWindows, batchCount, buf, sizeof(buf), &encoded);
+    if (len == 0) {
+        LOG_ERROR("[sensor] window does not fit in %u bytes, dropped", SENSOR_BATCH_BYTES);
+        encoded = 1;
+    } else {
+        uint32_t covered = 0;
+        for (size_t i = 0; i < encoded; i++) covered += batchWindows[i].count;
+        uplink.queue(buf, len);
+        batchesEncoded++;
+        batchBytes += len;
+        batchedSamples += covered;
+        LOG_INFO("[sensor] batch windows=%u samples=%u bytes=%u queued=%u",
+            (unsigned)encoded, covered, (unsigned)len, (unsigned)uplink.pending());
+        scheduler.arm(uploadDeadline, 0);
+    }
+    batchCount -= encoded;
+    memmove(batchWindows, batchWindows + encoded, batchCount * sizeof(batchWindows[0]));
+}
+
+// Fold the samples taken since the last call into windows
+void serviceSensor() {
+    SensorSample s;
+    while (samples.pop(&s)) {
+        if (!sensorWindows.add(s, &batchWindows[batchCount])) continue;
+        windowsClosed++;
+        if (++batchCount == SENSOR_BATCH_WINDOWS) closeSensorBatch();
+    }
+}
+
+void uploadSensorBatches() {
+    size_t acked = uplink.flush();
+    if (uplink.pending() > 0) {
+        LOG_WARN("[sensor] upload: %u acknowledged, %u pending, retry in %ums",
+            (unsigned)acked, (unsigned)uplink.pending(), SENSOR_RETRY_MS);
+        scheduler.arm(uploadDeadline, SENSOR_RETRY_MS);
+    } else {
+        scheduler.disarm(uploadDeadline);
+    }
+}
+
+void printSensorMetrics() {
+    const UplinkStats& u = uplink.stats();
+    Serial.printf("sensor_samples_total %u\n", samples.pushed());
+    Serial.printf("sensor_samples_dropped_total %u\n", samples.dropped());
+    Serial.printf("sensor_read_errors_total %u\n", sensorReadErrors);
+    Serial.printf("sensor_windows_total %u\n", windowsClosed);
+    Serial.printf("sensor_batches_total %u\n", batchesEncoded);
+    Serial.printf("sensor_batch_bytes_total %u\n", batchBytes);
+    Serial.printf("sensor_bytes_per_sample %.3f\n", batchedSamples ? (double)batchBytes / batchedSamples : 0.0);
+    // One write per batch instead of one per sample
+    Serial.printf("sensor_writes_saved_total %u\n", batchedSamples - batchesEncoded);
+    Serial.printf("sensor_uploads_total{result=\"ok\"} %u\n", u.uploaded);
+    Serial.printf("sensor_uploads_total{result=\"rejected\"} %u\n", u.rejected);
+    Serial.printf("sensor_uploads_total{result=\"retried\"} %u\n", u.retried);
+    Serial.printf("sensor_upload_failures_total %u\n", u.failures);
+    Serial.printf("sensor_batches_dropped_total %u\n", u.dropped);
+    Serial.printf("sensor_batches_pending %u\n", (unsigned)uplink.pending());
+    Serial.printf("sensor_upload_connects_total %u\n", u.connects);
+}
+#endif
+
+// Called right after the pump output goes high
+void onPumpEdge() {
+#if PUMP_RECEIPTS
+    dispenseStartMs = timeSynced() ? wallClockMs() : 0;
+#endif
+    if (!actuationPending) return;
+    actuationPending = false;
+
+    uint32_t detectToEdge = millis() - pendingDetectAt;
+    uint32_t total = pendingChainToDetect + detectToEdge;
+    actuationLatency.record(total);
+
+    LatencySummary s = actuationLatency.summary();
+    LOG_INFO("[latency] slot=%u block->detect=%ums detect->gpio=%ums total=%ums%s "
+        "p50=%u p95=%u p99=%u breaches=%u",
+        pendingSlot, pendingChainToDetect, detectToEdge, total,
+        total > CHAIN_LATENCY_SLO_MS ? " SLO BREACH" : "",
+        s.p50, s.p95, s.p99, actuationLatency.breaches());
+}
+
+// Called right after the pump output goes low
+void onPumpStop() {
+#if PUMP_RECEIPTS
+    uint64_t end = timeSynced() ? wallClockMs() : 0;
+    if (!recordReceipt(ASSET_UNIT, dispenseTx.c_str(), dispenseStartMs, end)) {
+        LOG_ERROR("[receipts] dispense tx=%s not receipted", dispenseTx.c_str());
+    } else if (pendingReceipts() >= RECEIPT_BATCH_MAX) {
+        scheduler.arm(receiptDeadline, 0);
+    }
+#endif
+#if DEVICE_RELOCK
+    // Not after a re-lock the chain already made
+    if (!isLocked) scheduler.arm(relockDeadline, 0);
+#endif
+}
 
 void updatePump() {
+#if DISPENSE_INPUTS
+    // The actuator task drives the pump from the inputs; follow it
+    if (isLocked && dispenseActive) {
+        cancelDispense();
+        dispenseActive = false;
+    }
+    DispenseReport r;
+    while (nextDispenseReport(&r)) {
+        if (r.pumpOn && !pumpState) {
+            pumpState = true;
+            onPumpEdge();
+        } else if (!r.pumpOn && pumpState) {
+            pumpState = false;
+            LOG_INFO("[dispense] stop=%s pulses=%u ml=%u pumped=%ums",
+                dispenseStopName((DispenseStop)r.stop), r.pulses, r.millilitres, r.pumpedMs);
+            onPumpStop();
+        }
+        if (r.done) dispenseActive = false;
+    }
+    // No light sleep while the task may be acting on inputs
+    if (dispenseActive) scheduler.arm(pumpDeadline, INPUT_TICK_MS);
+    return;
+#endif
     if (isLocked) {
         if (pumpState) {
             pumpState = false;
             digitalWrite(PUMP_PIN, LOW);
+            onPumpStop();
         }
     } else {
         if (pumpOnTime > 0 && millis() - pumpOnTime < PUMP_DURATION_MS) {
             if (!pumpState) {
                 pumpState = true;
                 digitalWrite(PUMP_PIN, HIGH);
+                onPumpEdge();
             }
         } else {
             if (pumpState) {
                 pumpState = false;
                 digitalWrite(PUMP_PIN, LOW);
+                onPumpStop();
             }
         }
     }
 }
 
-// Check asset state following monitor.ts approach
-void checkAssetState() {
-    AssetStateResult state = fetchAssetState(ASSET_UNIT);
+// Authorise one dispense
+void unlockPump() {
+    pumpOnTime = millis();
+#if DISPENSE_INPUTS
+    requestDispense();
+    dispenseActive = true;
+    scheduler.arm(pumpDeadline, INPUT_TICK_MS);
+#else
+    scheduler.arm(pumpDeadline, PUMP_DURATION_MS);
+#endif
+}
+
+// Stop the pump and re-lock
+void relock() {
+    isLocked = true;
+    pumpOnTime = 0;
+    actuationPending = false;
+    scheduler.disarm(pumpDeadline);
+    updatePump();
+}
 
-    if (!state.success) {
-        Serial.printf("Asset state error: %s\n", state.error.c_str());
+// Act on what the confirmation policy decided this poll
+void applyConfirmed() {
+    ConfirmDecision d;
+    while ((d = confirm.next()).action != CONFIRM_NONE) {
+        const ConfirmEntry& e = *d.entry;
+
+        if (d.action == CONFIRM_ROLLBACK) {
+            // Compensate: re-lock, and flag a dispense the chain no longer backs
+            LOG_WARN("[confirm] ROLLBACK tx=%s height=%u %s%s",
+                e.txHash, e.height, e.isLocked ? "LOCKED" : "UNLOCKED",
+                d.flagged ? " DISPENSE FLAGGED" : "");
+            relock();
+            continue;
+        }
+
+        LOG_INFO("[confirm] apply tx=%s height=%u depth=%u/%u %s%s",
+            e.txHash, e.height, d.confirmations, confirm.depth(),
+            e.isLocked ? "LOCKED" : "UNLOCKED", d.restore ? " (restore)" : "");
+        if (isLocked == e.isLocked) continue;
+
+        isLocked = e.isLocked;
+        if (!isLocked && !d.restore) {
+            uint32_t chainToDecide = 0;
+            unlockPump();
+            actuationPending = sinceBlock(e.slot + CHAIN_SLOT_ZERO_TIME, &chainToDecide);
+            pendingSlot = e.slot;
+            pendingChainToDetect = chainToDecide;
+            pendingDetectAt = millis();
+#if PUMP_RECEIPTS
+            dispenseTx = e.txHash;
+#endif
+        }
+        LOG_INFO(">>> State changed: %s", isLocked ? "LOCKED" : "UNLOCKED");
+    }
+}
+
+void resolvePrearm(PrearmOutcome outcome) {
+    if (outcome == PREARM_NONE) return;
+    if (outcome == PREARM_COMMIT) {
+        // The confirmed APPLY finds the pump already unlocked: no second dispense
+        LOG_INFO("[mempool] COMMIT tx=%s saved=%ums", prearmTx.c_str(), prearm.lastSavedMs());
+    } else {
+        const char* reason = outcome == PREARM_ABORT_EVICTED ? "evicted"
+            : outcome == PREARM_ABORT_CONFLICT ? "conflict" : "timeout";
+        LOG_WARN("[mempool] ABORT tx=%s %s DISPENSE FLAGGED", prearmTx.c_str(), reason);
+        relock();
+    }
+    prearmTx = "";
+}
+
+// Pre-arm on a pending unlock of the locker UTxO the actuator reflects
+void checkMempool(const AssetStateResult& state, const MempoolCheck& mempool) {
+    unsigned long now = millis();
+    if (!mempool.success) {
+        LOG_WARN("Mempool error: %s", mempool.error.c_str());
         return;
     }
+    // Only from the applied state, so a deeper confirmation cannot overtake it
+    bool inSync = state.txHash == confirm.appliedHash();
+    for (size_t i = 0; i < mempool.count && i < MEMPOOL_MAX_TXS; i++) {
+        const MempoolTx& tx = mempool.txs[i];
+        if (tx.spends != state.txHash || tx.spendsIndex != state.outputIndex) continue;
+        if (tx.txHash != prearm.armedHash()) {
+            if (!isLocked || !inSync) continue;
+            DatumResult datum = parseDatum(tx.inlineDatum, 0);
+            if (!datum.success || datum.isLocked) continue;
+        }
+        if (!prearm.offer(tx.txHash.c_str(), tx.spends.c_str(), now)) continue;
 
-    DatumResult datum = parseDatum(state.inlineDatum, 0); // 0=testnet
+        LOG_INFO("[mempool] ARM tx=%s spends=%s UNLOCKED", tx.txHash.c_str(), tx.spends.c_str());
+        prearmTx = tx.txHash;
+#if PUMP_RECEIPTS
+        dispenseTx = tx.txHash;
+#endif
+        isLocked = false;
+        unlockPump();
+        actuationPending = false;   // ahead of its block: not a block -> edge sample
+        LOG_INFO(">>> State changed: UNLOCKED (pending)");
+    }
+    resolvePrearm(prearm.expire(now));
+}
+
+PumpPoll PumpTransport::fetch() {
+    PumpPoll poll;
+    poll.check.height = confirm.checkHeight();
+    poll.mempool.address = lockerAddress;
+    poll.watchMempool = mempoolPrearm && lockerAddress.length() > 0;
+    static_cast<AssetStateResult&>(poll) =
+        fetchAssetState(ASSET_UNIT, &poll.check, poll.watchMempool ? &poll.mempool : nullptr);
+    return poll;
+}
+
+// Rollbacks first, so a new tx is compared against the surviving window
+void verifyChain(const BlockCheck& check) {
+    if (check.success) {
+        confirm.verify(check.tipHeight, check.height, check.found ? check.hash.c_str() : nullptr);
+    } else {
+        LOG_WARN("Block check error: %s", check.error.c_str());
+    }
+}
+
+void PumpActuator::onError(const PumpPoll& poll) {
+    verifyChain(poll.check);
+    applyConfirmed();
+}
+
+void PumpActuator::onState(const PumpPoll& poll, const DatumResult& datum) {
+    verifyChain(poll.check);
+    if (poll.address.length() > 0) lockerAddress = poll.address;
 
     if (datum.success) {
-        if (isLocked != datum.isLocked) {
-            isLocked = datum.isLocked;
-            if (!isLocked) {
-                pumpOnTime = millis();
-            }
-            Serial.printf(">>> State changed: %s\n", isLocked ? "LOCKED" : "UNLOCKED");
-        }
-        Serial.printf("Authority: %s | Locked: %s\n",
-            datum.authorityAddress.c_str(),
-            datum.isLocked ? "true" : "false");
+        confirm.observe(poll.txHash.c_str(), poll.blockHeight, poll.slot, datum.isLocked);
+        logState(datum, 0);
     } else {
-        Serial.printf("Datum error: %s\n", datum.error.c_str());
+        LOG_WARN("Datum error: %s", datum.error.c_str());
+    }
+    // Settle an armed unlock before confirmed txs act: a conflicting tx must
+    // find the pump re-locked
+    resolvePrearm(prearm.confirmed(poll.txHash.c_str(), millis()));
+    applyConfirmed();
+    if (poll.watchMempool) checkMempool(poll, poll.mempool);
+}
+
+// Metrics in Prometheus text format
+void printMetrics() {
+    monitor.detectLatency().writeMetrics(Serial, "chain_to_detection_ms");
+    actuationLatency.writeMetrics(Serial, "chain_to_actuation_ms");
+    Serial.printf("clock_synced %d\n", timeSynced() ? 1 : 0);
+    writeBlockfrostMetrics(Serial);
+    writeLoggerMetrics(Serial);
+
+    const ConfirmStats& c = confirm.stats();
+    Serial.printf("confirm_depth %u\n", confirm.depth());
+    Serial.printf("chain_tip_height %u\n", confirm.tipHeight());
+    Serial.printf("chain_rollbacks_total %u\n", c.rollbacks);
+    Serial.printf("chain_rolled_back_txs_total %u\n", c.rolledBackTxs);
+    Serial.printf("chain_reverted_actions_total %u\n", c.reverted);
+    Serial.printf("chain_flagged_dispenses_total %u\n", c.flaggedDispenses);
+
+    const PrearmStats& p = prearm.stats();
+    uint32_t aborts = p.evicted + p.conflicts + p.timeouts;
+    Serial.printf("mempool_prearm_enabled %d\n", mempoolPrearm ? 1 : 0);
+    Serial.printf("mempool_prearms_total %u\n", p.armed);
+    Serial.printf("mempool_prearm_commits_total %u\n", p.committed);
+    Serial.printf("mempool_prearm_aborts_total{reason=\"evicted\"} %u\n", p.evicted);
+    Serial.printf("mempool_prearm_aborts_total{reason=\"conflict\"} %u\n", p.conflicts);
+    Serial.printf("mempool_prearm_aborts_total{reason=\"timeout\"} %u\n", p.timeouts);
+    Serial.printf("mempool_prearm_saved_ms_sum %llu\n", (unsigned long long)p.savedMsSum);
+    Serial.printf("mempool_prearm_saved_ms_max %u\n", p.savedMsMax);
+    Serial.printf("mempool_prearm_false_positive_ratio %.4f\n",
+        p.committed + aborts ? (double)aborts / (p.committed + aborts) : 0.0);
+#if SENSOR_SAMPLING
+    printSensorMetrics();
+#endif
+#if DISPENSE_INPUTS
+    writeInputMetrics(Serial);
+#endif
+#if PUMP_RECEIPTS
+    writeReceiptMetrics(Serial);
+#endif
+#if DEVICE_RELOCK
+    writeRelockMetrics(Serial);
+#endif
+}
+
+// Serial console:
+//   "gzip on" / "gzip off"    switch response compression
+//   "sleep on" / "sleep off"  switch low-power mode
+//   "metrics"                 print latency, API, confirmation, mempool, log and sensor metrics
+//   "depth N"                 act on locker txs N blocks deep
+//   "mempool on|off"          pre-arm on pending unlocks
+//   "log binary|text"         log as telemetry frames or as text lines
+//   "inputs"                  dispense state, cup and door, flow pulses
+//   "receipts"                device public key and pending receipts
+//   "receipts bench"          time Ed25519 signing
+//   "relock"                  device key hash and the locker's authority
+//   "relock now"              build, sign and submit a re-lock
+//   "relock bench"            time building and signing the re-lock tx
+void handleSerialCommand() {
+    if (!Serial.available()) return;
+
+    String cmd = Serial.readStringUntil('\n');
+    cmd.trim();
+    if (cmd == "gzip on" || cmd == "gzip off") {
+        setBlockfrostCompression(cmd == "gzip on");
+        Serial.printf("Compression: %s\n", blockfrostCompression() ? "on" : "off");
+    } else if (cmd == "sleep on" || cmd == "sleep off") {
+        setLowPower(cmd == "sleep on");
+        Serial.printf("Low-power mode: %s\n", lowPower() ? "on" : "off");
+    } else if (cmd == "metrics") {
+        printMetrics();
+    } else if (cmd.startsWith("depth ")) {
+        confirm.setDepth(cmd.substring(6).toInt());
+        Serial.printf("Confirmation depth: %u\n", confirm.depth());
+    } else if (cmd == "mempool on" || cmd == "mempool off") {
+        mempoolPrearm = cmd == "mempool on";
+        Serial.printf("Mempool pre-arm: %s\n", mempoolPrearm ? "on" : "off");
+    } else if (cmd == "log binary" || cmd == "log text") {
+        setLogBinary(cmd == "log binary");
+        Serial.printf("Log output: %s\n", logBinary() ? "binary" : "text");
+#if DISPENSE_INPUTS
+    } else if (cmd == "inputs") {
+        printInputs(Serial);
+#endif
+#if PUMP_RECEIPTS
+    } else if (cmd == "receipts") {
+        Serial.print("Receipt key: ");
+        for (int i = 0; i < RECEIPT_KEY_LEN; i++) Serial.printf("%02x", receiptPublicKey()[i]);
+        Serial.printf("\nPending receipts: %u\n", pendingReceipts());
+    } else if (cmd == "receipts bench") {
+        Serial.printf("Ed25519 sign: %u us\n", benchReceiptSign(20));
+#endif
+#if DEVICE_RELOCK
+    } else if (cmd == "relock") {
+        printRelock(Serial);
+    } else if (cmd == "relock now") {
+        scheduler.arm(relockDeadline, 0);
+    } else if (cmd == "relock bench") {
+        uint32_t buildUs, signUs;
+        if (benchRelock(20, &buildUs, &signUs)) {
+            Serial.printf("Re-lock tx: build %u us, sign %u us\n", buildUs, signUs);
+        } else {
+            Serial.println("Re-lock bench: parameters or script not readable");
+        }
+#endif
     }
 }
 
@@ -65,6 +556,9 @@ void setup() {
 
     pinMode(PUMP_PIN, OUTPUT);
     digitalWrite(PUMP_PIN, LOW);
+#if DISPENSE_INPUTS
+    initInputs();
+#endif
 
     Serial.println("\n\n=== ESP32 Cardano Pump Controller ===");
     Serial.println("=====================================\n");
@@ -76,32 +570,87 @@ void setup() {
         Serial.print(".");
     }
     Serial.println("\nWiFi OK!");
+    initLogger();
+
+    monitor.begin(POLL_INTERVAL_MS);
+    pumpDeadline = scheduler.add("pump", 0);
+    heapLogDeadline = scheduler.add("heap", HEAP_LOG_INTERVAL_MS);
+#if SENSOR_SAMPLING
+    // Also keeps light sleep from outlasting a sample period
+    sampleDeadline = scheduler.add("sample", SENSOR_SAMPLE_MS);
+    uploadDeadline = scheduler.add("upload", 0);
+    dht.begin();
+    xTaskCreate(samplerTask, "sampler", 3072, nullptr, 2, nullptr);
+#endif
 
+    initTimeSync();
     initBlockfrost();
-    checkAssetState();
-    lastPollTime = millis();
+    initPower();
+#if PUMP_RECEIPTS
+    receiptDeadline = scheduler.add("receipts", RECEIPT_UPLOAD_MS);
+    initReceipts();
+#endif
+#if DEVICE_RELOCK
+    relockDeadline = scheduler.add("relock", 0);
+    initRelock();
+#endif
+    monitor.start();
 }
 
 void loop() {
+    handleSerialCommand();
+
     if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("WiFi lost, reconnecting...");
+        LOG_WARN("WiFi lost, reconnecting...");
         WiFi.reconnect();
         delay(5000);
         return;
     }
 
-    if (millis() - lastPollTime >= POLL_INTERVAL_MS) {
-        checkAssetState();
-        lastPollTime = millis();
-    }
+    monitor.service();
 
+    // The pump deadline only exists to wake us for the cutoff
+    if (scheduler.due(pumpDeadline)) scheduler.disarm(pumpDeadline);
     updatePump();
 
-    static unsigned long lastHeapLog = 0;
-    if (millis() - lastHeapLog >= 60000) {
-        Serial.printf("[heap] %u bytes free\n", ESP.getFreeHeap());
-        lastHeapLog = millis();
+#if SENSOR_SAMPLING
+    if (scheduler.due(sampleDeadline)) {
+        serviceSensor();
+        scheduler.rearm(sampleDeadline);
+    }
+    if (scheduler.due(uploadDeadline)) uploadSensorBatches();
+#endif
+
+#if PUMP_RECEIPTS
+    if (scheduler.due(receiptDeadline)) {
+        // A full batch left after a good upload goes straight away
+        if (uploadReceipts() > 0 && pendingReceipts() >= RECEIPT_BATCH_MAX) {
+            scheduler.arm(receiptDeadline, 0);
+        } else {
+            scheduler.rearm(receiptDeadline);
+        }
+    }
+#endif
+
+#if DEVICE_RELOCK
+    if (scheduler.due(relockDeadline)) {
+        // A submitted tx is on chain or dead once its TTL has passed
+        String tx;
+        if (isLocked) {
+            scheduler.disarm(relockDeadline);
+        } else if (lockerAddress.length() > 0 && submitRelock(lockerAddress, &tx)) {
+            scheduler.arm(relockDeadline, RELOCK_TTL_S * 1000UL);
+        } else {
+            scheduler.arm(relockDeadline, RELOCK_RETRY_MS);
+        }
+    }
+#endif
+
+    if (scheduler.due(heapLogDeadline)) {
+        LOG_DEBUG("[heap] %u bytes free", ESP.getFreeHeap());
+        scheduler.rearm(heapLogDeadline);
     }
 
-    delay(10);
+    serviceLogger();
+    powerIdle(scheduler.msUntilNext());
 }
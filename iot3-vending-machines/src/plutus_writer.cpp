@@ -0,0 +1,84 @@
+// Plutus data CBOR writer
+
+#include "plutus_writer.h"
+#include <string.h>
+
+#define MAJOR_UINT 0
+#define MAJOR_NEGINT 1
+#define MAJOR_BYTES 2
+#define MAJOR_TAG 6
+
+// Longer byte strings are split into chunks of this size (ledger limit)
+#define BYTES_CHUNK 64
+
+PlutusWriter::PlutusWriter(uint8_t* b, size_t c) : buf(b), cap(c), pos(0), overflow(false) {}
+
+void PlutusWriter::truncate(size_t len) {
+    if (len < pos) pos = len;
+    overflow = false;
+}
+
+// Initial byte and argument in the shortest form
+void PlutusWriter::head(uint8_t major, uint64_t arg) {
+    uint8_t mt = major << 5;
+    if (arg < 24) {
+        byte(mt | arg);
+        return;
+    }
+    int n = arg <= 0xff ? 1 : arg <= 0xffff ? 2 : arg <= 0xffffffffull ? 4 : 8;
+    byte(mt | (n == 1 ? 24 : n == 2 ? 25 : n == 4 ? 26 : 27));
+    for (int i = n - 1; i >= 0; i--) byte(arg >> (8 * i));
+}
+
+void PlutusWriter::raw(const uint8_t* data, size_t len) {
+    if (cap - pos < len) {
+        overflow = true;
+        pos = cap;
+        return;
+    }
+    memcpy(buf + pos, data, len);
+    pos += len;
+}
+
+void PlutusWriter::constr(uint32_t index) {
+    if (index < 7) {
+        head(MAJOR_TAG, 121 + index);
+    } else if (index < 128) {
+        head(MAJOR_TAG, 1280 + index - 7);
+    } else {
+        // General form: 102([index, fields]); the caller's field list
+        // follows the index
+        head(MAJOR_TAG, 102);
+        byte(0x82);
+        head(MAJOR_UINT, index);
+    }
+}
+
+void PlutusWriter::bytes(const uint8_t* data, size_t len) {
+    if (len <= BYTES_CHUNK) {
+        head(MAJOR_BYTES, len);
+        raw(data, len);
+        return;
+    }
+    byte(0x5f);
+    for (size_t off = 0; off < len; off += BYTES_CHUNK) {
+        size_t n = len - off < BYTES_CHUNK ? len - off : BYTES_CHUNK;
+        head(MAJOR_BYTES, n);
+        raw(data + off, n);
+    }
+    byte(0xff);
+}
+
+void PlutusWriter::byteString(const uint8_t* data, size_t len) {
+    head(MAJOR_BYTES, len);
+    raw(data, len);
+}
+
+void PlutusWriter::integer(int64_t value) {
+    if (value >= 0) {
+        head(MAJOR_UINT, value);
+    } else {
+        // -1 - value without overflowing at INT64_MIN
+        head(MAJOR_NEGINT, ~(uint64_t)value);
+    }
+}
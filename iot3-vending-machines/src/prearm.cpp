@@ -0,0 +1,72 @@
+// Mempool pre-arm: commit on confirmation, abort on eviction or conflict
+
+#include "prearm.h"
+#include <string.h>
+
+static void copyHash(char* dst, const char* src) {
+    strncpy(dst, src, PREARM_HASH_LEN);
+    dst[PREARM_HASH_LEN] = '\0';
+}
+
+PrearmTracker::PrearmTracker(uint32_t evictGraceMs, uint32_t timeoutMs)
+    : grace(evictGraceMs), timeout(timeoutMs), armedAt(0), lastSeen(0), lastSaved(0) {
+    memset(chainTx, 0, sizeof(chainTx));
+    memset(armedTx, 0, sizeof(armedTx));
+    memset(armedSpends, 0, sizeof(armedSpends));
+    memset(&counters, 0, sizeof(counters));
+}
+
+void PrearmTracker::disarm() {
+    armedTx[0] = '\0';
+    armedSpends[0] = '\0';
+}
+
+PrearmOutcome PrearmTracker::confirmed(const char* txHash, uint32_t nowMs) {
+    copyHash(chainTx, txHash);
+    if (!armed()) return PREARM_NONE;
+
+    if (strcmp(txHash, armedTx) == 0) {
+        lastSaved = nowMs - armedAt;
+        counters.committed++;
+        counters.savedMsSum += lastSaved;
+        if (lastSaved > counters.savedMsMax) counters.savedMsMax = lastSaved;
+        disarm();
+        return PREARM_COMMIT;
+    }
+    if (strcmp(txHash, armedSpends) != 0) {
+        counters.conflicts++;
+        disarm();
+        return PREARM_ABORT_CONFLICT;
+    }
+    return PREARM_NONE;
+}
+
+bool PrearmTracker::offer(const char* txHash, const char* spends, uint32_t nowMs) {
+    if (armed()) {
+        if (strcmp(txHash, armedTx) == 0) lastSeen = nowMs;
+        return false;
+    }
+    if (chainTx[0] == '\0' || strcmp(spends, chainTx) != 0) return false;
+
+    copyHash(armedTx, txHash);
+    copyHash(armedSpends, spends);
+    armedAt = nowMs;
+    lastSeen = nowMs;
+    counters.armed++;
+    return true;
+}
+
+PrearmOutcome PrearmTracker::expire(uint32_t nowMs) {
+    if (!armed()) return PREARM_NONE;
+    if (nowMs - lastSeen > grace) {
+        counters.evicted++;
+        disarm();
+        return PREARM_ABORT_EVICTED;
+    }
+    if (nowMs - armedAt > timeout) {
+        counters.timeouts++;
+        disarm();
+        return PREARM_ABORT_TIMEOUT;
+    }
+    return PREARM_NONE;
+}
@@ -0,0 +1,107 @@
+// Dispense receipt layout and batch framing
+
+#include "receipt.h"
+#include <string.h>
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Whole string as bytes; returns the byte count, or -1
+static int hexDecode(const char* hex, uint8_t* out, size_t max) {
+    size_t len = strlen(hex);
+    if (len % 2 != 0 || len / 2 > max) return -1;
+    for (size_t i = 0; i < len / 2; i++) {
+        int hi = hexNibble(hex[2 * i]);
+        int lo = hexNibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        out[i] = (hi << 4) | lo;
+    }
+    return len / 2;
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = v >> (8 * i);
+}
+
+static void putU64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = v >> (8 * i);
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t getU64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+bool receiptFromHex(const char* unitHex, const char* txHashHex, uint32_t seq,
+                    uint64_t startUnixMs, uint64_t endUnixMs, PumpReceipt* out) {
+    memset(out, 0, sizeof(*out));
+    int unitLen = hexDecode(unitHex, out->unit, RECEIPT_UNIT_MAX);
+    if (unitLen < 28) return false;     // at least a policy ID
+    if (hexDecode(txHashHex, out->txHash, RECEIPT_TX_HASH_LEN) != RECEIPT_TX_HASH_LEN) return false;
+    out->unitLen = unitLen;
+    out->seq = seq;
+    out->startUnixMs = startUnixMs;
+    out->endUnixMs = endUnixMs;
+    return true;
+}
+
+void receiptPackBody(uint8_t* out, const PumpReceipt& r) {
+    uint8_t* p = out;
+    *p++ = RECEIPT_VERSION;
+    putU32(p, r.seq);
+    p += 4;
+    *p++ = r.unitLen;
+    memset(p, 0, RECEIPT_UNIT_MAX);
+    memcpy(p, r.unit, r.unitLen <= RECEIPT_UNIT_MAX ? r.unitLen : RECEIPT_UNIT_MAX);
+    p += RECEIPT_UNIT_MAX;
+    memcpy(p, r.txHash, RECEIPT_TX_HASH_LEN);
+    p += RECEIPT_TX_HASH_LEN;
+    putU64(p, r.startUnixMs);
+    p += 8;
+    putU64(p, r.endUnixMs);
+}
+
+bool receiptUnpackBody(const uint8_t* body, PumpReceipt* r) {
+    if (body[0] != RECEIPT_VERSION || body[5] > RECEIPT_UNIT_MAX) return false;
+    const uint8_t* p = body + 1;
+    r->seq = getU32(p);
+    p += 4;
+    r->unitLen = *p++;
+    memcpy(r->unit, p, RECEIPT_UNIT_MAX);
+    p += RECEIPT_UNIT_MAX;
+    memcpy(r->txHash, p, RECEIPT_TX_HASH_LEN);
+    p += RECEIPT_TX_HASH_LEN;
+    r->startUnixMs = getU64(p);
+    r->endUnixMs = getU64(p + 8);
+    return true;
+}
+
+void receiptMessage(uint8_t* out, const uint8_t* body) {
+    memcpy(out, RECEIPT_CONTEXT, RECEIPT_CONTEXT_LEN);
+    memcpy(out + RECEIPT_CONTEXT_LEN, body, RECEIPT_BODY_LEN);
+}
+
+void receiptPackBatchHeader(uint8_t* out, const uint8_t* publicKey, uint16_t count) {
+    memcpy(out, RECEIPT_BATCH_MAGIC, 4);
+    memcpy(out + 4, publicKey, RECEIPT_KEY_LEN);
+    out[4 + RECEIPT_KEY_LEN] = count;
+    out[5 + RECEIPT_KEY_LEN] = count >> 8;
+}
+
+bool receiptParseBatch(const uint8_t* data, size_t len, uint8_t* publicKey, uint16_t* count) {
+    if (len < RECEIPT_BATCH_HEADER_LEN || memcmp(data, RECEIPT_BATCH_MAGIC, 4) != 0) return false;
+    memcpy(publicKey, data + 4, RECEIPT_KEY_LEN);
+    *count = data[4 + RECEIPT_KEY_LEN] | (data[5 + RECEIPT_KEY_LEN] << 8);
+    return len == RECEIPT_BATCH_HEADER_LEN + (size_t)*count * RECEIPT_RECORD_LEN;
+}
@@ -0,0 +1,334 @@
+// Signed dispense receipts: device key, LittleFS queue, batch upload
+
+#include "config.h"
+#include "receipts.h"
+
+#if PUMP_RECEIPTS
+#include <Ed25519.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <esp_system.h>
+#include <vector>
+#include "http_stream.h"
+#include "logger.h"
+#include "receipt.h"
+
+// Records per segment file. A segment is deleted once all of it has been
+// acknowledged, so flash use follows the pending count.
+#define SEGMENT_RECORDS 64
+#define RECEIPT_DIR "/receipts"
+// Records read from flash per socket write
+#define UPLOAD_CHUNK_RECORDS 4
+
+static Preferences prefs;
+static bool ready = false;
+static bool appendBroken = false;   // a segment could not be trimmed
+static uint8_t privateKey[32];
+static uint8_t publicKey[RECEIPT_KEY_LEN];
+static uint32_t nextSeq = 0;        // sequence number of the next receipt
+static uint32_t ackedSeq = 0;       // receipts below this are acknowledged
+static ReceiptStats counters;
+
+static String segmentPath(uint32_t segment) {
+    return String(RECEIPT_DIR "/") + segment + ".bin";
+}
+
+// Keep the whole records of a segment cut short mid-write. The segment is
+// only replaced once the copy is complete, by a rename that LittleFS does
+// atomically; false leaves it as it was.
+static bool trimSegment(const String& path, size_t size) {
+    size_t keep = size / RECEIPT_RECORD_LEN * RECEIPT_RECORD_LEN;
+    String tmp = path + ".tmp";
+    File in = LittleFS.open(path, FILE_READ);
+    File out = LittleFS.open(tmp, FILE_WRITE);
+    bool copied = in && out;
+    uint8_t buf[RECEIPT_RECORD_LEN];
+    for (size_t done = 0; copied && done < keep; done += sizeof(buf)) {
+        copied = in.read(buf, sizeof(buf)) == sizeof(buf) && out.write(buf, sizeof(buf)) == sizeof(buf);
+    }
+    in.close();
+    out.close();
+    if (!copied) {
+        LittleFS.remove(tmp);
+        return false;
+    }
+    return LittleFS.rename(tmp, path);
+}
+
+// A trim copy left by a reset: an unfinished copy if its segment is still
+// there, else the only copy of the segment (firmware that removed the
+// segment before the rename), which is put back
+static void recoverTrimCopies() {
+    std::vector<String> copies;
+    File dir = LittleFS.open(RECEIPT_DIR);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        String path = String(RECEIPT_DIR "/") + f.name();
+        f.close();
+        if (path.endsWith(".bin.tmp")) copies.push_back(path);
+    }
+    dir.close();
+    for (const String& tmp : copies) {
+        String path = tmp.substring(0, tmp.length() - strlen(".tmp"));
+        if (LittleFS.exists(path)) {
+            LittleFS.remove(tmp);
+        } else {
+            LittleFS.rename(tmp, path);
+            LOG_WARN("[receipts] restored %s from its trim copy", path.c_str());
+        }
+    }
+}
+
+// Records can reach flash before the counter in NVS does. Leftovers of a
+// reset mid-write are repaired after the directory walk.
+static uint32_t recoverNextSeq(uint32_t stored) {
+    recoverTrimCopies();
+
+    uint32_t next = stored;
+    std::vector<String> stale, partial;
+    std::vector<size_t> partialSizes;
+    File dir = LittleFS.open(RECEIPT_DIR);
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+        String path = String(RECEIPT_DIR "/") + f.name();
+        size_t size = f.size();
+        f.close();
+        if (!path.endsWith(".bin")) {
+            stale.push_back(path);
+            continue;
+        }
+        if (size % RECEIPT_RECORD_LEN != 0) {
+            partial.push_back(path);
+            partialSizes.push_back(size);
+        }
+        uint32_t segment = strtoul(path.c_str() + strlen(RECEIPT_DIR "/"), nullptr, 10);
+        uint32_t end = segment * SEGMENT_RECORDS + size / RECEIPT_RECORD_LEN;
+        if (end > next) next = end;
+    }
+    dir.close();
+    for (const String& path : stale) LittleFS.remove(path);
+    for (size_t i = 0; i < partial.size(); i++) trimSegment(partial[i], partialSizes[i]);
+    return next;
+}
+
+bool initReceipts() {
+    prefs.begin("receipts", false);
+    if (prefs.getBytes("key", privateKey, sizeof(privateKey)) != sizeof(privateKey)) {
+        esp_fill_random(privateKey, sizeof(privateKey));
+        prefs.putBytes("key", privateKey, sizeof(privateKey));
+    }
+    Ed25519::derivePublicKey(publicKey, privateKey);
+
+    if (!LittleFS.begin(true)) {
+        LOG_ERROR("[receipts] flash unavailable, dispenses will not be receipted");
+        return false;
+    }
+    if (!LittleFS.exists(RECEIPT_DIR)) LittleFS.mkdir(RECEIPT_DIR);
+    ackedSeq = prefs.getUInt("acked", 0);
+    nextSeq = recoverNextSeq(prefs.getUInt("next", 0));
+    ready = true;
+
+    char key[2 * RECEIPT_KEY_LEN + 1];
+    for (int i = 0; i < RECEIPT_KEY_LEN; i++) sprintf(key + 2 * i, "%02x", publicKey[i]);
+    LOG_INFO("[receipts] key=%s next=%u pending=%u", key, nextSeq, nextSeq - ackedSeq);
+    return true;
+}
+
+static uint32_t sign(uint8_t* signature, const uint8_t* body) {
+    uint8_t message[RECEIPT_MESSAGE_LEN];
+    receiptMessage(message, body);
+    uint32_t start = micros();
+    Ed25519::sign(signature, privateKey, publicKey, message, sizeof(message));
+    return micros() - start;
+}
+
+bool recordReceipt(const char* unitHex, const char* txHashHex, uint64_t startUnixMs, uint64_t endUnixMs) {
+    PumpReceipt r;
+    if (!ready || appendBroken || nextSeq - ackedSeq >= RECEIPT_MAX_PENDING ||
+        !receiptFromHex(unitHex, txHashHex, nextSeq, startUnixMs, endUnixMs, &r)) {
+        counters.unrecorded++;
+        return false;
+    }
+
+    uint8_t record[RECEIPT_RECORD_LEN];
+    receiptPackBody(record, r);
+    uint32_t us = sign(record + RECEIPT_BODY_LEN, record);
+    counters.signUsLast = us;
+    if (us > counters.signUsMax) counters.signUsMax = us;
+    counters.signUsSum += us;
+
+    String path = segmentPath(nextSeq / SEGMENT_RECORDS);
+    File f = LittleFS.open(path, FILE_APPEND);
+    bool opened = (bool)f;
+    bool ok = opened && f.write(record, sizeof(record)) == sizeof(record);
+    f.close();
+    if (!ok) {
+        counters.unrecorded++;
+        // Cut a short write back to whole records, or every later record
+        // of the segment would sit at the wrong offset
+        if (opened && !trimSegment(path, (nextSeq % SEGMENT_RECORDS) * RECEIPT_RECORD_LEN)) {
+            LOG_ERROR("[receipts] cannot trim %s, no new receipts until reboot", path.c_str());
+            appendBroken = true;
+        }
+        return false;
+    }
+    nextSeq++;
+    prefs.putUInt("next", nextSeq);
+    counters.signedCount++;
+    LOG_INFO("[receipts] seq=%u sign=%uus pending=%u", r.seq, us, nextSeq - ackedSeq);
+    return true;
+}
+
+// Whole records held by a segment file (0 if it is gone)
+static uint32_t segmentRecords(uint32_t segment) {
+    File f = LittleFS.open(segmentPath(segment), FILE_READ);
+    uint32_t n = f ? f.size() / RECEIPT_RECORD_LEN : 0;
+    f.close();
+    return n;
+}
+
+// Pending receipts whose records are no longer on flash cannot be sent:
+// skip them, so one lost segment does not stall the uploads for good
+static void skipLostRecords() {
+    uint32_t lost = 0;
+    while (ackedSeq < nextSeq) {
+        uint32_t segment = ackedSeq / SEGMENT_RECORDS;
+        if (ackedSeq % SEGMENT_RECORDS < segmentRecords(segment)) break;
+        uint32_t end = (segment + 1) * SEGMENT_RECORDS;
+        if (end > nextSeq) {
+            // The segment being appended is gone: continue in the next one,
+            // so new records land at their offsets again
+            lost += nextSeq - ackedSeq;
+            nextSeq = end;
+            prefs.putUInt("next", nextSeq);
+        } else {
+            lost += end - ackedSeq;
+        }
+        ackedSeq = end;
+        LittleFS.remove(segmentPath(segment));
+    }
+    if (lost == 0) return;
+    prefs.putUInt("acked", ackedSeq);
+    counters.lost += lost;
+    LOG_ERROR("[receipts] %u receipts lost with their segment, %u pending", lost, nextSeq - ackedSeq);
+}
+
+// Receipts from ackedSeq that can be read back, up to `count`: a batch
+// stops short of a missing segment, which the next upload skips
+static uint32_t readableRecords(uint32_t count) {
+    uint32_t seq = ackedSeq;
+    uint32_t last = ackedSeq + count;
+    while (seq < last) {
+        uint32_t segment = seq / SEGMENT_RECORDS;
+        uint32_t end = segment * SEGMENT_RECORDS + segmentRecords(segment);
+        if (end <= seq) break;
+        seq = end;
+        if (end % SEGMENT_RECORDS != 0) break;   // short segment: the rest is not on flash
+    }
+    return (seq < last ? seq : last) - ackedSeq;
+}
+
+// Stream records [seq, seq + count) from their segment files
+static bool writeRecords(Client& client, uint32_t seq, uint32_t count) {
+    uint8_t buf[UPLOAD_CHUNK_RECORDS * RECEIPT_RECORD_LEN];
+    while (count > 0) {
+        File f = LittleFS.open(segmentPath(seq / SEGMENT_RECORDS), FILE_READ);
+        if (!f || !f.seek((seq % SEGMENT_RECORDS) * RECEIPT_RECORD_LEN)) return false;
+        uint32_t inSegment = SEGMENT_RECORDS - seq % SEGMENT_RECORDS;
+        if (inSegment > count) inSegment = count;
+        while (inSegment > 0) {
+            uint32_t n = inSegment < UPLOAD_CHUNK_RECORDS ? inSegment : UPLOAD_CHUNK_RECORDS;
+            size_t len = n * RECEIPT_RECORD_LEN;
+            if (f.read(buf, len) != len || client.write(buf, len) != len) return false;
+            seq += n;
+            count -= n;
+            inSegment -= n;
+        }
+        f.close();
+    }
+    return true;
+}
+
+size_t uploadReceipts() {
+    if (!ready) return 0;
+    skipLostRecords();
+    uint32_t pending = nextSeq - ackedSeq;
+    if (pending == 0) return 0;
+    uint16_t count = readableRecords(pending < RECEIPT_BATCH_MAX ? pending : RECEIPT_BATCH_MAX);
+
+    WiFiClient client;
+    if (!client.connect(RECEIPT_BACKEND_HOST, RECEIPT_BACKEND_PORT)) {
+        counters.failures++;
+        LOG_WARN("[receipts] upload: cannot connect, %u pending", pending);
+        return 0;
+    }
+    char head[256];
+    int n = snprintf(head, sizeof(head),
+        "POST %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: ESP32HTTPClient\r\nConnection: close\r\n"
+        "Content-Type: application/octet-stream\r\nContent-Length: %u\r\n\r\n",
+        RECEIPT_BACKEND_PATH, RECEIPT_BACKEND_HOST,
+        (unsigned)(RECEIPT_BATCH_HEADER_LEN + count * RECEIPT_RECORD_LEN));
+    uint8_t header[RECEIPT_BATCH_HEADER_LEN];
+    receiptPackBatchHeader(header, publicKey, count);
+
+    bool sent = client.write((const uint8_t*)head, n) == (size_t)n &&
+                client.write(header, sizeof(header)) == sizeof(header) &&
+                writeRecords(client, ackedSeq, count);
+    int status = sent ? httpReadHead(client).status : -1;
+    client.stop();
+    if (status < 200 || status >= 300) {
+        counters.failures++;
+        LOG_WARN("[receipts] upload: status %d, %u pending", status, pending);
+        return 0;
+    }
+
+    // Segments wholly below the new mark are done
+    uint32_t from = ackedSeq / SEGMENT_RECORDS;
+    ackedSeq += count;
+    prefs.putUInt("acked", ackedSeq);
+    for (uint32_t s = from; s < ackedSeq / SEGMENT_RECORDS; s++) LittleFS.remove(segmentPath(s));
+    counters.uploaded += count;
+    counters.batches++;
+    LOG_INFO("[receipts] uploaded %u, %u pending", count, nextSeq - ackedSeq);
+    return count;
+}
+
+uint32_t benchReceiptSign(int count) {
+    PumpReceipt r = {};
+    r.unitLen = 28;
+    uint8_t record[RECEIPT_RECORD_LEN];
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        r.seq = i;
+        receiptPackBody(record, r);
+        total += sign(record + RECEIPT_BODY_LEN, record);
+    }
+    return count > 0 ? total / count : 0;
+}
+
+uint32_t pendingReceipts() {
+    return nextSeq - ackedSeq;
+}
+
+const uint8_t* receiptPublicKey() {
+    return publicKey;
+}
+
+const ReceiptStats& receiptStats() {
+    return counters;
+}
+
+void writeReceiptMetrics(Print& out) {
+    out.printf("receipts_signed_total %u\n", counters.signedCount);
+    out.printf("receipts_unrecorded_total %u\n", counters.unrecorded);
+    out.printf("receipts_pending %u\n", nextSeq - ackedSeq);
+    out.printf("receipts_uploaded_total %u\n", counters.uploaded);
+    out.printf("receipt_batches_total %u\n", counters.batches);
+    out.printf("receipt_upload_failures_total %u\n", counters.failures);
+    out.printf("receipts_lost_total %u\n", counters.lost);
+    out.printf("receipt_sign_us_last %u\n", counters.signUsLast);
+    out.printf("receipt_sign_us_max %u\n", counters.signUsMax);
+    out.printf("receipt_sign_us_avg %u\n",
+        counters.signedCount ? (uint32_t)(counters.signUsSum / counters.signedCount) : 0);
+}
+
+#endif
@@ -0,0 +1,402 @@
+// Device re-lock: key, Blockfrost reads, build, sign, submit
+
+#include "config.h"
+#include "relock.h"
+
+#if DEVICE_RELOCK
+#include <ArduinoJson.h>
+#include <Ed25519.h>
+#include <Preferences.h>
+#include <WiFiClientSecure.h>
+#include <esp_system.h>
+#include "bech32.h"
+#include "http_stream.h"
+#include "locker_datum.h"
+#include "logger.h"
+#include "relock_tx.h"
+#include "timesync.h"
+
+#define API_PREFIX "/api/v0"
+#define HEADERS "project_id: " BLOCKFROST_API_KEY "\r\n"
+#define HTTP_TIMEOUT_MS 15000
+
+static Preferences prefs;
+static uint8_t privateKey[32];
+static uint8_t publicKey[RELOCK_KEY_LEN];
+static uint8_t keyHash[RELOCK_KEY_HASH_LEN];
+static char policyHex[2 * RELOCK_KEY_HASH_LEN + 1];
+
+// Cached chain data; the script is checked against the policy ID
+static RelockParams params;
+static bool paramsValid = false;
+static unsigned long paramsAt = 0;
+static uint8_t script[RELOCK_SCRIPT_MAX];
+static size_t scriptLen = 0;
+
+// The request and tx are large; kept off the loop task's stack
+static RelockRequest request;
+static uint8_t txBuf[RELOCK_TX_MAX];
+static LockerAddress lastAuthority;
+static bool authorityKnown = false;
+
+static RelockStats counters;
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Whole string as bytes; returns the byte count, or -1
+static int hexDecode(const char* hex, uint8_t* out, size_t max) {
+    size_t len = strlen(hex);
+    if (len % 2 != 0 || len / 2 > max) return -1;
+    for (size_t i = 0; i < len / 2; i++) {
+        int hi = hexNibble(hex[2 * i]);
+        int lo = hexNibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return -1;
+        out[i] = (hi << 4) | lo;
+    }
+    return len / 2;
+}
+
+static void printHex(Print& out, const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) out.printf("%02x", p[i]);
+}
+
+void initRelock() {
+    prefs.begin("relock", false);
+    if (prefs.getBytes("key", privateKey, sizeof(privateKey)) != sizeof(privateKey)) {
+        esp_fill_random(privateKey, sizeof(privateKey));
+        prefs.putBytes("key", privateKey, sizeof(privateKey));
+    }
+    Ed25519::derivePublicKey(publicKey, privateKey);
+    relockKeyHash(publicKey, keyHash);
+    memcpy(request.publicKey, publicKey, RELOCK_KEY_LEN);
+
+    // ASSET_UNIT is the policy ID (the locker script hash) and the name
+    memcpy(policyHex, ASSET_UNIT, 2 * RELOCK_KEY_HASH_LEN);
+    policyHex[2 * RELOCK_KEY_HASH_LEN] = '\0';
+    hexDecode(policyHex, request.policyId, RELOCK_KEY_HASH_LEN);
+    int nameLen = hexDecode(ASSET_UNIT + 2 * RELOCK_KEY_HASH_LEN, request.assetName, RELOCK_ASSET_NAME_MAX);
+    request.assetNameLen = nameLen > 0 ? nameLen : 0;
+
+    char hash[2 * RELOCK_KEY_HASH_LEN + 1];
+    for (int i = 0; i < RELOCK_KEY_HASH_LEN; i++) sprintf(hash + 2 * i, "%02x", keyHash[i]);
+    LOG_INFO("[relock] authority key hash=%s", hash);
+}
+
+// One connection for all requests of a re-lock
+class Api {
+public:
+    Api() {
+#if BLOCKFROST_TLS
+        client.setInsecure();
+#endif
+        client.setTimeout(HTTP_TIMEOUT_MS / 1000);
+    }
+    ~Api() { client.stop(); }
+
+    // GET and parse with `filter`; false (error = label) unless 200 and valid JSON
+    bool get(const char* label, const String& path, JsonDocument& filter, JsonDocument& doc) {
+        if (!connect() || !httpSendGet(client, BLOCKFROST_HOST, API_PREFIX + path, HEADERS)) {
+            return fail("connect");
+        }
+        HttpResponseHead head = httpReadHead(client);
+        status = head.status;
+        HttpBodyStream body;
+        if (!body.begin(client, head.contentLength, head.chunked, head.compressed)) return fail("body");
+        bool ok = head.status == 200 && !deserializeJson(doc, body, DeserializationOption::Filter(filter));
+        if (!head.keepAlive || !body.drain()) client.stop();
+        body.end();
+        return ok || fail(label);
+    }
+
+    // POST the signed tx; `txHash` receives the quoted id from the body
+    bool submit(const uint8_t* tx, size_t len, String* txHash) {
+        if (!connect()) return fail("connect");
+        char head[256];
+        int n = snprintf(head, sizeof(head),
+            "POST " API_PREFIX "/tx/submit HTTP/1.1\r\nHost: %s\r\nUser-Agent: ESP32HTTPClient\r\n"
+            "Connection: close\r\n" HEADERS "Content-Type: application/cbor\r\nContent-Length: %u\r\n\r\n",
+            BLOCKFROST_HOST, (unsigned)len);
+        if (client.write((const uint8_t*)head, n) != (size_t)n || client.write(tx, len) != len) return fail("write");
+        HttpResponseHead response = httpReadHead(client);
+        status = response.status;
+        String reply = client.readString();     // "<tx id>" or an error object
+        client.stop();
+        if (status != 200) {
+            LOG_WARN("[relock] submit rejected: %s", reply.c_str());
+            return fail("submit");
+        }
+        reply.replace("\"", "");
+        reply.trim();
+        *txHash = reply;
+        return true;
+    }
+
+    const char* error = nullptr;
+    int status = 0;
+
+private:
+    bool connect() {
+        return client.connected() || client.connect(BLOCKFROST_HOST, BLOCKFROST_PORT);
+    }
+    bool fail(const char* what) {
+        error = what;
+        return false;
+    }
+
+#if BLOCKFROST_TLS
+    WiFiClientSecure client;
+#else
+    WiFiClient client;
+#endif
+};
+
+// Decimal price to nano-lovelace, e.g. 0.0577 -> 57700000
+static uint64_t nanoPrice(JsonVariant v) {
+    return (uint64_t)llround(v.as<double>() * 1e9);
+}
+
+static bool loadParams(Api& api) {
+    if (paramsValid && millis() - paramsAt < RELOCK_PARAMS_TTL_MS) return true;
+    JsonDocument filter;
+    filter["min_fee_a"] = true;
+    filter["min_fee_b"] = true;
+    filter["price_mem"] = true;
+    filter["price_step"] = true;
+    filter["collateral_percent"] = true;
+    filter["coins_per_utxo_size"] = true;
+    filter["cost_models_raw"]["PlutusV3"] = true;
+    JsonDocument doc;
+    if (!api.get("parameters", "/epochs/latest/parameters", filter, doc)) return false;
+
+    JsonArray costs = doc["cost_models_raw"]["PlutusV3"];
+    if (costs.size() == 0 || costs.size() > RELOCK_COST_MODEL_MAX) {
+        api.error = "cost model";
+        return false;
+    }
+    params.minFeeA = doc["min_fee_a"];
+    params.minFeeB = doc["min_fee_b"];
+    params.priceMemNano = nanoPrice(doc["price_mem"]);
+    params.priceStepNano = nanoPrice(doc["price_step"]);
+    params.collateralPercent = doc["collateral_percent"];
+    params.coinsPerUtxoByte = strtoul(doc["coins_per_utxo_size"] | "0", nullptr, 10);
+    params.costModelLen = 0;
+    for (JsonVariant c : costs) params.costModel[params.costModelLen++] = c.as<int64_t>();
+    paramsValid = true;
+    paramsAt = millis();
+    return true;
+}
+
+// The applied locker validator; its hash is the policy ID of ASSET_UNIT
+static bool loadScript(Api& api) {
+    if (scriptLen > 0) return true;
+    JsonDocument filter;
+    filter["cbor"] = true;
+    JsonDocument doc;
+    if (!api.get("script", String("/scripts/") + policyHex + "/cbor", filter, doc)) return false;
+    int len = hexDecode(doc["cbor"] | "", script, sizeof(script));
+    uint8_t hash[RELOCK_KEY_HASH_LEN];
+    if (len > 0) relockScriptHash(script, len, hash);
+    if (len <= 0 || memcmp(hash, request.policyId, sizeof(hash)) != 0) {
+        api.error = "script hash";
+        return false;
+    }
+    scriptLen = len;
+    return true;
+}
+
+static uint64_t lovelaceOf(JsonArray amount) {
+    for (JsonVariant a : amount) {
+        if (strcmp(a["unit"] | "", "lovelace") == 0) return strtoull(a["quantity"] | "0", nullptr, 10);
+    }
+    return 0;
+}
+
+static bool readTxIn(JsonVariant utxo, RelockTxIn* in) {
+    in->index = utxo["output_index"] | 0;
+    return hexDecode(utxo["tx_hash"] | "", in->txHash, RELOCK_HASH_LEN) == RELOCK_HASH_LEN;
+}
+
+// The locker UTxO and its datum. `locked` is set when there is nothing to do.
+static bool loadLocker(Api& api, const String& lockerAddress, bool* locked) {
+    JsonDocument filter;
+    filter[0]["tx_hash"] = true;
+    filter[0]["output_index"] = true;
+    filter[0]["amount"] = true;
+    filter[0]["inline_datum"] = true;
+    JsonDocument doc;
+    if (!api.get("locker utxo", "/addresses/" + lockerAddress + "/utxos/" ASSET_UNIT, filter, doc)) return false;
+
+    JsonVariant utxo = doc[0];
+    static uint8_t datum[128];
+    int datumLen = hexDecode(utxo["inline_datum"] | "", datum, sizeof(datum));
+    LockerDatum d;
+    const char* error = nullptr;
+    if (!readTxIn(utxo, &request.locker) || datumLen <= 0 ||
+        decodeLockerDatum(datum, datumLen, &d, &error) == PLUTUS_FAILED) {
+        api.error = error ? error : "locker utxo";
+        return false;
+    }
+    *locked = d.isLocked != 0;
+    request.lockerLovelace = lovelaceOf(utxo["amount"]);
+    request.authority = d.authority;
+    lastAuthority = d.authority;
+    authorityKnown = true;
+    return true;
+}
+
+// The first ADA-only UTxO at the authority address that can pay
+static bool loadFunding(Api& api) {
+    char address[CARDANO_ADDR_BUF_LEN];
+    encodeCardanoAddressTo(address, sizeof(address), request.authority.payment, request.authority.stake, request.network);
+    JsonDocument filter;
+    filter[0]["tx_hash"] = true;
+    filter[0]["output_index"] = true;
+    filter[0]["amount"] = true;
+    JsonDocument doc;
+    if (!api.get("funding utxos", String("/addresses/") + address + "/utxos", filter, doc)) return false;
+    for (JsonVariant utxo : doc.as<JsonArray>()) {
+        JsonArray amount = utxo["amount"];
+        uint64_t lovelace = lovelaceOf(amount);
+        if (amount.size() != 1 || lovelace < RELOCK_MIN_FUNDING) continue;
+        request.fundingLovelace = lovelace;
+        return readTxIn(utxo, &request.funding);
+    }
+    api.error = "no funding utxo";
+    return false;
+}
+
+static void fillRequest() {
+    request.network = 0;        // testnet, as checkAssetState() decodes the datum
+    request.script = script;
+    request.scriptLen = scriptLen;
+    request.exMem = RELOCK_EX_MEM;
+    request.exSteps = RELOCK_EX_STEPS;
+    // Valid for RELOCK_TTL_S from now, when the clock is known
+    request.ttl = timeSynced() ? wallClockMs() / 1000 - CHAIN_SLOT_ZERO_TIME + RELOCK_TTL_S : 0;
+}
+
+static void record(uint32_t buildUs, uint32_t signUs, size_t len) {
+    counters.buildUsLast = buildUs;
+    if (buildUs > counters.buildUsMax) counters.buildUsMax = buildUs;
+    counters.signUsLast = signUs;
+    if (signUs > counters.signUsMax) counters.signUsMax = signUs;
+    counters.txBytes = len;
+}
+
+// Build and sign `request`; times in microseconds
+static RelockError buildAndSign(RelockTx* tx, uint32_t* buildUs, uint32_t* signUs) {
+    uint32_t start = micros();
+    RelockError err = buildRelockTx(request, params, txBuf, sizeof(txBuf), tx);
+    *buildUs = micros() - start;
+    if (err != RELOCK_OK) return err;
+    uint8_t signature[RELOCK_SIGNATURE_LEN];
+    start = micros();
+    Ed25519::sign(signature, privateKey, publicKey, tx->bodyHash, RELOCK_HASH_LEN);
+    *signUs = micros() - start;
+    relockSetSignature(txBuf, *tx, signature);
+    return RELOCK_OK;
+}
+
+bool submitRelock(const String& lockerAddress, String* txHash) {
+    counters.attempts++;
+    Api api;
+    bool locked = false;
+    if (!loadParams(api) || !loadScript(api) || !loadLocker(api, lockerAddress, &locked)) {
+        counters.failures++;
+        LOG_WARN("[relock] %s failed (HTTP %d)", api.error, api.status);
+        return false;
+    }
+    if (locked) {
+        counters.skipped++;
+        LOG_INFO("[relock] locker already locked");
+        return false;
+    }
+    fillRequest();
+    if (!loadFunding(api)) {
+        counters.failures++;
+        LOG_WARN("[relock] %s failed (HTTP %d)", api.error, api.status);
+        return false;
+    }
+
+    RelockTx tx;
+    uint32_t buildUs = 0, signUs = 0;
+    RelockError err = buildAndSign(&tx, &buildUs, &signUs);
+    if (err != RELOCK_OK) {
+        counters.failures++;
+        LOG_ERROR("[relock] build failed: %s", relockErrorName(err));
+        return false;
+    }
+    record(buildUs, signUs, tx.len);
+    if (!api.submit(txBuf, tx.len, txHash)) {
+        counters.failures++;
+        LOG_WARN("[relock] %s failed (HTTP %d)", api.error, api.status);
+        return false;
+    }
+    counters.submitted++;
+    LOG_INFO("[relock] submitted tx=%s bytes=%u fee=%llu build=%uus sign=%uus",
+        txHash->c_str(), (unsigned)tx.len, (unsigned long long)tx.fee, buildUs, signUs);
+    return true;
+}
+
+bool benchRelock(int count, uint32_t* buildUs, uint32_t* signUs) {
+    Api api;
+    if (!loadParams(api) || !loadScript(api)) return false;
+    fillRequest();
+    // A made-up locker and funding UTxO under this key
+    memcpy(request.authority.payment, keyHash, RELOCK_KEY_HASH_LEN);
+    memset(request.authority.stake, 0x5a, RELOCK_KEY_HASH_LEN);
+    memset(request.locker.txHash, 0xa5, RELOCK_HASH_LEN);
+    memset(request.funding.txHash, 0x3c, RELOCK_HASH_LEN);
+    request.lockerLovelace = 2000000;
+    request.fundingLovelace = 25000000;
+
+    uint64_t buildSum = 0, signSum = 0;
+    RelockTx tx;
+    for (int i = 0; i < count; i++) {
+        request.funding.index = i;
+        uint32_t b, s;
+        if (buildAndSign(&tx, &b, &s) != RELOCK_OK) return false;
+        buildSum += b;
+        signSum += s;
+    }
+    *buildUs = count > 0 ? buildSum / count : 0;
+    *signUs = count > 0 ? signSum / count : 0;
+    return true;
+}
+
+const RelockStats& relockStats() {
+    return counters;
+}
+
+void printRelock(Print& out) {
+    out.print("Relock key hash: ");
+    printHex(out, keyHash, RELOCK_KEY_HASH_LEN);
+    out.println();
+    if (!authorityKnown) {
+        out.println("Authority: not read yet");
+        return;
+    }
+    char address[CARDANO_ADDR_BUF_LEN];
+    encodeCardanoAddressTo(address, sizeof(address), lastAuthority.payment, lastAuthority.stake, 0);
+    bool ours = memcmp(lastAuthority.payment, keyHash, RELOCK_KEY_HASH_LEN) == 0;
+    out.printf("Authority: %s%s\n", address, ours ? "" : " (not this device: cannot re-lock)");
+}
+
+void writeRelockMetrics(Print& out) {
+    out.printf("relock_attempts_total %u\n", counters.attempts);
+    out.printf("relock_submitted_total %u\n", counters.submitted);
+    out.printf("relock_skipped_total %u\n", counters.skipped);
+    out.printf("relock_failures_total %u\n", counters.failures);
+    out.printf("relock_tx_bytes %u\n", counters.txBytes);
+    out.printf("relock_build_us_last %u\n", counters.buildUsLast);
+    out.printf("relock_build_us_max %u\n", counters.buildUsMax);
+    out.printf("relock_sign_us_last %u\n", counters.signUsLast);
+    out.printf("relock_sign_us_max %u\n", counters.signUsMax);
+}
+
+#endif
@@ -0,0 +1,299 @@
+// Re-lock transaction: CBOR layout, fee, script data hash
+
+#include "relock_tx.h"
+#include <string.h>
+#include "blake2b.h"
+#include "plutus_writer.h"
+
+// Address headers (CIP-19): base key/key, enterprise script
+#define ADDR_BASE 0x00
+#define ADDR_SCRIPT 0x70
+#define ADDR_BASE_LEN 57
+#define ADDR_SCRIPT_LEN 29
+
+// Body and witness set keys
+#define BODY_INPUTS 0
+#define BODY_OUTPUTS 1
+#define BODY_FEE 2
+#define BODY_TTL 3
+#define BODY_SCRIPT_DATA_HASH 11
+#define BODY_COLLATERAL 13
+#define BODY_REQUIRED_SIGNERS 14
+#define BODY_COLLATERAL_RETURN 16
+#define BODY_TOTAL_COLLATERAL 17
+#define WITNESS_VKEYS 0
+#define WITNESS_REDEEMERS 5
+#define WITNESS_PLUTUS_V3 7
+
+#define TAG_SET 258
+#define TAG_CBOR 24
+#define REDEEMER_SPEND 0
+#define LANGUAGE_PLUTUS_V3 2
+#define STATUS_REDEEMER 0           // contract.ak Redeemer::Status
+#define LOCKED 1
+
+// Min-UTxO: (this overhead + output size) * coinsPerUtxoByte (Babbage)
+#define UTXO_OVERHEAD 160
+// Redeemers and a datum are small; scratch for them
+#define SCRATCH_LEN 128
+
+// Fixed for one request: addresses, key hash, datum, redeemers
+struct Parts {
+    uint8_t keyHash[RELOCK_KEY_HASH_LEN];
+    uint8_t lockerAddr[ADDR_SCRIPT_LEN];
+    uint8_t authorityAddr[ADDR_BASE_LEN];
+    uint8_t datum[SCRATCH_LEN];
+    size_t datumLen;
+    uint8_t redeemers[SCRATCH_LEN];
+    size_t redeemersLen;
+    uint8_t scriptDataHash[RELOCK_HASH_LEN];
+    bool lockerFirst;               // input order (sorted by tx hash, index)
+};
+
+const char* relockErrorName(RelockError error) {
+    switch (error) {
+        case RELOCK_OK: return "ok";
+        case RELOCK_NOT_AUTHORITY: return "not_authority";
+        case RELOCK_BAD_REQUEST: return "bad_request";
+        case RELOCK_LOCKER_MIN_ADA: return "locker_min_ada";
+        case RELOCK_FUNDS: return "funds";
+        case RELOCK_BUFFER: return "buffer";
+    }
+    return "unknown";
+}
+
+void relockKeyHash(const uint8_t* publicKey, uint8_t* out) {
+    blake2b(publicKey, RELOCK_KEY_LEN, out, BLAKE2B_224);
+}
+
+void relockScriptHash(const uint8_t* script, size_t len, uint8_t* out) {
+    static const uint8_t plutusV3 = 0x03;
+    Blake2b b(BLAKE2B_224);
+    b.update(&plutusV3, 1);
+    b.update(script, len);
+    b.final(out);
+}
+
+static bool inputBefore(const RelockTxIn& a, const RelockTxIn& b) {
+    int c = memcmp(a.txHash, b.txHash, RELOCK_HASH_LEN);
+    return c < 0 || (c == 0 && a.index < b.index);
+}
+
+// ceil((mem * priceMem + steps * priceStep) / 1e9)
+static uint64_t executionFee(const RelockRequest& req, const RelockParams& p) {
+    uint64_t nano = req.exMem * p.priceMemNano + req.exSteps * p.priceStepNano;
+    return (nano + 999999999) / 1000000000;
+}
+
+static void writeTxIn(PlutusWriter& w, const RelockTxIn& in) {
+    w.array(2);
+    w.byteString(in.txHash, RELOCK_HASH_LEN);
+    w.uint(in.index);
+}
+
+// Legacy output [address, coin] to the authority address
+static void writeAdaOutput(PlutusWriter& w, const Parts& parts, uint64_t lovelace) {
+    w.array(2);
+    w.byteString(parts.authorityAddr, ADDR_BASE_LEN);
+    w.uint(lovelace);
+}
+
+// {0: script address, 1: [coin, {policy: {name: 1}}], 2: [1, 24(datum)]}
+static void writeLockerOutput(PlutusWriter& w, const RelockRequest& req, const Parts& parts) {
+    w.map(3);
+    w.uint(0);
+    w.byteString(parts.lockerAddr, ADDR_SCRIPT_LEN);
+    w.uint(1);
+    w.array(2);
+    w.uint(req.lockerLovelace);
+    w.map(1);
+    w.byteString(req.policyId, RELOCK_KEY_HASH_LEN);
+    w.map(1);
+    w.byteString(req.assetName, req.assetNameLen);
+    w.uint(1);
+    w.uint(2);
+    w.array(2);
+    w.uint(1);
+    w.tag(TAG_CBOR);
+    w.byteString(parts.datum, parts.datumLen);
+}
+
+static uint64_t minUtxo(const RelockParams& p, size_t outputLen) {
+    return (UTXO_OVERHEAD + outputLen) * (uint64_t)p.coinsPerUtxoByte;
+}
+
+static uint64_t adaOutputMin(const RelockParams& p, const Parts& parts, uint64_t lovelace) {
+    uint8_t buf[ADDR_BASE_LEN + 16];
+    PlutusWriter w(buf, sizeof(buf));
+    writeAdaOutput(w, parts, lovelace);
+    return minUtxo(p, w.size());
+}
+
+static RelockError prepare(const RelockRequest& req, const RelockParams& params, Parts* parts) {
+    if (req.assetNameLen > RELOCK_ASSET_NAME_MAX || req.script == nullptr || req.scriptLen == 0 ||
+        params.costModelLen == 0 || params.costModelLen > RELOCK_COST_MODEL_MAX) {
+        return RELOCK_BAD_REQUEST;
+    }
+    relockKeyHash(req.publicKey, parts->keyHash);
+    if (memcmp(parts->keyHash, req.authority.payment, RELOCK_KEY_HASH_LEN) != 0) return RELOCK_NOT_AUTHORITY;
+
+    parts->lockerAddr[0] = ADDR_SCRIPT | (req.network & 0x0f);
+    relockScriptHash(req.script, req.scriptLen, parts->lockerAddr + 1);
+    parts->authorityAddr[0] = ADDR_BASE | (req.network & 0x0f);
+    memcpy(parts->authorityAddr + 1, req.authority.payment, RELOCK_KEY_HASH_LEN);
+    memcpy(parts->authorityAddr + 1 + RELOCK_KEY_HASH_LEN, req.authority.stake, RELOCK_KEY_HASH_LEN);
+
+    // Datum{Address{payment, stake}, is_locked: 1}
+    PlutusWriter d(parts->datum, sizeof(parts->datum));
+    d.constr(0);
+    d.beginList();
+    d.constr(0);
+    d.beginList();
+    d.bytes(req.authority.payment, RELOCK_KEY_HASH_LEN);
+    d.bytes(req.authority.stake, RELOCK_KEY_HASH_LEN);
+    d.endList();
+    d.integer(LOCKED);
+    d.endList();
+    parts->datumLen = d.size();
+
+    // [[spend, input index, Status, [mem, steps]]]
+    parts->lockerFirst = inputBefore(req.locker, req.funding);
+    PlutusWriter r(parts->redeemers, sizeof(parts->redeemers));
+    r.array(1);
+    r.array(4);
+    r.uint(REDEEMER_SPEND);
+    r.uint(parts->lockerFirst ? 0 : 1);
+    r.constr(STATUS_REDEEMER);
+    r.emptyList();
+    r.array(2);
+    r.uint(req.exMem);
+    r.uint(req.exSteps);
+    parts->redeemersLen = r.size();
+
+    // script_data_hash = blake2b-256(redeemers || language views); there
+    // are no witness datums. The views ({2: [cost model]}) are hashed as
+    // they are written, a few bytes at a time.
+    Blake2b h(BLAKE2B_256);
+    h.update(parts->redeemers, parts->redeemersLen);
+    uint8_t item[16];
+    PlutusWriter v(item, sizeof(item));
+    v.map(1);
+    v.uint(LANGUAGE_PLUTUS_V3);
+    v.array(params.costModelLen);
+    h.update(item, v.size());
+    for (size_t i = 0; i < params.costModelLen; i++) {
+        v.truncate(0);
+        v.integer(params.costModel[i]);
+        h.update(item, v.size());
+    }
+    h.final(parts->scriptDataHash);
+
+    if (d.overflowed() || r.overflowed()) return RELOCK_BAD_REQUEST;
+    return RELOCK_OK;
+}
+
+// [body, witnesses, true, null] for one fee; the signature left zeroed
+static void writeTx(PlutusWriter& w, const RelockRequest& req, const Parts& parts,
+                    uint64_t fee, uint64_t collateral, size_t* bodyEnd, size_t* signatureOffset) {
+    w.array(4);
+
+    w.map(req.ttl ? 9 : 8);
+    w.uint(BODY_INPUTS);
+    w.tag(TAG_SET);
+    w.array(2);
+    writeTxIn(w, parts.lockerFirst ? req.locker : req.funding);
+    writeTxIn(w, parts.lockerFirst ? req.funding : req.locker);
+    w.uint(BODY_OUTPUTS);
+    w.array(2);
+    writeLockerOutput(w, req, parts);
+    writeAdaOutput(w, parts, req.fundingLovelace - fee);
+    w.uint(BODY_FEE);
+    w.uint(fee);
+    if (req.ttl) {
+        w.uint(BODY_TTL);
+        w.uint(req.ttl);
+    }
+    w.uint(BODY_SCRIPT_DATA_HASH);
+    w.byteString(parts.scriptDataHash, RELOCK_HASH_LEN);
+    w.uint(BODY_COLLATERAL);
+    w.tag(TAG_SET);
+    w.array(1);
+    writeTxIn(w, req.funding);
+    w.uint(BODY_REQUIRED_SIGNERS);
+    w.tag(TAG_SET);
+    w.array(1);
+    w.byteString(parts.keyHash, RELOCK_KEY_HASH_LEN);
+    w.uint(BODY_COLLATERAL_RETURN);
+    writeAdaOutput(w, parts, req.fundingLovelace - collateral);
+    w.uint(BODY_TOTAL_COLLATERAL);
+    w.uint(collateral);
+    *bodyEnd = w.size();
+
+    static const uint8_t zeroSignature[RELOCK_SIGNATURE_LEN] = {};
+    w.map(3);
+    w.uint(WITNESS_VKEYS);
+    w.tag(TAG_SET);
+    w.array(1);
+    w.array(2);
+    w.byteString(req.publicKey, RELOCK_KEY_LEN);
+    w.byteString(zeroSignature, sizeof(zeroSignature));
+    *signatureOffset = w.size() - sizeof(zeroSignature);
+    w.uint(WITNESS_REDEEMERS);
+    w.encoded(parts.redeemers, parts.redeemersLen);
+    w.uint(WITNESS_PLUTUS_V3);
+    w.tag(TAG_SET);
+    w.array(1);
+    w.byteString(req.script, req.scriptLen);
+
+    w.boolean(true);
+    w.null();
+}
+
+RelockError buildRelockTx(const RelockRequest& req, const RelockParams& params,
+                          uint8_t* buf, size_t cap, RelockTx* out) {
+    Parts parts;
+    RelockError err = prepare(req, params, &parts);
+    if (err != RELOCK_OK) return err;
+
+    uint8_t lockerBuf[ADDR_SCRIPT_LEN + RELOCK_KEY_HASH_LEN + RELOCK_ASSET_NAME_MAX + SCRATCH_LEN + 32];
+    PlutusWriter lw(lockerBuf, sizeof(lockerBuf));
+    writeLockerOutput(lw, req, parts);
+    if (req.lockerLovelace < minUtxo(params, lw.size())) return RELOCK_LOCKER_MIN_ADA;
+
+    // min fee = a * size + b + execution fee, at the size this fee gives
+    uint64_t exFee = executionFee(req, params);
+    uint64_t fee = params.minFeeB + exFee;
+    uint64_t collateral = 0;
+    size_t bodyEnd = 0;
+    size_t sigOffset = 0;
+    PlutusWriter w(buf, cap);
+    // Ends: the fee only grows, and the funding check bounds it
+    for (;;) {
+        collateral = (fee * params.collateralPercent + 99) / 100;
+        if (req.fundingLovelace < collateral || req.fundingLovelace < fee) return RELOCK_FUNDS;
+        w.truncate(0);
+        writeTx(w, req, parts, fee, collateral, &bodyEnd, &sigOffset);
+        if (w.overflowed()) return RELOCK_BUFFER;
+        uint64_t need = (uint64_t)params.minFeeA * w.size() + params.minFeeB + exFee;
+        if (need <= fee) break;
+        fee = need;
+    }
+
+    uint64_t change = req.fundingLovelace - fee;
+    if (change < adaOutputMin(params, parts, change) ||
+        req.fundingLovelace - collateral < adaOutputMin(params, parts, req.fundingLovelace - collateral)) {
+        return RELOCK_FUNDS;
+    }
+
+    out->len = w.size();
+    out->signatureOffset = sigOffset;
+    out->fee = fee;
+    out->change = change;
+    out->collateral = collateral;
+    blake2b(buf + 1, bodyEnd - 1, out->bodyHash, BLAKE2B_256);
+    return RELOCK_OK;
+}
+
+void relockSetSignature(uint8_t* buf, const RelockTx& tx, const uint8_t* signature) {
+    memcpy(buf + tx.signatureOffset, signature, RELOCK_SIGNATURE_LEN);
+}
@@ -0,0 +1,171 @@
+// Sensor sample ring, window aggregation and batch encoding
+
+#include "sampling.h"
+#include "plutus_data.h"
+#include "plutus_writer.h"
+#include <string.h>
+
+SampleRing::SampleRing(SensorSample* storage, uint32_t size)
+    : buf(storage), mask(size - 1), head(0), tail(0), dropCount(0) {}
+
+bool SampleRing::pop(SensorSample* out) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    *out = buf[t & mask];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+WindowAggregator::WindowAggregator(uint32_t w) : windowMs(w), open(false), startMs(0), count(0) {}
+
+// Nearest integer to sum / n, halves away from zero
+static int32_t roundedDiv(int64_t sum, int64_t n) {
+    return (int32_t)(sum >= 0 ? (sum + n / 2) / n : (sum - n / 2) / n);
+}
+
+void WindowAggregator::close(SensorWindow* out) {
+    out->startMs = startMs;
+    out->count = count;
+    out->tMin = tMin;
+    out->tMax = tMax;
+    out->tMean = roundedDiv(tSum, count);
+    out->hMin = hMin;
+    out->hMax = hMax;
+    out->hMean = roundedDiv(hSum, count);
+    open = false;
+}
+
+bool WindowAggregator::add(const SensorSample& s, SensorWindow* closed) {
+    uint32_t start = s.ms - s.ms % windowMs;
+    bool didClose = false;
+    if (open && start != startMs) {
+        close(closed);
+        didClose = true;
+    }
+    if (!open) {
+        open = true;
+        startMs = start;
+        count = 0;
+        tMin = tMax = s.temperature;
+        hMin = hMax = s.humidity;
+        tSum = hSum = 0;
+    }
+    count++;
+    tSum += s.temperature;
+    hSum += s.humidity;
+    if (s.temperature < tMin) tMin = s.temperature;
+    if (s.temperature > tMax) tMax = s.temperature;
+    if (s.humidity < hMin) hMin = s.humidity;
+    if (s.humidity > hMax) hMax = s.humidity;
+    return didClose;
+}
+
+bool WindowAggregator::flush(SensorWindow* closed) {
+    if (!open) return false;
+    close(closed);
+    return true;
+}
+
+static int64_t quantise(int32_t v, int32_t step) {
+    return roundedDiv(v, step);
+}
+
+size_t encodeSensorBatch(const SensorBatchHeader& header, const SensorWindow* windows, size_t count,
+                         uint8_t* out, size_t size, size_t* encoded) {
+    *encoded = 0;
+    if (count == 0 || size == 0 || header.step <= 0 || header.windowMs == 0) return 0;
+
+    // Room for the closing breaks of the window list and the batch
+    PlutusWriter w(out, size - 2);
+    w.constr(0);
+    w.beginList();
+    w.bytes((const uint8_t*)header.name, strnlen(header.name, sizeof(header.name) - 1));
+    w.integer(header.startUnixMs);
+    w.integer(header.windowMs);
+    w.integer(header.step);
+    w.beginList();
+    if (w.overflowed()) return 0;
+
+    int64_t prevT = 0, prevH = 0;
+    uint32_t prevStart = windows[0].startMs - header.windowMs;
+    size_t n = 0;
+    for (; n < count; n++) {
+        const SensorWindow& win = windows[n];
+        int64_t t = quantise(win.tMean, header.step);
+        int64_t h = quantise(win.hMean, header.step);
+        size_t mark = w.size();
+
+        w.constr(0);
+        w.beginList();
+        w.integer((win.startMs - prevStart) / header.windowMs - 1);
+        w.integer(win.count);
+        w.integer(t - prevT);
+        w.integer(t - quantise(win.tMin, header.step));
+        w.integer(quantise(win.tMax, header.step) - t);
+        w.integer(h - prevH);
+        w.integer(h - quantise(win.hMin, header.step));
+        w.integer(quantise(win.hMax, header.step) - h);
+        w.endList();
+        if (w.overflowed()) {
+            w.truncate(mark);
+            break;
+        }
+        prevT = t;
+        prevH = h;
+        prevStart = win.startMs;
+    }
+    if (n == 0) return 0;
+
+    size_t len = w.size();
+    out[len++] = 0xff;      // windows
+    out[len++] = 0xff;      // batch fields
+    *encoded = n;
+    return len;
+}
+
+bool decodeSensorBatch(const uint8_t* data, size_t len, SensorBatchHeader* header,
+                       SensorWindow* windows, size_t max, size_t* count) {
+    PlutusReader r(data, len);
+    uint32_t index;
+    size_t nameLen;
+    int64_t start, windowMs, step;
+    memset(header, 0, sizeof(*header));
+    if (!r.constr(&index) || index != 0 || !r.beginList() ||
+        !r.bytesUpTo((uint8_t*)header->name, sizeof(header->name) - 1, &nameLen) ||
+        !r.integer(&start) || !r.integer(&windowMs) || !r.integer(&step) ||
+        start < 0 || windowMs <= 0 || windowMs > UINT32_MAX || step <= 0 || step > INT32_MAX ||
+        !r.beginList()) {
+        return false;
+    }
+    header->startUnixMs = start;
+    header->windowMs = windowMs;
+    header->step = step;
+
+    int64_t t = 0, h = 0;
+    int64_t offset = -windowMs;
+    size_t n = 0;
+    while (r.more()) {
+        int64_t f[8];
+        if (n == max || !r.constr(&index) || index != 0 || !r.beginList()) return false;
+        for (int64_t& v : f) {
+            if (!r.integer(&v)) return false;
+        }
+        if (!r.endList() || f[0] < 0 || f[1] <= 0 || f[1] > UINT32_MAX) return false;
+
+        offset += (f[0] + 1) * windowMs;
+        t += f[2];
+        h += f[5];
+        SensorWindow& win = windows[n++];
+        win.startMs = offset;
+        win.count = f[1];
+        win.tMean = t * step;
+        win.tMin = (t - f[3]) * step;
+        win.tMax = (t + f[4]) * step;
+        win.hMean = h * step;
+        win.hMin = (h - f[6]) * step;
+        win.hMax = (h + f[7]) * step;
+    }
+    if (!r.endList() || !r.endList() || !r.done()) return false;
+    *count = n;
+    return true;
+}
@@ -0,0 +1,98 @@
+// Sensor batch upload over one keep-alive connection
+
+#include "sensor_uplink.h"
+
+SensorUplink::SensorUplink(Client& c, const char* h, uint16_t p, const char* pth,
+                           uint8_t* storage, size_t bytes, size_t n)
+    : client(c), host(h), port(p), path(pth), slots(storage), slotBytes(bytes),
+      slotCount(n < SENSOR_UPLINK_MAX_SLOTS ? n : SENSOR_UPLINK_MAX_SLOTS), count(0) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+bool SensorUplink::queue(const uint8_t* data, size_t len) {
+    if (len > slotBytes || slotCount == 0) return false;
+    if (count == slotCount) {
+        // Full: the oldest batch makes room
+        memmove(slots, slots + slotBytes, (count - 1) * slotBytes);
+        memmove(lengths, lengths + 1, (count - 1) * sizeof(lengths[0]));
+        count--;
+        counters.dropped++;
+    }
+    memcpy(slots + count * slotBytes, data, len);
+    lengths[count++] = len;
+    counters.queued++;
+    return true;
+}
+
+bool SensorUplink::connect() {
+    if (client.connected()) return true;
+    client.stop();
+    if (!client.connect(host, port)) return false;
+    counters.connects++;
+    return true;
+}
+
+bool SensorUplink::writePost(const uint8_t* data, size_t len) {
+    char head[256];
+    int n = snprintf(head, sizeof(head),
+        "POST %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: ESP32HTTPClient\r\nConnection: keep-alive\r\n"
+        "Content-Type: application/cbor\r\nContent-Length: %u\r\n\r\n",
+        path, host, (unsigned)len);
+    if (n <= 0 || (size_t)n >= sizeof(head)) return false;
+    return client.write((const uint8_t*)head, n) == (size_t)n && client.write(data, len) == len;
+}
+
+size_t SensorUplink::flush() {
+    if (count == 0) return 0;
+    if (!connect()) {
+        counters.failures++;
+        return 0;
+    }
+
+    // Every batch on the wire first, then the answers in order
+    size_t sent = 0;
+    while (sent < count && writePost(slots + sent * slotBytes, lengths[sent])) sent++;
+
+    bool done[SENSOR_UPLINK_MAX_SLOTS] = {};
+    size_t acked = 0;
+    size_t answered = 0;
+    bool reusable = true;
+    for (size_t i = 0; i < sent; i++) {
+        HttpResponseHead head = httpReadHead(client);
+        if (head.status < 0 || !body.begin(client, head.contentLength, head.chunked, false)) {
+            reusable = false;
+            break;
+        }
+        reusable = head.keepAlive && body.drain();
+        body.end();
+        answered++;
+
+        if (head.status >= 200 && head.status < 300) {
+            done[i] = true;
+            acked++;
+            counters.uploaded++;
+            counters.bytes += lengths[i];
+        } else if (head.status >= 400 && head.status < 500 && head.status != 429) {
+            done[i] = true;
+            counters.rejected++;
+        } else {
+            counters.retried++;
+        }
+        if (!reusable) break;
+    }
+    if (!reusable || sent < count) client.stop();
+    if (answered < count) counters.failures++;
+
+    // Keep what is left, in order
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (done[i]) continue;
+        if (kept != i) {
+            memmove(slots + kept * slotBytes, slots + i * slotBytes, lengths[i]);
+            lengths[kept] = lengths[i];
+        }
+        kept++;
+    }
+    count = kept;
+    return acked;
+}
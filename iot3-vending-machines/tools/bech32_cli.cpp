@@ -0,0 +1,272 @@
+// Host CLI for the firmware bech32 codec (lib/chain_monitor/src/bech32.cpp)
+//
+// Build (from iot3-vending-machines/):
+//   L=../lib/chain_monitor
+//   g++ -std=c++17 -O3 -march=native -pthread -I$L/include tools/bech32_cli.cpp $L/src/bech32.cpp -o bech32
+//
+// Usage:
+//   bech32 encode <network> <pubKeyHash hex> <stakeCredHash hex>
+//   bech32 decode <address>
+//   bech32 encode-batch <network> [threads] < pairs.txt   # "pkh skh" per line
+//   bech32 decode-batch <network> [threads] < addrs.txt   # one address per line
+//   bech32 bench [count] [threads]
+//
+// Batch commands shard the input across threads; each shard goes through
+// encodeCardanoAddressBatch()/decodeCardanoAddressBatch(), so the output is
+// the same bytes the firmware prints.
+
+#include "bech32.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Exactly `len` bytes as 2 * len hex digits, nothing else
+static bool parseHex(const std::string& hex, uint8_t* out, size_t len) {
+    if (hex.size() != len * 2) return false;
+    for (size_t i = 0; i < len; i++) {
+        int hi = hexNibble(hex[2 * i]);
+        int lo = hexNibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = (hi << 4) | lo;
+    }
+    return true;
+}
+
+// Network id of a base address: 0 (testnets) or 1 (mainnet)
+static bool parseNetwork(const char* arg, uint8_t* network) {
+    if (strcmp(arg, "0") != 0 && strcmp(arg, "1") != 0) return false;
+    *network = arg[0] - '0';
+    return true;
+}
+
+static std::string toHex(const uint8_t* in, size_t len) {
+    static const char* digits = "0123456789abcdef";
+    std::string s;
+    for (size_t i = 0; i < len; i++) {
+        s += digits[in[i] >> 4];
+        s += digits[in[i] & 15];
+    }
+    return s;
+}
+
+static unsigned defaultThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// Run fn(begin, end) over [0, count) split into `threads` contiguous shards
+template <typename Fn>
+static void parallelFor(size_t count, unsigned threads, Fn fn) {
+    if (threads <= 1 || count < (size_t)threads * BECH32_BATCH_LANES) {
+        fn(0, count);
+        return;
+    }
+    std::vector<std::thread> pool;
+    size_t shard = (count + threads - 1) / threads;
+    // Keep shard boundaries lane-aligned so every shard fills whole batches
+    shard = (shard + BECH32_BATCH_LANES - 1) / BECH32_BATCH_LANES * BECH32_BATCH_LANES;
+    for (size_t begin = 0; begin < count; begin += shard) {
+        size_t end = begin + shard < count ? begin + shard : count;
+        pool.emplace_back(fn, begin, end);
+    }
+    for (auto& t : pool) t.join();
+}
+
+static void encodeAll(const std::vector<CardanoAddressPayload>& in, uint8_t network,
+                      unsigned threads, std::vector<char>& out) {
+    out.resize(in.size() * CARDANO_ADDR_BUF_LEN);
+    parallelFor(in.size(), threads, [&](size_t begin, size_t end) {
+        encodeCardanoAddressBatch(in.data() + begin, end - begin, network,
+                                  out.data() + begin * CARDANO_ADDR_BUF_LEN);
+    });
+}
+
+static size_t decodeAll(const std::vector<const char*>& in, uint8_t network, unsigned threads,
+                        std::vector<CardanoAddressPayload>& out, std::vector<char>& ok) {
+    out.resize(in.size());
+    ok.resize(in.size());
+    parallelFor(in.size(), threads, [&](size_t begin, size_t end) {
+        // std::vector<bool> is not addressable, decode into a local array
+        std::unique_ptr<bool[]> okShard(new bool[end - begin]);
+        decodeCardanoAddressBatch(in.data() + begin, end - begin, network,
+                                  out.data() + begin, okShard.get());
+        for (size_t i = begin; i < end; i++) ok[i] = okShard[i - begin];
+    });
+    size_t valid = 0;
+    for (char v : ok) valid += v ? 1 : 0;
+    return valid;
+}
+
+static int cmdEncode(int argc, char** argv) {
+    uint8_t network;
+    if (argc != 5 || !parseNetwork(argv[2], &network)) return 2;
+    CardanoAddressPayload p;
+    if (!parseHex(argv[3], p.pubKeyHash, CARDANO_KEY_HASH_LEN) ||
+        !parseHex(argv[4], p.stakeCredHash, CARDANO_KEY_HASH_LEN)) {
+        fprintf(stderr, "Key hashes must be 56 hex characters\n");
+        return 1;
+    }
+    char addr[CARDANO_ADDR_BUF_LEN];
+    encodeCardanoAddressTo(addr, sizeof(addr), p.pubKeyHash, p.stakeCredHash, network);
+    printf("%s\n", addr);
+    return 0;
+}
+
+static int cmdDecode(int argc, char** argv) {
+    if (argc != 3) return 2;
+    CardanoAddressPayload p;
+    uint8_t network;
+    if (!decodeCardanoAddress(argv[2], p.pubKeyHash, p.stakeCredHash, &network)) {
+        fprintf(stderr, "Invalid base address\n");
+        return 1;
+    }
+    printf("%u %s %s\n", network, toHex(p.pubKeyHash, CARDANO_KEY_HASH_LEN).c_str(),
+           toHex(p.stakeCredHash, CARDANO_KEY_HASH_LEN).c_str());
+    return 0;
+}
+
+static int cmdEncodeBatch(int argc, char** argv) {
+    uint8_t network;
+    if (argc < 3 || !parseNetwork(argv[2], &network)) return 2;
+    unsigned threads = argc > 3 ? (unsigned)atoi(argv[3]) : defaultThreads();
+
+    std::vector<CardanoAddressPayload> in;
+    std::string pkh, skh;
+    while (std::cin >> pkh >> skh) {
+        CardanoAddressPayload p;
+        if (!parseHex(pkh, p.pubKeyHash, CARDANO_KEY_HASH_LEN) ||
+            !parseHex(skh, p.stakeCredHash, CARDANO_KEY_HASH_LEN)) {
+            fprintf(stderr, "Bad key hash pair at line %zu\n", in.size() + 1);
+            return 1;
+        }
+        in.push_back(p);
+    }
+
+    std::vector<char> out;
+    encodeAll(in, network, threads, out);
+    for (size_t i = 0; i < in.size(); i++) {
+        puts(out.data() + i * CARDANO_ADDR_BUF_LEN);
+    }
+    return 0;
+}
+
+static int cmdDecodeBatch(int argc, char** argv) {
+    uint8_t network;
+    if (argc < 3 || !parseNetwork(argv[2], &network)) return 2;
+    unsigned threads = argc > 3 ? (unsigned)atoi(argv[3]) : defaultThreads();
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::cin >> line) lines.push_back(line);
+    std::vector<const char*> in;
+    for (auto& l : lines) in.push_back(l.c_str());
+
+    std::vector<CardanoAddressPayload> out;
+    std::vector<char> ok;
+    size_t valid = decodeAll(in, network, threads, out, ok);
+    for (size_t i = 0; i < in.size(); i++) {
+        if (ok[i]) {
+            printf("%s %s\n", toHex(out[i].pubKeyHash, CARDANO_KEY_HASH_LEN).c_str(),
+                   toHex(out[i].stakeCredHash, CARDANO_KEY_HASH_LEN).c_str());
+        } else {
+            printf("invalid\n");
+        }
+    }
+    return valid == in.size() ? 0 : 1;
+}
+
+// Throughput in addresses/sec for the scalar encoder, the batch encoder at
+// 1 and N threads, and the batch decoder at 1 and N threads.
+static int cmdBench(int argc, char** argv) {
+    size_t count = argc > 2 ? (size_t)atol(argv[2]) : 1000000;
+    unsigned threads = argc > 3 ? (unsigned)atoi(argv[3]) : defaultThreads();
+
+    std::mt19937 rng(537);
+    std::vector<CardanoAddressPayload> in(count);
+    for (auto& p : in) {
+        for (auto& b : p.pubKeyHash) b = (uint8_t)rng();
+        for (auto& b : p.stakeCredHash) b = (uint8_t)rng();
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto rate = [count](Clock::time_point t0) {
+        double s = std::chrono::duration<double>(Clock::now() - t0).count();
+        return count / s;
+    };
+
+    std::vector<char> scalar(count * CARDANO_ADDR_BUF_LEN);
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < count; i++) {
+        encodeCardanoAddressTo(scalar.data() + i * CARDANO_ADDR_BUF_LEN, CARDANO_ADDR_BUF_LEN,
+                               in[i].pubKeyHash, in[i].stakeCredHash, 0);
+    }
+    printf("encode scalar        1 thread : %12.0f addr/s\n", rate(t0));
+
+    std::vector<char> batch;
+    t0 = Clock::now();
+    encodeAll(in, 0, 1, batch);
+    printf("encode batch         1 thread : %12.0f addr/s\n", rate(t0));
+    if (memcmp(batch.data(), scalar.data(), scalar.size()) != 0) {
+        fprintf(stderr, "batch output differs from scalar encoder\n");
+        return 1;
+    }
+
+    t0 = Clock::now();
+    encodeAll(in, 0, threads, batch);
+    printf("encode batch %8u threads: %12.0f addr/s\n", threads, rate(t0));
+
+    std::vector<const char*> addrs(count);
+    for (size_t i = 0; i < count; i++) addrs[i] = batch.data() + i * CARDANO_ADDR_BUF_LEN;
+    std::vector<CardanoAddressPayload> decoded;
+    std::vector<char> ok;
+
+    t0 = Clock::now();
+    decodeAll(addrs, 0, 1, decoded, ok);
+    printf("decode batch         1 thread : %12.0f addr/s\n", rate(t0));
+
+    t0 = Clock::now();
+    size_t valid = decodeAll(addrs, 0, threads, decoded, ok);
+    printf("decode batch %8u threads: %12.0f addr/s\n", threads, rate(t0));
+
+    if (valid != count || memcmp(decoded.data(), in.data(), count * sizeof(in[0])) != 0) {
+        fprintf(stderr, "decode did not round-trip\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int rc = 2;
+    if (argc >= 2) {
+        std::string cmd = argv[1];
+        if (cmd == "encode") rc = cmdEncode(argc, argv);
+        else if (cmd == "decode") rc = cmdDecode(argc, argv);
+        else if (cmd == "encode-batch") rc = cmdEncodeBatch(argc, argv);
+        else if (cmd == "decode-batch") rc = cmdDecodeBatch(argc, argv);
+        else if (cmd == "bench") rc = cmdBench(argc, argv);
+    }
+    if (rc == 2) {
+        fprintf(stderr,
+                "usage: bech32 encode <network> <pkh> <skh>    (network: 0 testnet, 1 mainnet)\n"
+                "       bech32 decode <address>\n"
+                "       bech32 encode-batch <network> [threads] < pairs\n"
+                "       bech32 decode-batch <network> [threads] < addresses\n"
+                "       bech32 bench [count] [threads]\n");
+    }
+    return rc;
+}
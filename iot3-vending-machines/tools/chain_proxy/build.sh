@@ -0,0 +1,17 @@
+#!/bin/sh
+# Build the chain proxy and its load test (Linux; needs OpenSSL headers,
+# e.g. libssl-dev).
+#
+# Run from iot3-vending-machines/.
+set -e
+
+OUT=${OUT:-.pio/chain_proxy}
+CXX=${CXX:-g++}
+SRC=tools/chain_proxy
+FLAGS="-std=c++17 -O2 -g -Wall"
+
+mkdir -p "$OUT"
+$CXX $FLAGS $SRC/chain_proxy.cpp $SRC/upstream.cpp $SRC/store.cpp $SRC/http1.cpp -lssl -lcrypto \
+    -o "$OUT/chain_proxy"
+$CXX $FLAGS -pthread $SRC/load_test.cpp $SRC/http1.cpp -o "$OUT/load_test"
+echo "built $OUT/chain_proxy $OUT/load_test"
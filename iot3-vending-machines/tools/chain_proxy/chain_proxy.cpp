@@ -0,0 +1,591 @@
+// Chain proxy: a caching, request-coalescing Blockfrost proxy for sites
+// with many devices.
+//
+// Devices point BLOCKFROST_HOST / BLOCKFROST_PORT at the proxy (plain HTTP
+// on the LAN, BLOCKFROST_TLS 0) instead of the public API. Per route:
+//
+//   /txs/{hash}/utxos               immutable: kept forever in a memory-mapped
+//                                   store (--store) that survives restarts
+//   /assets/{unit}/transactions,    short TTL (--ttl-ms): every device polls
+//   /blocks/..., /mempool/...       these each second, so one answer serves
+//                                   the whole site
+//   other GETs                      coalesced only
+//   POST and the rest               passed through
+//
+// Identical GETs that arrive while one is already upstream join it instead
+// of sending their own. The proxy sends its own project_id (--key or
+// BLOCKFROST_API_KEY), so the devices need none; without one, the first
+// device's is forwarded. Pipelined requests on one connection are answered
+// in order. GET /metrics reports hit ratio and upstream reduction in
+// Prometheus text format.
+//
+// One thread, edge-triggered epoll. tools/chain_proxy/load_test.cpp is the
+// load generator.
+//
+// Build: tools/chain_proxy/build.sh
+//
+// Usage: chain_proxy [--port N] [--upstream HOST] [--upstream-port N]
+//                    [--tls 0|1] [--key PROJECT_ID] [--store PATH]
+//                    [--ttl-ms MS] [--conns N] [--timeout-ms MS]
+
+#include "http1.h"
+#include "store.h"
+#include "upstream.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define TICK_MS 100
+#define TTL_SWEEP_MS 1000
+#define STORE_RESERVE_BYTES (16 << 20)
+#define MAX_BODY_LEN (1 << 20)
+
+struct Options {
+    uint16_t port = 8080;
+    std::string upstream = "cardano-preprod.blockfrost.io";
+    uint16_t upstreamPort = 443;
+    int tls = -1;               // -1: on for port 443
+    std::string key;
+    std::string store = "chain_proxy.store";
+    uint32_t ttlMs = 1000;
+    int conns = 16;
+    uint32_t timeoutMs = 10000;
+};
+
+static Options opt;
+
+// ---- routes ----
+
+enum Route {
+    ROUTE_UTXOS,
+    ROUTE_ASSET_TXS,
+    ROUTE_BLOCKS,
+    ROUTE_MEMPOOL,
+    ROUTE_OTHER,
+    ROUTE_COUNT,
+};
+
+static const char* const ROUTE_NAMES[ROUTE_COUNT] = {"utxos", "asset_txs", "blocks", "mempool", "other"};
+
+enum Policy {
+    POLICY_IMMUTABLE,           // store forever
+    POLICY_TTL,                 // cache for --ttl-ms
+    POLICY_COALESCE,            // share in-flight fetches only
+    POLICY_PASS,                // one upstream request per request
+};
+
+static bool isHash(const std::string& s, size_t at, size_t end) {
+    if (end - at != 64) return false;
+    for (size_t i = at; i < end; i++) {
+        if (!isxdigit((unsigned char)s[i])) return false;
+    }
+    return true;
+}
+
+// Path segments after the optional /api/v0 prefix, query excluded
+static Route classify(const std::string& target) {
+    size_t end = target.find('?');
+    if (end == std::string::npos) end = target.size();
+    size_t at = target.compare(0, 8, "/api/v0/") == 0 ? 8 : 1;
+
+    std::vector<std::pair<size_t, size_t>> seg;
+    while (at <= end) {
+        size_t slash = target.find('/', at);
+        if (slash == std::string::npos || slash > end) slash = end;
+        seg.push_back({at, slash});
+        at = slash + 1;
+    }
+    auto is = [&](size_t i, const char* name) {
+        return i < seg.size() && target.compare(seg[i].first, seg[i].second - seg[i].first, name) == 0;
+    };
+
+    if (seg.size() == 3 && is(0, "txs") && isHash(target, seg[1].first, seg[1].second) && is(2, "utxos")) {
+        return ROUTE_UTXOS;
+    }
+    if (seg.size() == 3 && is(0, "assets") && is(2, "transactions")) return ROUTE_ASSET_TXS;
+    if (is(0, "blocks")) return ROUTE_BLOCKS;
+    if (is(0, "mempool")) return ROUTE_MEMPOOL;
+    return ROUTE_OTHER;
+}
+
+static Policy policyFor(const std::string& method, Route route) {
+    if (method != "GET") return POLICY_PASS;
+    switch (route) {
+    case ROUTE_UTXOS: return POLICY_IMMUTABLE;
+    case ROUTE_ASSET_TXS:
+    case ROUTE_BLOCKS:
+    case ROUTE_MEMPOOL: return opt.ttlMs > 0 ? POLICY_TTL : POLICY_COALESCE;
+    default: return POLICY_COALESCE;
+    }
+}
+
+struct RouteStats {
+    uint64_t requests;
+    uint64_t hits;              // answered from the store or TTL cache
+    uint64_t coalesced;         // joined a fetch already upstream
+    uint64_t upstream;          // sent upstream
+};
+
+static RouteStats routeStats[ROUTE_COUNT];
+
+// ---- state ----
+
+typedef std::shared_ptr<const std::string> Response;
+
+class Client;
+
+struct Waiter {
+    uint64_t client;
+    uint64_t seq;
+};
+
+struct Inflight {
+    std::string key;            // empty: not shared
+    Policy policy;
+    std::vector<Waiter> waiters;
+};
+
+struct TtlEntry {
+    Response response;
+    uint64_t expiresMs;
+};
+
+static int epfd = -1;
+static ImmutableStore store;
+static UpstreamPool upstream;
+static std::unordered_map<uint64_t, Client*> clients;
+static std::vector<Client*> closedClients;          // deleted after the event batch
+static uint64_t nextClientId = 1;
+static std::unordered_map<uint64_t, Inflight> inflight;
+static std::unordered_map<std::string, uint64_t> inflightByKey;
+static uint64_t nextTag = 1;
+static std::unordered_map<std::string, TtlEntry> ttlCache;
+
+static void handleRequest(Client* c, const HttpHead& head, const std::string& body);
+
+// ---- client connections ----
+
+class Client : public EventSource {
+public:
+    Client(int fd, uint64_t id) : fd(fd), id(id) {}
+    ~Client() override { ::close(fd); }
+
+    void onEvent(uint32_t events) override;
+
+    // Request `seq` is answered; responses leave in request order
+    void answer(uint64_t seq, const Response& r);
+    void answer(uint64_t seq, const char* data, size_t len);
+    uint64_t begin() {
+        pending.push_back(nullptr);
+        return seqBase + pending.size() - 1;
+    }
+
+    int fd;
+    uint64_t id;
+    bool closeAfter = false;    // close once everything queued is sent
+
+private:
+    void release();
+    void flush();
+    void close();
+
+    std::string in;
+    std::string out;
+    size_t outSent = 0;
+    uint64_t seqBase = 0;
+    std::deque<Response> pending;
+    bool closed = false;
+};
+
+void Client::close() {
+    if (closed) return;
+    closed = true;
+    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+    clients.erase(id);
+    closedClients.push_back(this);
+}
+
+void Client::flush() {
+    while (outSent < out.size()) {
+        ssize_t n = send(fd, out.data() + outSent, out.size() - outSent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno != EAGAIN) close();
+            return;
+        }
+        outSent += n;
+    }
+    out.clear();
+    outSent = 0;
+    if (closeAfter && pending.empty()) close();
+}
+
+void Client::release() {
+    while (!pending.empty() && pending.front()) {
+        out += *pending.front();
+        pending.pop_front();
+        seqBase++;
+    }
+    flush();
+}
+
+void Client::answer(uint64_t seq, const Response& r) {
+    if (closed) return;
+    pending[seq - seqBase] = r;
+    release();
+}
+
+void Client::answer(uint64_t seq, const char* data, size_t len) {
+    if (closed) return;
+    if (seq != seqBase) {
+        answer(seq, std::make_shared<const std::string>(data, len));
+        return;
+    }
+    // Next in line: no copy beyond the output buffer
+    out.append(data, len);
+    pending.pop_front();
+    seqBase++;
+    release();
+}
+
+static std::string errorResponse(int status, const char* message) {
+    std::string body = "{\"status_code\":" + std::to_string(status) + ",\"error\":\"" + httpReason(status) +
+                       "\",\"message\":\"" + message + "\"}";
+    return "HTTP/1.1 " + std::to_string(status) + " " + httpReason(status) +
+           "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\n\r\n" + body;
+}
+
+void Client::onEvent(uint32_t events) {
+    if (closed) return;
+    bool eof = (events & (EPOLLHUP | EPOLLERR)) != 0;
+    char buf[16384];
+    while (!eof) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            in.append(buf, n);
+        } else if (n == 0 || errno != EAGAIN) {
+            eof = true;
+        } else {
+            break;
+        }
+    }
+
+    size_t at = 0;
+    while (!closeAfter && at < in.size()) {
+        HttpHead head;
+        HttpParse p = parseRequestHead(in.data() + at, in.size() - at, &head);
+        if (p == HTTP_INCOMPLETE) break;
+        if (p == HTTP_BAD || head.chunked || head.contentLength > MAX_BODY_LEN) {
+            std::string r = errorResponse(400, "malformed request");
+            answer(begin(), r.data(), r.size());
+            closeAfter = true;
+            break;
+        }
+        size_t bodyLen = head.contentLength > 0 ? head.contentLength : 0;
+        if (in.size() - at < head.headLen + bodyLen) break;
+        std::string body = in.substr(at + head.headLen, bodyLen);
+        at += head.headLen + bodyLen;
+        if (head.close) closeAfter = true;
+        handleRequest(this, head, body);
+        if (closed) return;
+    }
+    in.erase(0, at);
+
+    if (eof) {
+        // Half-closed: answers still owed are dropped with the socket
+        close();
+        return;
+    }
+    flush();
+}
+
+class Listener : public EventSource {
+public:
+    explicit Listener(int fd) : fd(fd) {}
+    void onEvent(uint32_t events) override;
+    int fd;
+};
+
+void Listener::onEvent(uint32_t) {
+    while (true) {
+        int cfd = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cfd < 0) {
+            if (errno == EMFILE || errno == ENFILE) perror("accept");
+            return;
+        }
+        int one = 1;
+        setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        Client* c = new Client(cfd, nextClientId++);
+        clients[c->id] = c;
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = static_cast<EventSource*>(c);
+        epoll_ctl(epfd, EPOLL_CTL_ADD, cfd, &ev);
+    }
+}
+
+// ---- requests ----
+
+static std::string metricsText();
+
+static Response buildResponse(const UpstreamResult& r) {
+    std::string s = "HTTP/1.1 " + std::to_string(r.status) + " " + httpReason(r.status) + "\r\n";
+    if (!r.contentType.empty()) s += "Content-Type: " + r.contentType + "\r\n";
+    if (!r.contentEncoding.empty()) s += "Content-Encoding: " + r.contentEncoding + "\r\n";
+    s += "Content-Length: " + std::to_string(r.body.size()) + "\r\n\r\n";
+    s += r.body;
+    return std::make_shared<const std::string>(std::move(s));
+}
+
+static void handleRequest(Client* c, const HttpHead& head, const std::string& body) {
+    uint64_t seq = c->begin();
+
+    if (head.method == "GET" && head.target == "/metrics") {
+        std::string text = metricsText();
+        std::string r = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                        std::to_string(text.size()) + "\r\n\r\n" + text;
+        c->answer(seq, r.data(), r.size());
+        return;
+    }
+
+    Route route = classify(head.target);
+    Policy policy = policyFor(head.method, route);
+    RouteStats& stats = routeStats[route];
+    stats.requests++;
+
+    // Responses differ by encoding; everything that takes gzip shares one
+    bool gzip = strcasestr(head.acceptEncoding.c_str(), "gzip") != nullptr;
+    std::string key = head.target + (gzip ? "\ngzip" : "\nidentity");
+
+    if (policy == POLICY_IMMUTABLE) {
+        size_t len;
+        const char* data = store.get(key, &len);
+        if (data) {
+            stats.hits++;
+            c->answer(seq, data, len);
+            return;
+        }
+    } else if (policy == POLICY_TTL) {
+        auto it = ttlCache.find(key);
+        if (it != ttlCache.end() && it->second.expiresMs > monoMs()) {
+            stats.hits++;
+            c->answer(seq, it->second.response);
+            return;
+        }
+    }
+
+    if (policy != POLICY_PASS) {
+        auto it = inflightByKey.find(key);
+        if (it != inflightByKey.end()) {
+            stats.coalesced++;
+            inflight[it->second].waiters.push_back({c->id, seq});
+            return;
+        }
+    }
+
+    uint64_t tag = nextTag++;
+    Inflight& f = inflight[tag];
+    f.policy = policy;
+    f.waiters.push_back({c->id, seq});
+    if (policy != POLICY_PASS) {
+        f.key = key;
+        inflightByKey[key] = tag;
+    }
+    stats.upstream++;
+
+    const std::string& projectId = opt.key.empty() ? head.projectId : opt.key;
+    std::string headers;
+    if (!projectId.empty()) headers += "project_id: " + projectId + "\r\n";
+    if (gzip) headers += "Accept-Encoding: gzip\r\n";
+    if (!head.contentType.empty()) headers += "Content-Type: " + head.contentType + "\r\n";
+    upstream.fetch(tag, head.method, head.target, headers, body);
+}
+
+static void onUpstream(uint64_t tag, const UpstreamResult& result) {
+    auto it = inflight.find(tag);
+    if (it == inflight.end()) return;
+    Inflight f = std::move(it->second);
+    inflight.erase(it);
+    if (!f.key.empty()) inflightByKey.erase(f.key);
+
+    if (!result.error.empty()) fprintf(stderr, "upstream: %s\n", result.error.c_str());
+    Response r = buildResponse(result);
+    if (f.policy == POLICY_IMMUTABLE && result.status == 200) {
+        store.put(f.key, r->data(), r->size());
+    } else if (f.policy == POLICY_TTL && (result.status == 200 || result.status == 404)) {
+        ttlCache[f.key] = {r, monoMs() + opt.ttlMs};
+    }
+
+    for (const Waiter& w : f.waiters) {
+        auto c = clients.find(w.client);
+        if (c != clients.end()) c->second->answer(w.seq, r);
+    }
+}
+
+static void sweepTtlCache(uint64_t now) {
+    for (auto it = ttlCache.begin(); it != ttlCache.end();) {
+        if (it->second.expiresMs <= now) it = ttlCache.erase(it);
+        else ++it;
+    }
+}
+
+// ---- metrics ----
+
+static std::string metricsText() {
+    std::string s;
+    char line[160];
+    uint64_t requests = 0, hits = 0, coalesced = 0, sent = 0;
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        const RouteStats& st = routeStats[r];
+        snprintf(line, sizeof(line), "proxy_requests_total{route=\"%s\"} %llu\n", ROUTE_NAMES[r],
+                 (unsigned long long)st.requests);
+        s += line;
+        snprintf(line, sizeof(line), "proxy_cache_hits_total{route=\"%s\"} %llu\n", ROUTE_NAMES[r],
+                 (unsigned long long)st.hits);
+        s += line;
+        snprintf(line, sizeof(line), "proxy_coalesced_total{route=\"%s\"} %llu\n", ROUTE_NAMES[r],
+                 (unsigned long long)st.coalesced);
+        s += line;
+        snprintf(line, sizeof(line), "proxy_upstream_requests_total{route=\"%s\"} %llu\n", ROUTE_NAMES[r],
+                 (unsigned long long)st.upstream);
+        s += line;
+        requests += st.requests;
+        hits += st.hits;
+        coalesced += st.coalesced;
+        sent += st.upstream;
+    }
+    // Hit ratio: answered from a cache. Reduction: requests that did not
+    // become an upstream request, coalesced ones included.
+    snprintf(line, sizeof(line), "proxy_hit_ratio %.4f\n", requests ? (double)hits / requests : 0.0);
+    s += line;
+    snprintf(line, sizeof(line), "proxy_upstream_reduction_ratio %.4f\n",
+             requests ? 1.0 - (double)sent / requests : 0.0);
+    s += line;
+
+    const UpstreamStats& u = upstream.stats();
+    snprintf(line, sizeof(line),
+             "proxy_upstream_errors_total %llu\nproxy_upstream_retries_total %llu\n"
+             "proxy_upstream_connects_total %llu\nproxy_upstream_connections %u\nproxy_upstream_queued %zu\n",
+             (unsigned long long)u.errors, (unsigned long long)u.retries, (unsigned long long)u.connects,
+             u.open, upstream.queued());
+    s += line;
+    snprintf(line, sizeof(line), "proxy_clients %zu\nproxy_inflight %zu\nproxy_ttl_entries %zu\n",
+             clients.size(), inflight.size(), ttlCache.size());
+    s += line;
+    snprintf(line, sizeof(line), "proxy_store_entries %zu\nproxy_store_bytes %zu\n", store.entries(),
+             store.bytes());
+    s += line;
+    return s;
+}
+
+// ---- main ----
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s [--port N] [--upstream HOST] [--upstream-port N] [--tls 0|1]\n"
+        "          [--key PROJECT_ID] [--store PATH] [--ttl-ms MS] [--conns N]\n"
+        "          [--timeout-ms MS]\n", prog);
+    exit(2);
+}
+
+static void parseArgs(int argc, char** argv) {
+    const char* env = getenv("BLOCKFROST_API_KEY");
+    if (env) opt.key = env;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (i + 1 >= argc) usage(argv[0]);
+        const char* v = argv[++i];
+        if (strcmp(a, "--port") == 0) opt.port = atoi(v);
+        else if (strcmp(a, "--upstream") == 0) opt.upstream = v;
+        else if (strcmp(a, "--upstream-port") == 0) opt.upstreamPort = atoi(v);
+        else if (strcmp(a, "--tls") == 0) opt.tls = atoi(v) != 0;
+        else if (strcmp(a, "--key") == 0) opt.key = v;
+        else if (strcmp(a, "--store") == 0) opt.store = v;
+        else if (strcmp(a, "--ttl-ms") == 0) opt.ttlMs = atoi(v);
+        else if (strcmp(a, "--conns") == 0) opt.conns = atoi(v);
+        else if (strcmp(a, "--timeout-ms") == 0) opt.timeoutMs = atoi(v);
+        else usage(argv[0]);
+    }
+    if (opt.port == 0 || opt.upstreamPort == 0 || opt.conns < 1 || opt.timeoutMs == 0) usage(argv[0]);
+    if (opt.tls < 0) opt.tls = opt.upstreamPort == 443;
+}
+
+int main(int argc, char** argv) {
+    parseArgs(argc, argv);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+
+    if (!store.open(opt.store.c_str(), STORE_RESERVE_BYTES)) {
+        fprintf(stderr, "store %s: %s\n", opt.store.c_str(), strerror(errno));
+        return 1;
+    }
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (!upstream.init(epfd, opt.upstream, opt.upstreamPort, opt.tls, opt.conns, opt.timeoutMs, onUpstream)) {
+        fprintf(stderr, "cannot resolve %s\n", opt.upstream.c_str());
+        return 1;
+    }
+
+    int lfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt.port);
+    if (bind(lfd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(lfd, 1024) != 0) {
+        perror("listen");
+        return 1;
+    }
+    Listener listener(lfd);
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = static_cast<EventSource*>(&listener);
+    epoll_ctl(epfd, EPOLL_CTL_ADD, lfd, &ev);
+
+    printf("chain proxy on :%u -> %s:%u%s, store %s (%zu entries), ttl %ums\n", opt.port,
+           opt.upstream.c_str(), opt.upstreamPort, opt.tls ? " (TLS)" : "", opt.store.c_str(),
+           store.entries(), opt.ttlMs);
+    fflush(stdout);
+
+    uint64_t nextTick = monoMs() + TICK_MS;
+    uint64_t nextSweep = monoMs() + TTL_SWEEP_MS;
+    epoll_event events[256];
+    while (true) {
+        int n = epoll_wait(epfd, events, 256, TICK_MS);
+        for (int i = 0; i < n; i++) {
+            static_cast<EventSource*>(events[i].data.ptr)->onEvent(events[i].events);
+        }
+        for (Client* c : closedClients) delete c;
+        closedClients.clear();
+
+        uint64_t now = monoMs();
+        if (now >= nextTick) {
+            upstream.tick(now);
+            nextTick = now + TICK_MS;
+        }
+        if (now >= nextSweep) {
+            sweepTtlCache(now);
+            nextSweep = now + TTL_SWEEP_MS;
+        }
+    }
+}
@@ -0,0 +1,145 @@
+// HTTP/1.1 heads and chunked bodies
+
+#include "http1.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_HEAD_LEN 16384
+
+static const char* findHeadEnd(const char* buf, size_t len) {
+    for (size_t i = 3; i < len; i++) {
+        if (buf[i] == '\n' && buf[i - 1] == '\r' && buf[i - 2] == '\n' && buf[i - 3] == '\r') return buf + i + 1;
+    }
+    return nullptr;
+}
+
+static std::string trim(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    return std::string(p, end);
+}
+
+static bool nameIs(const char* p, const char* colon, const char* name) {
+    size_t n = strlen(name);
+    return (size_t)(colon - p) == n && strncasecmp(p, name, n) == 0;
+}
+
+// Header lines from `p` (just after the start line) to `end`
+static bool parseHeaders(const char* p, const char* end, HttpHead* head) {
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (!eol) return false;
+        if (eol - p <= 1) break;            // blank line
+        const char* colon = (const char*)memchr(p, ':', eol - p);
+        if (!colon) return false;
+        std::string value = trim(colon + 1, eol);
+
+        if (nameIs(p, colon, "Content-Length")) {
+            char* rest;
+            head->contentLength = strtol(value.c_str(), &rest, 10);
+            if (*rest || head->contentLength < 0) return false;
+        } else if (nameIs(p, colon, "Transfer-Encoding")) {
+            head->chunked = strcasestr(value.c_str(), "chunked") != nullptr;
+        } else if (nameIs(p, colon, "Connection")) {
+            if (strcasecmp(value.c_str(), "close") == 0) head->close = true;
+            if (strcasecmp(value.c_str(), "keep-alive") == 0) head->close = false;
+        } else if (nameIs(p, colon, "Content-Type")) {
+            head->contentType = value;
+        } else if (nameIs(p, colon, "Content-Encoding")) {
+            head->contentEncoding = value;
+        } else if (nameIs(p, colon, "Accept-Encoding")) {
+            head->acceptEncoding = value;
+        } else if (nameIs(p, colon, "project_id")) {
+            head->projectId = value;
+        }
+        p = eol + 1;
+    }
+    return true;
+}
+
+HttpParse parseRequestHead(const char* buf, size_t len, HttpHead* head) {
+    const char* end = findHeadEnd(buf, len < MAX_HEAD_LEN ? len : MAX_HEAD_LEN);
+    if (!end) return len < MAX_HEAD_LEN ? HTTP_INCOMPLETE : HTTP_BAD;
+    *head = HttpHead();
+    head->headLen = end - buf;
+
+    // METHOD SP target SP HTTP/1.x CRLF
+    const char* eol = (const char*)memchr(buf, '\n', end - buf);
+    const char* sp1 = (const char*)memchr(buf, ' ', eol - buf);
+    if (!sp1) return HTTP_BAD;
+    const char* sp2 = (const char*)memchr(sp1 + 1, ' ', eol - sp1 - 1);
+    if (!sp2 || eol - sp2 < 9 || strncmp(sp2 + 1, "HTTP/1.", 7) != 0) return HTTP_BAD;
+    head->method.assign(buf, sp1);
+    head->target.assign(sp1 + 1, sp2);
+    head->close = sp2[8] == '0';
+    return parseHeaders(eol + 1, end, head) ? HTTP_OK : HTTP_BAD;
+}
+
+HttpParse parseResponseHead(const char* buf, size_t len, HttpHead* head) {
+    const char* end = findHeadEnd(buf, len < MAX_HEAD_LEN ? len : MAX_HEAD_LEN);
+    if (!end) return len < MAX_HEAD_LEN ? HTTP_INCOMPLETE : HTTP_BAD;
+    *head = HttpHead();
+    head->headLen = end - buf;
+
+    // HTTP/1.x SP status SP reason CRLF
+    if (strncmp(buf, "HTTP/1.", 7) != 0 || buf[8] != ' ') return HTTP_BAD;
+    head->close = buf[7] == '0';
+    head->status = atoi(buf + 9);
+    if (head->status < 100 || head->status > 599) return HTTP_BAD;
+    const char* eol = (const char*)memchr(buf, '\n', end - buf);
+    return parseHeaders(eol + 1, end, head) ? HTTP_OK : HTTP_BAD;
+}
+
+HttpParse dechunk(const char* buf, size_t len, std::string* body, size_t* consumed) {
+    size_t start = body->size();
+    size_t i = 0;
+    while (true) {
+        const char* eol = (const char*)memchr(buf + i, '\n', len - i);
+        if (!eol) break;
+        char* rest;
+        unsigned long size = strtoul(buf + i, &rest, 16);
+        if (rest == buf + i) {
+            body->resize(start);
+            return HTTP_BAD;
+        }
+        i = eol - buf + 1;
+        if (size == 0) {
+            // Trailers, then a blank line
+            while (true) {
+                eol = (const char*)memchr(buf + i, '\n', len - i);
+                if (!eol) break;
+                bool blank = eol - (buf + i) <= 1;
+                i = eol - buf + 1;
+                if (blank) {
+                    *consumed = i;
+                    return HTTP_OK;
+                }
+            }
+            break;
+        }
+        if (len - i < size + 2) break;
+        body->append(buf + i, size);
+        i += size + 2;
+    }
+    body->resize(start);
+    return HTTP_INCOMPLETE;
+}
+
+const char* httpReason(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 418: return "I'm a teapot";
+    case 425: return "Too Early";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default: return "Status";
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef CHAIN_PROXY_HTTP1_H
+#define CHAIN_PROXY_HTTP1_H
+
+#include <stddef.h>
+#include <string>
+
+// HTTP/1.1 message framing for the proxy and its load test: heads,
+// Content-Length and chunked bodies. Enough for Blockfrost, the stand-in
+// and the firmware's http_stream, not a general-purpose parser.
+
+struct HttpHead {
+    // Requests
+    std::string method;
+    std::string target;
+    // Responses
+    int status = 0;
+
+    size_t headLen = 0;         // bytes up to and including the blank line
+    long contentLength = -1;    // -1: absent
+    bool chunked = false;
+    bool close = false;         // "Connection: close" (or HTTP/1.0)
+
+    std::string contentType;
+    std::string contentEncoding;
+    std::string acceptEncoding;
+    std::string projectId;
+};
+
+enum HttpParse {
+    HTTP_INCOMPLETE,
+    HTTP_OK,
+    HTTP_BAD,
+};
+
+// Parse the head at the start of `buf`
+HttpParse parseRequestHead(const char* buf, size_t len, HttpHead* head);
+HttpParse parseResponseHead(const char* buf, size_t len, HttpHead* head);
+
+// Chunked body starting at `buf`, appended to `body`. On HTTP_OK,
+// `*consumed` is the length of the encoded body, trailers included.
+HttpParse dechunk(const char* buf, size_t len, std::string* body, size_t* consumed);
+
+const char* httpReason(int status);
+
+#endif
@@ -0,0 +1,336 @@
+// Load test for the chain proxy (or the stand-in, or anything serving the
+// Blockfrost paths).
+//
+// Opens --conns keep-alive connections spread over --threads threads, each
+// keeping --pipeline GETs outstanding, and cycles through the paths one
+// pump controller poll requests: the asset's newest transaction, the latest
+// block, and that transaction's UTxOs (hash looked up once at start).
+// Reports throughput, latency percentiles and statuses, then the target's
+// proxy_* ratios from GET /metrics when it has them.
+//
+// Build: tools/chain_proxy/build.sh
+//
+// Usage: load_test [--host IP] [--port N] [--conns N] [--threads N]
+//                  [--duration S] [--pipeline N] [--gzip 0|1] [--path P]...
+
+#include "http1.h"
+#include "../../include/config.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define LATENCY_BUCKET_US 10
+#define LATENCY_BUCKETS 100000      // 10 us steps up to 1 s, then the last bucket
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080;
+    int conns = 64;
+    int threads = 4;
+    int durationS = 10;
+    int pipeline = 4;
+    bool gzip = true;
+    std::vector<std::string> paths;
+};
+
+static Options opt;
+static std::atomic<bool> stop(false);
+
+static uint64_t monoUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int connectTo(bool blocking) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | (blocking ? 0 : SOCK_NONBLOCK), 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opt.port);
+    inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One blocking GET for setup and the metrics at the end; the body, or ""
+static std::string fetchOnce(const std::string& path, int* status) {
+    *status = 0;
+    int fd = connectTo(true);
+    if (fd < 0) return "";
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: " + opt.host + "\r\nConnection: close\r\n\r\n";
+    send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+    std::string in;
+    char buf[16384];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) in.append(buf, n);
+    close(fd);
+
+    HttpHead head;
+    if (parseResponseHead(in.data(), in.size(), &head) != HTTP_OK) return "";
+    *status = head.status;
+    std::string body;
+    size_t consumed;
+    if (head.chunked) {
+        dechunk(in.data() + head.headLen, in.size() - head.headLen, &body, &consumed);
+        return body;
+    }
+    return in.substr(head.headLen);
+}
+
+struct Conn {
+    int fd;
+    size_t next;                // index into the request cycle
+    std::string out;
+    size_t outSent;
+    std::string in;
+    std::deque<uint64_t> sentUs;
+};
+
+struct ThreadStats {
+    uint64_t responses = 0;
+    uint64_t ok = 0;            // 200
+    uint64_t errors = 0;        // connection errors
+    uint64_t statuses[6] = {};  // by class: [2] 2xx ... [5] 5xx
+    std::vector<uint32_t> latency = std::vector<uint32_t>(LATENCY_BUCKETS);
+    uint32_t maxUs = 0;
+};
+
+static std::vector<std::string> requests;   // wire bytes per path
+
+static void queueRequests(Conn& c) {
+    while (c.sentUs.size() < (size_t)opt.pipeline) {
+        c.out += requests[c.next++ % requests.size()];
+        c.sentUs.push_back(monoUs());
+    }
+}
+
+static bool flushConn(Conn& c) {
+    while (c.outSent < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + c.outSent, c.out.size() - c.outSent, MSG_NOSIGNAL);
+        if (n < 0) return errno == EAGAIN;
+        c.outSent += n;
+    }
+    c.out.clear();
+    c.outSent = 0;
+    return true;
+}
+
+// Parse complete responses; false on a broken stream
+static bool readResponses(Conn& c, ThreadStats& st) {
+    size_t at = 0;
+    while (at < c.in.size() && !c.sentUs.empty()) {
+        HttpHead head;
+        HttpParse p = parseResponseHead(c.in.data() + at, c.in.size() - at, &head);
+        if (p == HTTP_BAD) return false;
+        if (p == HTTP_INCOMPLETE) break;
+        size_t len;
+        if (head.chunked) {
+            std::string body;
+            size_t consumed;
+            p = dechunk(c.in.data() + at + head.headLen, c.in.size() - at - head.headLen, &body, &consumed);
+            if (p == HTTP_BAD) return false;
+            if (p == HTTP_INCOMPLETE) break;
+            len = head.headLen + consumed;
+        } else {
+            if (head.contentLength < 0) return false;
+            len = head.headLen + head.contentLength;
+            if (c.in.size() - at < len) break;
+        }
+        at += len;
+
+        uint64_t us = monoUs() - c.sentUs.front();
+        c.sentUs.pop_front();
+        st.responses++;
+        if (head.status == 200) st.ok++;
+        st.statuses[head.status / 100 < 6 ? head.status / 100 : 5]++;
+        size_t bucket = us / LATENCY_BUCKET_US;
+        st.latency[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+        if (us > st.maxUs) st.maxUs = us;
+    }
+    c.in.erase(0, at);
+    return true;
+}
+
+static void runThread(int conns, size_t offset, ThreadStats* st) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Conn> cs(conns);
+    for (int i = 0; i < conns; i++) {
+        Conn& c = cs[i];
+        c.fd = connectTo(false);
+        c.next = offset + i;
+        c.outSent = 0;
+        if (c.fd < 0) {
+            st->errors++;
+            continue;
+        }
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.u32 = i;
+        epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+        queueRequests(c);
+    }
+
+    epoll_event events[256];
+    char buf[65536];
+    while (!stop.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(ep, events, 256, 100);
+        for (int i = 0; i < n; i++) {
+            Conn& c = cs[events[i].data.u32];
+            if (c.fd < 0) continue;
+            bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP));
+            while (alive) {
+                ssize_t r = read(c.fd, buf, sizeof(buf));
+                if (r > 0) c.in.append(buf, r);
+                else if (r == 0 || errno != EAGAIN) alive = false;
+                else break;
+            }
+            alive = alive && readResponses(c, *st);
+            if (alive) queueRequests(c);
+            alive = alive && flushConn(c);
+            if (!alive) {
+                st->errors++;
+                close(c.fd);
+                c.fd = -1;
+            }
+        }
+    }
+    for (Conn& c : cs) {
+        if (c.fd >= 0) close(c.fd);
+    }
+    close(ep);
+}
+
+static uint32_t percentileUs(const std::vector<uint32_t>& hist, uint64_t total, double pct) {
+    uint64_t rank = (uint64_t)(total * pct / 100.0);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < hist.size(); i++) {
+        seen += hist[i];
+        if (seen > rank) return (i + 1) * LATENCY_BUCKET_US;
+    }
+    return hist.size() * LATENCY_BUCKET_US;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s [--host IP] [--port N] [--conns N] [--threads N] [--duration S]\n"
+        "          [--pipeline N] [--gzip 0|1] [--path P]...\n", prog);
+    exit(2);
+}
+
+static void parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (i + 1 >= argc) usage(argv[0]);
+        const char* v = argv[++i];
+        if (strcmp(a, "--host") == 0) opt.host = v;
+        else if (strcmp(a, "--port") == 0) opt.port = atoi(v);
+        else if (strcmp(a, "--conns") == 0) opt.conns = atoi(v);
+        else if (strcmp(a, "--threads") == 0) opt.threads = atoi(v);
+        else if (strcmp(a, "--duration") == 0) opt.durationS = atoi(v);
+        else if (strcmp(a, "--pipeline") == 0) opt.pipeline = atoi(v);
+        else if (strcmp(a, "--gzip") == 0) opt.gzip = atoi(v) != 0;
+        else if (strcmp(a, "--path") == 0) opt.paths.push_back(v);
+        else usage(argv[0]);
+    }
+    struct in_addr tmp;
+    if (opt.conns < 1 || opt.threads < 1 || opt.durationS < 1 || opt.pipeline < 1 ||
+        inet_pton(AF_INET, opt.host.c_str(), &tmp) != 1) {
+        usage(argv[0]);
+    }
+    if (opt.threads > opt.conns) opt.threads = opt.conns;
+}
+
+int main(int argc, char** argv) {
+    parseArgs(argc, argv);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (opt.paths.empty()) {
+        std::string assetTxs = std::string("/api/v0/assets/") + ASSET_UNIT + "/transactions?order=desc&count=1";
+        int status;
+        std::string body = fetchOnce(assetTxs, &status);
+        size_t at = body.find("\"tx_hash\"");
+        size_t q = at == std::string::npos ? at : body.find('"', body.find(':', at));
+        if (status != 200 || q == std::string::npos) {
+            fprintf(stderr, "GET %s: status %d, no tx_hash\n", assetTxs.c_str(), status);
+            return 1;
+        }
+        std::string hash = body.substr(q + 1, 64);
+        opt.paths = {assetTxs, "/api/v0/blocks/latest", "/api/v0/txs/" + hash + "/utxos"};
+    }
+    for (const std::string& p : opt.paths) {
+        requests.push_back("GET " + p + " HTTP/1.1\r\nHost: " + opt.host + "\r\n" +
+                           (opt.gzip ? "Accept-Encoding: gzip, deflate\r\n" : "") + "\r\n");
+    }
+
+    printf("%d conns x %d pipelined, %d threads, %ds -> %s:%u, %zu paths\n", opt.conns, opt.pipeline,
+           opt.threads, opt.durationS, opt.host.c_str(), opt.port, opt.paths.size());
+
+    std::vector<ThreadStats> stats(opt.threads);
+    std::vector<std::thread> threads;
+    uint64_t t0 = monoUs();
+    for (int t = 0; t < opt.threads; t++) {
+        int conns = opt.conns / opt.threads + (t < opt.conns % opt.threads ? 1 : 0);
+        threads.emplace_back(runThread, conns, (size_t)t * 7, &stats[t]);
+    }
+    sleep(opt.durationS);
+    stop = true;
+    for (auto& th : threads) th.join();
+    double seconds = (monoUs() - t0) / 1e6;
+
+    ThreadStats total;
+    for (const ThreadStats& st : stats) {
+        total.responses += st.responses;
+        total.ok += st.ok;
+        total.errors += st.errors;
+        for (int i = 0; i < 6; i++) total.statuses[i] += st.statuses[i];
+        for (size_t i = 0; i < LATENCY_BUCKETS; i++) total.latency[i] += st.latency[i];
+        total.maxUs = std::max(total.maxUs, st.maxUs);
+    }
+
+    printf("\nresponses  %llu, %.0f req/s, %llu x 200, %llu x 4xx, %llu x 5xx, %llu conn errors\n",
+           (unsigned long long)total.responses, total.responses / seconds, (unsigned long long)total.ok,
+           (unsigned long long)total.statuses[4], (unsigned long long)total.statuses[5],
+           (unsigned long long)total.errors);
+    printf("latency    p50=%uus p99=%uus p99.9=%uus max=%uus\n",
+           percentileUs(total.latency, total.responses, 50), percentileUs(total.latency, total.responses, 99),
+           percentileUs(total.latency, total.responses, 99.9), total.maxUs);
+
+    int status;
+    std::string metrics = fetchOnce("/metrics", &status);
+    if (status == 200) {
+        size_t at = 0;
+        while (at < metrics.size()) {
+            size_t eol = metrics.find('\n', at);
+            if (eol == std::string::npos) eol = metrics.size();
+            std::string line = metrics.substr(at, eol - at);
+            if (line.compare(0, 15, "proxy_hit_ratio") == 0 || line.compare(0, 21, "proxy_upstream_reduct") == 0 ||
+                line.compare(0, 29, "proxy_upstream_requests_total") == 0) {
+                printf("%s\n", line.c_str());
+            }
+            at = eol + 1;
+        }
+    }
+    return total.responses > 0 && total.ok == total.responses ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// Memory-mapped immutable response store
+
+#include "store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define STORE_MAGIC "CPXSTOR1"
+#define STORE_HEADER_LEN 16
+#define RECORD_HEADER_LEN 8
+
+static size_t pad8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+static uint32_t load32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+ImmutableStore::~ImmutableStore() {
+    if (base) {
+        memcpy(base + 8, &used, 8);
+        munmap(base, mapped);
+    }
+    if (fd >= 0) close(fd);
+}
+
+bool ImmutableStore::open(const char* path, size_t reserveBytes) {
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+
+    bool fresh = st.st_size < STORE_HEADER_LEN;
+    size_t size = fresh ? pad8(reserveBytes > STORE_HEADER_LEN ? reserveBytes : 1 << 20) : st.st_size;
+    if (fresh && ftruncate(fd, size) != 0) return false;
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return false;
+    base = (char*)p;
+    mapped = size;
+
+    if (fresh) {
+        memcpy(base, STORE_MAGIC, 8);
+        used = STORE_HEADER_LEN;
+        memcpy(base + 8, &used, 8);
+        return true;
+    }
+    if (memcmp(base, STORE_MAGIC, 8) != 0) {
+        errno = EINVAL;
+        return false;
+    }
+    memcpy(&used, base + 8, 8);
+    if (used < STORE_HEADER_LEN || used > mapped) used = STORE_HEADER_LEN;
+
+    // Rebuild the index; a record cut short ends the walk
+    size_t at = STORE_HEADER_LEN;
+    while (at + RECORD_HEADER_LEN <= used) {
+        uint32_t keyLen = load32(base + at);
+        uint32_t valueLen = load32(base + at + 4);
+        size_t next = at + pad8(RECORD_HEADER_LEN + (size_t)keyLen + valueLen);
+        if (next > used) break;
+        std::string key(base + at + RECORD_HEADER_LEN, keyLen);
+        index[key] = {at + RECORD_HEADER_LEN + keyLen, valueLen};
+        at = next;
+    }
+    used = at;
+    return true;
+}
+
+const char* ImmutableStore::get(const std::string& key, size_t* len) const {
+    auto it = index.find(key);
+    if (it == index.end()) return nullptr;
+    *len = it->second.len;
+    return base + it->second.offset;
+}
+
+// Grow the file and the mapping (doubling) to hold `need` bytes
+bool ImmutableStore::reserve(size_t need) {
+    if (need <= mapped) return true;
+    size_t size = mapped;
+    while (size < need) size *= 2;
+    if (ftruncate(fd, size) != 0) return false;
+    void* p = mremap(base, mapped, size, MREMAP_MAYMOVE);
+    if (p == MAP_FAILED) return false;
+    base = (char*)p;
+    mapped = size;
+    return true;
+}
+
+bool ImmutableStore::put(const std::string& key, const char* value, size_t len) {
+    if (!base || index.count(key)) return false;
+    size_t record = pad8(RECORD_HEADER_LEN + key.size() + len);
+    if (!reserve(used + record)) return false;
+
+    char* p = base + used;
+    uint32_t keyLen = key.size();
+    uint32_t valueLen = len;
+    memcpy(p, &keyLen, 4);
+    memcpy(p + 4, &valueLen, 4);
+    memcpy(p + RECORD_HEADER_LEN, key.data(), key.size());
+    memcpy(p + RECORD_HEADER_LEN + key.size(), value, len);
+    index[key] = {used + RECORD_HEADER_LEN + key.size(), len};
+
+    used += record;
+    memcpy(base + 8, &used, 8);
+    return true;
+}
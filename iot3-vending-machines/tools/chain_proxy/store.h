@@ -0,0 +1,52 @@
+#ifndef CHAIN_PROXY_STORE_H
+#define CHAIN_PROXY_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+// Append-only, memory-mapped store for responses that never change, such
+// as /txs/{hash}/utxos (a tx's outputs are fixed by its hash). Entries are
+// never evicted and survive restarts: open() rebuilds the index by walking
+// the file. Records are written before the header's length covers them,
+// so a crash mid-append loses at most that record.
+//
+// File: "CPXSTOR1", u64 used bytes, then records of
+// u32 key length, u32 value length, key, value, padded to 8 bytes.
+class ImmutableStore {
+public:
+    ImmutableStore() = default;
+    ~ImmutableStore();
+    ImmutableStore(const ImmutableStore&) = delete;
+    ImmutableStore& operator=(const ImmutableStore&) = delete;
+
+    // Map `path`, creating it with room for `reserve` bytes if new.
+    // False with errno set on failure.
+    bool open(const char* path, size_t reserve);
+
+    // The stored value, valid until the next put(); nullptr if absent
+    const char* get(const std::string& key, size_t* len) const;
+    // Store a value for a new key; false if the key exists or the file
+    // cannot grow
+    bool put(const std::string& key, const char* value, size_t len);
+
+    size_t entries() const { return index.size(); }
+    size_t bytes() const { return used; }
+
+private:
+    bool reserve(size_t need);
+
+    struct Slot {
+        size_t offset;
+        size_t len;
+    };
+
+    int fd = -1;
+    char* base = nullptr;
+    size_t mapped = 0;
+    size_t used = 0;
+    std::unordered_map<std::string, Slot> index;
+};
+
+#endif
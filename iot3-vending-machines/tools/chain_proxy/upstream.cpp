@@ -0,0 +1,372 @@
+// Upstream connection pool: non-blocking connect, optional TLS, one
+// request per keep-alive connection at a time
+
+#include "upstream.h"
+#include "http1.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#define IO_AGAIN -1
+#define IO_ERROR -2
+
+uint64_t monoMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+class UpstreamConn : public EventSource {
+public:
+    explicit UpstreamConn(UpstreamPool* pool) : pool(pool) {}
+
+    void start(UpstreamPool::Request&& r);
+    void onEvent(uint32_t events) override;
+    void close();
+
+    UpstreamPool::Request req;
+    bool active = false;
+
+private:
+    enum State { DOWN, CONNECTING, HANDSHAKE, READY };
+
+    bool connect();
+    void drive();
+    bool progressTls();
+    long ioRead(char* buf, size_t len);
+    long ioWrite(const char* buf, size_t len);
+    // 1 complete, 0 need more, -1 malformed
+    int parse(bool eof, UpstreamResult* result, bool* reusable);
+
+    UpstreamPool* pool;
+    State state = DOWN;
+    int fd = -1;
+    SSL* ssl = nullptr;
+    bool reused = false;        // a request already completed on this connection
+    size_t sent = 0;
+    std::string in;
+};
+
+bool UpstreamConn::connect() {
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = static_cast<EventSource*>(this);
+    epoll_ctl(pool->epfd, EPOLL_CTL_ADD, fd, &ev);
+
+    pool->counters.connects++;
+    pool->counters.open++;
+    reused = false;
+    state = CONNECTING;
+    if (::connect(fd, (const sockaddr*)&pool->addr, sizeof(pool->addr)) == 0) {
+        state = pool->ssl ? HANDSHAKE : READY;
+    } else if (errno != EINPROGRESS) {
+        return false;
+    }
+    if (state == HANDSHAKE) return progressTls();
+    return true;
+}
+
+void UpstreamConn::close() {
+    if (ssl) {
+        SSL_free(ssl);
+        ssl = nullptr;
+    }
+    if (fd >= 0) {
+        epoll_ctl(pool->epfd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        fd = -1;
+        pool->counters.open--;
+    }
+    state = DOWN;
+    in.clear();
+}
+
+// False on a handshake failure
+bool UpstreamConn::progressTls() {
+    if (!ssl) {
+        ssl = SSL_new(pool->ssl);
+        SSL_set_fd(ssl, fd);
+        SSL_set_tlsext_host_name(ssl, pool->host.c_str());
+        SSL_set1_host(ssl, pool->host.c_str());
+    }
+    int rc = SSL_connect(ssl);
+    if (rc == 1) {
+        state = READY;
+        return true;
+    }
+    int err = SSL_get_error(ssl, rc);
+    return err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE;
+}
+
+long UpstreamConn::ioRead(char* buf, size_t len) {
+    if (ssl) {
+        int n = SSL_read(ssl, buf, len);
+        if (n > 0) return n;
+        int err = SSL_get_error(ssl, n);
+        if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) return IO_AGAIN;
+        return err == SSL_ERROR_ZERO_RETURN ? 0 : IO_ERROR;
+    }
+    ssize_t n = read(fd, buf, len);
+    if (n >= 0) return n;
+    return errno == EAGAIN ? IO_AGAIN : IO_ERROR;
+}
+
+long UpstreamConn::ioWrite(const char* buf, size_t len) {
+    if (ssl) {
+        int n = SSL_write(ssl, buf, len);
+        if (n > 0) return n;
+        int err = SSL_get_error(ssl, n);
+        return err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE ? IO_AGAIN : IO_ERROR;
+    }
+    ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+    if (n >= 0) return n;
+    return errno == EAGAIN ? IO_AGAIN : IO_ERROR;
+}
+
+void UpstreamConn::start(UpstreamPool::Request&& r) {
+    req = std::move(r);
+    active = true;
+    sent = 0;
+    in.clear();
+    if (state == DOWN && !connect()) {
+        close();
+        pool->failed(this, req, "connect: " + std::string(strerror(errno)), false);
+        return;
+    }
+    drive();
+}
+
+void UpstreamConn::onEvent(uint32_t events) {
+    if (state == CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0 || (events & EPOLLERR)) {
+            close();
+            if (active) pool->failed(this, req, "connect: " + std::string(strerror(err)), false);
+            return;
+        }
+        if (!(events & EPOLLOUT)) return;
+        state = pool->ssl ? HANDSHAKE : READY;
+    }
+    drive();
+}
+
+int UpstreamConn::parse(bool eof, UpstreamResult* result, bool* reusable) {
+    HttpHead head;
+    HttpParse p = parseResponseHead(in.data(), in.size(), &head);
+    if (p == HTTP_BAD) return -1;
+    if (p == HTTP_INCOMPLETE) return eof ? -1 : 0;
+
+    const char* body = in.data() + head.headLen;
+    size_t avail = in.size() - head.headLen;
+    size_t consumed;
+    result->body.clear();
+    if (req.wire.compare(0, 5, "HEAD ") == 0 || head.status == 204 || head.status == 304) {
+        consumed = 0;
+    } else if (head.chunked) {
+        p = dechunk(body, avail, &result->body, &consumed);
+        if (p == HTTP_BAD) return -1;
+        if (p == HTTP_INCOMPLETE) return eof ? -1 : 0;
+    } else if (head.contentLength >= 0) {
+        if (avail < (size_t)head.contentLength) return eof ? -1 : 0;
+        consumed = head.contentLength;
+        result->body.assign(body, consumed);
+    } else {
+        // Delimited by the server closing
+        if (!eof) return 0;
+        consumed = avail;
+        result->body.assign(body, consumed);
+        head.close = true;
+    }
+    result->status = head.status;
+    result->contentType = head.contentType;
+    result->contentEncoding = head.contentEncoding;
+    *reusable = !head.close && head.headLen + consumed == in.size();
+    return 1;
+}
+
+void UpstreamConn::drive() {
+    if (state == HANDSHAKE && !progressTls()) {
+        close();
+        if (active) pool->failed(this, req, "TLS handshake failed", false);
+        return;
+    }
+    if (state != READY) return;
+
+    while (active && sent < req.wire.size()) {
+        long n = ioWrite(req.wire.data() + sent, req.wire.size() - sent);
+        if (n == IO_AGAIN) break;
+        if (n <= 0) {
+            bool retry = reused;
+            close();
+            pool->failed(this, req, "send failed", retry);
+            return;
+        }
+        sent += n;
+    }
+
+    char buf[16384];
+    while (true) {
+        long n = ioRead(buf, sizeof(buf));
+        if (n == IO_AGAIN) return;
+        bool eof = n <= 0;
+        if (!eof) in.append(buf, n);
+        if (!active) {
+            // Idle: the server closed a kept-alive connection
+            if (eof) close();
+            else in.clear();
+            if (eof) return;
+            continue;
+        }
+
+        UpstreamResult result;
+        bool reusable = false;
+        int rc = parse(eof, &result, &reusable);
+        if (rc == 0) continue;
+        if (rc < 0) {
+            // A reused connection the server had already closed: resend
+            bool retry = reused && in.empty();
+            close();
+            pool->failed(this, req, eof ? "connection closed" : "malformed response", retry);
+            return;
+        }
+        if (!reusable) close();
+        in.clear();
+        reused = true;
+        pool->finished(this, req, result, reusable);
+        return;
+    }
+}
+
+// ---- pool ----
+
+bool UpstreamPool::init(int ep, const std::string& h, uint16_t port, bool tls, int conns,
+                        uint32_t timeout, Done cb) {
+    epfd = ep;
+    host = h;
+    maxConns = conns > 0 ? conns : 1;
+    timeoutMs = timeout;
+    done = cb;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(h.c_str(), nullptr, &hints, &res) != 0 || !res) return false;
+    addr = *(sockaddr_in*)res->ai_addr;
+    addr.sin_port = htons(port);
+    freeaddrinfo(res);
+
+    if (tls) {
+        ssl = SSL_CTX_new(TLS_client_method());
+        if (!ssl) return false;
+        SSL_CTX_set_default_verify_paths(ssl);
+        SSL_CTX_set_verify(ssl, SSL_VERIFY_PEER, nullptr);
+    }
+    for (int i = 0; i < maxConns; i++) idle.push_back(new UpstreamConn(this));
+    return true;
+}
+
+void UpstreamPool::fetch(uint64_t tag, const std::string& method, const std::string& target,
+                         const std::string& headers, const std::string& body) {
+    std::string wire = method + " " + target + " HTTP/1.1\r\nHost: " + host + "\r\n" + headers;
+    if (!body.empty() || method == "POST") wire += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    wire += "\r\n";
+    wire += body;
+    waiting.push_back({tag, std::move(wire), monoMs(), false});
+    dispatch();
+}
+
+void UpstreamPool::dispatch() {
+    while (!waiting.empty() && !idle.empty()) {
+        UpstreamConn* conn = idle.back();
+        idle.pop_back();
+        busy.push_back(conn);
+        Request req = std::move(waiting.front());
+        waiting.pop_front();
+        counters.requests++;
+        conn->start(std::move(req));
+    }
+}
+
+static void moveConn(std::vector<UpstreamConn*>& from, std::vector<UpstreamConn*>& to, UpstreamConn* conn) {
+    for (size_t i = 0; i < from.size(); i++) {
+        if (from[i] == conn) {
+            from[i] = from.back();
+            from.pop_back();
+            break;
+        }
+    }
+    to.push_back(conn);
+}
+
+void UpstreamPool::finished(UpstreamConn* conn, Request& req, UpstreamResult& result, bool reusable) {
+    (void)reusable;
+    conn->active = false;
+    moveConn(busy, idle, conn);
+    uint64_t tag = req.tag;
+    done(tag, result);
+    dispatch();
+}
+
+void UpstreamPool::failed(UpstreamConn* conn, Request& req, const std::string& error, bool retry) {
+    conn->active = false;
+    moveConn(busy, idle, conn);
+    if (retry && !req.retried) {
+        req.retried = true;
+        counters.retries++;
+        counters.requests--;        // counted again when re-sent
+        waiting.push_front(std::move(req));
+    } else {
+        counters.errors++;
+        UpstreamResult result;
+        result.status = 502;
+        result.contentType = "application/json";
+        result.error = error;
+        result.body = "{\"status_code\":502,\"error\":\"Bad Gateway\",\"message\":\"" + error + "\"}";
+        done(req.tag, result);
+    }
+    dispatch();
+}
+
+void UpstreamPool::tick(uint64_t nowMs) {
+    for (size_t i = 0; i < busy.size();) {
+        UpstreamConn* conn = busy[i];
+        if (nowMs - conn->req.queuedMs < timeoutMs) {
+            i++;
+            continue;
+        }
+        conn->close();
+        conn->active = false;
+        moveConn(busy, idle, conn);
+        counters.errors++;
+        UpstreamResult result = {504, "application/json", "",
+                                 "{\"status_code\":504,\"error\":\"Gateway Timeout\"}", "timeout"};
+        done(conn->req.tag, result);
+    }
+    while (!waiting.empty() && nowMs - waiting.front().queuedMs >= timeoutMs) {
+        counters.errors++;
+        UpstreamResult result = {504, "application/json", "",
+                                 "{\"status_code\":504,\"error\":\"Gateway Timeout\"}", "timeout"};
+        uint64_t tag = waiting.front().tag;
+        waiting.pop_front();
+        done(tag, result);
+    }
+    dispatch();
+}
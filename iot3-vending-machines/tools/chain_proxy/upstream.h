@@ -0,0 +1,90 @@
+#ifndef CHAIN_PROXY_UPSTREAM_H
+#define CHAIN_PROXY_UPSTREAM_H
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+
+typedef struct ssl_ctx_st SSL_CTX;
+typedef struct ssl_st SSL;
+
+uint64_t monoMs();
+
+// Anything registered with the proxy's epoll set (edge-triggered)
+struct EventSource {
+    virtual ~EventSource() = default;
+    virtual void onEvent(uint32_t events) = 0;
+};
+
+struct UpstreamResult {
+    int status;                 // 502 / 504 when the upstream failed
+    std::string contentType;
+    std::string contentEncoding;
+    std::string body;
+    std::string error;          // why it failed, for the log
+};
+
+struct UpstreamStats {
+    uint64_t requests;          // sent upstream
+    uint64_t errors;            // answered 502 / 504 by the pool
+    uint64_t retries;           // re-sent after a kept-alive connection closed
+    uint64_t connects;
+    uint32_t open;              // connections now
+};
+
+class UpstreamConn;
+
+// Keep-alive connections to one API host (plain HTTP or TLS), one request
+// in flight per connection, up to `maxConns`; further requests queue.
+class UpstreamPool {
+public:
+    typedef std::function<void(uint64_t tag, const UpstreamResult& result)> Done;
+
+    // `host` is resolved once, here. False if it cannot be.
+    bool init(int epfd, const std::string& host, uint16_t port, bool tls, int maxConns,
+              uint32_t timeoutMs, Done done);
+
+    // Send `method target` with `headers` (CRLF-terminated lines) and an
+    // optional body; `done(tag, ...)` is called exactly once
+    void fetch(uint64_t tag, const std::string& method, const std::string& target,
+               const std::string& headers, const std::string& body);
+
+    // Fail requests older than the timeout; call every ~100 ms
+    void tick(uint64_t nowMs);
+
+    const UpstreamStats& stats() const { return counters; }
+    size_t queued() const { return waiting.size(); }
+
+private:
+    friend class UpstreamConn;
+
+    struct Request {
+        uint64_t tag;
+        std::string wire;       // request bytes
+        uint64_t queuedMs;      // the timeout counts from here
+        bool retried;
+    };
+
+    void dispatch();
+    void finished(UpstreamConn* conn, Request& req, UpstreamResult& result, bool reusable);
+    void failed(UpstreamConn* conn, Request& req, const std::string& error, bool retry);
+
+    int epfd = -1;
+    std::string host;
+    sockaddr_in addr = {};
+    SSL_CTX* ssl = nullptr;
+    int maxConns = 1;
+    uint32_t timeoutMs = 10000;
+    Done done;
+
+    std::vector<UpstreamConn*> idle;
+    std::vector<UpstreamConn*> busy;
+    std::deque<Request> waiting;
+    UpstreamStats counters = {};
+};
+
+#endif
@@ -0,0 +1,258 @@
+// Host simulation of the confirmation-depth policy against a mock chain.
+//
+// Generates one chain script (blocks every ~20 s, locker lock/unlock txs,
+// and rollbacks of 1-3 blocks whose txs are re-included or lost), then
+// replays it for each depth with ConfirmTracker (src/confirm.cpp) polled
+// the way main.cpp does it: re-read one block and the tip, observe the
+// newest locker tx, act on the decisions.
+//
+// Per depth: block -> dispense latency, dispenses the final chain does not
+// back (false), rolled-back dispenses the tracker flagged (a flagged one
+// can be re-included later, so flagged >= false), false dispenses it did
+// not flag (miss, should be 0), rollbacks it detected and block lookups.
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tools/confirm_sim.cpp src/confirm.cpp -o confirm_sim
+//
+// Usage: ./confirm_sim [hours] [rollback_pct] [seed]
+//   hours          simulated time (default 24)
+//   rollback_pct   chance a new block starts a rollback (default 2)
+//   seed           chain script seed (default 537)
+
+#include "confirm.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#define POLL_MS 1000
+#define MAX_DEPTH 6
+
+enum EventType { EV_BLOCK, EV_TX, EV_ROLLBACK };
+
+struct Event {
+    uint64_t atMs;
+    EventType type;
+    bool locked;            // EV_TX
+    int depth;              // EV_ROLLBACK
+    bool reinclude;         // EV_ROLLBACK
+};
+
+struct Block {
+    uint32_t height;
+    uint32_t id;            // hash = id, unique per block ever minted
+    uint64_t timeMs;
+    std::vector<int> txs;   // locker tx ids
+};
+
+struct Tx {
+    bool locked;
+    uint32_t firstBlockMs;  // first inclusion, for latency
+};
+
+// Blockfrost's view: blocks on the current fork and the txs in them
+struct MockChain {
+    std::vector<Block> blocks;
+    std::vector<Tx> txs;
+    std::vector<int> mempool;
+    uint32_t nextId = 1;
+
+    void mint(uint64_t atMs) {
+        Block b;
+        b.height = blocks.empty() ? 3400000 : blocks.back().height + 1;
+        b.id = nextId++;
+        b.timeMs = atMs;
+        b.txs = mempool;
+        for (int tx : mempool) {
+            if (txs[tx].firstBlockMs == 0) txs[tx].firstBlockMs = atMs;
+        }
+        mempool.clear();
+        blocks.push_back(b);
+    }
+
+    void rollback(int depth, bool reinclude, uint64_t atMs) {
+        if (depth >= (int)blocks.size()) depth = blocks.size() - 1;
+        std::vector<int> dropped;
+        for (int i = 0; i < depth; i++) {
+            dropped.insert(dropped.begin(), blocks.back().txs.begin(), blocks.back().txs.end());
+            blocks.pop_back();
+        }
+        for (int i = 0; i < depth; i++) {
+            if (i == 0 && reinclude) mempool.insert(mempool.begin(), dropped.begin(), dropped.end());
+            mint(atMs);
+        }
+    }
+
+    const Block* at(uint32_t height) const {
+        if (blocks.empty() || height < blocks[0].height || height > blocks.back().height) return nullptr;
+        return &blocks[height - blocks[0].height];
+    }
+
+    // Newest locker tx and its block, or -1
+    int newest(const Block** in) const {
+        for (size_t i = blocks.size(); i-- > 0;) {
+            if (!blocks[i].txs.empty()) {
+                *in = &blocks[i];
+                return blocks[i].txs.back();
+            }
+        }
+        return -1;
+    }
+
+    bool contains(int tx) const {
+        for (const Block& b : blocks) {
+            if (std::find(b.txs.begin(), b.txs.end(), tx) != b.txs.end()) return true;
+        }
+        return false;
+    }
+};
+
+static void hexId(char* out, uint32_t tag, uint32_t id) {
+    snprintf(out, CONFIRM_HASH_LEN + 1, "%08x%056x", tag, id);
+}
+
+static int txId(const char* hash) {
+    return (int)strtoul(hash + 8, nullptr, 16);
+}
+
+static std::vector<Event> makeScript(double hours, double rollbackPct, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::exponential_distribution<double> blockGap(1.0 / 20000.0);
+    std::exponential_distribution<double> txGap(1.0 / 120000.0);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    std::vector<Event> script;
+    uint64_t end = (uint64_t)(hours * 3600000.0);
+    for (uint64_t t = (uint64_t)blockGap(rng); t < end; t += (uint64_t)blockGap(rng) + 1) {
+        script.push_back({t, EV_BLOCK, false, 0, false});
+        if (u(rng) * 100.0 < rollbackPct) {
+            // Mostly single-block forks, as on Cardano
+            double r = u(rng);
+            int depth = r < 0.80 ? 1 : r < 0.95 ? 2 : 3;
+            script.push_back({t + 2000, EV_ROLLBACK, false, depth, u(rng) < 0.5});
+        }
+    }
+    bool locked = false;
+    for (uint64_t t = (uint64_t)txGap(rng); t < end; t += (uint64_t)txGap(rng) + 1) {
+        script.push_back({t, EV_TX, locked, 0, false});
+        locked = !locked;
+    }
+    std::stable_sort(script.begin(), script.end(),
+        [](const Event& a, const Event& b) { return a.atMs < b.atMs; });
+    return script;
+}
+
+struct SimResult {
+    uint32_t dispenses;
+    uint32_t falseDispenses;    // unlock txs dispensed for, gone from the final chain
+    uint32_t flagged;           // rolled-back dispenses the tracker reported
+    uint32_t missed;            // false dispenses it did not report
+    uint32_t rollbacks;
+    double latencyMeanMs;       // unlock's first block -> dispense
+    double latencyP95Ms;
+    double lookupsPerPoll;      // block re-reads
+};
+
+static SimResult simulate(const std::vector<Event>& script, uint32_t depth) {
+    MockChain chain;
+    chain.mint(0);
+    ConfirmTracker confirm(depth, 10);
+
+    std::vector<int> dispensed;
+    std::vector<int> flagged;
+    std::vector<uint32_t> latencies;
+    uint64_t polls = 0;
+    uint64_t lookups = 0;
+    size_t next = 0;
+    uint64_t end = script.empty() ? 0 : script.back().atMs + 600000;
+
+    for (uint64_t now = POLL_MS; now < end; now += POLL_MS) {
+        for (; next < script.size() && script[next].atMs <= now; next++) {
+            const Event& ev = script[next];
+            if (ev.type == EV_BLOCK) {
+                chain.mint(ev.atMs);
+            } else if (ev.type == EV_TX) {
+                chain.txs.push_back({ev.locked, 0});
+                chain.mempool.push_back(chain.txs.size() - 1);
+            } else {
+                chain.rollback(ev.depth, ev.reinclude, ev.atMs);
+            }
+        }
+
+        // One poll: tip + re-read block, then the newest locker tx
+        polls++;
+        char hash[CONFIRM_HASH_LEN + 1];
+        uint32_t check = confirm.checkHeight();
+        const Block* checked = nullptr;
+        if (check > 0) {
+            lookups++;
+            checked = chain.at(check);
+            if (checked) hexId(hash, 0xb10c, checked->id);
+        }
+        confirm.verify(chain.blocks.back().height, check, checked ? hash : nullptr);
+
+        const Block* in = nullptr;
+        int tx = chain.newest(&in);
+        if (tx >= 0) {
+            hexId(hash, 0x7a, tx);
+            confirm.observe(hash, in->height, in->timeMs / 1000, chain.txs[tx].locked);
+        }
+
+        ConfirmDecision d;
+        while ((d = confirm.next()).action != CONFIRM_NONE) {
+            if (d.action == CONFIRM_ROLLBACK) {
+                if (d.flagged) flagged.push_back(txId(d.entry->txHash));
+                continue;
+            }
+            if (d.entry->isLocked || d.restore) continue;
+            int id = txId(d.entry->txHash);
+            dispensed.push_back(id);
+            latencies.push_back(now - chain.txs[id].firstBlockMs);
+        }
+    }
+
+    SimResult r;
+    r.dispenses = dispensed.size();
+    r.falseDispenses = 0;
+    r.missed = 0;
+    for (int id : dispensed) {
+        if (chain.contains(id)) continue;
+        r.falseDispenses++;
+        if (std::find(flagged.begin(), flagged.end(), id) == flagged.end()) r.missed++;
+    }
+    r.flagged = flagged.size();
+    r.rollbacks = confirm.stats().rollbacks;
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (uint32_t l : latencies) sum += l;
+    r.latencyMeanMs = latencies.empty() ? 0 : sum / latencies.size();
+    r.latencyP95Ms = latencies.empty() ? 0 : latencies[latencies.size() * 95 / 100];
+    r.lookupsPerPoll = polls ? (double)lookups / polls : 0;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 24.0;
+    double rollbackPct = argc > 2 ? atof(argv[2]) : 2.0;
+    unsigned seed = argc > 3 ? atoi(argv[3]) : 537;
+
+    std::vector<Event> script = makeScript(hours, rollbackPct, seed);
+    size_t rollbacks[4] = {0, 0, 0, 0};
+    for (const Event& ev : script) {
+        if (ev.type == EV_ROLLBACK) rollbacks[ev.depth]++;
+    }
+    printf("%.0fh, %zu scripted rollbacks (depth 1/2/3: %zu/%zu/%zu), poll %dms\n\n",
+        hours, rollbacks[1] + rollbacks[2] + rollbacks[3],
+        rollbacks[1], rollbacks[2], rollbacks[3], POLL_MS);
+    printf("%5s %9s %12s %11s %7s %7s %5s %9s %13s\n", "depth", "dispenses", "latency avg",
+        "latency p95", "false", "flagged", "miss", "detected", "lookups/poll");
+
+    for (uint32_t depth = 1; depth <= MAX_DEPTH; depth++) {
+        SimResult r = simulate(script, depth);
+        printf("%5u %9u %10.0fms %9.0fms %7u %7u %5u %9u %13.2f\n",
+            depth, r.dispenses, r.latencyMeanMs, r.latencyP95Ms, r.falseDispenses,
+            r.flagged, r.missed, r.rollbacks, r.lookupsPerPoll);
+    }
+    return 0;
+}
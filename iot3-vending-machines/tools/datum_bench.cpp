@@ -0,0 +1,165 @@
+// Host benchmark: generated locker datum decoder vs the TinyCBOR walk.
+//
+// The TinyCBOR path below is the hand-written parser parseDatum() used
+// before the decoders were generated from plutus.json. Both run over the
+// same datums: the usual indefinite-length encoding (fixed-layout path),
+// definite-length lists and a multi-byte integer (general walk), and
+// truncated input. Outputs are checked to match before timing.
+//
+// Build (TinyCBOR is not a firmware dependency; check out the release the
+// old parser used, 0.5.3):
+//   git clone -q --depth 1 -b v0.5.3 https://github.com/intel/tinycbor /tmp/tinycbor
+//   T=/tmp/tinycbor/src
+//   gcc -O2 -c -I$T $T/cborparser.c $T/cborerrorstrings.c
+//   L=../lib/chain_monitor
+//   g++ -std=c++17 -O2 -I$L/include -I$T tools/datum_bench.cpp $L/src/plutus_data.cpp
+//     $L/src/locker_datum.cpp cborparser.o cborerrorstrings.o -o datum_bench
+//
+// Usage: ./datum_bench [iterations]    (default 2000000)
+
+#include "locker_datum.h"
+
+#include <cbor.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// The pre-generator parser: Tag121[ Tag121[pubKeyHash, stakeCredHash], lockStatus ]
+static bool tinycborDecode(const uint8_t* bytes, size_t len, LockerDatum* out) {
+    CborParser parser;
+    CborValue value;
+    if (cbor_parser_init(bytes, len, 0, &parser, &value) != CborNoError) return false;
+
+    CborTag tag;
+    if (!cbor_value_is_tag(&value)) return false;
+    cbor_value_get_tag(&value, &tag);
+    if (tag != 121) return false;
+    cbor_value_skip_tag(&value);
+    if (!cbor_value_is_array(&value)) return false;
+
+    CborValue outerArray;
+    if (cbor_value_enter_container(&value, &outerArray) != CborNoError) return false;
+    if (!cbor_value_is_tag(&outerArray)) return false;
+    cbor_value_get_tag(&outerArray, &tag);
+    if (tag != 121) return false;
+    cbor_value_skip_tag(&outerArray);
+    if (!cbor_value_is_array(&outerArray)) return false;
+
+    CborValue credArray;
+    if (cbor_value_enter_container(&outerArray, &credArray) != CborNoError) return false;
+    size_t n = 28;
+    if (!cbor_value_is_byte_string(&credArray) ||
+        cbor_value_copy_byte_string(&credArray, out->authority.payment, &n, &credArray) != CborNoError || n != 28) {
+        return false;
+    }
+    n = 28;
+    if (!cbor_value_is_byte_string(&credArray) ||
+        cbor_value_copy_byte_string(&credArray, out->authority.stake, &n, &credArray) != CborNoError || n != 28) {
+        return false;
+    }
+    if (cbor_value_leave_container(&outerArray, &credArray) != CborNoError) return false;
+
+    if (!cbor_value_is_integer(&outerArray)) return false;
+    int lockStatus;
+    cbor_value_get_int(&outerArray, &lockStatus);
+    out->isLocked = lockStatus;
+    return true;
+}
+
+struct Case {
+    const char* name;
+    std::vector<uint8_t> cbor;
+    bool valid;
+};
+
+static void putBytes(std::vector<uint8_t>& v, uint8_t fill) {
+    v.push_back(0x58);
+    v.push_back(28);
+    for (int i = 0; i < 28; i++) v.push_back(fill + i);
+}
+
+// Locker datum as the off-chain code encodes it (indefinite-length lists),
+// or with definite-length lists as some other serialisers do
+static std::vector<uint8_t> lockerDatum(int lockStatus, bool definite) {
+    std::vector<uint8_t> v = {0xd8, 0x79, (uint8_t)(definite ? 0x82 : 0x9f),
+                              0xd8, 0x79, (uint8_t)(definite ? 0x82 : 0x9f)};
+    putBytes(v, 0x10);
+    putBytes(v, 0x80);
+    if (!definite) v.push_back(0xff);
+    if (lockStatus < 24) {
+        v.push_back(lockStatus);
+    } else {
+        v.push_back(0x19);
+        v.push_back(lockStatus >> 8);
+        v.push_back(lockStatus & 0xff);
+    }
+    if (!definite) v.push_back(0xff);
+    return v;
+}
+
+static double nsPerOp(bool (*fn)(const Case&, LockerDatum*), const Case& c, long iterations) {
+    LockerDatum out;
+    volatile int64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        fn(c, &out);
+        sink = sink + out.isLocked;
+    }
+    auto end = std::chrono::steady_clock::now();
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static bool runTinycbor(const Case& c, LockerDatum* out) {
+    return tinycborDecode(c.cbor.data(), c.cbor.size(), out);
+}
+
+static bool runGenerated(const Case& c, LockerDatum* out) {
+    const char* error;
+    return decodeLockerDatum(c.cbor.data(), c.cbor.size(), out, &error) != PLUTUS_FAILED;
+}
+
+static const char* pathName(PlutusPath path) {
+    return path == PLUTUS_FIXED ? "fixed" : path == PLUTUS_WALK ? "walk" : "failed";
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 2000000;
+
+    std::vector<Case> cases = {
+        {"locked", lockerDatum(1, false), true},
+        {"unlocked", lockerDatum(0, false), true},
+        {"definite lists", lockerDatum(1, true), true},
+        {"status=1000", lockerDatum(1000, false), true},
+        {"truncated", {}, false},
+    };
+    cases[4].cbor = lockerDatum(1, false);
+    cases[4].cbor.resize(40);
+
+    printf("%-16s %6s %8s %14s %14s %8s\n", "datum", "bytes", "path", "tinycbor ns", "generated ns", "speedup");
+    bool ok = true;
+    for (const Case& c : cases) {
+        LockerDatum a, b;
+        memset(&a, 0, sizeof(a));
+        memset(&b, 0, sizeof(b));
+        const char* error = nullptr;
+        bool refOk = runTinycbor(c, &a);
+        PlutusPath path = decodeLockerDatum(c.cbor.data(), c.cbor.size(), &b, &error);
+        bool genOk = path != PLUTUS_FAILED;
+
+        if (refOk != c.valid || genOk != c.valid ||
+            (c.valid && memcmp(&a, &b, sizeof(a)) != 0)) {
+            printf("%-16s MISMATCH tinycbor=%d generated=%d (%s)\n", c.name, refOk, genOk, error ? error : "");
+            ok = false;
+            continue;
+        }
+
+        double ref = nsPerOp(runTinycbor, c, iterations);
+        double gen = nsPerOp(runGenerated, c, iterations);
+        printf("%-16s %6zu %8s %14.1f %14.1f %7.1fx\n",
+            c.name, c.cbor.size(), pathName(path), ref, gen, ref / gen);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,360 @@
+// Host test: the Blockfrost resolver cache (lib/chain_monitor/src/dns_cache.cpp).
+//
+// Runs DnsCache against a stub resolver and a simulated clock, the two
+// function pointers blockfrost.cpp passes on the device. The stub serves
+// scripted A records and TTLs, can be made to fail, and takes a fixed time
+// per call so resolve timing shows up in the stats. Each scenario checks
+// when the resolver is called and which address the next connect gets:
+// TTL clamping and expiry, failover across A records after connect
+// failures, stale addresses when resolving fails, refresh ahead of expiry,
+// the pin callback, the clock wrapping past 2^32 ms, LRU eviction, and
+// hosts too long to cache.
+//
+// Build: L=../lib/chain_monitor
+//   g++ -std=c++17 -O2 -I$L/include tools/dns_sim.cpp $L/src/dns_cache.cpp -o dns_sim
+//
+// Usage: ./dns_sim
+
+#include "dns_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define HOST "cardano-preprod.blockfrost.io"
+#define RESOLVE_MS 40       // simulated resolver round trip
+
+static uint32_t ip(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    return (uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24;
+}
+
+static const uint32_t A1 = ip(104, 18, 10, 1);
+static const uint32_t A2 = ip(104, 18, 10, 2);
+static const uint32_t A3 = ip(104, 18, 10, 3);
+
+// Stub resolver, clock and pin store behind the cache's one context pointer
+struct Net {
+    uint32_t nowMs;
+    std::vector<uint32_t> records;
+    uint32_t ttlSec;
+    bool down;
+    uint32_t calls;
+    uint32_t pins;
+    uint32_t pinnedAddr;
+};
+
+static size_t stubResolve(const char*, uint32_t* addrs, size_t maxAddrs, uint32_t* ttlSec, void* ctx) {
+    Net* net = (Net*)ctx;
+    net->calls++;
+    net->nowMs += RESOLVE_MS;
+    if (net->down) return 0;
+    size_t n = net->records.size() < maxAddrs ? net->records.size() : maxAddrs;
+    for (size_t i = 0; i < n; i++) addrs[i] = net->records[i];
+    *ttlSec = net->ttlSec;
+    return n;
+}
+
+static uint32_t stubClock(void* ctx) { return ((Net*)ctx)->nowMs; }
+
+static void stubPin(const char*, uint32_t addr, void* ctx) {
+    Net* net = (Net*)ctx;
+    net->pins++;
+    net->pinnedAddr = addr;
+}
+
+static Net freshNet(uint32_t startMs, uint32_t ttlSec) {
+    Net net = {};
+    net.nowMs = startMs;
+    net.records = { A1, A2, A3 };
+    net.ttlSec = ttlSec;
+    return net;
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* scenario, const char* what) {
+    if (!ok) {
+        printf("  FAIL %s: %s\n", scenario, what);
+        failures++;
+    }
+}
+
+// Address the next connect would use, and whether the resolver ran for it
+static uint32_t next(DnsCache& cache, Net& net, uint32_t* resolveMs = nullptr, bool* resolved = nullptr) {
+    uint32_t before = net.calls;
+    uint32_t addr = 0, ms = 0;
+    if (!cache.lookup(HOST, &addr, &ms)) addr = 0;
+    if (resolveMs) *resolveMs = ms;
+    if (resolved) *resolved = net.calls != before;
+    return addr;
+}
+
+static void report(const char* name, const Net& net, const DnsCache& cache) {
+    const DnsCacheStats& s = cache.stats();
+    printf("%-28s resolves=%u failures=%u hits=%u stale=%u pins=%u\n",
+           name, s.resolves, s.failures, s.hits, s.staleUses, net.pins);
+}
+
+// Expiry follows the TTL, clamped to [DNS_CACHE_MIN_TTL_S, DNS_CACHE_MAX_TTL_S]
+static void ttl(const char* name, uint32_t ttlSec, uint32_t expectSec) {
+    Net net = freshNet(1000, ttlSec);
+    DnsCache cache(stubResolve, stubClock, &net);
+
+    uint32_t ms;
+    bool resolved;
+    check(next(cache, net, &ms, &resolved) == A1 && resolved, name, "first lookup resolves");
+    check(ms == RESOLVE_MS, name, "resolve time reported");
+    uint32_t resolvedAt = net.nowMs;
+
+    net.nowMs = resolvedAt + expectSec * 1000 - 1;
+    check(next(cache, net, &ms, &resolved) == A1 && !resolved && ms == 0, name, "hit until the clamped TTL");
+    net.nowMs = resolvedAt + expectSec * 1000;
+    next(cache, net, &ms, &resolved);
+    check(resolved && ms == RESOLVE_MS, name, "re-resolves once it expires");
+    check(cache.stats().hits == 1 && cache.stats().resolves == 2, name, "one hit, two resolves");
+    report(name, net, cache);
+}
+
+// A failed connect moves to the next A record; once all failed, re-resolve
+static void failover() {
+    const char* name = "failover";
+    Net net = freshNet(1000, 300);
+    DnsCache cache(stubResolve, stubClock, &net);
+
+    uint32_t addr = next(cache, net);
+    check(addr == A1 && cache.addressCount(HOST) == 3, name, "all A records kept");
+    cache.reportFailure(HOST, addr);
+    bool resolved;
+    addr = next(cache, net, nullptr, &resolved);
+    check(addr == A2 && !resolved, name, "second record after one failure");
+
+    // A late report for an address no longer handed out is ignored
+    cache.reportFailure(HOST, A1);
+    check(next(cache, net) == A2, name, "stale failure report ignored");
+
+    cache.reportFailure(HOST, A2);
+    addr = next(cache, net, nullptr, &resolved);
+    check(addr == A3 && !resolved, name, "third record after two failures");
+
+    // Every record failed: the records may have moved
+    net.records = { A3, A2 };
+    cache.reportFailure(HOST, A3);
+    addr = next(cache, net, nullptr, &resolved);
+    check(resolved && cache.addressCount(HOST) == 2, name, "re-resolves after every record failed");
+    check(addr == A3, name, "starts over at the first new record");
+
+    cache.reportSuccess(HOST, addr);
+    cache.reportFailure(HOST, addr);
+    check(next(cache, net, nullptr, &resolved) == A2 && !resolved, name, "success resets the failure count");
+    report(name, net, cache);
+}
+
+// Resolver down: keep using what we had, back off between attempts
+static void stale() {
+    const char* name = "stale on resolver failure";
+    Net net = freshNet(1000, 60);
+    DnsCache cache(stubResolve, stubClock, &net);
+
+    check(next(cache, net) == A1, name, "first lookup");
+    net.down = true;
+    net.nowMs += 60 * 1000;
+    bool resolved;
+    check(next(cache, net, nullptr, &resolved) == A1 && resolved, name, "expired entry used when resolve fails");
+    uint32_t failedAt = net.nowMs;
+
+    net.nowMs = failedAt + DNS_CACHE_RETRY_MS - 1;
+    check(next(cache, net, nullptr, &resolved) == A1 && !resolved, name, "no resolver call during back-off");
+    net.nowMs = failedAt + DNS_CACHE_RETRY_MS;
+    next(cache, net, nullptr, &resolved);
+    check(resolved, name, "retries after DNS_CACHE_RETRY_MS");
+    check(cache.stats().staleUses == 3 && cache.stats().failures == 2, name, "stale uses and failures counted");
+
+    net.down = false;
+    net.records = { A2 };
+    net.nowMs += DNS_CACHE_RETRY_MS;
+    check(next(cache, net, nullptr, &resolved) == A2 && resolved, name, "new records once the resolver is back");
+
+    // Nothing known and nothing resolved: no address at all
+    Net empty = freshNet(1000, 60);
+    empty.down = true;
+    DnsCache cold(stubResolve, stubClock, &empty);
+    uint32_t addr = 1;
+    check(!cold.lookup(HOST, &addr, nullptr), name, "lookup fails with no address");
+
+    // A seeded (persisted) address stands in until the resolver answers
+    Net boot = freshNet(1000, 60);
+    boot.down = true;
+    DnsCache seeded(stubResolve, stubClock, &boot);
+    seeded.seed(HOST, A3);
+    check(next(seeded, boot, nullptr, &resolved) == A3 && resolved, name, "seeded address used when resolve fails");
+    boot.down = false;
+    boot.nowMs += DNS_CACHE_RETRY_MS;
+    check(next(seeded, boot, nullptr, &resolved) == A3 && resolved, name, "seed is pinned, so preferred after resolve");
+    report(name, net, cache);
+}
+
+// refresh() re-resolves ahead of expiry, so the poll path stays a hit
+static void refresh() {
+    const char* name = "refresh before expiry";
+    Net net = freshNet(1000, 120);
+    DnsCache cache(stubResolve, stubClock, &net);
+
+    check(cache.msUntilRefresh() == UINT32_MAX, name, "nothing to refresh while empty");
+    next(cache, net);
+    uint32_t due = 120 * 1000 - DNS_CACHE_REFRESH_MARGIN_MS;
+    check(cache.msUntilRefresh() == due, name, "due REFRESH_MARGIN before expiry");
+
+    net.nowMs += due - 1;
+    check(!cache.refresh() && net.calls == 1, name, "no refresh before it is due");
+    net.nowMs += 1;
+    check(cache.msUntilRefresh() == 0, name, "due now");
+    net.records = { A2, A1 };
+    check(cache.refresh() && net.calls == 2, name, "refresh resolves");
+    check(!cache.refresh(), name, "one refresh per due entry");
+
+    // The old expiry passes without the poll path waiting on DNS
+    net.nowMs += DNS_CACHE_REFRESH_MARGIN_MS;
+    uint32_t ms;
+    bool resolved;
+    uint32_t addr = next(cache, net, &ms, &resolved);
+    check(!resolved && ms == 0, name, "lookup after the old expiry is a hit");
+    check(addr == A2, name, "refreshed records in use");
+
+    // A failed refresh is retried after the back-off, not on every idle slot
+    net.down = true;
+    net.nowMs += cache.msUntilRefresh();
+    check(cache.refresh(), name, "refresh attempted");
+    check(cache.msUntilRefresh() == DNS_CACHE_RETRY_MS, name, "next attempt after the back-off");
+    check(!cache.refresh() && net.calls == 3, name, "no retry during the back-off");
+    report(name, net, cache);
+}
+
+// The pin callback fires when the connected address changes, and a pinned
+// address stays first after a re-resolve
+static void pins() {
+    const char* name = "pin callback";
+    Net net = freshNet(1000, 60);
+    DnsCache cache(stubResolve, stubClock, &net);
+    cache.onPin(stubPin);
+
+    uint32_t addr = next(cache, net);
+    cache.reportSuccess(HOST, addr);
+    check(net.pins == 1 && net.pinnedAddr == A1, name, "first connect pinned");
+    cache.reportSuccess(HOST, addr);
+    check(net.pins == 1, name, "same address not pinned again");
+
+    cache.reportFailure(HOST, addr);
+    addr = next(cache, net);
+    cache.reportSuccess(HOST, addr);
+    check(net.pins == 2 && net.pinnedAddr == A2, name, "failover address pinned");
+
+    // The resolver now lists the pinned address last
+    net.records = { A3, A1, A2 };
+    net.nowMs += 60 * 1000;
+    bool resolved;
+    addr = next(cache, net, nullptr, &resolved);
+    check(resolved && addr == A2, name, "pinned address first after re-resolve");
+    check(net.pins == 2, name, "no callback without a new connect");
+
+    // Gone from DNS: start from the first record
+    net.records = { A3, A1 };
+    net.nowMs += 60 * 1000;
+    check(next(cache, net) == A3, name, "unpublished pin not used");
+    report(name, net, cache);
+}
+
+// millis() wraps after ~49.7 days; expiry and refresh must not notice
+static void wrap() {
+    const char* name = "clock wrap";
+    Net net = freshNet(UINT32_MAX - 20000, 60);
+    DnsCache cache(stubResolve, stubClock, &net);
+
+    next(cache, net);
+    uint32_t resolvedAt = net.nowMs;
+    net.nowMs = resolvedAt + 59 * 1000;      // past 2^32
+    bool resolved;
+    next(cache, net, nullptr, &resolved);
+    check(!resolved, name, "still a hit across the wrap");
+    check(cache.msUntilRefresh() == 0, name, "refresh due across the wrap");
+    net.nowMs = resolvedAt + 60 * 1000;
+    next(cache, net, nullptr, &resolved);
+    check(resolved, name, "expires across the wrap");
+    report(name, net, cache);
+}
+
+// More hosts than slots: the least recently used one is dropped
+static void eviction() {
+    const char* name = "eviction";
+    Net net = freshNet(1000, 600);
+    DnsCache cache(stubResolve, stubClock, &net);
+
+    char hosts[DNS_CACHE_HOSTS + 1][DNS_CACHE_HOST_LEN];
+    uint32_t addr;
+    for (int i = 0; i <= DNS_CACHE_HOSTS; i++) {
+        snprintf(hosts[i], sizeof(hosts[i]), "provider-%d.example", i);
+        if (i == DNS_CACHE_HOSTS) {
+            net.nowMs += 1000;
+            cache.lookup(hosts[0], &addr, nullptr);      // the oldest is used again
+        }
+        net.nowMs += 1000;
+        cache.lookup(hosts[i], &addr, nullptr);
+    }
+    check(cache.addressCount(hosts[0]) == 3, name, "recently used host kept");
+    check(cache.addressCount(hosts[1]) == 0, name, "least recently used host dropped");
+    check(cache.addressCount(hosts[DNS_CACHE_HOSTS]) == 3, name, "new host cached");
+    report(name, net, cache);
+}
+
+// Hosts that do not fit an entry are resolved every time and leave the
+// cached hosts alone
+static void longHost() {
+    const char* name = "long host uncached";
+    Net net = freshNet(1000, 600);
+    DnsCache cache(stubResolve, stubClock, &net);
+
+    char hosts[DNS_CACHE_HOSTS][DNS_CACHE_HOST_LEN];
+    uint32_t addr;
+    for (int i = 0; i < DNS_CACHE_HOSTS; i++) {
+        snprintf(hosts[i], sizeof(hosts[i]), "provider-%d.example", i);
+        cache.lookup(hosts[i], &addr, nullptr);
+    }
+
+    // One character short of fitting, exactly the buffer, and well past it
+    const size_t lengths[] = {DNS_CACHE_HOST_LEN - 1, DNS_CACHE_HOST_LEN, 100};
+    for (size_t len : lengths) {
+        std::string host(len - strlen(".example"), 'a');
+        host += ".example";
+        uint32_t calls = net.calls;
+        bool ok = cache.lookup(host.c_str(), &addr, nullptr) && addr == A1;
+        cache.lookup(host.c_str(), &addr, nullptr);
+        bool cached = len < DNS_CACHE_HOST_LEN;
+        check(ok, name, "long host resolves");
+        check(net.calls - calls == (cached ? 1u : 2u), name,
+              cached ? "longest fitting host cached" : "too-long host resolved every lookup");
+        check((cache.addressCount(host.c_str()) > 0) == cached, name, "cached only if it fits");
+        net.nowMs += 1000;
+    }
+    // The one fitting long host took one slot; the others kept theirs
+    int kept = 0;
+    for (int i = 0; i < DNS_CACHE_HOSTS; i++) kept += cache.addressCount(hosts[i]) > 0;
+    check(kept == DNS_CACHE_HOSTS - 1, name, "too-long hosts evict nothing");
+    check(cache.stats().uncached == 4, name, "uncached lookups counted");
+    report(name, net, cache);
+}
+
+int main() {
+    ttl("ttl 300 s", 300, 300);
+    ttl("ttl 5 s (clamped up)", 5, DNS_CACHE_MIN_TTL_S);
+    ttl("ttl 1 day (clamped down)", 86400, DNS_CACHE_MAX_TTL_S);
+    failover();
+    stale();
+    refresh();
+    pins();
+    wrap();
+    eviction();
+    longHost();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "all scenarios ok", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Build the fleet simulator from the firmware sources.
+#
+# The firmware keeps its state in globals. Each object is compiled without
+# PIE and its .data/.bss renamed to fw_data/fw_bss, which sim_core.cpp
+# copies in and out per virtual device.
+#
+# Run from iot3-vending-machines/ after `pio pkg install` has fetched
+# ArduinoJson, or point ARDUINOJSON at its src/ directory.
+set -e
+
+LIBDEPS=${LIBDEPS:-.pio/libdeps/seeed_xiao_esp32c3}
+ARDUINOJSON=${ARDUINOJSON:-$LIBDEPS/ArduinoJson/src}
+OUT=${OUT:-.pio/fleet_sim}
+CXX=${CXX:-g++}
+
+SIM=tools/fleet_sim
+LIB=../lib/chain_monitor
+FLAGS="-O2 -g -fno-pie -DARDUINO=10800 -DARDUINOJSON_ENABLE_PROGMEM=0"
+INCLUDES="-I$SIM/shim -Iinclude -I$LIB/include -I$ARDUINOJSON"
+
+if [ ! -d "$ARDUINOJSON" ]; then
+    echo "missing $ARDUINOJSON (run 'pio pkg install' or set ARDUINOJSON)" >&2
+    exit 1
+fi
+
+mkdir -p "$OUT/fw" "$OUT/host"
+
+# Firmware and the shared library: one set of globals per device
+for src in src/*.cpp $LIB/src/*.cpp; do
+    obj="$OUT/fw/$(basename "$src" .cpp).o"
+    $CXX -std=gnu++17 $FLAGS $INCLUDES -c "$src" -o "$obj"
+    objcopy --rename-section .data=fw_data --rename-section .bss=fw_bss "$obj"
+done
+
+# Simulator code is shared by all devices
+for src in sim_core shim fleet_sim; do
+    $CXX -std=gnu++17 $FLAGS $INCLUDES -c "$SIM/$src.cpp" -o "$OUT/host/$src.o"
+done
+
+$CXX -no-pie "$OUT"/fw/*.o "$OUT"/host/*.o -lpthread -o "$OUT/fleet_sim"
+echo "built $OUT/fleet_sim"
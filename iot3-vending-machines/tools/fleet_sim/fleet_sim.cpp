@@ -0,0 +1,504 @@
+// Fleet simulator: thousands of pump controllers against one API stand-in.
+//
+// Links the unmodified firmware (src/*.cpp and ../lib/chain_monitor)
+// against the host shim in shim/ and runs one virtual device per fiber
+// (sim_core.cpp). Devices boot spread over --ramp seconds and poll the
+// stand-in (iot2-sync-state-onchain/script/standin.ts) exactly as on hardware.
+// A driver thread flips the lock with POST /control/tx every --tx
+// seconds; each unlock should produce a pump edge on every device.
+// With --mempool 1 the driver submits the txs to the stand-in's mempool
+// instead (start it with BLOCK_MS, and EVICT_PCT to drop some); with
+// --prearm 1 the devices also run with MEMPOOL_PREARM on, and the
+// pre-arms, commits, aborts (false positives) and time saved are reported.
+// With --backup-port the devices get a second provider on that port (the
+// stand-in's MIRROR_PORT) and hedge slow batches on it; start the stand-in
+// with STALL_PCT to inject the stalls that hedging should hide.
+//
+// Reported: API request rate and 429s (from the stand-in's /control/stats),
+// polls per device, poll start -> datum percentiles, unlock -> pump edge latency percentiles and histogram,
+// missed unlocks, and event-loop lag. Loop lag is how late fibers were
+// woken; when it grows the simulator, not the stand-in, is the bottleneck,
+// so add --procs.
+//
+// Build: tools/fleet_sim/build.sh (needs `pio pkg install` for the libs)
+//
+// Usage: fleet_sim [--devices N] [--procs P] [--duration S] [--ramp S]
+//                  [--tx S] [--host IP] [--port N] [--poll MS] [--trace ID]
+//                  [--mempool 0|1] [--prearm 0|1] [--backup-port N]
+
+#include "sim_core.h"
+#include "../../include/config.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char simApiHost[64];
+extern uint16_t simApiPort;
+extern uint16_t simBackupPort;
+extern uint32_t simPollIntervalMs;
+extern int simPumpPin;
+extern bool mempoolPrearm;      // firmware global (main.cpp)
+
+struct Options {
+    int devices = 100;
+    int procs = 1;
+    int durationS = 60;
+    int rampS = 10;
+    int txS = 10;
+    int trace = -1;             // echo this device's serial output
+    bool mempool = false;       // submit txs to the mempool
+    bool prearm = false;        // devices pre-arm on pending unlocks
+};
+
+static Options opt;
+static int shardBase = 0;       // global id of this shard's device 0
+
+// Totals one shard sends back to the parent
+struct ShardReport {
+    uint32_t devices;
+    uint32_t polls;
+    uint32_t pollErrors;
+    uint32_t rateLimited;
+    uint64_t switches;
+    uint64_t lateWakeMs;
+    uint32_t maxLateMs;
+    uint32_t timerWakes;
+    uint32_t edgeCount;
+    uint32_t prearms;
+    uint32_t commits;
+    uint32_t aborts;
+    uint64_t savedMsSum;
+    uint32_t savedMsMax;
+    uint32_t hedges;
+    uint32_t backupWins;
+    uint32_t datumCount;
+};
+
+namespace sim {
+
+void onSerialLine(Device& dev, const std::string& line) {
+    if (shardBase + dev.id == opt.trace) printf("[%d] %s\n", opt.trace, line.c_str());
+
+    if (line.compare(0, 7, "[fetch]") == 0) {
+        size_t p = line.find(" datum=");
+        dev.stats.polls++;
+        if (p != std::string::npos) dev.stats.datumMs.push_back(strtoul(line.c_str() + p + 7, nullptr, 10));
+    } else if (line.compare(0, 17, "Asset state error") == 0) {
+        dev.stats.pollErrors++;
+        if (line.find("HTTP 429") != std::string::npos) dev.stats.rateLimited++;
+    } else if (line.compare(0, 13, "[mempool] ARM") == 0) {
+        dev.stats.prearms++;
+    } else if (line.compare(0, 16, "[mempool] COMMIT") == 0) {
+        size_t p = line.find("saved=");
+        uint32_t saved = p == std::string::npos ? 0 : strtoul(line.c_str() + p + 6, nullptr, 10);
+        dev.stats.commits++;
+        dev.stats.savedMsSum += saved;
+        if (saved > dev.stats.savedMsMax) dev.stats.savedMsMax = saved;
+    } else if (line.compare(0, 15, "[mempool] ABORT") == 0) {
+        dev.stats.aborts++;
+    } else if (line.compare(0, 15, "[hedge] winner=") == 0) {
+        dev.stats.hedges++;
+        if (line.compare(15, 6, "backup") == 0) dev.stats.backupWins++;
+    }
+}
+
+}
+
+// ---- stand-in control API (plain blocking HTTP, parent only) ----
+
+static std::string httpRequest(const char* method, const char* path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return "";
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(simApiPort);
+    inet_pton(AF_INET, simApiHost, &sa.sin_addr);
+    if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0) {
+        close(fd);
+        return "";
+    }
+
+    char req[256];
+    int n = snprintf(req, sizeof(req),
+        "%s %s HTTP/1.1\r\nHost: %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+        method, path, simApiHost);
+    if (send(fd, req, n, MSG_NOSIGNAL) != n) {
+        close(fd);
+        return "";
+    }
+
+    std::string resp;
+    char buf[4096];
+    ssize_t r;
+    while ((r = recv(fd, buf, sizeof(buf), 0)) > 0) resp.append(buf, r);
+    close(fd);
+
+    size_t body = resp.find("\r\n\r\n");
+    if (resp.compare(0, 12, "HTTP/1.1 200") != 0 || body == std::string::npos) return "";
+    return resp.substr(body + 4);
+}
+
+// Integer value of "key": in a flat JSON object, 0 if absent
+static uint64_t jsonNumber(const std::string& json, const char* key) {
+    std::string needle = std::string("\"") + key + "\":";
+    size_t p = json.find(needle);
+    return p == std::string::npos ? 0 : strtoull(json.c_str() + p + needle.size(), nullptr, 10);
+}
+
+struct ApiStats {
+    uint64_t requests;
+    uint64_t rateLimited;
+};
+
+static bool readApiStats(ApiStats* s) {
+    std::string body = httpRequest("GET", "/control/stats");
+    if (body.empty()) return false;
+    s->requests = jsonNumber(body, "requests");
+    s->rateLimited = jsonNumber(body, "429");
+    return true;
+}
+
+static bool postTx(bool locked) {
+    return !httpRequest("POST", locked ? "/control/tx?locked=1" : "/control/tx?locked=0").empty();
+}
+
+// Into the mempool; the stand-in's block timer includes (or evicts) it
+static bool submitTx(bool locked) {
+    return !httpRequest("POST", locked ? "/control/submit?locked=1" : "/control/submit?locked=0").empty();
+}
+
+// ---- tx driver thread ----
+
+struct Driver {
+    uint64_t startMs;
+    uint64_t endMs;
+    std::vector<uint64_t> unlocks;  // wall-clock ms of each unlock POST
+    std::atomic<bool> failed;
+};
+
+static void sleepUntilWall(uint64_t atMs) {
+    uint64_t now = sim::wallMs();
+    if (atMs > now) usleep((atMs - now) * 1000);
+}
+
+// Locked while the fleet boots, then alternate unlock / lock every --tx
+// seconds. Unlocks whose lock phase would run past the end are skipped.
+static void* driveTxs(void* arg) {
+    Driver* d = (Driver*)arg;
+    uint64_t at = d->startMs + (uint64_t)opt.rampS * 1000 + 2 * simPollIntervalMs;
+    bool unlock = true;
+    while (at + (uint64_t)opt.txS * 1000 <= d->endMs) {
+        sleepUntilWall(at);
+        uint64_t sent = sim::wallMs();
+        if (!(opt.mempool ? submitTx(!unlock) : postTx(!unlock))) {
+            d->failed = true;
+            break;
+        }
+        if (unlock) d->unlocks.push_back(sent);
+        unlock = !unlock;
+        at += (uint64_t)opt.txS * 1000;
+    }
+    return nullptr;
+}
+
+// ---- shards ----
+
+// Run `count` devices in this process and write the results to `out`
+static void runShard(int count, uint64_t startMono, uint64_t endMono, int out) {
+    mempoolPrearm = opt.prearm;     // before the devices copy the firmware globals
+    sim::createDevices(count, startMono, (uint64_t)opt.rampS * 1000 * count / opt.devices, endMono);
+    sim::runLoop();
+
+    ShardReport r;
+    memset(&r, 0, sizeof(r));
+    r.devices = count;
+    std::vector<uint64_t> edges;
+    std::vector<uint32_t> datum;
+    for (sim::Device* d : sim::devices()) {
+        r.polls += d->stats.polls;
+        r.pollErrors += d->stats.pollErrors;
+        r.rateLimited += d->stats.rateLimited;
+        r.prearms += d->stats.prearms;
+        r.commits += d->stats.commits;
+        r.aborts += d->stats.aborts;
+        r.savedMsSum += d->stats.savedMsSum;
+        if (d->stats.savedMsMax > r.savedMsMax) r.savedMsMax = d->stats.savedMsMax;
+        r.hedges += d->stats.hedges;
+        r.backupWins += d->stats.backupWins;
+        datum.insert(datum.end(), d->stats.datumMs.begin(), d->stats.datumMs.end());
+        edges.insert(edges.end(), d->stats.edges.begin(), d->stats.edges.end());
+    }
+    const sim::LoopStats& loop = sim::loopStats();
+    r.switches = loop.switches;
+    r.lateWakeMs = loop.lateWakeMs;
+    r.maxLateMs = loop.maxLateMs;
+    r.timerWakes = loop.timerWakes;
+    r.edgeCount = edges.size();
+    r.datumCount = datum.size();
+
+    fflush(stdout);
+    if (write(out, &r, sizeof(r)) != sizeof(r) ||
+        write(out, edges.data(), edges.size() * sizeof(uint64_t)) != (ssize_t)(edges.size() * sizeof(uint64_t)) ||
+        write(out, datum.data(), datum.size() * sizeof(uint32_t)) != (ssize_t)(datum.size() * sizeof(uint32_t))) {
+        perror("shard report");
+        _exit(1);
+    }
+    _exit(0);
+}
+
+static bool readAll(int fd, void* buf, size_t n) {
+    uint8_t* p = (uint8_t*)buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+// `pct` in tenths of a percent, so 999 is p99.9
+template <typename T>
+static uint64_t percentile(const std::vector<T>& sorted, int pct) {
+    if (sorted.empty()) return 0;
+    size_t i = sorted.size() * pct / 1000;
+    return sorted[i < sorted.size() ? i : sorted.size() - 1];
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+        "usage: %s [--devices N] [--procs P] [--duration S] [--ramp S] [--tx S]\n"
+        "          [--host IP] [--port N] [--poll MS] [--trace ID]\n"
+        "          [--mempool 0|1] [--prearm 0|1] [--backup-port N]\n", prog);
+    exit(2);
+}
+
+static void parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (i + 1 >= argc) usage(argv[0]);
+        const char* v = argv[++i];
+        if (strcmp(a, "--devices") == 0) opt.devices = atoi(v);
+        else if (strcmp(a, "--procs") == 0) opt.procs = atoi(v);
+        else if (strcmp(a, "--duration") == 0) opt.durationS = atoi(v);
+        else if (strcmp(a, "--ramp") == 0) opt.rampS = atoi(v);
+        else if (strcmp(a, "--tx") == 0) opt.txS = atoi(v);
+        else if (strcmp(a, "--host") == 0) snprintf(simApiHost, sizeof(simApiHost), "%s", v);
+        else if (strcmp(a, "--port") == 0) simApiPort = atoi(v);
+        else if (strcmp(a, "--poll") == 0) simPollIntervalMs = atoi(v);
+        else if (strcmp(a, "--trace") == 0) opt.trace = atoi(v);
+        else if (strcmp(a, "--mempool") == 0) opt.mempool = atoi(v) != 0;
+        else if (strcmp(a, "--prearm") == 0) opt.prearm = atoi(v) != 0;
+        else if (strcmp(a, "--backup-port") == 0) simBackupPort = atoi(v);
+        else usage(argv[0]);
+    }
+    struct in_addr tmp;
+    if (opt.devices < 1 || opt.procs < 1 || opt.durationS < 1 || opt.txS < 1 ||
+        inet_pton(AF_INET, simApiHost, &tmp) != 1) {
+        usage(argv[0]);
+    }
+    if (opt.procs > opt.devices) opt.procs = opt.devices;
+    if (opt.rampS >= opt.durationS) opt.rampS = opt.durationS / 2;
+}
+
+int main(int argc, char** argv) {
+    simPollIntervalMs = POLL_INTERVAL_MS;
+    simPumpPin = PUMP_PIN;
+    parseArgs(argc, argv);
+    signal(SIGPIPE, SIG_IGN);
+
+    // One socket per device, plus slack
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
+    }
+    if ((rlim_t)(opt.devices / opt.procs + 64) > lim.rlim_cur) {
+        fprintf(stderr, "warning: open file limit %lu is below %d devices per shard\n",
+            (unsigned long)lim.rlim_cur, opt.devices / opt.procs);
+    }
+
+    ApiStats before;
+    if (!readApiStats(&before) || !postTx(true)) {
+        fprintf(stderr, "stand-in not reachable at %s:%u (QUIET=1 PORT=%u bun run script/standin.ts)\n",
+            simApiHost, simApiPort, simApiPort);
+        return 1;
+    }
+
+    printf("devices=%d procs=%d duration=%ds ramp=%ds poll=%ums tx every %ds%s -> %s:%u",
+        opt.devices, opt.procs, opt.durationS, opt.rampS, simPollIntervalMs, opt.txS,
+        opt.mempool ? (opt.prearm ? " (mempool, pre-arm)" : " (mempool)") : "",
+        simApiHost, simApiPort);
+    if (simBackupPort != 0) printf(", backup :%u", simBackupPort);
+    printf("\n");
+    fflush(stdout);
+
+    uint64_t startMono = sim::monoMs() + 200;
+    uint64_t endMono = startMono + (uint64_t)opt.durationS * 1000;
+    Driver driver;
+    driver.startMs = sim::wallMs() + 200;
+    driver.endMs = driver.startMs + (uint64_t)opt.durationS * 1000;
+    driver.failed = false;
+
+    // Shard i runs devices [first, first + count) with the same boot spacing
+    std::vector<int> pipes;
+    std::vector<pid_t> pids;
+    int first = 0;
+    for (int i = 0; i < opt.procs; i++) {
+        int count = opt.devices / opt.procs + (i < opt.devices % opt.procs ? 1 : 0);
+        int fds[2];
+        if (pipe(fds) < 0) {
+            perror("pipe");
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            shardBase = first;
+            uint64_t shardStart = startMono + (uint64_t)opt.rampS * 1000 * first / opt.devices;
+            runShard(count, shardStart, endMono, fds[1]);
+        }
+        close(fds[1]);
+        pipes.push_back(fds[0]);
+        pids.push_back(pid);
+        first += count;
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, nullptr, driveTxs, &driver);
+
+    ShardReport total;
+    memset(&total, 0, sizeof(total));
+    std::vector<uint64_t> edges;
+    std::vector<uint32_t> datum;
+    bool ok = true;
+    for (size_t i = 0; i < pipes.size(); i++) {
+        ShardReport r;
+        if (!readAll(pipes[i], &r, sizeof(r))) {
+            ok = false;
+            continue;
+        }
+        std::vector<uint64_t> e(r.edgeCount);
+        if (!readAll(pipes[i], e.data(), e.size() * sizeof(uint64_t))) ok = false;
+        edges.insert(edges.end(), e.begin(), e.end());
+        std::vector<uint32_t> d(r.datumCount);
+        if (!readAll(pipes[i], d.data(), d.size() * sizeof(uint32_t))) ok = false;
+        datum.insert(datum.end(), d.begin(), d.end());
+
+        total.devices += r.devices;
+        total.polls += r.polls;
+        total.pollErrors += r.pollErrors;
+        total.rateLimited += r.rateLimited;
+        total.prearms += r.prearms;
+        total.commits += r.commits;
+        total.aborts += r.aborts;
+        total.savedMsSum += r.savedMsSum;
+        if (r.savedMsMax > total.savedMsMax) total.savedMsMax = r.savedMsMax;
+        total.hedges += r.hedges;
+        total.backupWins += r.backupWins;
+        total.switches += r.switches;
+        total.lateWakeMs += r.lateWakeMs;
+        total.timerWakes += r.timerWakes;
+        if (r.maxLateMs > total.maxLateMs) total.maxLateMs = r.maxLateMs;
+        close(pipes[i]);
+    }
+    for (pid_t pid : pids) {
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+    }
+    pthread_join(thread, nullptr);
+    if (!ok) fprintf(stderr, "warning: a shard failed, totals are partial\n");
+    if (driver.failed) fprintf(stderr, "warning: POST /control/%s failed, unlocks stopped early\n",
+        opt.mempool ? "submit" : "tx");
+
+    ApiStats after;
+    if (!readApiStats(&after)) after = before;
+    uint64_t requests = after.requests - before.requests;
+    uint64_t limited = after.rateLimited - before.rateLimited;
+
+    // Each edge belongs to the latest unlock before it
+    std::sort(edges.begin(), edges.end());
+    std::vector<uint64_t> latencies;
+    uint32_t unmatched = 0;
+    for (uint64_t edge : edges) {
+        std::vector<uint64_t>::iterator it =
+            std::upper_bound(driver.unlocks.begin(), driver.unlocks.end(), edge);
+        if (it == driver.unlocks.begin()) {
+            unmatched++;        // e.g. a device that booted into "unlocked"
+            continue;
+        }
+        latencies.push_back(edge - *(it - 1));
+    }
+    std::sort(latencies.begin(), latencies.end());
+    uint64_t expected = (uint64_t)driver.unlocks.size() * total.devices;
+    uint64_t missed = expected > latencies.size() ? expected - latencies.size() : 0;
+
+    printf("\nAPI        %lu requests, %.1f req/s, %lu x 429 (%.2f%%)\n",
+        (unsigned long)requests, requests / (double)opt.durationS,
+        (unsigned long)limited, requests ? 100.0 * limited / requests : 0.0);
+    printf("polls      %u ok, %u failed (%u rate-limited), %.1f ok per device\n",
+        total.polls, total.pollErrors, total.rateLimited, total.polls / (double)total.devices);
+    std::sort(datum.begin(), datum.end());
+    printf("poll       p50=%lums p99=%lums p99.9=%lums max=%lums (poll start -> datum)\n",
+        (unsigned long)percentile(datum, 500), (unsigned long)percentile(datum, 990),
+        (unsigned long)percentile(datum, 999), (unsigned long)(datum.empty() ? 0 : datum.back()));
+    printf("unlocks    %zu sent, %zu pump edges, %lu missed, %u unmatched\n",
+        driver.unlocks.size(), latencies.size(), (unsigned long)missed, unmatched);
+    printf("latency    p50=%lums p90=%lums p99=%lums max=%lums (unlock POST -> pump edge)\n",
+        (unsigned long)percentile(latencies, 500), (unsigned long)percentile(latencies, 900),
+        (unsigned long)percentile(latencies, 990),
+        (unsigned long)(latencies.empty() ? 0 : latencies.back()));
+
+    static const uint64_t bounds[] = {250, 500, 1000, 2000, 5000, 10000, 30000};
+    const size_t nBounds = sizeof(bounds) / sizeof(bounds[0]);
+    size_t prev = 0;
+    for (size_t i = 0; i <= nBounds; i++) {
+        size_t upto = i < nBounds
+            ? std::upper_bound(latencies.begin(), latencies.end(), bounds[i]) - latencies.begin()
+            : latencies.size();
+        if (i < nBounds) printf("  <=%6lums %8zu\n", (unsigned long)bounds[i], upto - prev);
+        else printf("   >%6lums %8zu\n", (unsigned long)bounds[nBounds - 1], upto - prev);
+        prev = upto;
+    }
+
+    if (opt.prearm) {
+        uint32_t resolved = total.commits + total.aborts;
+        printf("mempool    %u pre-arms, %u committed, %u aborted (%.1f%% false positive), "
+            "saved avg=%.0fms max=%ums\n",
+            total.prearms, total.commits, total.aborts,
+            resolved ? 100.0 * total.aborts / resolved : 0.0,
+            total.commits ? total.savedMsSum / (double)total.commits : 0.0, total.savedMsMax);
+    }
+
+    if (simBackupPort != 0) {
+        printf("hedge      %u batches hedged (%.2f%% of polls), backup answered first %u\n",
+            total.hedges, total.polls ? 100.0 * total.hedges / total.polls : 0.0, total.backupWins);
+    }
+
+    printf("sim loop   %lu fiber switches, timer lag avg=%.1fms max=%ums\n",
+        (unsigned long)total.switches,
+        total.timerWakes ? total.lateWakeMs / (double)total.timerWakes : 0.0, total.maxLateMs);
+    if (total.maxLateMs > 250) {
+        printf("           lag is high: the simulator is saturated, use more --procs\n");
+    }
+    return ok ? 0 : 1;
+}
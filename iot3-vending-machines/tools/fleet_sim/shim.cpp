@@ -0,0 +1,251 @@
+// Arduino-ESP32 calls used by the firmware, backed by the simulator
+
+#include "sim_core.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_pm.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// Targets of the macros in shim/config.h, set from the command line
+char simApiHost[64] = "127.0.0.1";
+uint16_t simApiPort = 3000;
+uint16_t simBackupPort = 0;
+uint32_t simPollIntervalMs = 1000;
+
+// Pin the pump is on (PUMP_PIN in the firmware's config.h)
+int simPumpPin = -1;
+
+HardwareSerial Serial;
+EspClass ESP;
+WiFiClass WiFi;
+
+#define SIM_FREE_HEAP 180000
+
+static uint64_t deviceNow() {
+    sim::Device* d = sim::current();
+    uint64_t now = sim::monoMs();
+    return d ? now - d->bootMs : now;
+}
+
+unsigned long millis() {
+    return (unsigned long)deviceNow();
+}
+
+unsigned long micros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    sim::Device* d = sim::current();
+    return (unsigned long)(d ? us - d->bootMs * 1000 : us);
+}
+
+void delay(unsigned long ms) {
+    if (!sim::current()) return;
+    sim::wait(sim::monoMs() + ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+    (void)us;
+}
+
+void yield() {
+    if (sim::current()) sim::wait(sim::monoMs());
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    sim::Device* d = sim::current();
+    if (!d || pin >= sizeof(d->pins)) return;
+    if (pin == simPumpPin && val == HIGH && d->pins[pin] == LOW) {
+        d->stats.edges.push_back(sim::wallMs());
+    }
+    d->pins[pin] = val;
+}
+
+int digitalRead(uint8_t pin) {
+    sim::Device* d = sim::current();
+    return d && pin < sizeof(d->pins) ? d->pins[pin] : LOW;
+}
+
+void configTime(long, int, const char*, const char*, const char*) {
+    // The host clock is already synchronised
+}
+
+int esp_pm_configure(const void* config) {
+    (void)config;
+    return ESP_OK;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    sim::Device* d = sim::current();
+    if (!d) return 1;
+    if (c == '\n') {
+        sim::onSerialLine(*d, d->line);
+        d->line.clear();
+    } else if (c != '\r' && d->line.size() < 512) {
+        d->line += (char)c;
+    }
+    return 1;
+}
+
+bool Stream::waitForInput(unsigned long ms) {
+    delay(ms < 10 ? ms : 10);
+    return true;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return SIM_FREE_HEAP;
+}
+
+void EspClass::restart() {
+    fprintf(stderr, "device %d called ESP.restart()\n", sim::current() ? sim::current()->id : -1);
+    exit(1);
+}
+
+WiFiClient::WiFiClient() : fd(-1), eof(false), rxPos(0), rxLen(0) {}
+
+WiFiClient::~WiFiClient() {
+    // Globals of a device image are never destroyed one by one; the
+    // process exit closes every socket
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, getTimeout());
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    stop();
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 0;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = (uint32_t)ip;
+
+    if (::connect(fd, (struct sockaddr*)&sa, sizeof(sa)) < 0) {
+        if (errno != EINPROGRESS) {
+            stop();
+            return 0;
+        }
+        sim::wait(sim::monoMs() + timeoutMs, fd, EPOLLOUT);
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            stop();
+            return 0;
+        }
+        // Still in progress means the wait timed out
+        struct sockaddr_in peer;
+        socklen_t peerLen = sizeof(peer);
+        if (getpeername(fd, (struct sockaddr*)&peer, &peerLen) < 0) {
+            stop();
+            return 0;
+        }
+    }
+    eof = false;
+    rxPos = rxLen = 0;
+    return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    IPAddress ip;
+    if (!ip.fromString(host)) return 0;     // names go through the DNS cache
+    return connect(ip, port);
+}
+
+size_t WiFiClient::write(const uint8_t* data, size_t n) {
+    size_t sent = 0;
+    uint64_t deadline = sim::monoMs() + getTimeout();
+    while (fd >= 0 && sent < n) {
+        ssize_t w = send(fd, data + sent, n - sent, MSG_NOSIGNAL);
+        if (w > 0) {
+            sent += w;
+        } else if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (sim::monoMs() >= deadline) break;
+            sim::wait(deadline, fd, EPOLLOUT);
+        } else {
+            break;
+        }
+    }
+    return sent;
+}
+
+// Read whatever the socket has without blocking
+bool WiFiClient::fill() {
+    if (rxPos < rxLen) return true;
+    if (fd < 0 || eof) return false;
+    ssize_t r = recv(fd, rx, sizeof(rx), 0);
+    if (r > 0) {
+        rxPos = 0;
+        rxLen = r;
+        return true;
+    }
+    if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) eof = true;
+    return false;
+}
+
+bool WiFiClient::waitForInput(unsigned long ms) {
+    if (fd < 0 || eof) return false;
+    sim::wait(sim::monoMs() + ms, fd, EPOLLIN | EPOLLRDHUP);
+    return true;
+}
+
+int WiFiClient::available() {
+    fill();
+    return rxLen - rxPos;
+}
+
+int WiFiClient::read() {
+    if (!fill()) return -1;
+    return rx[rxPos++];
+}
+
+int WiFiClient::read(uint8_t* out, size_t n) {
+    if (!fill()) return -1;
+    size_t k = rxLen - rxPos;
+    if (k > n) k = n;
+    memcpy(out, rx + rxPos, k);
+    rxPos += k;
+    return k;
+}
+
+int WiFiClient::peek() {
+    if (!fill()) return -1;
+    return rx[rxPos];
+}
+
+void WiFiClient::stop() {
+    if (fd >= 0) close(fd);     // also drops it from the epoll set
+    fd = -1;
+    eof = false;
+    rxPos = rxLen = 0;
+}
+
+uint8_t WiFiClient::connected() {
+    if (fd < 0) return 0;
+    if (rxPos < rxLen) return 1;
+    if (eof) return 0;
+    char c;
+    ssize_t r = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (r == 0) eof = true;
+    else if (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK) eof = true;
+    return eof ? 0 : 1;
+}
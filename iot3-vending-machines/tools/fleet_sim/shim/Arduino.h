@@ -0,0 +1,307 @@
+#ifndef FLEET_SIM_ARDUINO_H
+#define FLEET_SIM_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino-ESP32 core the firmware uses.
+// Time, pin and socket calls act on the virtual device that is currently
+// running (see ../sim_core.h), so many devices can share one process.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define IRAM_ATTR
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+inline uint32_t getCpuFrequencyMhz() { return 160; }
+inline uint32_t getXtalFrequencyMhz() { return 40; }
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+// SNTP is replaced by the host clock
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+class String {
+public:
+    String() {}
+    String(const char* s) { if (s) buf = s; }
+    String(const char* s, size_t n) : buf(s, n) {}
+    String(const String& s) = default;
+    String(String&& s) = default;
+    explicit String(char c) : buf(1, c) {}
+    explicit String(int v) : buf(std::to_string(v)) {}
+    explicit String(unsigned int v) : buf(std::to_string(v)) {}
+    explicit String(long v) : buf(std::to_string(v)) {}
+    explicit String(unsigned long v) : buf(std::to_string(v)) {}
+    explicit String(long long v) : buf(std::to_string(v)) {}
+    explicit String(unsigned long long v) : buf(std::to_string(v)) {}
+    explicit String(double v, unsigned int decimals = 2) {
+        char tmp[48];
+        snprintf(tmp, sizeof(tmp), "%.*f", (int)decimals, v);
+        buf = tmp;
+    }
+
+    String& operator=(const String& s) = default;
+    String& operator=(String&& s) = default;
+    String& operator=(const char* s) {
+        if (s) buf = s; else buf.clear();
+        return *this;
+    }
+
+    unsigned int length() const { return buf.size(); }
+    const char* c_str() const { return buf.c_str(); }
+    bool reserve(unsigned int n) { buf.reserve(n); return true; }
+    bool isEmpty() const { return buf.empty(); }
+
+    bool concat(const String& s) { buf += s.buf; return true; }
+    bool concat(const char* s) { if (!s) return false; buf += s; return true; }
+    bool concat(const char* s, unsigned int n) { if (!s) return false; buf.append(s, n); return true; }
+    bool concat(char c) { buf += c; return true; }
+    bool concat(int v) { buf += std::to_string(v); return true; }
+    bool concat(unsigned int v) { buf += std::to_string(v); return true; }
+    bool concat(long v) { buf += std::to_string(v); return true; }
+    bool concat(unsigned long v) { buf += std::to_string(v); return true; }
+
+    template <typename T>
+    String& operator+=(const T& v) { concat(v); return *this; }
+
+    char charAt(unsigned int i) const { return i < buf.size() ? buf[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    char& operator[](unsigned int i) { return buf[i]; }
+
+    bool equals(const String& s) const { return buf == s.buf; }
+    bool equals(const char* s) const { return s && buf == s; }
+    bool operator==(const String& s) const { return equals(s); }
+    bool operator==(const char* s) const { return equals(s); }
+    bool operator!=(const String& s) const { return !equals(s); }
+    bool operator!=(const char* s) const { return !equals(s); }
+    bool operator<(const String& s) const { return buf < s.buf; }
+    bool equalsIgnoreCase(const String& s) const { return strcasecmp(c_str(), s.c_str()) == 0; }
+    bool startsWith(const String& s) const { return buf.compare(0, s.buf.size(), s.buf) == 0; }
+    bool endsWith(const String& s) const {
+        return buf.size() >= s.buf.size() && buf.compare(buf.size() - s.buf.size(), s.buf.size(), s.buf) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return pos(buf.find(c, from)); }
+    int indexOf(const String& s, unsigned int from = 0) const { return pos(buf.find(s.buf, from)); }
+    int lastIndexOf(char c) const { return pos(buf.rfind(c)); }
+    String substring(unsigned int from) const { return from < buf.size() ? String(buf.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) { unsigned int t = from; from = to; to = t; }
+        if (from >= buf.size()) return String();
+        return String(buf.substr(from, to - from));
+    }
+
+    void trim() {
+        size_t a = buf.find_first_not_of(" \t\r\n");
+        size_t b = buf.find_last_not_of(" \t\r\n");
+        buf = a == std::string::npos ? std::string() : buf.substr(a, b - a + 1);
+    }
+    void toLowerCase() { for (char& c : buf) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (char& c : buf) c = toupper((unsigned char)c); }
+    long toInt() const { return atol(buf.c_str()); }
+    float toFloat() const { return atof(buf.c_str()); }
+
+private:
+    explicit String(const std::string& s) : buf(s) {}
+    static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+
+    std::string buf;
+};
+
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, char b) { String r(a); r += b; return r; }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t n) {
+        size_t i = 0;
+        while (i < n && write(data[i])) i++;
+        return i;
+    }
+    size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+    size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+    virtual void flush() {}
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned int v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int decimals = 2) { return printf("%.*f", decimals, v); }
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& v) { size_t n = print(v); return n + println(); }
+
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char tmp[256];
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(tmp, sizeof(tmp), fmt, args);
+        va_end(args);
+        if (n < 0) return 0;
+        if ((size_t)n < sizeof(tmp)) return write((const uint8_t*)tmp, n);
+
+        std::string big(n + 1, '\0');
+        va_start(args, fmt);
+        vsnprintf(&big[0], big.size(), fmt, args);
+        va_end(args);
+        return write((const uint8_t*)big.data(), n);
+    }
+};
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) { timeoutMs = ms; }
+    unsigned long getTimeout() const { return timeoutMs; }
+
+    size_t readBytes(char* out, size_t n) {
+        size_t i = 0;
+        while (i < n) {
+            int c = timedRead();
+            if (c < 0) break;
+            out[i++] = (char)c;
+        }
+        return i;
+    }
+    size_t readBytes(uint8_t* out, size_t n) { return readBytes((char*)out, n); }
+
+    size_t readBytesUntil(char terminator, char* out, size_t n) {
+        size_t i = 0;
+        while (i < n) {
+            int c = timedRead();
+            if (c < 0 || c == terminator) break;
+            out[i++] = (char)c;
+        }
+        return i;
+    }
+
+    String readStringUntil(char terminator) {
+        String s;
+        int c;
+        while ((c = timedRead()) >= 0 && c != terminator) s += (char)c;
+        return s;
+    }
+
+protected:
+    // Block the device until input may be available, at most `ms`.
+    // Returns false when no more input can arrive (end of stream).
+    virtual bool waitForInput(unsigned long ms);
+
+    int timedRead() {
+        unsigned long start = millis();
+        for (;;) {
+            int c = read();
+            if (c >= 0) return c;
+            unsigned long spent = millis() - start;
+            if (spent >= timeoutMs || !waitForInput(timeoutMs - spent)) return -1;
+        }
+    }
+
+    unsigned long timeoutMs = 1000;
+};
+
+class IPAddress {
+public:
+    IPAddress() : addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        uint8_t* p = (uint8_t*)&addr;
+        p[0] = a; p[1] = b; p[2] = c; p[3] = d;
+    }
+    IPAddress(uint32_t raw) : addr(raw) {}     // network byte order, as lwIP
+
+    operator uint32_t() const { return addr; }
+    uint8_t operator[](int i) const { return ((const uint8_t*)&addr)[i]; }
+
+    bool fromString(const char* s) {
+        unsigned a, b, c, d;
+        char tail;
+        if (sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4) return false;
+        if (a > 255 || b > 255 || c > 255 || d > 255) return false;
+        *this = IPAddress(a, b, c, d);
+        return true;
+    }
+    String toString() const {
+        char tmp[16];
+        snprintf(tmp, sizeof(tmp), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return String(tmp);
+    }
+
+private:
+    uint32_t addr;
+};
+
+class Client : public Stream {
+public:
+    virtual int connect(IPAddress ip, uint16_t port) = 0;
+    virtual int connect(const char* host, uint16_t port) = 0;
+    using Print::write;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t n) = 0;
+    virtual int read(uint8_t* out, size_t n) = 0;
+    using Stream::read;
+    virtual void stop() = 0;
+    virtual uint8_t connected() = 0;
+    virtual operator bool() = 0;
+};
+
+// Serial output goes to the simulator, which reads the firmware's log lines
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    using Print::write;
+    size_t write(uint8_t c) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap() { return getFreeHeap(); }
+    uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+    void restart();
+};
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef FLEET_SIM_CLIENT_H
+#define FLEET_SIM_CLIENT_H
+#include "Arduino.h"
+#endif
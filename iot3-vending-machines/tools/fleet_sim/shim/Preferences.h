@@ -0,0 +1,22 @@
+#ifndef FLEET_SIM_PREFERENCES_H
+#define FLEET_SIM_PREFERENCES_H
+
+#include "Arduino.h"
+#include <map>
+
+// NVS replaced by memory that lasts as long as the virtual device
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) { (void)name; (void)readOnly; return true; }
+    void end() {}
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) {
+        std::map<std::string, uint32_t>::const_iterator it = values.find(key);
+        return it == values.end() ? defaultValue : it->second;
+    }
+    size_t putUInt(const char* key, uint32_t value) { values[key] = value; return sizeof(value); }
+
+private:
+    std::map<std::string, uint32_t> values;
+};
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef FLEET_SIM_PRINT_H
+#define FLEET_SIM_PRINT_H
+#include "Arduino.h"
+#endif
@@ -0,0 +1,64 @@
+#ifndef FLEET_SIM_WIFI_H
+#define FLEET_SIM_WIFI_H
+
+#include "Arduino.h"
+
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+
+typedef enum { WIFI_PS_NONE, WIFI_PS_MIN_MODEM, WIFI_PS_MAX_MODEM } wifi_ps_type_t;
+
+// The virtual network is always up
+class WiFiClass {
+public:
+    void begin(const char* ssid, const char* password) { (void)ssid; (void)password; }
+    int status() { return WL_CONNECTED; }
+    bool reconnect() { return true; }
+    bool setSleep(bool enabled) { (void)enabled; return true; }
+    bool setSleep(wifi_ps_type_t type) { (void)type; return true; }
+};
+extern WiFiClass WiFi;
+
+// Non-blocking TCP socket that suspends the calling device instead of the
+// process while it waits, so thousands of devices share one event loop.
+class WiFiClient : public Client {
+public:
+    WiFiClient();
+    ~WiFiClient();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs);
+    int connect(const char* host, uint16_t port) override;
+
+    using Client::write;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t n) override;
+
+    int available() override;
+    int read() override;
+    int read(uint8_t* out, size_t n) override;
+    int peek() override;
+    void flush() override {}
+
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return fd >= 0; }
+
+    // Seconds, as on arduino-esp32
+    void setTimeout(uint32_t seconds) { Stream::setTimeout(seconds * 1000); }
+    void setNoDelay(bool) {}
+
+protected:
+    bool waitForInput(unsigned long ms) override;
+
+private:
+    bool fill();
+
+    int fd;
+    bool eof;
+    uint8_t rx[1460];
+    size_t rxPos;
+    size_t rxLen;
+};
+
+#endif
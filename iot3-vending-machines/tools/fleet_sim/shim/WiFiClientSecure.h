@@ -0,0 +1,18 @@
+#ifndef FLEET_SIM_WIFI_CLIENT_SECURE_H
+#define FLEET_SIM_WIFI_CLIENT_SECURE_H
+
+#include "WiFi.h"
+
+// The stand-in speaks plain HTTP, so TLS is a pass-through here
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() {}
+    using WiFiClient::connect;
+    int connect(IPAddress ip, uint16_t port, const char* host, const char* caCert,
+                const char* cert, const char* privateKey) {
+        (void)host; (void)caCert; (void)cert; (void)privateKey;
+        return WiFiClient::connect(ip, port);
+    }
+};
+
+#endif
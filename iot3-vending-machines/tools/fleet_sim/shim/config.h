@@ -0,0 +1,43 @@
+#ifndef FLEET_SIM_CONFIG_H
+#define FLEET_SIM_CONFIG_H
+
+// The firmware's configuration, pointed at the stand-in given on the
+// simulator's command line instead of Blockfrost
+#include "../../../include/config.h"
+
+#include <stdint.h>
+
+extern char simApiHost[64];
+extern uint16_t simApiPort;
+extern uint16_t simBackupPort;
+extern uint32_t simPollIntervalMs;
+
+#undef BLOCKFROST_HOST
+#undef BLOCKFROST_PORT
+#undef BLOCKFROST_TLS
+#undef CHAIN_PROVIDERS
+#undef POLL_INTERVAL_MS
+#undef LOW_POWER_MODE
+#undef TELEMETRY_BINARY
+#undef TELEMETRY_TASK
+
+#define BLOCKFROST_HOST simApiHost
+#define BLOCKFROST_PORT simApiPort
+#define BLOCKFROST_TLS 0
+// --backup-port: a second stand-in listener to hedge on (0: none)
+#define CHAIN_PROVIDERS { \
+    { "primary", simApiHost, simApiPort, 0, "" }, \
+    { "backup", simApiHost, simBackupPort, 0, "" }, \
+}
+#define POLL_INTERVAL_MS simPollIntervalMs
+
+// Sleep to the next deadline instead of waking every 10 ms: the firmware's
+// own low-power path is what lets one core run thousands of devices
+#define LOW_POWER_MODE 1
+
+// Text log lines for onSerialLine(), drained from the device's own loop
+// (there are no FreeRTOS tasks)
+#define TELEMETRY_BINARY 0
+#define TELEMETRY_TASK 0
+
+#endif
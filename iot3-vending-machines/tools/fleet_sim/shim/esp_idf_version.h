@@ -0,0 +1,6 @@
+#ifndef FLEET_SIM_ESP_IDF_VERSION_H
+#define FLEET_SIM_ESP_IDF_VERSION_H
+
+#define ESP_IDF_VERSION_MAJOR 5
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef FLEET_SIM_ESP_PM_H
+#define FLEET_SIM_ESP_PM_H
+
+#include <stdbool.h>
+
+#define ESP_OK 0
+
+typedef struct {
+    int max_freq_mhz;
+    int min_freq_mhz;
+    bool light_sleep_enable;
+} esp_pm_config_t;
+
+// Automatic light sleep is always available: an idle device is simply
+// suspended in delay()
+int esp_pm_configure(const void* config);
+
+#endif
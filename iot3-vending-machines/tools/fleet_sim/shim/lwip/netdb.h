@@ -0,0 +1,6 @@
+#ifndef FLEET_SIM_LWIP_NETDB_H
+#define FLEET_SIM_LWIP_NETDB_H
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#endif
@@ -0,0 +1,193 @@
+// Fiber event loop: timers + epoll, one firmware globals image per device
+
+#include "sim_core.h"
+
+#include <errno.h>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <time.h>
+
+// Firmware entry points (src/main.cpp)
+void setup();
+void loop();
+
+// Provided by the linker for the sections build.sh renames
+extern "C" char __start_fw_data[], __stop_fw_data[];
+extern "C" char __start_fw_bss[], __stop_fw_bss[];
+
+#define STACK_SIZE (128 * 1024)
+
+namespace sim {
+
+struct Timer {
+    uint64_t at;
+    int device;
+    uint32_t gen;
+    bool operator>(const Timer& o) const { return at > o.at; }
+};
+
+static std::vector<Device*> all;
+static std::vector<uint8_t> pristineData;
+static std::vector<uint8_t> pristineBss;
+static std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+static std::vector<int> ready;
+static Device* running = nullptr;
+static ucontext_t loopCtx;
+static int epfd = -1;
+static uint64_t stopAt = 0;
+static LoopStats counters;
+
+uint64_t monoMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint64_t wallMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+Device* current() {
+    return running;
+}
+
+const std::vector<Device*>& devices() {
+    return all;
+}
+
+const LoopStats& loopStats() {
+    return counters;
+}
+
+static size_t dataSize() { return __stop_fw_data - __start_fw_data; }
+static size_t bssSize() { return __stop_fw_bss - __start_fw_bss; }
+
+static void swapIn(Device* d) {
+    memcpy(__start_fw_data, d->data.data(), dataSize());
+    memcpy(__start_fw_bss, d->bss.data(), bssSize());
+}
+
+static void swapOut(Device* d) {
+    memcpy(d->data.data(), __start_fw_data, dataSize());
+    memcpy(d->bss.data(), __start_fw_bss, bssSize());
+}
+
+static void fiberMain() {
+    Device* d = running;
+    setup();
+    while (monoMs() < stopAt) loop();
+    d->finished = true;
+    swapcontext(&d->ctx, &loopCtx);
+}
+
+void wait(uint64_t atMs, int fd, uint32_t events) {
+    Device* d = running;
+    d->wakeAt = atMs;
+    d->waitGen++;
+    timers.push({atMs, d->id, d->waitGen});
+
+    if (fd >= 0) {
+        struct epoll_event ev;
+        ev.events = events | EPOLLONESHOT;
+        ev.data.u64 = ((uint64_t)d->waitGen << 32) | (uint32_t)d->id;
+        if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) < 0 && errno == ENOENT) {
+            epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+        }
+    }
+    swapcontext(&d->ctx, &loopCtx);
+}
+
+void createDevices(int count, uint64_t startMs, uint64_t rampMs, uint64_t endMs) {
+    // The image after static initialisation is every device's power-on state
+    pristineData.assign(__start_fw_data, __stop_fw_data);
+    pristineBss.assign(__start_fw_bss, __stop_fw_bss);
+    stopAt = endMs;
+    if (epfd < 0) epfd = epoll_create1(0);
+
+    for (int i = 0; i < count; i++) {
+        Device* d = new Device();
+        d->id = all.size();
+        d->data = pristineData;
+        d->bss = pristineBss;
+        d->bootMs = startMs + (count > 1 ? (uint64_t)i * rampMs / count : 0);
+        memset(d->pins, 0, sizeof(d->pins));
+        d->stack = mmap(nullptr, STACK_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (d->stack == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
+        getcontext(&d->ctx);
+        d->ctx.uc_stack.ss_sp = d->stack;
+        d->ctx.uc_stack.ss_size = STACK_SIZE;
+        d->ctx.uc_link = nullptr;
+        makecontext(&d->ctx, fiberMain, 0);
+
+        d->wakeAt = d->bootMs;
+        timers.push({d->bootMs, d->id, d->waitGen});
+        all.push_back(d);
+    }
+}
+
+static void resume(Device* d) {
+    running = d;
+    swapIn(d);
+    counters.switches++;
+    swapcontext(&loopCtx, &d->ctx);
+    swapOut(d);
+    running = nullptr;
+    if (d->finished) munmap(d->stack, STACK_SIZE);
+}
+
+static void wake(int id, uint32_t gen) {
+    Device* d = all[id];
+    if (d->finished || gen != d->waitGen) return;
+    d->waitGen++;       // the other pending wake-up source is now stale
+    ready.push_back(id);
+}
+
+void runLoop() {
+    size_t live = all.size();
+    struct epoll_event events[256];
+
+    while (live > 0) {
+        for (size_t i = 0; i < ready.size(); i++) {
+            Device* d = all[ready[i]];
+            resume(d);
+            if (d->finished) live--;
+        }
+        ready.clear();
+        if (live == 0) break;
+
+        int timeout = -1;
+        if (!timers.empty()) {
+            uint64_t now = monoMs();
+            timeout = timers.top().at > now ? (int)(timers.top().at - now) : 0;
+        }
+        int n = epoll_wait(epfd, events, 256, timeout);
+        for (int i = 0; i < n; i++) {
+            wake((int)(events[i].data.u64 & 0xffffffff), (uint32_t)(events[i].data.u64 >> 32));
+        }
+
+        uint64_t now = monoMs();
+        while (!timers.empty() && timers.top().at <= now) {
+            Timer t = timers.top();
+            timers.pop();
+            Device* d = all[t.device];
+            if (d->finished || t.gen != d->waitGen) continue;
+            uint32_t late = now - t.at;
+            counters.lateWakeMs += late;
+            counters.timerWakes++;
+            if (late > counters.maxLateMs) counters.maxLateMs = late;
+            wake(t.device, t.gen);
+        }
+    }
+}
+
+}
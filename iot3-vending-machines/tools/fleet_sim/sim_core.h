@@ -0,0 +1,87 @@
+#ifndef SIM_CORE_H
+#define SIM_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <ucontext.h>
+#include <vector>
+
+// Virtual devices for the fleet simulator.
+//
+// Each device runs the firmware's setup()/loop() on its own fiber with its
+// own clock (millis() counts from the device's boot) and its own sockets.
+// The firmware keeps its state in globals, so build.sh moves the .data and
+// .bss of the firmware objects into the fw_data / fw_bss sections, and the
+// event loop swaps each device's copy of them in before resuming it.
+// Devices only yield inside delay() and socket waits.
+
+namespace sim {
+
+struct DeviceStats {
+    uint32_t polls;             // [fetch] lines: polls that got a datum
+    uint32_t pollErrors;        // "Asset state error" lines
+    uint32_t rateLimited;       // ... of which were HTTP 429
+    uint32_t prearms;           // [mempool] ARM lines
+    uint32_t commits;           // [mempool] COMMIT lines
+    uint32_t aborts;            // [mempool] ABORT lines
+    uint64_t savedMsSum;        // COMMIT saved=, summed
+    uint32_t savedMsMax;
+    uint32_t hedges;            // [hedge] winner= lines: batches sent to both providers
+    uint32_t backupWins;        // ... that the backup answered first
+    std::vector<uint32_t> datumMs;  // [fetch] datum=: poll start -> datum
+    std::vector<uint64_t> edges;    // wall-clock ms of pump rising edges
+};
+
+struct Device {
+    int id;
+    ucontext_t ctx;
+    void* stack;
+    std::vector<uint8_t> data;  // this device's fw_data
+    std::vector<uint8_t> bss;   // this device's fw_bss
+
+    uint64_t bootMs;            // host monotonic time at boot
+    uint8_t pins[64];
+
+    uint64_t wakeAt;            // waiting: resume at this monotonic time
+    uint32_t waitGen;           // invalidates stale timer/epoll wake-ups
+    bool finished;
+
+    std::string line;           // Serial output being assembled
+    DeviceStats stats;
+};
+
+struct LoopStats {
+    uint64_t switches;          // fiber resumes
+    uint64_t lateWakeMs;        // summed timer lateness (event loop overload)
+    uint32_t maxLateMs;
+    uint32_t timerWakes;
+};
+
+// Host clocks
+uint64_t monoMs();
+uint64_t wallMs();
+
+// Device currently running, nullptr outside a fiber
+Device* current();
+
+// Suspend the running device until monotonic time `atMs`, or, when
+// fd >= 0, until the fd is ready for `events` (EPOLLIN/EPOLLOUT).
+void wait(uint64_t atMs, int fd = -1, uint32_t events = 0);
+
+// Create `count` devices. Device i boots at start + i * rampMs / count
+// and runs loop() until `endMs`.
+void createDevices(int count, uint64_t startMs, uint64_t rampMs, uint64_t endMs);
+
+// Run every device to completion
+void runLoop();
+
+const std::vector<Device*>& devices();
+const LoopStats& loopStats();
+
+// Firmware log line from a device (shim.cpp)
+void onSerialLine(Device& dev, const std::string& line);
+
+}
+
+#endif
@@ -0,0 +1,265 @@
+// Host benchmark: FleetState vs a per-asset object map.
+//
+// The baseline is the obvious design: an unordered_map from the asset
+// unit (policy ID + name, hex) to a heap object with string fields and
+// the bech32 authority address, updated one change at a time. Both are
+// loaded with the same assets, then fed the same blocks of lock flips;
+// lock states are checked to match, and FleetState is checked again after
+// a block removing half the assets, before the numbers are printed.
+//
+// Build:
+//   L=../lib/chain_monitor
+//   g++ -std=c++17 -O2 -pthread -I$L/include tools/fleet_state/fleet_state.cpp
+//     tools/fleet_state/fleet_bench.cpp $L/src/locker_datum.cpp $L/src/plutus_data.cpp
+//     $L/src/bech32.cpp -o fleet_bench
+//
+// Usage: ./fleet_bench [assets...]    (default 10000 100000)
+//   THREADS=n sets the decode threads (default: hardware threads)
+
+#include "fleet_state.h"
+#include "bech32.h"
+
+#include <chrono>
+#include <malloc.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#define ASSETS_PER_POLICY 100
+#define CHANGES_PER_BLOCK 1000
+#define BLOCKS 200
+#define LOOKUPS 1000000
+
+struct Asset {
+    AssetKey key;
+    uint8_t payment[FLEET_POLICY_LEN];
+    uint8_t stake[FLEET_POLICY_LEN];
+};
+
+// Indefinite-length locker datum, as emitted by the contract
+static std::vector<uint8_t> lockerDatum(const Asset& a, bool locked) {
+    std::vector<uint8_t> v = {0xd8, 0x79, 0x9f, 0xd8, 0x79, 0x9f, 0x58, 0x1c};
+    v.insert(v.end(), a.payment, a.payment + FLEET_POLICY_LEN);
+    v.push_back(0x58);
+    v.push_back(0x1c);
+    v.insert(v.end(), a.stake, a.stake + FLEET_POLICY_LEN);
+    v.push_back(0xff);
+    v.push_back(locked ? 1 : 0);
+    v.push_back(0xff);
+    return v;
+}
+
+static std::string hex(const uint8_t* p, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    std::string s;
+    s.reserve(len * 2);
+    for (size_t i = 0; i < len; i++) {
+        s += digits[p[i] >> 4];
+        s += digits[p[i] & 15];
+    }
+    return s;
+}
+
+// Baseline: one heap object per asset, keyed by unit hex
+struct AssetRecord {
+    std::string txHash;
+    uint32_t outputIndex;
+    uint64_t slot;
+    bool locked;
+    std::string authority;
+};
+
+typedef std::unordered_map<std::string, AssetRecord> ObjectMap;
+
+static void applyObjects(ObjectMap& map, const UtxoChange* changes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const UtxoChange& c = changes[i];
+        std::string unit = hex(c.asset.policy, FLEET_POLICY_LEN) + hex(c.asset.name, c.asset.nameLen);
+        if (!c.datum) {
+            map.erase(unit);
+            continue;
+        }
+        AssetRecord& r = map[unit];
+        r.txHash = hex(c.txHash, FLEET_TX_HASH_LEN);
+        r.outputIndex = c.outputIndex;
+        r.slot = c.slot;
+        LockerDatum d;
+        const char* error;
+        if (decodeLockerDatum(c.datum, c.datumLen, &d, &error) == PLUTUS_FAILED) continue;
+        r.locked = d.isLocked == 1;
+        char address[CARDANO_ADDR_BUF_LEN];
+        encodeCardanoAddressTo(address, sizeof(address), d.authority.payment, d.authority.stake, 0);
+        r.authority = address;
+    }
+}
+
+static size_t heapInUse() {
+    return mallinfo2().uordblks;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool run(size_t count, unsigned threads) {
+    std::mt19937_64 rng(count);
+    auto r = [&](uint64_t n) { return rng() % n; };
+
+    std::vector<Asset> assets(count);
+    uint8_t policy[FLEET_POLICY_LEN];
+    for (size_t i = 0; i < count; i++) {
+        if (i % ASSETS_PER_POLICY == 0) {
+            for (auto& b : policy) b = r(256);
+        }
+        char name[FLEET_MAX_NAME_LEN + 1];
+        int nameLen = snprintf(name, sizeof(name), "locker_%zu", i);
+        makeAssetKey(policy, (const uint8_t*)name, nameLen, &assets[i].key);
+        for (auto& b : assets[i].payment) b = r(256);
+        for (auto& b : assets[i].stake) b = r(256);
+    }
+
+    // Datums outlive the changes that point at them
+    std::vector<std::vector<uint8_t>> datums;
+    datums.reserve(count + (size_t)BLOCKS * CHANGES_PER_BLOCK);
+    auto change = [&](size_t asset, bool locked, uint64_t slot) {
+        UtxoChange c;
+        c.asset = assets[asset].key;
+        for (auto& b : c.txHash) b = r(256);
+        c.outputIndex = r(4);
+        c.slot = slot;
+        datums.push_back(lockerDatum(assets[asset], locked));
+        c.datum = datums.back().data();
+        c.datumLen = datums.back().size();
+        return c;
+    };
+
+    std::vector<UtxoChange> initial;
+    std::vector<bool> expected(count);
+    for (size_t i = 0; i < count; i++) {
+        expected[i] = r(2);
+        initial.push_back(change(i, expected[i], 1000));
+    }
+    std::vector<std::vector<UtxoChange>> blocks(BLOCKS);
+    for (size_t b = 0; b < BLOCKS; b++) {
+        for (size_t i = 0; i < CHANGES_PER_BLOCK; i++) {
+            size_t a = r(count);
+            expected[a] = !expected[a];
+            blocks[b].push_back(change(a, expected[a], 2000 + b));
+        }
+    }
+
+    printf("\n%zu assets, %zu policies, blocks of %d changes, %u decode threads\n", count,
+           (count + ASSETS_PER_POLICY - 1) / ASSETS_PER_POLICY, CHANGES_PER_BLOCK, threads);
+
+    // Struct of arrays
+    size_t heapBefore = heapInUse();
+    auto start = std::chrono::steady_clock::now();
+    FleetState fleet(0);
+    BlockResult loaded = fleet.applyBlock(initial.data(), initial.size(), threads);
+    double loadSoa = secondsSince(start);
+    size_t heapSoa = heapInUse() - heapBefore;
+    size_t soaBytes = fleet.memoryBytes();
+
+    double blockSoa[2];
+    unsigned threadCounts[2] = {1, threads};
+    for (int t = 0; t < 2; t++) {
+        // Datums carry the absolute lock state, so a replay ends where the
+        // first pass did
+        start = std::chrono::steady_clock::now();
+        for (auto& block : blocks) fleet.applyBlock(block.data(), block.size(), threadCounts[t]);
+        blockSoa[t] = secondsSince(start);
+    }
+    FleetState parallel(0, count);
+    parallel.applyBlock(initial.data(), initial.size(), threads);
+    for (auto& block : blocks) parallel.applyBlock(block.data(), block.size(), threads);
+
+    // Objects
+    heapBefore = heapInUse();
+    start = std::chrono::steady_clock::now();
+    ObjectMap* objects = new ObjectMap();
+    applyObjects(*objects, initial.data(), initial.size());
+    double loadObj = secondsSince(start);
+    size_t heapObj = heapInUse() - heapBefore;
+    start = std::chrono::steady_clock::now();
+    for (auto& block : blocks) applyObjects(*objects, block.data(), block.size());
+    double blockObj = secondsSince(start);
+
+    // Same lock state and authority everywhere
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; i++) {
+        const AssetKey& k = assets[i].key;
+        uint32_t row = fleet.find(k);
+        uint32_t prow = parallel.find(k);
+        auto it = objects->find(hex(k.policy, FLEET_POLICY_LEN) + hex(k.name, k.nameLen));
+        if (row == FLEET_NO_ROW || prow == FLEET_NO_ROW || it == objects->end() ||
+            fleet.locked(row) != (bool)expected[i] || parallel.locked(prow) != (bool)expected[i] ||
+            it->second.locked != (bool)expected[i]) {
+            mismatches++;
+            continue;
+        }
+        char address[CARDANO_ADDR_BUF_LEN];
+        parallel.authorityAddress(prow, address, sizeof(address));
+        if (it->second.authority != address) mismatches++;
+    }
+
+    // Remove every other asset; the rest must still be found
+    std::vector<UtxoChange> removals;
+    for (size_t i = 0; i < count; i += 2) {
+        UtxoChange c = {};
+        c.asset = assets[i].key;
+        removals.push_back(c);
+    }
+    BlockResult removed = parallel.applyBlock(removals.data(), removals.size(), threads);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t row = parallel.find(assets[i].key);
+        bool gone = i % 2 == 0;
+        if (gone != (row == FLEET_NO_ROW) || (!gone && parallel.locked(row) != (bool)expected[i])) mismatches++;
+    }
+    if (removed.removed != removals.size() || parallel.size() != count - removals.size()) mismatches++;
+
+    // Random lookups
+    std::vector<uint32_t> probes(LOOKUPS);
+    for (auto& p : probes) p = r(count);
+    volatile uint32_t sink = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t p : probes) sink = sink + fleet.find(assets[p].key);
+    double lookupSoa = secondsSince(start);
+    std::vector<std::string> units(LOOKUPS);
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        const AssetKey& k = assets[probes[i]].key;
+        units[i] = hex(k.policy, FLEET_POLICY_LEN) + hex(k.name, k.nameLen);
+    }
+    start = std::chrono::steady_clock::now();
+    for (auto& u : units) sink = sink + (objects->find(u) != objects->end());
+    double lookupObj = secondsSince(start);
+    delete objects;
+
+    double changes = (double)BLOCKS * CHANGES_PER_BLOCK;
+    printf("%-28s %14s %14s\n", "", "struct of arrays", "object map");
+    printf("%-28s %14.2f %14.2f\n", "initial load (ms)", loadSoa * 1e3, loadObj * 1e3);
+    printf("%-28s %14.0f %14s\n", "updates/s (1 thread)", changes / blockSoa[0], "");
+    printf("%-28s %14.0f %14.0f\n", "updates/s (decode threads)", changes / blockSoa[1], changes / blockObj);
+    printf("%-28s %14.1f %14.1f\n", "lookup (ns)", lookupSoa / LOOKUPS * 1e9, lookupObj / LOOKUPS * 1e9);
+    printf("%-28s %14.1f %14.1f\n", "heap bytes/asset", (double)heapSoa / count, (double)heapObj / count);
+    printf("%-28s %14.1f %14s\n", "  columns + index", (double)soaBytes / count, "");
+    printf("load: %u inserted, %u lock changes; mismatches: %zu\n", loaded.inserted, loaded.lockChanges, mismatches);
+    return mismatches == 0 && loaded.inserted == count;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = std::thread::hardware_concurrency();
+    if (const char* env = getenv("THREADS")) threads = atoi(env);
+    if (threads == 0) threads = 1;
+
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(strtoul(argv[i], nullptr, 10));
+    if (sizes.empty()) sizes = {10000, 100000};
+
+    bool ok = true;
+    for (size_t n : sizes) ok = run(n, threads) && ok;
+    return ok ? 0 : 1;
+}
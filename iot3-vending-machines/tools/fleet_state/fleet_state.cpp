@@ -0,0 +1,243 @@
+// Struct-of-arrays locker asset table with an open-addressing index
+
+#include "fleet_state.h"
+#include "bech32.h"
+
+#include <string.h>
+#include <thread>
+
+#define MIN_INDEX_SLOTS 16
+// Grow when more than 7 of 10 slots are taken
+#define MAX_LOAD_NUM 7
+#define MAX_LOAD_DEN 10
+// Changes per thread below which a decode thread costs more than it saves
+#define MIN_CHANGES_PER_THREAD 2048
+// How far ahead the update pass prefetches index slots
+#define PREFETCH_DISTANCE 8
+
+bool makeAssetKey(const uint8_t* policy, const uint8_t* name, size_t nameLen, AssetKey* out) {
+    if (nameLen > FLEET_MAX_NAME_LEN) return false;
+    memset(out, 0, sizeof(*out));
+    memcpy(out->policy, policy, FLEET_POLICY_LEN);
+    memcpy(out->name, name, nameLen);
+    out->nameLen = nameLen;
+    return true;
+}
+
+static uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+// Policy and name words through a multiply-xorshift; the unused name
+// bytes are zero, so whole words can be read
+static uint64_t hashKey(const AssetKey& k) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ k.nameLen;
+    const uint8_t* p = (const uint8_t*)&k;
+    size_t words = (FLEET_POLICY_LEN + 1 + k.nameLen + 7) / 8;
+    for (size_t i = 0; i < words; i++) {
+        h ^= load64(p + i * 8);
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    h *= 0xC4CEB9FE1A85EC53ull;
+    return h ^ (h >> 29);
+}
+
+static bool keyEquals(const AssetKey& a, const AssetKey& b) {
+    return a.nameLen == b.nameLen && memcmp(&a, &b, FLEET_POLICY_LEN + 1 + a.nameLen) == 0;
+}
+
+FleetState::FleetState(uint8_t network, size_t expectedAssets) : network(network) {
+    size_t slots = MIN_INDEX_SLOTS;
+    while (slots * MAX_LOAD_NUM < expectedAssets * MAX_LOAD_DEN) slots *= 2;
+    index.assign(slots, {0, FLEET_NO_ROW});
+    mask = slots - 1;
+
+    keys.reserve(expectedAssets);
+    lockedCol.reserve(expectedAssets);
+    statusCol.reserve(expectedAssets);
+    slotCol.reserve(expectedAssets);
+    outputCol.reserve(expectedAssets);
+    txHashCol.reserve(expectedAssets * FLEET_TX_HASH_LEN);
+    paymentCol.reserve(expectedAssets * FLEET_POLICY_LEN);
+    stakeCol.reserve(expectedAssets * FLEET_POLICY_LEN);
+}
+
+// Slot holding `key`, or the empty slot where it would go
+size_t FleetState::probe(const AssetKey& key, uint64_t hash) const {
+    uint32_t tag = hash >> 32;
+    size_t i = hash & mask;
+    while (index[i].row != FLEET_NO_ROW) {
+        if (index[i].tag == tag && keyEquals(keys[index[i].row], key)) return i;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+uint32_t FleetState::find(const AssetKey& key) const {
+    return index[probe(key, hashKey(key))].row;
+}
+
+void FleetState::insertSlot(uint64_t hash, uint32_t row) {
+    size_t i = hash & mask;
+    while (index[i].row != FLEET_NO_ROW) i = (i + 1) & mask;
+    index[i] = {(uint32_t)(hash >> 32), row};
+}
+
+void FleetState::grow() {
+    index.assign(index.size() * 2, {0, FLEET_NO_ROW});
+    mask = index.size() - 1;
+    for (uint32_t row = 0; row < keys.size(); row++) insertSlot(hashKey(keys[row]), row);
+}
+
+uint32_t FleetState::append(const AssetKey& key, uint64_t hash) {
+    if ((keys.size() + 1) * MAX_LOAD_DEN > index.size() * MAX_LOAD_NUM) grow();
+    uint32_t row = keys.size();
+    keys.push_back(key);
+    lockedCol.push_back(0);
+    statusCol.push_back(ASSET_OK);
+    slotCol.push_back(0);
+    outputCol.push_back(0);
+    txHashCol.resize(txHashCol.size() + FLEET_TX_HASH_LEN);
+    paymentCol.resize(paymentCol.size() + FLEET_POLICY_LEN);
+    stakeCol.resize(stakeCol.size() + FLEET_POLICY_LEN);
+    insertSlot(hash, row);
+    return row;
+}
+
+// Empty index slot `at` by shifting later entries of its probe run back,
+// then fill the row hole with the last row
+void FleetState::remove(size_t at) {
+    uint32_t row = index[at].row;
+    size_t hole = at;
+    size_t j = at;
+    while (true) {
+        j = (j + 1) & mask;
+        if (index[j].row == FLEET_NO_ROW) break;
+        size_t home = hashKey(keys[index[j].row]) & mask;
+        // Move j into the hole unless its home lies cyclically in (hole, j]
+        bool between = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!between) {
+            index[hole] = index[j];
+            hole = j;
+        }
+    }
+    index[hole] = {0, FLEET_NO_ROW};
+
+    uint32_t last = keys.size() - 1;
+    if (row != last) {
+        // Repoint the last row's slot, then move its columns
+        index[probe(keys[last], hashKey(keys[last]))].row = row;
+        keys[row] = keys[last];
+        lockedCol[row] = lockedCol[last];
+        statusCol[row] = statusCol[last];
+        slotCol[row] = slotCol[last];
+        outputCol[row] = outputCol[last];
+        memcpy(&txHashCol[(size_t)row * FLEET_TX_HASH_LEN], &txHashCol[(size_t)last * FLEET_TX_HASH_LEN],
+               FLEET_TX_HASH_LEN);
+        memcpy(&paymentCol[(size_t)row * FLEET_POLICY_LEN], &paymentCol[(size_t)last * FLEET_POLICY_LEN],
+               FLEET_POLICY_LEN);
+        memcpy(&stakeCol[(size_t)row * FLEET_POLICY_LEN], &stakeCol[(size_t)last * FLEET_POLICY_LEN],
+               FLEET_POLICY_LEN);
+    }
+    keys.pop_back();
+    lockedCol.pop_back();
+    statusCol.pop_back();
+    slotCol.pop_back();
+    outputCol.pop_back();
+    txHashCol.resize(txHashCol.size() - FLEET_TX_HASH_LEN);
+    paymentCol.resize(paymentCol.size() - FLEET_POLICY_LEN);
+    stakeCol.resize(stakeCol.size() - FLEET_POLICY_LEN);
+}
+
+// Hashes and datums of changes [begin, end): no table access, so ranges
+// run on separate threads
+void FleetState::decodeRange(const UtxoChange* changes, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        const UtxoChange& c = changes[i];
+        hashes[i] = hashKey(c.asset);
+        const char* error;
+        decodedOk[i] = c.datum && decodeLockerDatum(c.datum, c.datumLen, &decoded[i], &error) != PLUTUS_FAILED;
+    }
+}
+
+BlockResult FleetState::applyBlock(const UtxoChange* changes, size_t count, unsigned threads) {
+    BlockResult result = {};
+    flipped.clear();
+    hashes.resize(count);
+    decoded.resize(count);
+    decodedOk.resize(count);
+
+    unsigned workers = threads;
+    if (workers > count / MIN_CHANGES_PER_THREAD) workers = count / MIN_CHANGES_PER_THREAD;
+    if (workers <= 1) {
+        decodeRange(changes, 0, count);
+    } else {
+        std::vector<std::thread> pool;
+        size_t per = (count + workers - 1) / workers;
+        for (unsigned t = 1; t < workers; t++) {
+            size_t begin = t * per;
+            size_t end = begin + per < count ? begin + per : count;
+            pool.emplace_back(&FleetState::decodeRange, this, changes, begin, end);
+        }
+        decodeRange(changes, 0, per);
+        for (auto& th : pool) th.join();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        // Index slots for changes a few ahead, while this one is applied
+        if (i + PREFETCH_DISTANCE < count) __builtin_prefetch(&index[hashes[i + PREFETCH_DISTANCE] & mask]);
+
+        const UtxoChange& c = changes[i];
+        size_t at = probe(c.asset, hashes[i]);
+        uint32_t row = index[at].row;
+
+        if (!c.datum) {
+            if (row != FLEET_NO_ROW) {
+                remove(at);
+                result.removed++;
+            }
+            continue;
+        }
+
+        bool fresh = row == FLEET_NO_ROW;
+        if (fresh) {
+            row = append(c.asset, hashes[i]);
+            result.inserted++;
+        } else {
+            result.updated++;
+        }
+        slotCol[row] = c.slot;
+        outputCol[row] = c.outputIndex;
+        memcpy(&txHashCol[(size_t)row * FLEET_TX_HASH_LEN], c.txHash, FLEET_TX_HASH_LEN);
+
+        if (!decodedOk[i]) {
+            statusCol[row] = ASSET_BAD_DATUM;
+            result.decodeErrors++;
+            continue;
+        }
+        const LockerDatum& d = decoded[i];
+        uint8_t locked = d.isLocked == 1;
+        if (fresh || locked != lockedCol[row]) {
+            flipped.push_back(i);
+            result.lockChanges++;
+        }
+        lockedCol[row] = locked;
+        statusCol[row] = ASSET_OK;
+        memcpy(&paymentCol[(size_t)row * FLEET_POLICY_LEN], d.authority.payment, FLEET_POLICY_LEN);
+        memcpy(&stakeCol[(size_t)row * FLEET_POLICY_LEN], d.authority.stake, FLEET_POLICY_LEN);
+    }
+    return result;
+}
+
+size_t FleetState::authorityAddress(uint32_t row, char* out, size_t size) const {
+    return encodeCardanoAddressTo(out, size, authorityPayment(row), authorityStake(row), network);
+}
+
+size_t FleetState::memoryBytes() const {
+    return keys.capacity() * sizeof(AssetKey) + lockedCol.capacity() + statusCol.capacity() +
+           slotCol.capacity() * sizeof(uint64_t) + outputCol.capacity() * sizeof(uint32_t) +
+           txHashCol.capacity() + paymentCol.capacity() + stakeCol.capacity() + index.capacity() * sizeof(Slot);
+}
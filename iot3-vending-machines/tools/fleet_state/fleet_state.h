@@ -0,0 +1,129 @@
+#ifndef FLEET_STATE_H
+#define FLEET_STATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "locker_datum.h"
+
+// State of many locker assets for a central monitor, decoded with the
+// firmware's own datum decoder (lib/chain_monitor/src/locker_datum.cpp) and
+// address encoder (lib/chain_monitor/src/bech32.cpp).
+//
+// Assets are rows of a struct-of-arrays table: one column per field, so
+// a pass over lock flags or slots reads only those bytes. Keys (28-byte
+// policy ID + asset name) sit in one 64-byte slot per row, so a key
+// compare is one cache line. The index is open addressing with linear
+// probing over 8-byte {hash tag, row} slots; removals shift entries back
+// instead of leaving tombstones and move the last row into the hole.
+// No Arduino dependencies.
+
+#define FLEET_POLICY_LEN 28
+#define FLEET_MAX_NAME_LEN 32
+#define FLEET_TX_HASH_LEN 32
+#define FLEET_NO_ROW UINT32_MAX
+
+struct AssetKey {
+    uint8_t policy[FLEET_POLICY_LEN];
+    uint8_t nameLen;
+    uint8_t name[FLEET_MAX_NAME_LEN];   // zero past nameLen
+    uint8_t pad[3];
+};
+
+// Key from raw policy ID and asset name bytes; false if the name is too long
+bool makeAssetKey(const uint8_t* policy, const uint8_t* name, size_t nameLen, AssetKey* out);
+
+// One locker UTxO change from a block, in chain order
+struct UtxoChange {
+    AssetKey asset;
+    uint8_t txHash[FLEET_TX_HASH_LEN];  // the UTxO now holding the asset
+    uint32_t outputIndex;
+    uint64_t slot;
+    const uint8_t* datum;               // inline datum CBOR; nullptr: asset left the locker
+    size_t datumLen;
+};
+
+enum AssetStatus {
+    ASSET_OK = 0,
+    ASSET_BAD_DATUM = 1,                // last datum did not decode; lock flag kept
+};
+
+struct BlockResult {
+    uint32_t inserted;
+    uint32_t updated;
+    uint32_t removed;
+    uint32_t lockChanges;               // ... of inserted/updated, lock flag differs
+    uint32_t decodeErrors;
+};
+
+class FleetState {
+public:
+    // network: 0 = testnet, 1 = mainnet (for authorityAddress())
+    explicit FleetState(uint8_t network, size_t expectedAssets = 0);
+
+    // Apply a block's changes in one pass. Datums are decoded first, split
+    // over `threads` when the block is large enough to pay for them; the
+    // table is then updated in order, so later changes to an asset win.
+    BlockResult applyBlock(const UtxoChange* changes, size_t count, unsigned threads = 1);
+
+    // Indices into the last applyBlock()'s changes whose lock flag flipped
+    // (new assets count as flipped)
+    const std::vector<uint32_t>& lockChanged() const { return flipped; }
+
+    uint32_t find(const AssetKey& key) const;
+    size_t size() const { return keys.size(); }
+
+    // Columns by row; rows move when assets are removed
+    const AssetKey& key(uint32_t row) const { return keys[row]; }
+    bool locked(uint32_t row) const { return lockedCol[row] != 0; }
+    uint8_t status(uint32_t row) const { return statusCol[row]; }
+    uint64_t slot(uint32_t row) const { return slotCol[row]; }
+    const uint8_t* txHash(uint32_t row) const { return &txHashCol[(size_t)row * FLEET_TX_HASH_LEN]; }
+    uint32_t outputIndex(uint32_t row) const { return outputCol[row]; }
+    const uint8_t* authorityPayment(uint32_t row) const { return &paymentCol[(size_t)row * FLEET_POLICY_LEN]; }
+    const uint8_t* authorityStake(uint32_t row) const { return &stakeCol[(size_t)row * FLEET_POLICY_LEN]; }
+
+    // Bech32 authority address, encoded on demand rather than stored;
+    // returns its length (0 if `size` is too small)
+    size_t authorityAddress(uint32_t row, char* out, size_t size) const;
+
+    // Heap held by the columns and the index
+    size_t memoryBytes() const;
+
+private:
+    struct Slot {
+        uint32_t tag;                   // high half of the key hash
+        uint32_t row;                   // FLEET_NO_ROW: empty
+    };
+
+    size_t probe(const AssetKey& key, uint64_t hash) const;
+    void grow();
+    void insertSlot(uint64_t hash, uint32_t row);
+    uint32_t append(const AssetKey& key, uint64_t hash);
+    void remove(size_t slot);
+    void decodeRange(const UtxoChange* changes, size_t begin, size_t end);
+
+    uint8_t network;
+
+    // Columns
+    std::vector<AssetKey> keys;
+    std::vector<uint8_t> lockedCol;
+    std::vector<uint8_t> statusCol;
+    std::vector<uint64_t> slotCol;
+    std::vector<uint32_t> outputCol;
+    std::vector<uint8_t> txHashCol;     // FLEET_TX_HASH_LEN per row
+    std::vector<uint8_t> paymentCol;    // FLEET_POLICY_LEN per row
+    std::vector<uint8_t> stakeCol;      // FLEET_POLICY_LEN per row
+
+    std::vector<Slot> index;
+    size_t mask = 0;
+
+    // Per-block scratch, reused
+    std::vector<uint64_t> hashes;
+    std::vector<LockerDatum> decoded;
+    std::vector<uint8_t> decodedOk;
+    std::vector<uint32_t> flipped;
+};
+
+#endif
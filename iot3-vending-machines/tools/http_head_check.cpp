@@ -0,0 +1,93 @@
+// Host test: response head parsing (lib/chain_monitor/src/http_stream.cpp).
+//
+// Feeds httpReadHead() scripted responses whose header lines are around
+// and well past its 160-byte line buffer, in front of and behind the
+// headers it acts on. Each scenario checks the parsed status, length and
+// keep-alive flag, and that the body starts right after the blank line.
+//
+// Build: L=../lib/chain_monitor
+//   g++ -std=gnu++17 -O2 -DARDUINO=10800 -Itools/fleet_sim/shim -I$L/include
+//     tools/http_head_check.cpp $L/src/http_stream.cpp $L/src/inflate.cpp -o http_head_check
+//
+// Usage: ./http_head_check
+
+#include "http_stream.h"
+
+#include <stdio.h>
+#include <string>
+
+// The shim's Stream blocks in waitForInput(); here all input is scripted
+// up front, so there is never more to wait for
+unsigned long millis() { return 0; }
+bool Stream::waitForInput(unsigned long ms) { (void)ms; return false; }
+
+class ScriptClient : public Client {
+public:
+    explicit ScriptClient(const std::string& data) : data(data) {}
+
+    int connect(IPAddress, uint16_t) override { return 1; }
+    int connect(const char*, uint16_t) override { return 1; }
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t*, size_t n) override { return n; }
+    int available() override { return data.size() - pos; }
+    int read() override { return pos < data.size() ? (uint8_t)data[pos++] : -1; }
+    int read(uint8_t* out, size_t n) override {
+        size_t i = 0;
+        while (i < n && pos < data.size()) out[i++] = data[pos++];
+        return i;
+    }
+    int peek() override { return pos < data.size() ? (uint8_t)data[pos] : -1; }
+    void stop() override {}
+    uint8_t connected() override { return 1; }
+    operator bool() override { return true; }
+
+    std::string rest() const { return data.substr(pos); }
+
+private:
+    std::string data;
+    size_t pos = 0;
+};
+
+static int failures = 0;
+
+static void check(bool ok, const char* scenario, const char* what) {
+    if (!ok) {
+        printf("FAIL %s: %s\n", scenario, what);
+        failures++;
+    }
+}
+
+// A header line of exactly `len` characters, CRLF not counted
+static std::string padHeader(size_t len) {
+    std::string line = "X-Pad: ";
+    line.append(len - line.size(), 'a');
+    return line + "\r\n";
+}
+
+static void scenario(const char* name, const std::string& before, const std::string& after) {
+    std::string response = "HTTP/1.1 200 OK\r\n" + before +
+                           "Content-Length: 4\r\nConnection: close\r\n" + after +
+                           "\r\nBODY";
+    ScriptClient client(response);
+    HttpResponseHead head = httpReadHead(client);
+    check(head.status == 200, name, "status");
+    check(head.contentLength == 4, name, "content length");
+    check(!head.keepAlive, name, "connection close");
+    check(client.rest() == "BODY", name, "body follows the head");
+}
+
+int main() {
+    const size_t lengths[] = {157, 158, 159, 160, 400};
+    for (size_t len : lengths) {
+        char name[48];
+        snprintf(name, sizeof(name), "%zu-char line first", len);
+        scenario(name, padHeader(len), "");
+        snprintf(name, sizeof(name), "%zu-char line last", len);
+        scenario(name, "", padHeader(len));
+    }
+    // Several over-long lines back to back, then the headers that matter
+    scenario("three 400-char lines", padHeader(400) + padHeader(400) + padHeader(400), "");
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "all scenarios ok", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,347 @@
+// Host test: input events and closed-loop dispensing (src/dispense.cpp).
+//
+// Feeds simulated pulse trains through the same path as the firmware:
+// ISR debouncing, the event queue and the DispenseController, with the
+// actuator task's tick and switch re-read. Flow pulses come at a jittered
+// rate with noise spikes, and the cup and door switches bounce. Each
+// scenario checks why and when the pump stopped, and what was dispensed.
+// The queue is then run with the producer on its own thread, as the ISR
+// and the actuator task are on the device, to check that every event
+// arrives once and in order, and to time event -> actuation decisions.
+//
+// Build:
+//   g++ -std=c++17 -O2 -pthread -Iinclude tools/input_sim.cpp src/dispense.cpp -o input_sim
+//
+// Usage: ./input_sim [seed]
+
+#include "dispense.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+// Firmware defaults (include/config.h)
+#define FLOW_PULSES_PER_L 450
+#define DISPENSE_ML 250
+#define DISPENSE_MAX_MS 15000
+#define DISPENSE_NO_FLOW_MS 1500
+#define FLOW_DEBOUNCE_US 1000
+#define SWITCH_DEBOUNCE_US 20000
+#define INPUT_QUEUE_EVENTS 64
+#define INPUT_TICK_MS 5
+
+static const DispenseConfig config = {
+    FLOW_PULSES_PER_L, DISPENSE_ML, DISPENSE_MAX_MS, DISPENSE_NO_FLOW_MS, true
+};
+
+// A raw pin edge, before debouncing
+struct Edge {
+    uint32_t us;
+    uint8_t kind;
+    uint8_t level;
+};
+
+// The meter on the pump outlet: pulses at `litresPerMin` (jittered)
+// while the pump runs, slowing to a stop over `runOnMs` after it stops.
+// `noisePct` of pulses are followed by a spike.
+struct Flow {
+    double litresPerMin;
+    int noisePct;
+    uint32_t runOnMs;
+};
+
+static std::mt19937 rng;
+
+// One device: ISRs, queue and actuator task on a virtual microsecond clock
+struct Device {
+    EdgeDebouncer debouncers[INPUT_KINDS] = {
+        EdgeDebouncer(FLOW_DEBOUNCE_US), EdgeDebouncer(SWITCH_DEBOUNCE_US), EdgeDebouncer(SWITCH_DEBOUNCE_US)
+    };
+    SpscQueue<InputEvent, INPUT_QUEUE_EVENTS> events;
+    DispenseController controller{config};
+    uint8_t pins[INPUT_KINDS] = {0, 0, 0};
+    bool pump = false;
+    uint32_t onUs = 0;
+    uint32_t offUs = 0;
+    uint32_t changes = 0;
+    double nextPulseUs = 0;
+    uint32_t runOnPulses = 0;
+
+    void actuate(uint32_t now) {
+        if (controller.pumpOn() == pump) return;
+        pump = controller.pumpOn();
+        (pump ? onUs : offUs) = now;
+        if (pump) nextPulseUs = now + 50000;    // spin-up
+        changes++;
+    }
+
+    // The ISR
+    void edge(const Edge& e) {
+        pins[e.kind] = e.level;
+        if (!debouncers[e.kind].accept(e.us)) return;
+        events.push({e.us, e.kind, pins[e.kind]});
+        drain(e.us);            // the task is woken at once
+    }
+
+    void drain(uint32_t now) {
+        InputEvent ev;
+        while (events.pop(&ev)) {
+            if (controller.apply(ev)) actuate(now);
+        }
+    }
+
+    // The task's periodic wake: switch re-read, then time limits
+    void tick(uint32_t now) {
+        for (uint8_t kind = INPUT_CUP; kind < INPUT_KINDS; kind++) {
+            if (!debouncers[kind].quietFor(now)) continue;
+            bool known = kind == INPUT_CUP ? controller.cupPresent() : controller.doorOpen();
+            if ((pins[kind] != 0) != known && controller.apply({now, kind, pins[kind]})) actuate(now);
+        }
+        if (controller.tick(now)) actuate(now);
+    }
+
+    void flowAt(uint32_t t, const Flow& flow) {
+        bool runningOn = !pump && changes > 0 && t - offUs < flow.runOnMs * 1000;
+        if ((!pump && !runningOn) || t < nextPulseUs) return;
+        std::uniform_real_distribution<double> jitter(0.9, 1.1);
+        double periodUs = 60e6 / (flow.litresPerMin * FLOW_PULSES_PER_L);
+        if (runningOn) {
+            periodUs *= 1.0 + (t - offUs) / 20000.0;
+            runOnPulses++;
+        }
+        nextPulseUs = t + periodUs * jitter(rng);
+        edge({t, INPUT_FLOW, 1});
+        if ((int)(rng() % 100) < flow.noisePct) spikes.push_back(t + 100 + rng() % 300);
+    }
+
+    // Play switch `edges` and the flow meter until `endUs`, in 50 us steps
+    void run(std::vector<Edge> edges, uint32_t fromUs, uint32_t endUs, const Flow* flow = nullptr) {
+        std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.us < b.us; });
+        size_t i = 0;
+        for (uint32_t t = fromUs; t <= endUs; t += 50) {
+            while (i < edges.size() && edges[i].us <= t) edge(edges[i++]);
+            if (flow) flowAt(t, *flow);
+            while (!spikes.empty() && spikes.front() <= t) {
+                edge({t, INPUT_FLOW, 1});
+                spikes.erase(spikes.begin());
+            }
+            if ((t - fromUs) % (INPUT_TICK_MS * 1000) == 0) tick(t);
+        }
+    }
+
+    std::vector<uint32_t> spikes;
+};
+
+// A switch changing to `level` at `us`, bouncing `bounces` times over a few ms
+static void switchEdges(std::vector<Edge>& out, uint8_t kind, uint32_t us, uint8_t level, int bounces) {
+    uint32_t t = us;
+    for (int i = 0; i < bounces; i++) {
+        out.push_back({t, kind, (uint8_t)(i % 2 == 0 ? level : !level)});
+        t += 200 + rng() % 800;
+    }
+    out.push_back({t, kind, level});
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* scenario, const char* what) {
+    if (!ok) {
+        printf("  FAIL %s: %s\n", scenario, what);
+        failures++;
+    }
+}
+
+static void report(const char* name, const Device& d) {
+    const DispenseController& c = d.controller;
+    printf("%-28s stop=%-12s pulses=%4u/%u ml=%4u pumped=%6u ms changes=%u stray=%u rejects=%u/%u/%u\n", name,
+           dispenseStopName(c.lastStop()), c.pulses(), c.targetPulses(), c.millilitres(), c.pumpedMs(), d.changes,
+           c.strayPulses(), d.debouncers[INPUT_FLOW].rejected(), d.debouncers[INPUT_CUP].rejected(),
+           d.debouncers[INPUT_DOOR].rejected());
+}
+
+// Cup in, then unlock at `unlockUs`
+static void cupThenUnlock(Device& d, uint32_t unlockUs, int bounces) {
+    std::vector<Edge> edges;
+    switchEdges(edges, INPUT_CUP, unlockUs / 4, 1, bounces);
+    d.run(edges, 0, unlockUs);
+    d.controller.begin(unlockUs);
+    d.actuate(unlockUs);
+}
+
+// Pour to volume; noise spikes, switch bounce and run-on rejected or set aside
+static void normalPour(double litresPerMin) {
+    Device d;
+    Flow flow = {litresPerMin, 10, 100};
+    cupThenUnlock(d, 400000, 6);
+    d.run({}, 400000, 20000000, &flow);
+
+    char name[40];
+    snprintf(name, sizeof(name), "pour %.1f L/min", litresPerMin);
+    report(name, d);
+    const DispenseController& c = d.controller;
+    check(c.lastStop() == DISPENSE_STOP_VOLUME, name, "stopped on volume");
+    check(c.pulses() == c.targetPulses(), name, "stopped on the target pulse");
+    check(d.changes == 2 && !d.pump, name, "one on, one off");
+    check(c.strayPulses() == d.runOnPulses, name, "only run-on pulses after the stop");
+    uint32_t expectMs = 50 + (uint32_t)(c.targetPulses() * 60000.0 / (litresPerMin * FLOW_PULSES_PER_L));
+    check(c.pumpedMs() > expectMs * 9 / 10 && c.pumpedMs() < expectMs * 11 / 10, name, "pour time follows flow");
+}
+
+static void cupRemoved() {
+    Device d;
+    Flow flow = {2.0, 5, 100};
+    cupThenUnlock(d, 100000, 4);
+    std::vector<Edge> edges;
+    switchEdges(edges, INPUT_CUP, 2100000, 0, 8);
+    d.run(edges, 100000, 4000000, &flow);
+    report("cup removed at 2.1 s", d);
+    check(d.controller.lastStop() == DISPENSE_STOP_CUP_REMOVED, "cup removed", "stopped on the cup");
+    check(d.offUs >= 2100000 && d.offUs < 2100000 + 100, "cup removed", "stopped on the first edge");
+    check(d.controller.pulses() < d.controller.targetPulses(), "cup removed", "short of the volume");
+}
+
+static void doorOpened() {
+    Device d;
+    Flow flow = {2.0, 0, 100};
+    cupThenUnlock(d, 100000, 0);
+    std::vector<Edge> edges;
+    switchEdges(edges, INPUT_DOOR, 1500000, 1, 5);
+    d.run(edges, 100000, 3000000, &flow);
+    report("door opened at 1.5 s", d);
+    check(d.controller.lastStop() == DISPENSE_STOP_DOOR_OPEN, "door", "stopped on the door");
+    check(d.offUs >= 1500000 && d.offUs < 1500000 + 100, "door", "stopped on the first edge");
+}
+
+// Unlock with no cup: wait, then pour once the cup arrives
+static void waitForCup() {
+    Device d;
+    Flow flow = {2.5, 0, 100};
+    d.controller.begin(0);
+    std::vector<Edge> edges;
+    switchEdges(edges, INPUT_CUP, 3000000, 1, 6);
+    d.run(edges, 0, 12000000, &flow);
+    report("cup placed 3 s after unlock", d);
+    check(d.onUs >= 3000000 && d.onUs < 3000100, "wait for cup", "started on the cup edge");
+    check(d.controller.lastStop() == DISPENSE_STOP_VOLUME, "wait for cup", "stopped on volume");
+}
+
+// The cup bounces and the last accepted edge reads "absent": the re-read fixes it
+static void lostBounce() {
+    Device d;
+    d.controller.begin(0);
+    std::vector<Edge> edges = {{100000, INPUT_CUP, 0}, {100300, INPUT_CUP, 1}};
+    d.run(edges, 0, 200000);
+    report("bounce lost, level re-read", d);
+    check(d.pump && d.onUs >= 100000 + SWITCH_DEBOUNCE_US && d.onUs <= 100000 + SWITCH_DEBOUNCE_US + INPUT_TICK_MS * 1000,
+          "lost bounce", "started within a tick of the debounce time");
+}
+
+static void dryLine() {
+    Device d;
+    cupThenUnlock(d, 10000, 0);
+    d.run({}, 10000, 3000000);
+    report("dry line", d);
+    check(d.controller.lastStop() == DISPENSE_STOP_NO_FLOW, "dry line", "stopped on no flow");
+    check(d.offUs >= 10000 + DISPENSE_NO_FLOW_MS * 1000 && d.offUs <= 10000 + DISPENSE_NO_FLOW_MS * 1000 + INPUT_TICK_MS * 1000,
+          "dry line", "within a tick of DISPENSE_NO_FLOW_MS");
+}
+
+static void slowFlow() {
+    Device d;
+    Flow flow = {0.5, 0, 100};
+    cupThenUnlock(d, 10000, 0);
+    d.run({}, 10000, 20000000, &flow);
+    report("slow flow 0.5 L/min", d);
+    check(d.controller.lastStop() == DISPENSE_STOP_TIMEOUT, "slow flow", "stopped on DISPENSE_MAX_MS");
+}
+
+static void cancelledWaiting() {
+    Device d;
+    d.controller.begin(0);
+    d.run({}, 0, 1000000);
+    d.controller.cancel(1000000);
+    report("re-locked before a cup", d);
+    check(d.changes == 0 && d.controller.lastStop() == DISPENSE_STOP_CANCELLED && !d.controller.busy(), "cancel",
+          "never pumped");
+}
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Producer thread as the ISR, consumer as the actuator task. Pump
+// decisions are timed from the event's timestamp.
+static bool threaded(uint32_t count) {
+    static SpscQueue<InputEvent, INPUT_QUEUE_EVENTS> queue;
+    std::atomic<bool> done{false};
+    uint64_t base = nowNs();
+    std::thread isr([&] {
+        for (uint32_t i = 0; i < count; i++) {
+            // Cup in / out every 1000 pulses toggles the pump
+            uint8_t kind = i % 1000 == 0 ? INPUT_CUP : INPUT_FLOW;
+            InputEvent e = {(uint32_t)((nowNs() - base) / 1000), kind, (uint8_t)(i / 1000 % 2 == 0)};
+            while (!queue.push(e)) std::this_thread::yield();
+        }
+        done = true;
+    });
+
+    DispenseConfig big = config;
+    big.targetMl = 1000000;
+    big.maxMs = 1000000;
+    big.noFlowMs = 1000000;
+    DispenseController c(big);
+    bool ok = true;
+    uint32_t seen = 0, lastUs = 0, cupEvents = 0;
+    std::vector<uint32_t> latency;
+    while (seen < count) {
+        InputEvent e;
+        if (!queue.pop(&e)) {
+            if (done && queue.pushed() == seen) break;
+            std::this_thread::yield();
+            continue;
+        }
+        if (e.us < lastUs || e.kind != (seen % 1000 == 0 ? INPUT_CUP : INPUT_FLOW)) ok = false;
+        lastUs = e.us;
+        seen++;
+        if (e.kind == INPUT_CUP) {
+            cupEvents++;
+            if (!c.busy()) c.begin(e.us);
+        }
+        if (c.apply(e)) latency.push_back((uint32_t)((nowNs() - base) / 1000) - e.us);
+    }
+    isr.join();
+    std::sort(latency.begin(), latency.end());
+    printf("threaded queue: %u events, %u in order, %u drops retried, %zu pump changes, event -> decision "
+           "p50 %u us, p99 %u us, max %u us (host)\n",
+           count, seen, queue.dropped(), latency.size(), latency.empty() ? 0 : latency[latency.size() / 2],
+           latency.empty() ? 0 : latency[latency.size() * 99 / 100], latency.empty() ? 0 : latency.back());
+    return ok && seen == count && cupEvents == (count + 999) / 1000;
+}
+
+int main(int argc, char** argv) {
+    rng.seed(argc > 1 ? atoi(argv[1]) : 42);
+
+    normalPour(1.5);
+    normalPour(2.0);
+    normalPour(3.0);
+    cupRemoved();
+    doorOpened();
+    waitForCup();
+    lostBounce();
+    dryLine();
+    slowFlow();
+    cancelledWaiting();
+    if (!threaded(200000)) {
+        printf("  FAIL threaded queue\n");
+        failures++;
+    }
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "all scenarios ok", failures);
+    return failures ? 1 : 0;
+}
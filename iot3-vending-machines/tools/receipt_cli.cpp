@@ -0,0 +1,164 @@
+// Host CLI for signed dispense receipts (src/receipt.cpp)
+//
+// Build (from iot3-vending-machines/):
+//   g++ -std=c++17 -O2 -Iinclude tools/receipt_cli.cpp src/receipt.cpp -lcrypto -o receipt
+//
+// Usage:
+//   receipt verify [file]  # one uploaded batch, default stdin; one line per receipt
+//   receipt bench [n]      # default 256 (RECEIPT_BATCH_MAX)
+//
+// verify is what the backend does before settling a batch: every
+// signature is checked against the key in the batch header, and sequence
+// numbers must be consecutive. Exits non-zero if any receipt fails.
+//
+// bench signs n receipts with a fresh key into one batch, then times
+// verifying it and checks that a flipped bit in any body or signature is
+// caught. Signing here is OpenSSL on a desktop CPU; the device's own sign
+// time is in its metrics (receipt_sign_us_*) and `receipts bench`.
+
+#include "receipt.h"
+
+#include <openssl/evp.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Firmware default RECEIPT_BATCH_MAX (include/config.h)
+#define BATCH_RECEIPTS 256
+
+static bool verifyRecord(const uint8_t* publicKey, const uint8_t* record) {
+    EVP_PKEY* key = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, publicKey, RECEIPT_KEY_LEN);
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    uint8_t message[RECEIPT_MESSAGE_LEN];
+    receiptMessage(message, record);
+    bool ok = key && ctx && EVP_DigestVerifyInit(ctx, nullptr, nullptr, nullptr, key) == 1 &&
+              EVP_DigestVerify(ctx, record + RECEIPT_BODY_LEN, RECEIPT_SIG_LEN, message, sizeof(message)) == 1;
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+static void signRecord(EVP_PKEY* key, uint8_t* record) {
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    uint8_t message[RECEIPT_MESSAGE_LEN];
+    receiptMessage(message, record);
+    size_t sigLen = RECEIPT_SIG_LEN;
+    EVP_DigestSignInit(ctx, nullptr, nullptr, nullptr, key);
+    EVP_DigestSign(ctx, record + RECEIPT_BODY_LEN, &sigLen, message, sizeof(message));
+    EVP_MD_CTX_free(ctx);
+}
+
+static void printHex(const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) printf("%02x", p[i]);
+}
+
+// Receipts in `batch` that fail verification or break the sequence
+static int checkBatch(const std::vector<uint8_t>& batch, bool print) {
+    uint8_t publicKey[RECEIPT_KEY_LEN];
+    uint16_t count;
+    if (!receiptParseBatch(batch.data(), batch.size(), publicKey, &count)) {
+        fprintf(stderr, "not a receipt batch (%zu bytes)\n", batch.size());
+        return -1;
+    }
+    if (print) {
+        printf("device ");
+        printHex(publicKey, RECEIPT_KEY_LEN);
+        printf(", %u receipts\n", count);
+    }
+    int bad = 0;
+    uint32_t firstSeq = 0;
+    const uint8_t* record = batch.data() + RECEIPT_BATCH_HEADER_LEN;
+    for (uint16_t i = 0; i < count; i++, record += RECEIPT_RECORD_LEN) {
+        PumpReceipt r;
+        bool ok = receiptUnpackBody(record, &r) && verifyRecord(publicKey, record);
+        if (i == 0) firstSeq = r.seq;
+        else if (r.seq != firstSeq + i) ok = false;
+        if (!ok) bad++;
+        if (!print) continue;
+        printf("%6u %s unit=", r.seq, ok ? "ok " : "BAD");
+        printHex(r.unit, r.unitLen);
+        printf(" tx=");
+        printHex(r.txHash, RECEIPT_TX_HASH_LEN);
+        printf(" start=%llu dispense=%lld ms\n", (unsigned long long)r.startUnixMs,
+               r.startUnixMs ? (long long)(r.endUnixMs - r.startUnixMs) : -1LL);
+    }
+    return bad;
+}
+
+static int verify(FILE* in) {
+    std::vector<uint8_t> batch;
+    uint8_t buf[4096];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), in)) > 0;) batch.insert(batch.end(), buf, buf + n);
+    int bad = checkBatch(batch, true);
+    if (bad != 0) fprintf(stderr, "%d receipts failed\n", bad < 0 ? 0 : bad);
+    return bad == 0 ? 0 : 1;
+}
+
+static int bench(int n) {
+    if (n < 1 || n > 0xffff) n = BATCH_RECEIPTS;
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_CTX* kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+    EVP_PKEY_keygen_init(kctx);
+    EVP_PKEY_keygen(kctx, &key);
+    EVP_PKEY_CTX_free(kctx);
+    uint8_t publicKey[RECEIPT_KEY_LEN];
+    size_t keyLen = sizeof(publicKey);
+    EVP_PKEY_get_raw_public_key(key, publicKey, &keyLen);
+
+    std::vector<uint8_t> batch(RECEIPT_BATCH_HEADER_LEN + (size_t)n * RECEIPT_RECORD_LEN);
+    receiptPackBatchHeader(batch.data(), publicKey, n);
+    char unit[2 * 34 + 1], tx[2 * RECEIPT_TX_HASH_LEN + 1];
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        snprintf(unit, sizeof(unit), "%056x%012x", 0xab, i);
+        snprintf(tx, sizeof(tx), "%064x", i * 7919);
+        PumpReceipt r;
+        uint64_t t = 1760000000000ull + i * 60000ull;
+        receiptFromHex(unit, tx, i, t, t + 4200, &r);
+        uint8_t* record = batch.data() + RECEIPT_BATCH_HEADER_LEN + (size_t)i * RECEIPT_RECORD_LEN;
+        receiptPackBody(record, r);
+        signRecord(key, record);
+    }
+    double signS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    int bad = checkBatch(batch, false);
+    double verifyS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // One flipped bit per record, alternating body and signature
+    int caught = 0;
+    for (int i = 0; i < n; i++) {
+        uint8_t* record = batch.data() + RECEIPT_BATCH_HEADER_LEN + (size_t)i * RECEIPT_RECORD_LEN;
+        size_t offset = i % 2 ? RECEIPT_BODY_LEN + i % RECEIPT_SIG_LEN : i % RECEIPT_BODY_LEN;
+        record[offset] ^= 1 << (i % 8);
+        PumpReceipt r;
+        if (!receiptUnpackBody(record, &r) || !verifyRecord(publicKey, record)) caught++;
+        record[offset] ^= 1 << (i % 8);
+    }
+    EVP_PKEY_free(key);
+
+    printf("%d receipts, %zu bytes per batch (%d B header + %d B per receipt)\n", n, batch.size(),
+           RECEIPT_BATCH_HEADER_LEN, RECEIPT_RECORD_LEN);
+    printf("sign:   %8.1f us/receipt (host)\n", signS * 1e6 / n);
+    printf("verify: %8.1f us/receipt, %.0f receipts/s, batch in %.2f ms\n", verifyS * 1e6 / n, n / verifyS,
+           verifyS * 1e3);
+    printf("valid batch: %s, tampered records caught: %d/%d\n", bad == 0 ? "ok" : "FAILED", caught, n);
+    return bad == 0 && caught == n ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "verify") == 0) {
+        FILE* in = argc >= 3 ? fopen(argv[2], "rb") : stdin;
+        if (!in) {
+            perror(argv[2]);
+            return 1;
+        }
+        return verify(in);
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) return bench(argc >= 3 ? atoi(argv[2]) : BATCH_RECEIPTS);
+    fprintf(stderr, "usage: receipt verify [file] | receipt bench [n]\n");
+    return 2;
+}
@@ -0,0 +1,391 @@
+// Host checks for the device re-lock transaction (src/relock_tx.cpp)
+//
+// Build (from iot3-vending-machines/):
+//   g++ -std=c++17 -O2 -Iinclude -I../lib/chain_monitor/include tools/relock_check.cpp
+//     src/relock_tx.cpp src/blake2b.cpp src/plutus_writer.cpp -lcrypto -o relock
+//
+// Usage:
+//   relock fixture [script.hex]     # the fixture request, one "key value" line each
+//   relock check [vector.txt]       # build, sign and check the fixture tx
+//   relock tx [script.hex]          # the signed fixture tx as hex (for a node's submit API)
+//   relock bench [n]                # default 200
+//
+// check walks the CBOR, re-derives the tx id, verifies the signature with
+// OpenSSL and checks the fee, balance and collateral. Given the output of
+// iot2-sync-state-onchain/script/relock-vector.ts (the default fixture
+// built with MeshTxBuilder, as offchain.ts builds it), it also compares the
+// bodies byte for byte:
+//   ./relock fixture > fixture.txt
+//   bun script/relock-vector.ts < fixture.txt > vector.txt    (in iot2-sync-state-onchain/)
+//   ./relock check vector.txt
+//
+// The fixture script defaults to a stand-in of the locker's size (1457
+// bytes); pass the applied validator's hex for a tx that would validate.
+// The cost model is a stand-in too unless the vector supplies Mesh's.
+// Build and sign times here are a desktop CPU; the device's are in its
+// metrics (relock_build_us_*, relock_sign_us_*) and `relock bench`.
+
+#include "relock_tx.h"
+#include "blake2b.h"
+
+#include <openssl/evp.h>
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Firmware default RELOCK_TX_MAX (include/config.h)
+#define TX_MAX 4096
+#define LOCKER_SCRIPT_LEN 1457
+
+static std::vector<uint8_t> script;
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool fromHex(const std::string& hex, std::vector<uint8_t>* out) {
+    if (hex.size() % 2 != 0) return false;
+    out->clear();
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int hi = hexNibble(hex[i]);
+        int lo = hexNibble(hex[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out->push_back((hi << 4) | lo);
+    }
+    return true;
+}
+
+static std::string toHex(const uint8_t* p, size_t len) {
+    std::string s;
+    char b[3];
+    for (size_t i = 0; i < len; i++) {
+        snprintf(b, sizeof(b), "%02x", p[i]);
+        s += b;
+    }
+    return s;
+}
+
+static bool loadScript(const char* path) {
+    if (path == nullptr) {
+        // A CBOR-wrapped byte string, as compiledCode is
+        script.assign(LOCKER_SCRIPT_LEN, 0);
+        script[0] = 0x59;
+        script[1] = (LOCKER_SCRIPT_LEN - 3) >> 8;
+        script[2] = (LOCKER_SCRIPT_LEN - 3) & 0xff;
+        for (size_t i = 3; i < script.size(); i++) script[i] = (uint8_t)(i * 131 + 7);
+        return true;
+    }
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    std::string hex;
+    for (int c; (c = fgetc(f)) != EOF;) {
+        if (!isspace(c)) hex += (char)c;
+    }
+    fclose(f);
+    return fromHex(hex, &script);
+}
+
+// Device key seed; the datum authority is its hash
+static const uint8_t SEED[32] = {
+    0x9d, 0x61, 0xb1, 0x9d, 0xef, 0xfd, 0x5a, 0x60, 0xba, 0x84, 0x4a, 0xf4, 0x92, 0xec, 0x2c, 0xc4,
+    0x44, 0x49, 0xc5, 0x69, 0x7b, 0x32, 0x69, 0x19, 0x70, 0x3b, 0xac, 0x03, 0x1c, 0xae, 0x7f, 0x60,
+};
+
+static EVP_PKEY* deviceKey() {
+    return EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, SEED, sizeof(SEED));
+}
+
+static void fixture(EVP_PKEY* key, RelockRequest* req, RelockParams* params) {
+    memset(req, 0, sizeof(*req));
+    req->network = 0;
+    for (int i = 0; i < RELOCK_HASH_LEN; i++) {
+        req->locker.txHash[i] = 0xa0 + i;
+        req->funding.txHash[i] = 0x30 + i;
+    }
+    req->locker.index = 0;
+    req->lockerLovelace = 1900000;
+    req->funding.index = 1;
+    req->fundingLovelace = 25000000;
+    for (int i = 0; i < RELOCK_KEY_HASH_LEN; i++) req->policyId[i] = 0x14 + i;
+    memcpy(req->assetName, "locker_537", 10);
+    req->assetNameLen = 10;
+    size_t keyLen = RELOCK_KEY_LEN;
+    EVP_PKEY_get_raw_public_key(key, req->publicKey, &keyLen);
+    relockKeyHash(req->publicKey, req->authority.payment);
+    for (int i = 0; i < RELOCK_KEY_HASH_LEN; i++) req->authority.stake[i] = 0xe0 - i;
+    req->script = script.data();
+    req->scriptLen = script.size();
+    // Firmware defaults RELOCK_EX_MEM / RELOCK_EX_STEPS
+    req->exMem = 600000;
+    req->exSteps = 200000000;
+    req->ttl = 0;
+
+    // preprod protocol parameters; stand-in cost model values
+    memset(params, 0, sizeof(*params));
+    params->minFeeA = 44;
+    params->minFeeB = 155381;
+    params->priceMemNano = 57700000;        // 0.0577
+    params->priceStepNano = 72100;          // 0.0000721
+    params->collateralPercent = 150;
+    params->coinsPerUtxoByte = 4310;
+    params->costModelLen = 297;
+    for (size_t i = 0; i < params->costModelLen; i++) params->costModel[i] = (int64_t)((i * 7919) % 200000) - 1000;
+}
+
+// Fee and collateral do not depend on the cost model (only its hash is in the tx)
+static void printFixture(const RelockRequest& req, const RelockParams& p, const RelockTx& tx) {
+    printf("network %u\n", req.network);
+    printf("locker %s#%u\n", toHex(req.locker.txHash, RELOCK_HASH_LEN).c_str(), req.locker.index);
+    printf("locker_lovelace %llu\n", (unsigned long long)req.lockerLovelace);
+    printf("funding %s#%u\n", toHex(req.funding.txHash, RELOCK_HASH_LEN).c_str(), req.funding.index);
+    printf("funding_lovelace %llu\n", (unsigned long long)req.fundingLovelace);
+    printf("policy %s\n", toHex(req.policyId, RELOCK_KEY_HASH_LEN).c_str());
+    printf("asset_name %s\n", toHex(req.assetName, req.assetNameLen).c_str());
+    printf("authority_payment %s\n", toHex(req.authority.payment, RELOCK_KEY_HASH_LEN).c_str());
+    printf("authority_stake %s\n", toHex(req.authority.stake, RELOCK_KEY_HASH_LEN).c_str());
+    printf("ex_mem %llu\n", (unsigned long long)req.exMem);
+    printf("ex_steps %llu\n", (unsigned long long)req.exSteps);
+    printf("min_fee_a %u\nmin_fee_b %u\n", p.minFeeA, p.minFeeB);
+    printf("collateral_percent %u\ncoins_per_utxo_byte %u\n", p.collateralPercent, p.coinsPerUtxoByte);
+    printf("fee %llu\n", (unsigned long long)tx.fee);
+    printf("total_collateral %llu\n", (unsigned long long)tx.collateral);
+    printf("script %s\n", toHex(req.script, req.scriptLen).c_str());
+}
+
+static uint32_t sign(EVP_PKEY* key, uint8_t* buf, const RelockTx& tx) {
+    auto start = std::chrono::steady_clock::now();
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    uint8_t signature[RELOCK_SIGNATURE_LEN];
+    size_t sigLen = sizeof(signature);
+    EVP_DigestSignInit(ctx, nullptr, nullptr, nullptr, key);
+    EVP_DigestSign(ctx, signature, &sigLen, tx.bodyHash, RELOCK_HASH_LEN);
+    EVP_MD_CTX_free(ctx);
+    relockSetSignature(buf, tx, signature);
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool verify(const uint8_t* publicKey, const uint8_t* signature, const uint8_t* message, size_t len) {
+    EVP_PKEY* key = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, publicKey, RELOCK_KEY_LEN);
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    bool ok = key && ctx && EVP_DigestVerifyInit(ctx, nullptr, nullptr, nullptr, key) == 1 &&
+              EVP_DigestVerify(ctx, signature, RELOCK_SIGNATURE_LEN, message, len) == 1;
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+// End of the CBOR item at `p` (definite and indefinite lengths), or nullptr
+static const uint8_t* skipItem(const uint8_t* p, const uint8_t* end, int depth = 0) {
+    if (p >= end || depth > 32) return nullptr;
+    uint8_t major = *p >> 5, info = *p & 0x1f;
+    p++;
+    uint64_t arg = info;
+    if (info == 31) {
+        if (major < 2 || major > 5) return nullptr;
+        while (p < end && *p != 0xff) {
+            p = skipItem(p, end, depth + 1);
+            if (!p) return nullptr;
+        }
+        return p < end ? p + 1 : nullptr;
+    }
+    if (info >= 24) {
+        if (info > 27) return nullptr;
+        int n = 1 << (info - 24);
+        if (end - p < n) return nullptr;
+        arg = 0;
+        for (int i = 0; i < n; i++) arg = (arg << 8) | *p++;
+    }
+    switch (major) {
+        case 2:
+        case 3:
+            return (uint64_t)(end - p) < arg ? nullptr : p + arg;
+        case 4:
+        case 5:
+            for (uint64_t i = 0; i < (major == 5 ? 2 * arg : arg); i++) {
+                p = skipItem(p, end, depth + 1);
+                if (!p) return nullptr;
+            }
+            return p;
+        case 6:
+            return skipItem(p, end, depth + 1);
+        default:
+            return p;
+    }
+}
+
+// Vector lines from relock-vector.ts: "cost_model n,n,..." and "body hex"
+static bool loadVector(const char* path, RelockParams* params, std::vector<uint8_t>* body) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    std::string line;
+    bool haveBody = false;
+    for (int c;;) {
+        c = fgetc(f);
+        if (c != '\n' && c != EOF) {
+            line += (char)c;
+            continue;
+        }
+        if (line.rfind("cost_model ", 0) == 0) {
+            params->costModelLen = 0;
+            const char* s = line.c_str() + 11;
+            while (*s && params->costModelLen < RELOCK_COST_MODEL_MAX) {
+                params->costModel[params->costModelLen++] = strtoll(s, (char**)&s, 10);
+                if (*s == ',') s++;
+            }
+        } else if (line.rfind("body ", 0) == 0) {
+            haveBody = fromHex(line.substr(5), body);
+        }
+        line.clear();
+        if (c == EOF) break;
+    }
+    fclose(f);
+    return haveBody;
+}
+
+static int check(const char* vectorPath) {
+    EVP_PKEY* key = deviceKey();
+    RelockRequest req;
+    RelockParams params;
+    fixture(key, &req, &params);
+    std::vector<uint8_t> meshBody;
+    if (vectorPath && !loadVector(vectorPath, &params, &meshBody)) {
+        fprintf(stderr, "cannot read a vector from %s\n", vectorPath);
+        return 2;
+    }
+
+    static uint8_t buf[TX_MAX];
+    RelockTx tx;
+    RelockError err = buildRelockTx(req, params, buf, sizeof(buf), &tx);
+    if (err != RELOCK_OK) {
+        fprintf(stderr, "build failed: %s\n", relockErrorName(err));
+        return 1;
+    }
+    sign(key, buf, tx);
+    EVP_PKEY_free(key);
+
+    int failures = 0;
+    auto expect = [&](bool ok, const char* what) {
+        printf("%-44s %s\n", what, ok ? "ok" : "FAIL");
+        if (!ok) failures++;
+    };
+
+    const uint8_t* end = buf + tx.len;
+    const uint8_t* bodyStart = buf + 1;
+    const uint8_t* bodyEnd = skipItem(bodyStart, end);
+    expect(buf[0] == 0x84 && skipItem(buf, end) == end, "tx is one 4-item array, nothing after it");
+    expect(bodyEnd != nullptr && skipItem(bodyEnd, end) != nullptr, "body and witness set are well formed");
+
+    uint8_t id[RELOCK_HASH_LEN];
+    if (bodyEnd) blake2b(bodyStart, bodyEnd - bodyStart, id, BLAKE2B_256);
+    expect(bodyEnd && memcmp(id, tx.bodyHash, sizeof(id)) == 0, "tx id is blake2b-256 of the body bytes");
+    expect(verify(req.publicKey, buf + tx.signatureOffset, tx.bodyHash, RELOCK_HASH_LEN), "device signature verifies");
+    expect(tx.signatureOffset > (size_t)(bodyEnd - buf) && tx.signatureOffset + RELOCK_SIGNATURE_LEN <= tx.len,
+           "signature sits in the witness set");
+
+    uint64_t exFee = (req.exMem * params.priceMemNano + req.exSteps * params.priceStepNano + 999999999) / 1000000000;
+    uint64_t minFee = (uint64_t)params.minFeeA * tx.len + params.minFeeB + exFee;
+    expect(tx.fee >= minFee && tx.fee - minFee < params.minFeeA * 9, "fee covers size and budget, nothing spare");
+    expect(req.lockerLovelace + req.fundingLovelace == req.lockerLovelace + tx.change + tx.fee, "inputs balance outputs and fee");
+    expect(tx.collateral * 100 >= tx.fee * params.collateralPercent, "collateral covers collateral_percent");
+
+    uint8_t scriptHash[RELOCK_KEY_HASH_LEN];
+    relockScriptHash(req.script, req.scriptLen, scriptHash);
+    std::string txHex = toHex(buf, tx.len);
+    expect(txHex.find(toHex(scriptHash, sizeof(scriptHash))) != std::string::npos, "locker output pays the script hash");
+    // Datum{Address{payment, stake}, 1} as Mesh's mConStr0 writes it
+    std::string datum = "d8799fd8799f581c" + toHex(req.authority.payment, RELOCK_KEY_HASH_LEN) + "581c" +
+                        toHex(req.authority.stake, RELOCK_KEY_HASH_LEN) + "ff01ff";
+    expect(txHex.find(datum) != std::string::npos, "inline datum keeps the authority, is_locked 1");
+
+    if (vectorPath) {
+        bool same = meshBody.size() == (size_t)(bodyEnd - bodyStart) &&
+                    memcmp(meshBody.data(), bodyStart, meshBody.size()) == 0;
+        expect(same, "body matches MeshTxBuilder byte for byte");
+        if (!same) {
+            printf("device: %s\nmesh:   %s\n", toHex(bodyStart, bodyEnd - bodyStart).c_str(),
+                   toHex(meshBody.data(), meshBody.size()).c_str());
+        }
+    }
+
+    printf("tx %s: %zu bytes, fee %llu, change %llu, collateral %llu\n", toHex(tx.bodyHash, RELOCK_HASH_LEN).c_str(),
+           tx.len, (unsigned long long)tx.fee, (unsigned long long)tx.change, (unsigned long long)tx.collateral);
+    return failures ? 1 : 0;
+}
+
+static int printTx() {
+    EVP_PKEY* key = deviceKey();
+    RelockRequest req;
+    RelockParams params;
+    fixture(key, &req, &params);
+    static uint8_t buf[TX_MAX];
+    RelockTx tx;
+    RelockError err = buildRelockTx(req, params, buf, sizeof(buf), &tx);
+    if (err != RELOCK_OK) {
+        fprintf(stderr, "build failed: %s\n", relockErrorName(err));
+        return 1;
+    }
+    sign(key, buf, tx);
+    EVP_PKEY_free(key);
+    printf("%s\n", toHex(buf, tx.len).c_str());
+    return 0;
+}
+
+static int bench(int n) {
+    EVP_PKEY* key = deviceKey();
+    RelockRequest req;
+    RelockParams params;
+    fixture(key, &req, &params);
+    static uint8_t buf[TX_MAX];
+    RelockTx tx;
+    uint64_t buildUs = 0, signUs = 0;
+    for (int i = 0; i < n; i++) {
+        req.funding.index = i;      // a different tx each time
+        auto start = std::chrono::steady_clock::now();
+        if (buildRelockTx(req, params, buf, sizeof(buf), &tx) != RELOCK_OK) return 1;
+        buildUs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        signUs += sign(key, buf, tx);
+    }
+    EVP_PKEY_free(key);
+    printf("%d txs of %zu bytes: build %.1f us, sign %.1f us (mean)\n", n, tx.len,
+           (double)buildUs / n, (double)signUs / n);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "";
+    const char* arg = argc > 2 ? argv[2] : nullptr;
+    bool scriptArg = strcmp(mode, "fixture") == 0 || strcmp(mode, "tx") == 0;
+    if (!loadScript(scriptArg ? arg : nullptr)) {
+        fprintf(stderr, "cannot read script hex from %s\n", arg);
+        return 2;
+    }
+    if (strcmp(mode, "fixture") == 0) {
+        EVP_PKEY* key = deviceKey();
+        RelockRequest req;
+        RelockParams params;
+        fixture(key, &req, &params);
+        EVP_PKEY_free(key);
+        static uint8_t buf[TX_MAX];
+        RelockTx tx;
+        RelockError err = buildRelockTx(req, params, buf, sizeof(buf), &tx);
+        if (err != RELOCK_OK) {
+            fprintf(stderr, "build failed: %s\n", relockErrorName(err));
+            return 1;
+        }
+        printFixture(req, params, tx);
+        return 0;
+    }
+    if (strcmp(mode, "check") == 0) return check(arg);
+    if (strcmp(mode, "tx") == 0) return printTx();
+    if (strcmp(mode, "bench") == 0) return bench(arg ? atoi(arg) : 200);
+    fprintf(stderr, "usage: relock fixture [script.hex] | check [vector.txt] | tx [script.hex] | bench [n]\n");
+    return 2;
+}
@@ -0,0 +1,127 @@
+// Host simulation of the firmware loop's deadline scheduling and energy use.
+//
+// Drives DeadlineScheduler and EnergyMeter (lib/chain_monitor/src/scheduler.cpp)
+// with a simulated clock, using the same loop shape as main.cpp: poll when due,
+// otherwise idle until the next deadline (delay() or light sleep). Unlock
+// transactions land at random times; detection latency is the time from a
+// transaction to the end of the poll that sees it.
+//
+// Build: L=../lib/chain_monitor
+//   g++ -std=c++17 -O2 -Iinclude -I$L/include tools/sched_sim.cpp $L/src/scheduler.cpp -o sched_sim
+//
+// Usage: ./sched_sim [poll_ms] [wake_ms] [hours]
+//   poll_ms   time one poll keeps the radio busy (default 350)
+//   wake_ms   sleep end to WiFi ready (default 1: automatic light sleep
+//             keeps the association, so there is nothing to reconnect)
+//   hours     simulated time per configuration (default 24)
+
+#include "config.h"
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static uint32_t simNow = 0;
+static uint32_t simClock(void*) { return simNow; }
+
+struct SimResult {
+    double avgMa;
+    double mahPerDay;
+    double latencyMeanMs;
+    double latencyP95Ms;
+    double wakesPerHour;
+};
+
+static SimResult simulate(uint32_t intervalMs, bool lowPower, uint32_t pollMs, uint32_t wakeMs, double hours) {
+    static const uint32_t currentUa[POWER_STATES] = {
+        POWER_ACTIVE_UA, POWER_IDLE_UA, POWER_SLEEP_UA
+    };
+    simNow = 0;
+    DeadlineScheduler scheduler(simClock, nullptr);
+    EnergyMeter meter(currentUa, POWER_SUPPLY_MV, simClock, nullptr);
+    int poll = scheduler.add("poll", intervalMs);
+
+    // One unlock every ~2 minutes on average
+    std::mt19937 rng(537);
+    std::exponential_distribution<double> gap(1.0 / 120000.0);
+    uint32_t end = (uint32_t)(hours * 3600000.0);
+    uint32_t nextTx = (uint32_t)gap(rng);
+    std::vector<uint32_t> pending;
+    std::vector<uint32_t> latencies;
+    uint64_t chargeUas = 0;
+    uint32_t wakes = 0;
+
+    while (simNow < end) {
+        if (scheduler.due(poll)) {
+            // A poll sees every tx that landed before its request went out
+            uint32_t sent = simNow;
+            meter.enter(POWER_ACTIVE);
+            simNow += pollMs;
+            meter.enter(POWER_IDLE);
+            while (nextTx <= sent) {
+                pending.push_back(nextTx);
+                nextTx += (uint32_t)gap(rng) + 1;
+            }
+            for (uint32_t tx : pending) latencies.push_back(simNow - tx);
+            pending.clear();
+            scheduler.rearm(poll);
+
+            EnergyReport r = meter.take();
+            chargeUas += r.chargeUas;
+            wakes += r.wakes;
+        }
+
+        uint32_t wait = scheduler.msUntilNext();
+        if (lowPower && wait >= LOW_POWER_MIN_SLEEP_MS) {
+            if (wait > LOW_POWER_MAX_SLEEP_MS) wait = LOW_POWER_MAX_SLEEP_MS;
+            meter.enter(POWER_SLEEP);
+            simNow += wait;
+            meter.enter(POWER_IDLE);
+            simNow += wakeMs;
+            meter.addWake(wakeMs);
+        } else {
+            // delay(10) steps until the deadline; account them in one go
+            simNow += wait > 0 ? wait : 1;
+        }
+    }
+    EnergyReport r = meter.take();
+    chargeUas += r.chargeUas;
+    wakes += r.wakes;
+
+    SimResult res;
+    double seconds = simNow / 1000.0;
+    res.avgMa = chargeUas / seconds / 1000.0;
+    res.mahPerDay = res.avgMa * 24.0;
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (uint32_t l : latencies) sum += l;
+    res.latencyMeanMs = latencies.empty() ? 0 : sum / latencies.size();
+    res.latencyP95Ms = latencies.empty() ? 0 : latencies[latencies.size() * 95 / 100];
+    res.wakesPerHour = wakes / (seconds / 3600.0);
+    return res;
+}
+
+int main(int argc, char** argv) {
+    uint32_t pollMs = argc > 1 ? atoi(argv[1]) : 350;
+    uint32_t wakeMs = argc > 2 ? atoi(argv[2]) : 1;
+    double hours = argc > 3 ? atof(argv[3]) : 24.0;
+
+    static const uint32_t intervals[] = {1000, 2000, 5000, 10000, 30000, 60000};
+
+    printf("poll=%ums wake=%ums draw active/idle/sleep=%u/%u/%u uA\n\n",
+        pollMs, wakeMs, POWER_ACTIVE_UA, POWER_IDLE_UA, POWER_SLEEP_UA);
+    printf("%9s %6s %9s %10s %12s %11s %9s\n",
+        "interval", "mode", "avg mA", "mAh/day", "latency avg", "latency p95", "wakes/h");
+    for (uint32_t interval : intervals) {
+        for (int lowPower = 0; lowPower <= 1; lowPower++) {
+            SimResult r = simulate(interval, lowPower, pollMs, wakeMs, hours);
+            printf("%7ums %6s %9.2f %10.1f %10.0fms %9.0fms %9.0f\n",
+                interval, lowPower ? "sleep" : "awake", r.avgMa, r.mahPerDay,
+                r.latencyMeanMs, r.latencyP95Ms, r.wakesPerHour);
+        }
+    }
+    return 0;
+}
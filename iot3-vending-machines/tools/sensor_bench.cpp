@@ -0,0 +1,240 @@
+// Host benchmark: the sensor sampling pipeline (src/sampling.cpp).
+//
+// Feeds a simulated DHT22 trace (cabinet temperature and humidity random
+// walks at 0.1 resolution, door openings, missed readings) through the
+// sample ring, window aggregation and batch encoder with the firmware's
+// default settings, and decodes every batch again to check it. Reports
+// bytes per sample and on-chain writes against one datum per sample (as
+// scripts/batch-write.ts in iot1 does today), and pipeline throughput.
+// The ring is also run with the producer on its own thread to check that
+// every sample arrives once and in order.
+//
+// Build:
+//   L=../lib/chain_monitor
+//   g++ -std=c++17 -O2 -pthread -Iinclude -I$L/include tools/sensor_bench.cpp src/sampling.cpp
+//     src/plutus_writer.cpp $L/src/plutus_data.cpp -o sensor_bench
+//
+// Usage: ./sensor_bench [hours]    (default 24)
+
+#include "sampling.h"
+#include "plutus_writer.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+// Firmware defaults (include/config.h)
+#define SAMPLE_MS 2000
+#define WINDOW_MS 60000
+#define STEP 100
+#define BATCH_WINDOWS 30
+#define BATCH_BYTES 512
+#define RING_SAMPLES 32
+
+#define MISSED_READING_PCT 1
+#define DOOR_OPEN_PER_HOUR 4
+
+static std::vector<SensorSample> trace(double hours) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> pct(0, 99);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<SensorSample> out;
+
+    double t = 4.0, h = 60.0;       // chilled cabinet
+    int doorLeft = 0;
+    uint32_t samples = hours * 3600000 / SAMPLE_MS;
+    for (uint32_t i = 0; i < samples; i++) {
+        if (doorLeft == 0 && rng() % (3600000 / SAMPLE_MS) < DOOR_OPEN_PER_HOUR) doorLeft = 15;
+        if (doorLeft > 0) {
+            doorLeft--;
+            t += 0.4;
+            h += 1.5;
+        } else {
+            t += (4.0 - t) * 0.02 + noise(rng) * 0.03;
+            h += (60.0 - h) * 0.02 + noise(rng) * 0.1;
+        }
+        if (pct(rng) < MISSED_READING_PCT) continue;
+        // DHT22 resolution: 0.1
+        int32_t tq = (int32_t)(t * 10 + (t >= 0 ? 0.5 : -0.5)) * 100;
+        int32_t hq = (int32_t)(h * 10 + 0.5) * 100;
+        out.push_back({i * SAMPLE_MS, tq, hq});
+    }
+    return out;
+}
+
+// One reading as its own datum: Constr 0 [temperature, humidity, owner]
+static size_t perSampleDatumBytes(const SensorSample& s) {
+    uint8_t buf[64], owner[28] = {};
+    PlutusWriter w(buf, sizeof(buf));
+    w.constr(0);
+    w.beginList();
+    w.integer(s.temperature);
+    w.integer(s.humidity);
+    w.bytes(owner, sizeof(owner));
+    w.endList();
+    return w.size();
+}
+
+// The same windows with absolute values instead of deltas
+static size_t absoluteWindowBytes(const SensorWindow& win) {
+    uint8_t buf[96];
+    PlutusWriter w(buf, sizeof(buf));
+    w.constr(0);
+    w.beginList();
+    w.integer(win.startMs);
+    w.integer(win.count);
+    for (int32_t v : {win.tMean, win.tMin, win.tMax, win.hMean, win.hMin, win.hMax}) w.integer(v / STEP);
+    w.endList();
+    return w.size();
+}
+
+struct Totals {
+    size_t samples = 0;
+    size_t windows = 0;
+    size_t batches = 0;
+    size_t batchBytes = 0;
+    size_t absoluteBytes = 0;
+    size_t mismatches = 0;
+};
+
+static int32_t quantised(int32_t v) {
+    return (v >= 0 ? v + STEP / 2 : v - STEP / 2) / STEP * STEP;
+}
+
+static bool sameWindow(const SensorWindow& a, const SensorWindow& decoded, uint32_t offset) {
+    return decoded.startMs == offset && decoded.count == a.count &&
+           decoded.tMean == quantised(a.tMean) && decoded.tMin == quantised(a.tMin) &&
+           decoded.tMax == quantised(a.tMax) && decoded.hMean == quantised(a.hMean) &&
+           decoded.hMin == quantised(a.hMin) && decoded.hMax == quantised(a.hMax);
+}
+
+// Encode what is collected, decode it back and compare
+static void closeBatch(std::vector<SensorWindow>& pending, Totals& totals, bool check) {
+    SensorBatchHeader header = {};
+    strcpy(header.name, "dht22_sensor_01");
+    header.startUnixMs = 1760000000000ull + pending[0].startMs;
+    header.windowMs = WINDOW_MS;
+    header.step = STEP;
+
+    uint8_t buf[BATCH_BYTES];
+    size_t encoded;
+    size_t len = encodeSensorBatch(header, pending.data(), pending.size(), buf, sizeof(buf), &encoded);
+    if (len == 0) {
+        totals.mismatches++;
+        pending.clear();
+        return;
+    }
+    totals.batches++;
+    totals.batchBytes += len;
+
+    if (check) {
+        SensorBatchHeader h;
+        SensorWindow decoded[BATCH_WINDOWS];
+        size_t n = 0;
+        if (!decodeSensorBatch(buf, len, &h, decoded, BATCH_WINDOWS, &n) || n != encoded ||
+            h.startUnixMs != header.startUnixMs || strcmp(h.name, header.name) != 0) {
+            totals.mismatches++;
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                if (!sameWindow(pending[i], decoded[i], pending[i].startMs - pending[0].startMs)) totals.mismatches++;
+                totals.absoluteBytes += absoluteWindowBytes(pending[i]);
+            }
+        }
+    }
+    pending.erase(pending.begin(), pending.begin() + encoded);
+}
+
+// Ring -> windows -> batches, on one thread as the loop runs it
+static Totals runPipeline(const std::vector<SensorSample>& samples, bool check) {
+    static SensorSample storage[RING_SAMPLES];
+    SampleRing ring(storage, RING_SAMPLES);
+    WindowAggregator windows(WINDOW_MS);
+    std::vector<SensorWindow> pending;
+    pending.reserve(BATCH_WINDOWS);
+    Totals totals;
+
+    // The loop drains the ring every sample period; push a few at a time
+    for (size_t i = 0; i < samples.size(); i++) {
+        ring.push(samples[i]);
+        if (i % 4 != 3 && i + 1 != samples.size()) continue;
+        SensorSample s;
+        SensorWindow closed;
+        while (ring.pop(&s)) {
+            totals.samples++;
+            if (!windows.add(s, &closed)) continue;
+            pending.push_back(closed);
+            totals.windows++;
+            if (pending.size() == BATCH_WINDOWS) closeBatch(pending, totals, check);
+        }
+    }
+    SensorWindow closed;
+    if (windows.flush(&closed)) {
+        pending.push_back(closed);
+        totals.windows++;
+    }
+    while (!pending.empty()) closeBatch(pending, totals, check);
+    return totals;
+}
+
+// Producer thread vs consumer: every sample once, in order
+static bool checkRingThreaded(size_t count) {
+    static SensorSample storage[RING_SAMPLES];
+    SampleRing ring(storage, RING_SAMPLES);
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < count; i++) {
+            SensorSample s = {i, (int32_t)i, -(int32_t)i};
+            while (!ring.push(s)) std::this_thread::yield();
+        }
+    });
+    size_t next = 0;
+    bool ok = true;
+    while (next < count) {
+        SensorSample s;
+        if (!ring.pop(&s)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (s.ms != next || s.temperature != (int32_t)next || s.humidity != -(int32_t)next) ok = false;
+        next++;
+    }
+    producer.join();
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 24;
+    std::vector<SensorSample> samples = trace(hours);
+
+    Totals t = runPipeline(samples, true);
+
+    size_t perSample = 0;
+    for (const SensorSample& s : samples) perSample += perSampleDatumBytes(s);
+
+    // Throughput without the decode check
+    int rounds = 20;
+    auto start = std::chrono::steady_clock::now();
+    size_t sink = 0;
+    for (int i = 0; i < rounds; i++) sink += runPipeline(samples, false).batchBytes;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool ringOk = checkRingThreaded(1000000);
+
+    printf("%.1f h at %d ms: %zu samples (%d%% missed), %zu windows of %d s, %zu batches\n",
+           hours, SAMPLE_MS, t.samples, MISSED_READING_PCT, t.windows, WINDOW_MS / 1000, t.batches);
+    printf("%-30s %12s %12s %14s\n", "", "bytes", "bytes/sample", "on-chain writes");
+    printf("%-30s %12zu %12.2f %14zu\n", "datum per sample", perSample, (double)perSample / t.samples, t.samples);
+    printf("%-30s %12zu %12.2f %14s\n", "windows, absolute values", t.absoluteBytes,
+           (double)t.absoluteBytes / t.samples, "");
+    printf("%-30s %12zu %12.2f %14zu\n", "delta-encoded batches", t.batchBytes, (double)t.batchBytes / t.samples,
+           t.batches);
+    printf("writes saved: %zu (%.1f%%), %.1f bytes per window\n", t.samples - t.batches,
+           100.0 * (t.samples - t.batches) / t.samples, (double)t.batchBytes / t.windows);
+    printf("pipeline: %.2f M samples/s (%.0f ns/sample, ring + windows + encode)\n",
+           rounds * samples.size() / seconds / 1e6, seconds * 1e9 / (rounds * samples.size()));
+    printf("round trip mismatches: %zu, threaded ring: %s\n", t.mismatches, ringOk ? "ok" : "FAILED");
+    return t.mismatches == 0 && ringOk && sink > 0 ? 0 : 1;
+}
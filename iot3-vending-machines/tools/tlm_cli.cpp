@@ -0,0 +1,221 @@
+// Host CLI for the firmware telemetry frames (lib/chain_monitor/src/telemetry.cpp)
+//
+// Build (from iot3-vending-machines/):
+//   L=../lib/chain_monitor
+//   g++ -std=c++17 -O2 -I$L/include tools/tlm_cli.cpp $L/src/telemetry.cpp $L/src/bech32.cpp -o tlm
+//
+// Usage:
+//   tlm decode [file]      # serial capture, default stdin; one line per record
+//   tlm bench [polls]
+//
+// decode streams: `pio device monitor --raw | tlm decode` follows a live
+// device. Chunks between 0x00 delimiters that are not valid frames (boot
+// banner, metrics, command replies) are passed through unchanged. A count
+// of frames, bad frames and passed-through bytes goes to stderr at EOF.
+//
+// bench times what one poll's log costs the firmware loop: the text path
+// (snprintf + bech32 + blocking UART write) against packing and queueing
+// the same three records, and the bytes each puts on the wire.
+
+#include "telemetry.h"
+#include "bech32.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#define UART_BAUD 115200
+
+static int cmdDecode(int argc, char** argv) {
+    FILE* in = stdin;
+    if (argc > 2) {
+        in = fopen(argv[2], "rb");
+        if (!in) {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+
+    std::vector<uint8_t> chunk;
+    unsigned frames = 0;
+    unsigned bad = 0;
+    size_t textBytes = 0;
+    uint8_t scratch[TLM_MAX_RECORD];
+    char line[TLM_MAX_LINE];
+
+    int c;
+    while ((c = getc(in)) != EOF) {
+        if (c != 0) {
+            chunk.push_back((uint8_t)c);
+            continue;
+        }
+        if (chunk.empty()) continue;
+        TlmRecord rec;
+        if (chunk.size() <= TLM_MAX_FRAME && tlmDecode(chunk.data(), chunk.size(), scratch, &rec)) {
+            tlmFormat(rec, line, sizeof(line));
+            printf("%7u.%03u %-5s %s\n", rec.timeMs / 1000, rec.timeMs % 1000, tlmLevelName(rec.level), line);
+            frames++;
+        } else {
+            // Text has no 0x00 of its own, so anything with a frame's
+            // shape that fails the CRC is a corrupted frame
+            bool binary = false;
+            for (uint8_t b : chunk) binary |= b < 0x09 || (b > 0x0D && b < 0x20) || b == 0x7F;
+            if (binary) {
+                bad++;
+            } else {
+                fwrite(chunk.data(), 1, chunk.size(), stdout);
+                textBytes += chunk.size();
+            }
+        }
+        chunk.clear();
+        fflush(stdout);
+    }
+    fwrite(chunk.data(), 1, chunk.size(), stdout);
+    textBytes += chunk.size();
+
+    if (in != stdin) fclose(in);
+    fprintf(stderr, "%u frames, %u bad, %zu text bytes passed through\n", frames, bad, textBytes);
+    return 0;
+}
+
+// One poll's worth of log input, varied per poll
+struct PollLog {
+    TlmFetch fetch;
+    TlmState state;
+    TlmEnergy energy;
+};
+
+static std::vector<PollLog> samplePolls(size_t count) {
+    std::mt19937 rng(37);
+    auto r = [&rng](uint32_t n) { return (uint32_t)(rng() % n); };
+    std::vector<PollLog> polls(count);
+    for (auto& p : polls) {
+        p.fetch = {r(2) == 0, 1800 + r(400), 3900 + r(800), r(3), 150000 + r(20000),
+                   4, (uint16_t)(2 + r(2)), (uint16_t)r(2), r(300), r(40), 80 + r(400)};
+        p.state.network = 0;
+        p.state.isLocked = r(2);
+        for (auto& b : p.state.pubKeyHash) b = (uint8_t)rng();
+        for (auto& b : p.state.stakeCredHash) b = (uint8_t)rng();
+        p.energy = {1000 + r(500), r(200), 8000 + r(1000), r(12), r(40), 40000 + r(9000), 130 + r(30), 4000 + r(900)};
+    }
+    return polls;
+}
+
+// The firmware's text log before the telemetry ring: three printf lines
+static size_t textLog(const PollLog& p, char* out, size_t size) {
+    const TlmFetch& f = p.fetch;
+    const TlmEnergy& e = p.energy;
+    char address[CARDANO_ADDR_BUF_LEN];
+    encodeCardanoAddressTo(address, sizeof(address), p.state.pubKeyHash, p.state.stakeCredHash, p.state.network);
+    int n = snprintf(out, size,
+        "[fetch] %s wire=%uB body=%uB datum=%ums heap_min=%u "
+        "req=%u rtt=%u conn=%u/%ums dns=%ums wait=%ums\n"
+        "Authority: %s | Locked: %s\n"
+        "[energy] active=%ums idle=%ums sleep=%ums wake=%u/%ums "
+        "charge=%uuAs (%umJ) avg=%uuA\n",
+        f.compressed ? "gzip" : "identity", f.wireBytes, f.bodyBytes, f.datumMs, f.minFreeHeap,
+        f.requests, f.roundTrips, f.connects, f.connectMs, f.resolveMs, f.waitMs,
+        address, p.state.isLocked ? "true" : "false",
+        e.activeMs, e.idleMs, e.sleepMs, e.wakes, e.wakeMs, e.chargeUas, e.energyMj, e.avgUa);
+    return n > 0 ? n : 0;
+}
+
+static void binaryLog(TelemetryRing& ring, const PollLog& p, uint32_t timeMs) {
+    uint8_t payload[TLM_MAX_PAYLOAD];
+    ring.push(TLM_FETCH, TLM_INFO, timeMs, payload, tlmPackFetch(payload, p.fetch));
+    ring.push(TLM_STATE, TLM_INFO, timeMs, payload, tlmPackState(payload, p.state));
+    ring.push(TLM_ENERGY, TLM_INFO, timeMs, payload, tlmPackEnergy(payload, p.energy));
+}
+
+static int cmdBench(int argc, char** argv) {
+    size_t count = argc > 2 ? strtoul(argv[2], nullptr, 10) : 100000;
+    if (count == 0) return 2;
+    std::vector<PollLog> polls = samplePolls(count);
+
+    using Clock = std::chrono::steady_clock;
+    auto nsPer = [count](Clock::time_point t0) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / count;
+    };
+
+    // Text: format only (the UART time comes on top, below)
+    char text[3 * TLM_MAX_LINE];
+    size_t textBytes = 0;
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < count; i++) textBytes += textLog(polls[i], text, sizeof(text));
+    double textNs = nsPer(t0);
+
+    // Binary: pack + encode + queue; drained between batches, off the clock
+    const uint32_t ringSize = 1 << 20;
+    std::vector<uint8_t> storage(ringSize);
+    TelemetryRing ring(storage.data(), ringSize);
+    uint8_t frame[TLM_MAX_FRAME];
+    const size_t batch = 4096;
+    double binaryNs = 0;
+    for (size_t i = 0; i < count; i += batch) {
+        size_t end = i + batch < count ? i + batch : count;
+        t0 = Clock::now();
+        for (size_t k = i; k < end; k++) binaryLog(ring, polls[k], (uint32_t)k * 1000);
+        binaryNs += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        while (ring.nextFrame(frame) > 0) {}
+    }
+    binaryNs /= count;
+    TelemetryStats s = ring.stats();
+    if (s.dropped) {
+        fprintf(stderr, "ring dropped %u records\n", s.dropped);
+        return 1;
+    }
+
+    // Round trip: every frame renders back to the text path's lines
+    for (size_t i = 0; i < count && i < 1000; i++) {
+        binaryLog(ring, polls[i], 0);
+        std::string rendered;
+        size_t n;
+        while ((n = ring.nextFrame(frame)) > 0) {
+            uint8_t scratch[TLM_MAX_RECORD];
+            TlmRecord rec;
+            char line[TLM_MAX_LINE];
+            if (!tlmDecode(frame, n - 1, scratch, &rec)) {
+                fprintf(stderr, "frame %zu does not decode\n", i);
+                return 1;
+            }
+            tlmFormat(rec, line, sizeof(line));
+            rendered += line;
+            rendered += '\n';
+        }
+        textLog(polls[i], text, sizeof(text));
+        if (rendered != text) {
+            fprintf(stderr, "poll %zu renders differently:\n%s---\n%s", i, rendered.c_str(), text);
+            return 1;
+        }
+    }
+
+    double textPerPoll = (double)textBytes / count;
+    double binaryPerPoll = (double)s.bytes / count;
+    // 8N1: ten bit times per byte
+    double usPerByte = 10e6 / UART_BAUD;
+    printf("per poll (fetch + state + energy records), %zu polls\n", count);
+    printf("  text    %6.1f B  format %6.0f ns + UART %5.2f ms at %u baud, in the loop\n",
+           textPerPoll, textNs, textPerPoll * usPerByte / 1000, UART_BAUD);
+    printf("  binary  %6.1f B  queue  %6.0f ns; UART %5.2f ms in the drain task\n",
+           binaryPerPoll, binaryNs, binaryPerPoll * usPerByte / 1000);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int rc = 2;
+    if (argc >= 2) {
+        std::string cmd = argv[1];
+        if (cmd == "decode") rc = cmdDecode(argc, argv);
+        else if (cmd == "bench") rc = cmdBench(argc, argv);
+    }
+    if (rc == 2) {
+        fprintf(stderr,
+                "usage: tlm decode [file]\n"
+                "       tlm bench [polls]\n");
+    }
+    return rc;
+}
@@ -0,0 +1,81 @@
+#ifndef BECH32_H
+#define BECH32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Bech32 encoding for Cardano addresses
+// Based on sipa/bech32 reference implementation (BIP-173)
+//
+// The core codec is plain C++ with no heap use and no Arduino dependency,
+// so the same file builds into the firmware and into host tools
+// (see tools/bech32_cli.cpp).
+
+#define CARDANO_KEY_HASH_LEN 28
+#define CARDANO_ADDR_PAYLOAD_LEN 57   // header byte + 2 * 28-byte hashes
+#define CARDANO_ADDR_DATA5_LEN 92     // 57 * 8 bits -> 5-bit groups, padded
+// "addr_test" + '1' + data + 6-char checksum
+#define CARDANO_ADDR_MAX_LEN (9 + 1 + CARDANO_ADDR_DATA5_LEN + 6)
+#define CARDANO_ADDR_BUF_LEN (CARDANO_ADDR_MAX_LEN + 1)
+
+// Number of addresses whose checksums are computed side by side in the
+// batch encoder/decoder. The per-lane loop is written so the compiler can
+// map it onto SIMD registers on hosts that have them.
+#define BECH32_BATCH_LANES 8
+
+// Base address key-hash pair as stored in the locker datum
+struct CardanoAddressPayload {
+    uint8_t pubKeyHash[CARDANO_KEY_HASH_LEN];
+    uint8_t stakeCredHash[CARDANO_KEY_HASH_LEN];
+};
+
+// Encode Cardano base address (type 0x00) from pubKeyHash + stakeCredHash
+// into `out` (at least CARDANO_ADDR_BUF_LEN bytes), NUL-terminated.
+// network: 0 = testnet, 1 = mainnet
+// Returns the address length, or 0 if `outSize` is too small.
+size_t encodeCardanoAddressTo(
+    char* out, size_t outSize,
+    const uint8_t* pubKeyHash,      // 28 bytes
+    const uint8_t* stakeCredHash,   // 28 bytes
+    uint8_t network                 // 0 or 1
+);
+
+// Decode and checksum-verify a base address produced by the encoder above.
+// `network` receives 0/1 from the header byte; it may be NULL.
+bool decodeCardanoAddress(
+    const char* address,
+    uint8_t* pubKeyHash,            // 28 bytes out
+    uint8_t* stakeCredHash,         // 28 bytes out
+    uint8_t* network
+);
+
+// Batch encode `count` payloads for one network. Address i is written to
+// out + i * CARDANO_ADDR_BUF_LEN. Output is identical to calling
+// encodeCardanoAddressTo() per payload.
+void encodeCardanoAddressBatch(
+    const CardanoAddressPayload* payloads, size_t count,
+    uint8_t network, char* out
+);
+
+// Batch decode `count` addresses. ok[i] reports whether address i was a
+// valid base address for `network`; payloads[i] is zeroed when it was not.
+// Returns the number of valid addresses.
+size_t decodeCardanoAddressBatch(
+    const char* const* addresses, size_t count,
+    uint8_t network, CardanoAddressPayload* payloads, bool* ok
+);
+
+#ifdef ARDUINO
+// Firmware convenience wrapper around encodeCardanoAddressTo()
+String encodeCardanoAddress(
+    const uint8_t* pubKeyHash,      // 28 bytes
+    const uint8_t* stakeCredHash,   // 28 bytes
+    uint8_t network                 // 0 or 1
+);
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef BLOCKFROST_H
+#define BLOCKFROST_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "hedge.h"
+
+// One Blockfrost-compatible API (config.h CHAIN_PROVIDERS): Blockfrost, a
+// self-hosted Blockfrost backend or a local indexer serving the same paths
+struct ChainProvider {
+    const char* name;
+    const char* host;
+    uint16_t port;          // 0 disables the entry
+    bool tls;
+    const char* headers;    // auth header lines, e.g. "project_id: ...\r\n"
+};
+
+// Transfer statistics for one poll (all requests it made)
+struct FetchStats {
+    uint32_t wireBytes;     // body bytes received (compressed size when gzip)
+    uint32_t bodyBytes;     // body bytes after decompression
+    uint32_t datumMs;       // poll start -> this asset's inline_datum extracted
+    uint32_t minFreeHeap;   // lowest free heap seen during the poll
+    bool compressed;        // server sent a gzip/deflate body
+    uint16_t requests;      // GETs answered
+    uint16_t roundTrips;    // pipelined request/response round trips
+    uint16_t connects;      // connections opened (TLS handshakes)
+    uint32_t waitMs;        // time spent waiting for first response bytes
+    uint32_t resolveMs;     // DNS lookups (0 when served from the cache)
+    uint32_t connectMs;     // opening connections, including resolveMs
+};
+
+// Result for asset state query (follows monitor.ts approach)
+struct AssetStateResult {
+    bool success;
+    String error;
+    String txHash;
+    uint16_t outputIndex;   // output of txHash that holds the asset
+    uint32_t blockHeight;   // block that included txHash
+    uint32_t blockTime;     // its POSIX time (s), from the transactions list
+    uint32_t slot;          // derived: blockTime - CHAIN_SLOT_ZERO_TIME
+    String inlineDatum;
+    String address;         // address holding the asset (the locker script)
+    FetchStats stats;
+};
+
+// Chain tip and one re-read block for rollback checks (see confirm.h)
+struct BlockCheck {
+    uint32_t height;        // in: block to re-read, 0 for none
+    bool success;           // tip (and block, if asked) looked up
+    String error;
+    uint32_t tipHeight;
+    uint32_t tipSlot;
+    bool found;             // the chain has a block at `height`
+    String hash;            // ... and this is its hash
+};
+
+// Pending txs at the locker address (Blockfrost mempool)
+#define MEMPOOL_MAX_TXS 4
+
+struct MempoolTx {
+    String txHash;
+    String spends;          // tx_hash of its input holding the asset ("" if none)
+    uint16_t spendsIndex;   // ... and that input's output_index
+    String inlineDatum;     // datum of its output holding the asset at the address
+};
+
+struct MempoolCheck {
+    String address;         // in: address to watch
+    bool success;
+    String error;
+    size_t count;           // pending txs, details for the first MEMPOOL_MAX_TXS
+    MempoolTx txs[MEMPOOL_MAX_TXS];
+};
+
+void initBlockfrost();
+
+// Re-resolve the API host ahead of its DNS cache expiry; call when idle
+void refreshBlockfrostDns();
+// Time until refreshBlockfrostDns() has work (UINT32_MAX if none)
+uint32_t blockfrostDnsRefreshInMs();
+AssetStateResult fetchAssetState(const char* assetUnit);
+
+// Same, with the tip and `check->height` fetched in the transactions
+// lookup's round trip (GET /blocks/latest, GET /blocks/{height}). With
+// `mempool`, the pending txs at its address are listed in that round trip
+// (GET /mempool/addresses/{address}) and fetched in the UTxO lookup's
+// (GET /mempool/{hash}).
+AssetStateResult fetchAssetState(const char* assetUnit, BlockCheck* check, MempoolCheck* mempool = nullptr);
+
+// Several assets in one poll: the transactions lookups share one pipelined
+// round trip, then the UTxO lookups share another.
+void fetchAssetStates(const char* const* assetUnits, size_t count, AssetStateResult* results);
+
+// Newest `count` states of one asset, newest first (Blockfrost caps the
+// page at 100). Returns the number of results filled.
+size_t fetchAssetHistory(const char* assetUnit, AssetStateResult* results, size_t count);
+
+// Offer gzip/deflate via Accept-Encoding; applies from the next request
+void setBlockfrostCompression(bool enabled);
+bool blockfrostCompression();
+
+// Hedging across CHAIN_PROVIDERS: when the primary has not started a
+// response within the hedge delay, the rest of that batch is also sent to
+// the backup, whichever answers first is read and the other connection
+// closed. Every HEDGE_CROSSCHECK_POLLS polls the providers' tx_hash is
+// compared too.
+const HedgePolicy& blockfrostHedge();
+const char* blockfrostProviderName(size_t index);   // nullptr past the last
+
+// Response waits, hedge delay and counters in Prometheus text format
+void writeBlockfrostMetrics(Print& out);
+
+#endif
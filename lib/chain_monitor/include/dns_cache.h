@@ -0,0 +1,104 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Resolver cache for the API hosts.
+// Plain C++ with the resolver and clock injected, so the cache logic runs
+// unchanged on the host against a stub resolver and a simulated clock.
+//
+// - Entries live for the TTL the resolver reports (clamped below).
+// - When a connection to one A record fails, the next one is tried.
+// - refresh() re-resolves entries shortly before they expire, from the
+//   idle part of the loop rather than on the poll path.
+// - If resolution fails, the last known addresses keep being used.
+// - The address that last connected is "pinned": it is tried first after
+//   a re-resolve and handed to the pin callback for persistence.
+// - Hosts of DNS_CACHE_HOST_LEN characters or more are resolved on every
+//   lookup and never cached.
+
+#define DNS_CACHE_HOSTS 4
+#define DNS_CACHE_MAX_ADDRS 4
+#define DNS_CACHE_HOST_LEN 64
+
+#define DNS_CACHE_MIN_TTL_S 30
+#define DNS_CACHE_MAX_TTL_S 3600
+#define DNS_CACHE_REFRESH_MARGIN_MS 10000   // refresh this long before expiry
+#define DNS_CACHE_RETRY_MS 5000             // back-off after a failed resolve
+
+// Fill up to `maxAddrs` IPv4 addresses (network byte order) and the TTL in
+// seconds. Returns the number of addresses, 0 on failure.
+typedef size_t (*DnsResolveFn)(const char* host, uint32_t* addrs, size_t maxAddrs,
+                               uint32_t* ttlSec, void* ctx);
+// Milliseconds since boot
+typedef uint32_t (*DnsClockFn)(void* ctx);
+// Called when the pinned (last connected) address of a host changes
+typedef void (*DnsPinFn)(const char* host, uint32_t addr, void* ctx);
+
+struct DnsCacheStats {
+    uint32_t hits;
+    uint32_t resolves;          // resolver calls (lookups + refreshes)
+    uint32_t failures;          // resolver calls that returned nothing
+    uint32_t staleUses;         // expired entry used because resolving failed
+    uint32_t uncached;          // lookups of hosts too long to cache
+    uint32_t lastResolveMs;     // duration of the most recent resolver call
+};
+
+class DnsCache {
+public:
+    DnsCache(DnsResolveFn resolve, DnsClockFn clock, void* ctx);
+
+    void onPin(DnsPinFn fn) { pinFn = fn; }
+
+    // Seed a host with a persisted address. It counts as expired, so the
+    // first lookup still resolves, but it is used if that fails.
+    void seed(const char* host, uint32_t addr);
+
+    // Address to connect to next. Resolves when the entry is missing or
+    // expired; `resolveMs` receives the time spent resolving (0 on a hit).
+    bool lookup(const char* host, uint32_t* addr, uint32_t* resolveMs);
+
+    // Number of addresses known for `host` (0 if none)
+    size_t addressCount(const char* host) const;
+
+    // Connection outcome for the address returned by lookup()
+    void reportFailure(const char* host, uint32_t addr);
+    void reportSuccess(const char* host, uint32_t addr);
+
+    // Re-resolve entries close to expiry. Returns true if it resolved.
+    bool refresh();
+
+    // Milliseconds until the next entry wants refreshing (UINT32_MAX if none)
+    uint32_t msUntilRefresh() const;
+
+    const DnsCacheStats& stats() const { return counters; }
+
+private:
+    struct Entry {
+        char host[DNS_CACHE_HOST_LEN];
+        uint32_t addrs[DNS_CACHE_MAX_ADDRS];
+        uint8_t count;
+        uint8_t current;            // address handed out by lookup()
+        uint8_t failed;             // consecutive failed connects
+        uint32_t pinned;            // last address that connected
+        uint32_t expiresMs;
+        uint32_t retryMs;           // no resolver call before this time
+        uint32_t lastUsedMs;
+    };
+
+    Entry* find(const char* host);
+    const Entry* find(const char* host) const;
+    Entry* claim(const char* host);
+    bool resolve(Entry* e, uint32_t* resolveMs);
+    bool resolveUncached(const char* host, uint32_t* addr, uint32_t* resolveMs);
+
+    DnsResolveFn resolveFn;
+    DnsClockFn clockFn;
+    DnsPinFn pinFn;
+    void* ctx;
+    Entry entries[DNS_CACHE_HOSTS];
+    DnsCacheStats counters;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef HEDGE_H
+#define HEDGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "latency.h"
+
+// When to hedge a late response on the backup provider.
+//
+// The delay is the p95 of the primary's recent response waits, clamped,
+// so only the slowest ~5% are hedged and the delay follows the provider's
+// normal latency. Until HEDGE_MIN_SAMPLES waits are known the
+// maximum is used. A token budget caps hedges at a share of all batches,
+// so a provider that is slow across the board does not double the load.
+// No Arduino dependencies.
+
+#define HEDGE_MIN_SAMPLES 8
+
+struct HedgeStats {
+    uint32_t batches;       // batches sent to the primary
+    uint32_t hedged;        // ... of which a late rest also went to the backup
+    uint32_t backupWins;    // hedged batches the backup answered first
+    uint32_t denied;        // hedges skipped because the budget was spent
+    uint32_t failovers;     // primary unreachable: batch sent to the backup only
+    uint32_t crossChecks;   // tx_hash comparisons between providers
+    uint32_t mismatches;    // ... that disagreed twice in a row
+};
+
+class HedgePolicy {
+public:
+    // Hedge delay clamped to [minMs, maxMs]; at most budgetPct hedges per
+    // 100 batches, with up to `burst` saved up.
+    HedgePolicy(uint32_t minMs, uint32_t maxMs, uint32_t budgetPct, uint32_t burst);
+
+    uint32_t delayMs() const;
+
+    // A batch goes to the primary (earns budget)
+    void onBatch();
+    // How long the primary took to start a response; one the backup won
+    // records the time it was given up on (a lower bound)
+    void recordWait(uint32_t ms);
+    // Take one hedge from the budget; false (and counted) when spent
+    bool tryHedge();
+
+    const LatencyTracker& waits() const { return firstByte; }
+    HedgeStats& stats() { return counters; }
+    const HedgeStats& stats() const { return counters; }
+
+private:
+    uint32_t minMs;
+    uint32_t maxMs;
+    uint32_t earn;          // budget per batch, in 1/1000 of a hedge
+    uint32_t cap;
+    uint32_t tokens;
+    LatencyTracker firstByte;
+    HedgeStats counters;
+};
+
+#endif
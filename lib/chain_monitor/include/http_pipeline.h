@@ -0,0 +1,92 @@
+#ifndef HTTP_PIPELINE_H
+#define HTTP_PIPELINE_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "http_stream.h"
+
+// HTTP/1.1 request pipelining over one persistent connection.
+// Up to HTTP_PIPELINE_DEPTH GETs are written back to back, then their
+// responses are read in the same order, so N independent lookups cost
+// one round trip per batch instead of one each.
+#ifndef HTTP_PIPELINE_DEPTH
+#define HTTP_PIPELINE_DEPTH 8
+#endif
+
+// Counters for one poll cycle; reset with resetStats()
+struct PipelineStats {
+    uint16_t requests;      // responses received
+    uint16_t roundTrips;    // write-batch / wait-for-responses cycles
+    uint16_t connects;      // connections opened (TLS handshakes)
+    uint32_t connectMs;     // time spent opening connections
+    uint32_t waitMs;        // summed time from batch sent to first response
+    uint32_t wireBytes;     // response body bytes off the socket
+    uint32_t bodyBytes;     // response body bytes after decoding
+};
+
+// Called once per response, in request order. `body` is positioned at the
+// start of the decoded body; whatever the handler leaves unread is drained.
+typedef void (*HttpResponseHandler)(size_t index, const HttpResponseHead& head,
+                                    HttpBodyStream& body, void* ctx);
+
+// Opens a connection on `client`. Lets the owner pick the address (e.g.
+// from a DNS cache) instead of resolving the host on every connect.
+typedef bool (*HttpConnectFn)(Client& client, void* ctx);
+
+// Called before each response is read, while its bytes may not have
+// arrived yet. Returning false stops receiving there: the connection is
+// closed and run()/receive() return the responses delivered so far.
+typedef bool (*HttpAwaitFn)(size_t index, void* ctx);
+
+class HttpPipeline {
+public:
+    HttpPipeline(Client& client, const char* host, uint16_t port);
+
+    // GET paths[0..count) with the given extra header block and hand each
+    // response to `handler`. Requests cut off by a closed connection are
+    // re-sent on a new one. Returns the number of responses delivered.
+    size_t run(const String* paths, size_t count, const char* headers,
+               HttpResponseHandler handler, void* ctx);
+
+    // run() in two steps: send() writes the first batch and returns how
+    // many GETs went out (0: no connection); receive() then does the rest
+    // of run() with the same arguments. cancel() instead drops the batch
+    // and the connection.
+    size_t send(const String* paths, size_t count, const char* headers);
+    size_t receive(const String* paths, size_t count, const char* headers,
+                   HttpResponseHandler handler, void* ctx);
+    void cancel();
+    // Response bytes are waiting, or the connection closed (receive()
+    // then re-sends)
+    bool responding();
+
+    // Replace the default client.connect(host, port)
+    void setConnector(HttpConnectFn fn, void* ctx);
+    // Watch each response before it is read (e.g. to hedge a slow one)
+    void setAwait(HttpAwaitFn fn, void* ctx);
+
+    const PipelineStats& stats() const { return counters; }
+    void resetStats();
+
+private:
+    bool ensureConnected();
+    bool writeBatch(const String* paths, size_t from, size_t count, const char* headers);
+
+    Client& client;
+    const char* host;
+    uint16_t port;
+    HttpConnectFn connector;
+    void* connectorCtx;
+    HttpAwaitFn await;
+    void* awaitCtx;
+    PipelineStats counters;
+    HttpBodyStream body;
+
+    // Batch on the wire: requests [done, sent) of [done, batchEnd)
+    bool pending;
+    size_t sent;
+    size_t batchEnd;
+    unsigned long batchStart;
+};
+
+#endif
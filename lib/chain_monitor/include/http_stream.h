@@ -0,0 +1,79 @@
+#ifndef HTTP_STREAM_H
+#define HTTP_STREAM_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include "inflate.h"
+
+// Minimal HTTP/1.1 GET over an already-connected Client.
+// Used instead of HTTPClient because HTTPClient pins Accept-Encoding to
+// identity on HTTP/1.1 and only offers compression with HTTP/1.0, which
+// would cost a TLS handshake per request.
+
+struct HttpResponseHead {
+    int status;                 // HTTP status, or < 0 on transport error
+    int32_t contentLength;      // -1 when not given
+    bool chunked;               // Transfer-Encoding: chunked
+    bool compressed;            // Content-Encoding: gzip or deflate
+    bool keepAlive;             // connection may carry another request
+};
+
+// Write a GET request. `extraHeaders` is a block of "Name: value\r\n"
+// lines (may be NULL). Returns false if the write was short.
+bool httpSendGet(Client& client, const char* host, const String& path, const char* extraHeaders);
+
+// Read the status line and headers of the next response on `client`
+HttpResponseHead httpReadHead(Client& client);
+
+// Response body reader handed straight to deserializeJson().
+// Undoes Transfer-Encoding: chunked and Content-Encoding: gzip/deflate
+// while the parser pulls bytes, so a body is never buffered whole.
+class HttpBodyStream : public Stream {
+public:
+    HttpBodyStream();
+
+    // contentLength < 0 means unknown (chunked or close-delimited).
+    // Returns false if the inflate window cannot be allocated.
+    bool begin(Stream& src, int32_t contentLength, bool chunked, bool inflate);
+    // Releases the inflate window
+    void end();
+    // Consume the rest of the body so a keep-alive connection can be
+    // reused. Returns false when the body length is unknown.
+    bool drain();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t) override { return 0; }
+
+    uint32_t wireBytes() const { return wire; }     // raw bytes off the socket
+    uint32_t bodyBytes() const { return body; }     // bytes after decoding
+    const char* error() const { return inflating ? inflater.error() : nullptr; }
+
+private:
+    int rawByte(size_t limit);
+    int bodyByte();
+    bool readChunkHeader();
+    int decodedByte();
+    static int pull(void* ctx);
+
+    Stream* src;
+    int32_t remaining;          // bytes left in body or current chunk, -1 unknown
+    bool chunked;
+    bool firstChunk;
+    bool inflating;
+    bool finished;              // decoded stream ended
+    bool rawDone;               // body bytes on the socket ended
+    int peeked;
+
+    uint8_t buf[256];
+    size_t bufPos;
+    size_t bufLen;
+
+    uint32_t wire;
+    uint32_t body;
+
+    Inflater inflater;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Streaming DEFLATE decoder (RFC 1950/1951/1952) for HTTP response bodies
+// Based on Mark Adler's puff.c, reworked to resume between output bytes
+// so a JSON parser can pull decompressed bytes one at a time.
+//
+// Compressed input is pulled through a callback; nothing is buffered
+// beyond the sliding window. Back-references can never reach further
+// than the bytes produced so far, so a window larger than the decompressed
+// body is always enough, whatever window the server compressed with.
+
+// log2 of the sliding window. Servers may emit distances up to 32 KB, and
+// a 100-entry transactions page or a large UTxO set already reaches past
+// 8 KB, so only lower this for bodies known to be smaller than the window.
+#ifndef INFLATE_WINDOW_BITS
+#define INFLATE_WINDOW_BITS 15
+#endif
+
+// Returns the next compressed byte, or -1 on end of input / timeout
+typedef int (*InflateSource)(void* ctx);
+
+class Inflater {
+public:
+    enum Format { RAW, ZLIB, GZIP, AUTO };   // AUTO: gzip or zlib by magic
+
+    Inflater();
+    ~Inflater();
+
+    // Allocates the window. Returns false when out of memory.
+    bool begin(Format format, InflateSource source, void* ctx);
+    void end();
+
+    // Next decompressed byte, or -1 at end of stream or on error
+    int read();
+
+    bool done() const { return state == DONE; }
+    const char* error() const { return err; }
+    uint32_t totalOut() const { return total; }
+
+private:
+    struct Huffman {
+        uint16_t count[16];     // number of symbols of each length
+        uint16_t symbol[288];   // canonically ordered symbols
+    };
+
+    enum State { HEADER, BLOCK, STORED, CODES, TRAILER, DONE, FAILED };
+
+    int needByte();
+    int bits(int need);
+    int decode(const Huffman* h);
+    int construct(Huffman* h, const uint8_t* length, int n);
+    bool readHeader();
+    bool readTrailer();
+    bool startBlock();
+    bool buildDynamic();
+    int emit(uint8_t b);
+    bool fail(const char* msg);
+
+    InflateSource source;
+    void* sourceCtx;
+    Format format;
+    State state;
+    const char* err;
+
+    uint32_t bitbuf;
+    int bitcnt;
+    bool lastBlock;
+    uint32_t storedLeft;
+
+    Huffman lencode;
+    Huffman distcode;
+
+    uint32_t copyLen;
+    uint32_t copyDist;
+
+    uint8_t* window;
+    uint32_t winPos;
+    uint32_t total;
+    uint32_t check;             // running CRC-32 (gzip) or Adler-32 (zlib)
+
+    uint8_t pushback[2];        // header bytes returned to a raw stream
+    uint8_t pushbackLen;
+};
+
+#endif
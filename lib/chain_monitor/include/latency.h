@@ -0,0 +1,56 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#ifdef ARDUINO
+#include <Print.h>
+#endif
+
+// Latency distribution for chain events (block time -> detection -> GPIO).
+// Percentiles cover the last LATENCY_WINDOW events; bucket counts, sum and
+// SLO breaches are totals since boot. No Arduino dependencies apart from
+// writeMetrics().
+
+#define LATENCY_WINDOW 64
+#define LATENCY_BUCKETS 10
+
+struct LatencySummary {
+    uint32_t count;         // events in the window
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+    uint32_t max;
+};
+
+class LatencyTracker {
+public:
+    explicit LatencyTracker(uint32_t sloMs);
+
+    void record(uint32_t ms);
+
+    LatencySummary summary() const;
+    uint32_t total() const { return events; }
+    uint32_t breaches() const { return sloBreaches; }
+    uint32_t slo() const { return sloMs; }
+
+    // Upper bounds (ms) of the histogram buckets; the last is +Inf
+    static const uint32_t bucketBounds[LATENCY_BUCKETS];
+    uint32_t bucket(size_t i) const { return buckets[i]; }
+
+#ifdef ARDUINO
+    // Prometheus text format under `name`, e.g. chain_to_actuation_ms
+    void writeMetrics(Print& out, const char* name) const;
+#endif
+
+private:
+    uint32_t sloMs;
+    uint32_t window[LATENCY_WINDOW];
+    size_t next;
+    uint32_t events;
+    uint32_t sloBreaches;
+    uint64_t sumMs;
+    uint32_t buckets[LATENCY_BUCKETS];
+};
+
+#endif
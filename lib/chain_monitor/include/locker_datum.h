@@ -0,0 +1,26 @@
+#ifndef LOCKER_DATUM_H
+#define LOCKER_DATUM_H
+
+// Generated by tools/gen_datum.py from plutus.json (htlabs/iot2 0.0.0). Do not edit.
+
+#include "plutus_data.h"
+
+// contract/Address
+struct LockerAddress {
+    uint8_t payment[28];            // VerificationKeyHash
+    uint8_t stake[28];              // VerificationKeyHash
+};
+
+// contract/Datum
+struct LockerDatum {
+    LockerAddress authority;
+    int64_t isLocked;
+};
+
+// Encoded size of LockerDatum when every field has its expected length
+#define LOCKER_DATUM_FIXED_LEN 69
+
+// Datum of contract.locker.spend. Sets `error` when PLUTUS_FAILED is returned.
+PlutusPath decodeLockerDatum(const uint8_t* data, size_t len, LockerDatum* out, const char** error);
+
+#endif
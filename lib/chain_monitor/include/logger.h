@@ -0,0 +1,67 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include "telemetry.h"
+#include "blockfrost.h"
+#include "datum_parser.h"
+#include "scheduler.h"
+
+// Firmware log through the telemetry ring (telemetry.h). The loop only
+// encodes records; a background task writes them to Serial, as the usual
+// text lines or as COBS frames (TELEMETRY_BINARY, decode with
+// tools/tlm_cli). Records below TELEMETRY_LEVEL are compiled out; include
+// config.h first.
+
+#ifndef TELEMETRY_LEVEL
+#define TELEMETRY_LEVEL TLM_INFO
+#endif
+
+// After Serial.begin(); starts the drain task
+void initLogger();
+
+// Without a drain task (TELEMETRY_TASK 0): write what is queued. Call
+// once per loop.
+void serviceLogger();
+// Wait up to `maxMs` for the queue to reach the UART, e.g. before sleeping
+void flushLogger(uint32_t maxMs);
+
+void setLogBinary(bool enabled);
+bool logBinary();
+
+void logRecord(uint8_t type, uint8_t level, const uint8_t* payload, size_t len);
+void logText(uint8_t level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Per-poll records, at INFO
+void logFetch(const FetchStats& stats);
+void logState(const DatumResult& datum, uint8_t network);
+void logEnergy(const EnergyReport& e);
+
+// Records queued, dropped and the ring's high-water mark, Prometheus text
+void writeLoggerMetrics(Print& out);
+
+#if TELEMETRY_LEVEL <= TLM_DEBUG
+#define LOG_DEBUG(...) logText(TLM_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if TELEMETRY_LEVEL <= TLM_INFO
+#define LOG_INFO(...) logText(TLM_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if TELEMETRY_LEVEL <= TLM_WARN
+#define LOG_WARN(...) logText(TLM_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if TELEMETRY_LEVEL <= TLM_ERROR
+#define LOG_ERROR(...) logText(TLM_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif
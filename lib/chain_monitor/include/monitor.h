@@ -0,0 +1,171 @@
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include <Arduino.h>
+#include "blockfrost.h"
+#include "datum_parser.h"
+#include "latency.h"
+#include "logger.h"
+#include "power.h"
+#include "timesync.h"
+
+// The poll loop the asset monitor and the pump controller share: fetch the
+// asset's UTxO, time new chain events, decode the datum and hand the result
+// to the actuator, plus the DNS refresh between polls. The parts that
+// differ are compile-time policies, so every call below resolves statically
+// (and mostly inlines): no vtables, no function pointers.
+//
+//   Transport  Result                    AssetStateResult, or derived from it
+//                                        to carry more of the same poll
+//              Result fetch()            one poll of the asset
+//              uint32_t dnsRefreshInMs() as blockfrostDnsRefreshInMs()
+//              void refreshDns()
+//   Decoder    DatumResult decode(const String& inlineDatum)
+//   Actuator   void onState(const Result&, const DatumResult&)
+//              void onError(const Result&)   the fetch failed (logged)
+//   Scheduler  add(), due(), arm(), rearm(), disarm() as DeadlineScheduler
+//
+// BlockfrostTransport, LockerDecoder and LogActuator make the plain
+// monitor. Include config.h first.
+
+// Time since a block, or false while the wall clock is not synced
+inline bool sinceBlock(uint32_t blockTime, uint32_t* ms) {
+    if (!timeSynced() || blockTime == 0) return false;
+    int64_t elapsed = (int64_t)wallClockMs() - (int64_t)blockTime * 1000;
+    *ms = elapsed > 0 ? elapsed : 0;    // block_time has 1 s resolution
+    return true;
+}
+
+// The asset's latest UTxO from the configured providers
+struct BlockfrostTransport {
+    typedef AssetStateResult Result;
+
+    const char* unit;
+
+    Result fetch() { return fetchAssetState(unit); }
+    uint32_t dnsRefreshInMs() { return blockfrostDnsRefreshInMs(); }
+    void refreshDns() { refreshBlockfrostDns(); }
+};
+
+// The locker datum (datum_parser.h); network 0 = testnet, 1 = mainnet
+struct LockerDecoder {
+    uint8_t network;
+
+    DatumResult decode(const String& inlineDatum) { return parseDatum(inlineDatum, network); }
+};
+
+// Log every state, act on none
+struct LogActuator {
+    uint8_t network;
+
+    template <class Result>
+    void onState(const Result&, const DatumResult& datum) {
+        if (datum.success) {
+            logState(datum, network);
+        } else {
+            LOG_WARN("Datum error: %s", datum.error.c_str());
+        }
+    }
+    template <class Result>
+    void onError(const Result&) {}
+};
+
+template <class Transport, class Decoder, class Actuator, class Scheduler>
+class Monitor {
+public:
+    Monitor(Transport& transport, Decoder& decoder, Actuator& actuator, Scheduler& scheduler,
+            uint32_t sloMs)
+        : transport(transport), decoder(decoder), actuator(actuator), scheduler(scheduler),
+          detect(sloMs), pollDeadline(-1), dnsDeadline(-1) {}
+
+    // Add the poll and DNS deadlines to the scheduler
+    void begin(uint32_t pollIntervalMs) {
+        pollDeadline = scheduler.add("poll", pollIntervalMs);
+        dnsDeadline = scheduler.add("dns", 0);
+    }
+
+    // First poll, once the transport is up; starts the poll period
+    void start() {
+        poll();
+        scheduler.rearm(pollDeadline);
+        scheduleDnsRefresh();
+    }
+
+    // Call once per loop: polls when due, with its energy estimate, or
+    // refreshes DNS in between. True if it polled.
+    bool service() {
+        if (scheduler.due(pollDeadline)) {
+            powerBeginPoll();
+            poll();
+            powerEndPoll();
+            scheduler.rearm(pollDeadline);
+            logEnergy(powerTakeReport());
+            scheduleDnsRefresh();
+            return true;
+        }
+        if (scheduler.due(dnsDeadline)) {
+            transport.refreshDns();
+            scheduleDnsRefresh();
+        }
+        return false;
+    }
+
+    // One poll: fetch -> time a new tx -> decode -> actuator
+    void poll() {
+        typename Transport::Result state = transport.fetch();
+        if (!state.success) {
+            LOG_WARN("Asset state error: %s", state.error.c_str());
+            actuator.onError(state);
+            return;
+        }
+
+        logFetch(state.stats);
+        trackChainEvent(state);
+        DatumResult datum = decoder.decode(state.inlineDatum);
+        actuator.onState(state, datum);
+    }
+
+    // block_time of a new tx -> its detection here
+    const LatencyTracker& detectLatency() const { return detect; }
+
+private:
+    // A tx hash we have not seen on the previous poll is a new chain event
+    void trackChainEvent(const AssetStateResult& state) {
+        bool isNew = lastTxHash.length() > 0 && state.txHash != lastTxHash;
+        lastTxHash = state.txHash;
+        if (!isNew) return;
+
+        uint32_t ms;
+        if (!sinceBlock(state.blockTime, &ms)) {
+            LOG_WARN("[latency] clock not synced, event not timed");
+            return;
+        }
+        detect.record(ms);
+
+        LatencySummary s = detect.summary();
+        LOG_INFO("[latency] slot=%u block->detect=%ums%s p50=%u p95=%u p99=%u breaches=%u",
+            state.slot, ms, ms > detect.slo() ? " SLO BREACH" : "",
+            s.p50, s.p95, s.p99, detect.breaches());
+    }
+
+    // Re-arm the DNS refresh deadline from the cache's own schedule
+    void scheduleDnsRefresh() {
+        uint32_t ms = transport.dnsRefreshInMs();
+        if (ms == UINT32_MAX) {
+            scheduler.disarm(dnsDeadline);
+        } else {
+            scheduler.arm(dnsDeadline, ms);
+        }
+    }
+
+    Transport& transport;
+    Decoder& decoder;
+    Actuator& actuator;
+    Scheduler& scheduler;
+    LatencyTracker detect;
+    String lastTxHash;
+    int pollDeadline;
+    int dnsDeadline;
+};
+
+#endif
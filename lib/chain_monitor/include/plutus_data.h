@@ -0,0 +1,121 @@
+#ifndef PLUTUS_DATA_H
+#define PLUTUS_DATA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Reader for Plutus data CBOR, used by the decoders tools/gen_datum.py
+// generates from a CIP-57 blueprint (plutus.json).
+// No Arduino dependency, so generated decoders also build on the host.
+//
+// Covers what validators emit: constructors (tags 121-127, 1280-1400 and
+// 102), definite and indefinite lists, byte strings (chunked ones too)
+// and integers that fit in 64 bits.
+
+#define PLUTUS_MAX_DEPTH 8
+
+// How a generated decoder got its result
+enum PlutusPath {
+    PLUTUS_FAILED,
+    PLUTUS_FIXED,       // matched the expected bytes, fields copied at fixed offsets
+    PLUTUS_WALK         // general walk (lengths or encoding differed)
+};
+
+class PlutusReader {
+public:
+    PlutusReader(const uint8_t* data, size_t len);
+
+    // The common one-byte headers are handled inline, so generated code
+    // specialises on its constant lengths; everything else goes through
+    // the general *Slow() paths.
+
+    // Constructor header; leaves the reader on its field list
+    bool constr(uint32_t* index) {
+        if (!failed && end - pos >= 2 && pos[0] == 0xd8 && pos[1] >= 121 && pos[1] <= 127) {
+            *index = pos[1] - 121;
+            pos += 2;
+            return true;
+        }
+        return constrSlow(index);
+    }
+
+    // Lists: beginList(), then items while more(), then endList()
+    bool beginList() {
+        if (!failed && pos < end && depth < PLUTUS_MAX_DEPTH && (*pos == 0x9f || (*pos >= 0x80 && *pos <= 0x97))) {
+            item();
+            remaining[depth++] = *pos == 0x9f ? -1 : *pos - 0x80;
+            pos++;
+            return true;
+        }
+        return beginListSlow();
+    }
+    bool more();
+    bool endList();
+
+    // Byte string of exactly `len` bytes
+    bool bytes(uint8_t* out, size_t len) {
+        size_t headLen = len < 24 ? 1 : 2;
+        if (!failed && len <= 0xff && (size_t)(end - pos) >= headLen + len &&
+            pos[0] == (len < 24 ? 0x40 + len : 0x58) && (len < 24 || pos[1] == len)) {
+            memcpy(out, pos + headLen, len);
+            pos += headLen + len;
+            item();
+            return true;
+        }
+        return bytesSlow(out, len);
+    }
+    // Byte string of up to `max` bytes; `len` receives its length
+    bool bytesUpTo(uint8_t* out, size_t max, size_t* len);
+
+    bool integer(int64_t* value) {
+        if (!failed && pos < end && *pos <= 0x37 && (*pos <= 0x17 || *pos >= 0x20)) {
+            *value = *pos <= 0x17 ? *pos : -1 - (int64_t)(*pos - 0x20);
+            pos++;
+            item();
+            return true;
+        }
+        return integerSlow(value);
+    }
+
+    // Skip one item of any type
+    bool skip();
+
+    // Everything consumed
+    bool done() const { return !failed && pos == end; }
+
+    // Record an error (the first one wins). Always returns false.
+    bool fail(const char* message);
+    const char* error() const { return message; }
+
+private:
+    bool head(uint8_t* major, uint64_t* arg, bool* indefinite);
+    // Count one item against the enclosing list
+    void item() {
+        if (depth > 0 && remaining[depth - 1] > 0) remaining[depth - 1]--;
+    }
+    bool skipItem(int depth);
+    bool constrSlow(uint32_t* index);
+    bool beginListSlow();
+    bool bytesSlow(uint8_t* out, size_t len);
+    bool integerSlow(int64_t* value);
+
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool failed;
+    const char* message;
+
+    // Open lists: items left (-1 for indefinite)
+    int64_t remaining[PLUTUS_MAX_DEPTH];
+    uint8_t depth;
+};
+
+// Small integer stored in the initial byte (0..23 or -1..-24).
+// Fixed-layout decoders use it; anything longer takes the general walk.
+static inline bool plutusTinyInt(uint8_t b, int64_t* value) {
+    if (b <= 0x17) { *value = b; return true; }
+    if (b >= 0x20 && b <= 0x37) { *value = -1 - (int64_t)(b - 0x20); return true; }
+    return false;
+}
+
+#endif
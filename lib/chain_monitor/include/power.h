@@ -0,0 +1,31 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include "scheduler.h"
+
+// Low-power idling between loop deadlines.
+// With low-power mode on, waits of LOW_POWER_MIN_SLEEP_MS or more are spent
+// in automatic light sleep (CPU halted, modem waking for DTIM beacons)
+// instead of delay(10) steps.
+
+void initPower();
+
+void setLowPower(bool enabled);
+bool lowPower();
+
+// Account the time until powerEndPoll() as radio-active
+void powerBeginPoll();
+void powerEndPoll();
+
+// Wait up to `ms` for the next deadline. Serial commands that arrive
+// during a light sleep are handled after it.
+void powerIdle(uint32_t ms);
+
+// Energy estimate for the cycle since the previous call
+EnergyReport powerTakeReport();
+
+// Milliseconds since boot, for DeadlineScheduler and EnergyMeter
+uint32_t powerClock(void* ctx);
+
+#endif
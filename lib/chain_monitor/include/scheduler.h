@@ -0,0 +1,97 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Deadline bookkeeping for the main loop and a per-cycle energy estimate.
+// No Arduino dependencies: the clock is injected so both run on the host
+// against a simulated clock (see tools/sched_sim.cpp).
+
+#define SCHED_MAX_DEADLINES 8
+
+// Milliseconds since boot
+typedef uint32_t (*SchedClockFn)(void* ctx);
+
+class DeadlineScheduler {
+public:
+    DeadlineScheduler(SchedClockFn clock, void* ctx);
+
+    // Register a deadline. A non-zero period arms it `periodMs` from now;
+    // period 0 leaves it disarmed until arm(). Returns -1 when full.
+    int add(const char* name, uint32_t periodMs);
+
+    void arm(int id, uint32_t inMs);
+    void rearm(int id) { arm(id, deadlines[id].periodMs); }
+    void disarm(int id);
+
+    // True when an armed deadline has passed. It stays due until re-armed
+    // or disarmed, so the caller decides when the next period starts.
+    bool due(int id) const;
+
+    // Time until the earliest armed deadline (0 if one is overdue,
+    // UINT32_MAX if none). `id` receives which one.
+    uint32_t msUntilNext(int* id = nullptr) const;
+
+    const char* name(int id) const { return deadlines[id].name; }
+    uint32_t now() const { return clockFn(ctx); }
+
+private:
+    struct Deadline {
+        const char* name;
+        uint32_t periodMs;
+        uint32_t atMs;
+        bool armed;
+    };
+
+    SchedClockFn clockFn;
+    void* ctx;
+    Deadline deadlines[SCHED_MAX_DEADLINES];
+    size_t count;
+};
+
+// Where the time of one cycle went
+enum PowerState {
+    POWER_ACTIVE,       // CPU on, radio exchanging data (a poll)
+    POWER_IDLE,         // CPU on, radio associated (modem sleep between beacons)
+    POWER_SLEEP,        // light sleep
+    POWER_STATES
+};
+
+struct EnergyReport {
+    uint32_t ms[POWER_STATES];  // time spent in each state
+    uint32_t wakes;             // light-sleep wake-ups
+    uint32_t wakeMs;            // summed wake-to-ready time (included in IDLE)
+    uint32_t chargeUas;         // estimated charge, microamp-seconds
+    uint32_t energyMj;          // estimated energy at the supply voltage
+    uint32_t avgUa;             // average current over the cycle
+};
+
+// Integrates a current-draw model over the time spent in each state
+class EnergyMeter {
+public:
+    // currentUa[POWER_STATES]: draw per state in microamps
+    EnergyMeter(const uint32_t* currentUa, uint32_t supplyMv, SchedClockFn clock, void* ctx);
+
+    void enter(PowerState state);
+    void addWake(uint32_t readyMs);
+    PowerState state() const { return current; }
+
+    // Totals since the previous take(), then start a new cycle
+    EnergyReport take();
+
+private:
+    void close();
+
+    const uint32_t* currentUa;
+    uint32_t supplyMv;
+    SchedClockFn clockFn;
+    void* ctx;
+    PowerState current;
+    uint32_t since;
+    uint64_t stateMs[POWER_STATES];
+    uint32_t wakes;
+    uint32_t wakeMs;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary telemetry records.
+//
+// A record is a type, a severity, a millisecond timestamp and a fixed
+// little-endian payload, followed by a CRC-8. It is COBS-encoded so that
+// 0x00 never occurs inside it, and written between 0x00 delimiters; plain
+// text printed on the same UART shows up between frames and is passed
+// through by the decoder (tools/tlm_cli.cpp). Producers append whole
+// frames to a lock-free single-producer / single-consumer ring and never
+// wait on the UART. No Arduino dependencies.
+
+// Severities; TELEMETRY_LEVEL (config.h) drops the lower ones at compile time
+#define TLM_DEBUG 0
+#define TLM_INFO 1
+#define TLM_WARN 2
+#define TLM_ERROR 3
+
+enum TlmType {
+    TLM_TEXT = 1,       // free-form line (events, errors)
+    TLM_FETCH = 2,      // per-poll transfer statistics ("[fetch]")
+    TLM_STATE = 3,      // datum authority key hashes + lock flag
+    TLM_ENERGY = 4,     // per-poll energy estimate ("[energy]")
+};
+
+#define TLM_HEADER_LEN 6                // type, level, time (u32)
+#define TLM_MAX_PAYLOAD 128
+#define TLM_MAX_RECORD (TLM_HEADER_LEN + TLM_MAX_PAYLOAD + 1)
+// COBS adds one byte per 254, plus the trailing delimiter
+#define TLM_MAX_FRAME (TLM_MAX_RECORD + TLM_MAX_RECORD / 254 + 2)
+// Longest rendered line, including the NUL
+#define TLM_MAX_LINE 256
+
+struct TlmFetch {
+    bool compressed;
+    uint32_t wireBytes;
+    uint32_t bodyBytes;
+    uint32_t datumMs;
+    uint32_t minFreeHeap;
+    uint16_t requests;
+    uint16_t roundTrips;
+    uint16_t connects;
+    uint32_t connectMs;
+    uint32_t resolveMs;
+    uint32_t waitMs;
+};
+
+struct TlmState {
+    uint8_t network;                    // 0 testnet, 1 mainnet
+    bool isLocked;
+    uint8_t pubKeyHash[28];
+    uint8_t stakeCredHash[28];
+};
+
+struct TlmEnergy {
+    uint32_t activeMs;
+    uint32_t idleMs;
+    uint32_t sleepMs;
+    uint32_t wakes;
+    uint32_t wakeMs;
+    uint32_t chargeUas;
+    uint32_t energyMj;
+    uint32_t avgUa;
+};
+
+// A decoded record; `payload` points into the caller's buffer
+struct TlmRecord {
+    uint8_t type;
+    uint8_t level;
+    uint32_t timeMs;
+    const uint8_t* payload;
+    size_t len;
+};
+
+// Payload layouts; each returns the payload length
+size_t tlmPackFetch(uint8_t* out, const TlmFetch& f);
+size_t tlmPackState(uint8_t* out, const TlmState& s);
+size_t tlmPackEnergy(uint8_t* out, const TlmEnergy& e);
+
+// Header + payload + CRC, COBS-encoded and 0x00-terminated into `frame`
+// (TLM_MAX_FRAME bytes). Returns the frame length; payloads over
+// TLM_MAX_PAYLOAD are truncated.
+size_t tlmEncode(uint8_t* frame, uint8_t type, uint8_t level, uint32_t timeMs,
+                 const uint8_t* payload, size_t len);
+
+// One frame without its delimiter. `scratch` (TLM_MAX_RECORD bytes) holds
+// the decoded bytes `rec` points into. False on bad COBS, length or CRC,
+// e.g. for a run of plain text.
+bool tlmDecode(const uint8_t* frame, size_t len, uint8_t* scratch, TlmRecord* rec);
+
+// The record as the firmware's text log line (no newline). Returns the
+// length written.
+size_t tlmFormat(const TlmRecord& rec, char* out, size_t size);
+
+const char* tlmLevelName(uint8_t level);
+
+struct TelemetryStats {
+    uint32_t records;       // frames queued
+    uint32_t dropped;       // ... not queued, ring full
+    uint32_t bytes;         // frame bytes queued
+    uint32_t highWater;     // most bytes waiting at once
+};
+
+// Frame queue. push() is the producer side (one task), nextFrame() the
+// consumer side (another task); neither takes a lock.
+class TelemetryRing {
+public:
+    // `size` must be a power of two
+    TelemetryRing(uint8_t* storage, uint32_t size);
+
+    // Encode and queue a record; false (and counted) when it does not fit
+    bool push(uint8_t type, uint8_t level, uint32_t timeMs, const uint8_t* payload, size_t len);
+    bool text(uint8_t level, uint32_t timeMs, const char* fmt, va_list args);
+
+    // Copy the oldest frame (with its delimiter) into `out` (TLM_MAX_FRAME
+    // bytes) and release it; 0 when empty
+    size_t nextFrame(uint8_t* out);
+    uint32_t pending() const;
+
+    const TelemetryStats& stats() const { return counters; }
+
+private:
+    uint8_t* buf;
+    uint32_t mask;
+    std::atomic<uint32_t> head;     // written by the producer
+    std::atomic<uint32_t> tail;     // written by the consumer
+    TelemetryStats counters;        // producer-owned
+};
+
+#endif
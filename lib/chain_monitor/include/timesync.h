@@ -0,0 +1,17 @@
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+#include <Arduino.h>
+
+// Wall clock from SNTP, needed to compare device events with block_time.
+// The SNTP client keeps resyncing in the background once started.
+
+void initTimeSync();
+
+// True once the clock has been set from NTP
+bool timeSynced();
+
+// Milliseconds since the Unix epoch (meaningless until timeSynced())
+uint64_t wallClockMs();
+
+#endif
@@ -0,0 +1,334 @@
+// Bech32 encoding for Cardano addresses
+// Ported from sipa/bech32 reference implementation (BIP-173)
+
+#include "bech32.h"
+#include <string.h>
+
+static const char* CHARSET = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+static const int8_t CHARSET_REV[128] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    15, -1, 10, 17, 21, 20, 26, 30,  7,  5, -1, -1, -1, -1, -1, -1,
+    -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+     1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1,
+    -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+     1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1
+};
+
+static const uint32_t GEN[] = {
+    0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3
+};
+
+#define CHECKSUM_LEN 6
+#define DATA_WITH_CHECKSUM_LEN (CARDANO_ADDR_DATA5_LEN + CHECKSUM_LEN)
+
+// One round of the bech32 polymod. Branch-free so the batch loops below
+// vectorize; gives the same result as the reference `if` form.
+static inline uint32_t polymod_step(uint32_t chk, uint8_t value) {
+    uint32_t top = chk >> 25;
+    chk = ((chk & 0x1ffffff) << 5) ^ value;
+    for (int j = 0; j < 5; j++) {
+        chk ^= (0u - ((top >> j) & 1)) & GEN[j];
+    }
+    return chk;
+}
+
+// HRP: "addr" for mainnet, "addr_test" for testnet
+static const char* hrp_for(uint8_t network) {
+    return (network == 1) ? "addr" : "addr_test";
+}
+
+// Polymod state after the expanded HRP. It is the same for every address
+// of a network, so batch callers compute it once.
+static uint32_t hrp_polymod(const char* hrp) {
+    size_t hrplen = strlen(hrp);
+    uint32_t chk = 1;
+    // HRP expansion: high bits (>> 5), separator, low bits (& 31)
+    for (size_t i = 0; i < hrplen; i++) {
+        chk = polymod_step(chk, hrp[i] >> 5);
+    }
+    chk = polymod_step(chk, 0);
+    for (size_t i = 0; i < hrplen; i++) {
+        chk = polymod_step(chk, hrp[i] & 31);
+    }
+    return chk;
+}
+
+// Convert between bit-group sizes for bech32. When not padding, leftover
+// non-zero bits are rejected as required by BIP-173 decoding.
+static bool convert_bits(
+    uint8_t* out, size_t* outlen,
+    const uint8_t* in, size_t inlen,
+    int frombits, int tobits, bool pad
+) {
+    uint32_t acc = 0;
+    int bits = 0;
+    size_t maxv = (1 << tobits) - 1;
+    *outlen = 0;
+
+    for (size_t i = 0; i < inlen; i++) {
+        acc = (acc << frombits) | in[i];
+        bits += frombits;
+        while (bits >= tobits) {
+            bits -= tobits;
+            out[(*outlen)++] = (acc >> bits) & maxv;
+        }
+    }
+
+    if (pad) {
+        if (bits > 0) {
+            out[(*outlen)++] = (acc << (tobits - bits)) & maxv;
+        }
+    } else if (bits >= frombits || ((acc << (tobits - bits)) & maxv)) {
+        return false;
+    }
+    return true;
+}
+
+// Build address payload: type_byte | pubKeyHash | stakeCredHash
+// and convert it to 5-bit groups.
+// Type byte format: (address_type << 4) | network_id
+// Type 0 = base address with both keyhash credentials
+static void payload_to_data5(
+    uint8_t* data5,
+    const uint8_t* pubKeyHash,
+    const uint8_t* stakeCredHash,
+    uint8_t network
+) {
+    uint8_t payload[CARDANO_ADDR_PAYLOAD_LEN];
+    payload[0] = (0x00 << 4) | (network & 0x0F);
+    memcpy(payload + 1, pubKeyHash, CARDANO_KEY_HASH_LEN);
+    memcpy(payload + 1 + CARDANO_KEY_HASH_LEN, stakeCredHash, CARDANO_KEY_HASH_LEN);
+
+    size_t data5len;
+    convert_bits(data5, &data5len, payload, CARDANO_ADDR_PAYLOAD_LEN, 8, 5, true);
+}
+
+// Inverse of payload_to_data5(); also checks the header byte.
+static bool data5_to_payload(
+    const uint8_t* data5,
+    uint8_t* pubKeyHash,
+    uint8_t* stakeCredHash,
+    uint8_t* network
+) {
+    uint8_t payload[CARDANO_ADDR_PAYLOAD_LEN + 1];
+    size_t len;
+    if (!convert_bits(payload, &len, data5, CARDANO_ADDR_DATA5_LEN, 5, 8, false) ||
+        len != CARDANO_ADDR_PAYLOAD_LEN || (payload[0] >> 4) != 0x00) {
+        return false;
+    }
+    memcpy(pubKeyHash, payload + 1, CARDANO_KEY_HASH_LEN);
+    memcpy(stakeCredHash, payload + 1 + CARDANO_KEY_HASH_LEN, CARDANO_KEY_HASH_LEN);
+    if (network) *network = payload[0] & 0x0F;
+    return true;
+}
+
+// Write hrp + "1" + data + checksum, NUL-terminated. Returns length.
+static size_t write_address(
+    char* out, const char* hrp, const uint8_t* data5, uint32_t polymod
+) {
+    size_t pos = strlen(hrp);
+    memcpy(out, hrp, pos);
+    out[pos++] = '1';
+    for (size_t i = 0; i < CARDANO_ADDR_DATA5_LEN; i++) {
+        out[pos++] = CHARSET[data5[i]];
+    }
+    for (int i = 0; i < CHECKSUM_LEN; i++) {
+        out[pos++] = CHARSET[(polymod >> (5 * (5 - i))) & 31];
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+// Split an address into its HRP and 5-bit values (data + checksum).
+// Only lowercase addresses of the expected length are accepted.
+static bool split_address(
+    const char* address, const char* hrp, uint8_t* values
+) {
+    size_t hrplen = strlen(hrp);
+    if (strncmp(address, hrp, hrplen) != 0 || address[hrplen] != '1') {
+        return false;
+    }
+    const char* data = address + hrplen + 1;
+    for (size_t i = 0; i < DATA_WITH_CHECKSUM_LEN; i++) {
+        unsigned char c = data[i];
+        if (c == '\0' || c >= 128 || (c >= 'A' && c <= 'Z') || CHARSET_REV[c] < 0) {
+            return false;
+        }
+        values[i] = CHARSET_REV[c];
+    }
+    return data[DATA_WITH_CHECKSUM_LEN] == '\0';
+}
+
+size_t encodeCardanoAddressTo(
+    char* out, size_t outSize,
+    const uint8_t* pubKeyHash,
+    const uint8_t* stakeCredHash,
+    uint8_t network
+) {
+    const char* hrp = hrp_for(network);
+    if (outSize < strlen(hrp) + 1 + DATA_WITH_CHECKSUM_LEN + 1) {
+        return 0;
+    }
+
+    uint8_t data5[CARDANO_ADDR_DATA5_LEN];
+    payload_to_data5(data5, pubKeyHash, stakeCredHash, network);
+
+    // Checksum over hrp_expand + data + 6 zeros (XOR with 1 for bech32)
+    uint32_t chk = hrp_polymod(hrp);
+    for (size_t i = 0; i < CARDANO_ADDR_DATA5_LEN; i++) {
+        chk = polymod_step(chk, data5[i]);
+    }
+    for (int i = 0; i < CHECKSUM_LEN; i++) {
+        chk = polymod_step(chk, 0);
+    }
+
+    return write_address(out, hrp, data5, chk ^ 1);
+}
+
+bool decodeCardanoAddress(
+    const char* address,
+    uint8_t* pubKeyHash,
+    uint8_t* stakeCredHash,
+    uint8_t* network
+) {
+    // Try the longer HRP first: "addr_test1..." also starts with "addr".
+    for (uint8_t net = 0; net <= 1; net++) {
+        const char* hrp = hrp_for(net);
+        uint8_t values[DATA_WITH_CHECKSUM_LEN];
+        if (!split_address(address, hrp, values)) continue;
+
+        uint32_t chk = hrp_polymod(hrp);
+        for (size_t i = 0; i < DATA_WITH_CHECKSUM_LEN; i++) {
+            chk = polymod_step(chk, values[i]);
+        }
+        uint8_t headerNet;
+        if (chk != 1 || !data5_to_payload(values, pubKeyHash, stakeCredHash, &headerNet) ||
+            (headerNet == 1) != (net == 1)) {
+            return false;
+        }
+        if (network) *network = headerNet;
+        return true;
+    }
+    return false;
+}
+
+void encodeCardanoAddressBatch(
+    const CardanoAddressPayload* payloads, size_t count,
+    uint8_t network, char* out
+) {
+    const char* hrp = hrp_for(network);
+    const uint32_t hrpChk = hrp_polymod(hrp);
+
+    // data5 is stored lane-minor so each polymod round touches one
+    // contiguous row of BECH32_BATCH_LANES values.
+    uint8_t lanes[CARDANO_ADDR_DATA5_LEN][BECH32_BATCH_LANES];
+    uint8_t data5[CARDANO_ADDR_DATA5_LEN];
+    uint32_t chk[BECH32_BATCH_LANES];
+
+    for (size_t base = 0; base < count; base += BECH32_BATCH_LANES) {
+        size_t n = count - base;
+        if (n > BECH32_BATCH_LANES) n = BECH32_BATCH_LANES;
+
+        for (size_t l = 0; l < BECH32_BATCH_LANES; l++) {
+            if (l < n) {
+                payload_to_data5(data5, payloads[base + l].pubKeyHash,
+                                 payloads[base + l].stakeCredHash, network);
+            } else {
+                memset(data5, 0, sizeof(data5));
+            }
+            for (size_t i = 0; i < CARDANO_ADDR_DATA5_LEN; i++) {
+                lanes[i][l] = data5[i];
+            }
+            chk[l] = hrpChk;
+        }
+
+        for (size_t i = 0; i < CARDANO_ADDR_DATA5_LEN; i++) {
+            for (size_t l = 0; l < BECH32_BATCH_LANES; l++) {
+                chk[l] = polymod_step(chk[l], lanes[i][l]);
+            }
+        }
+        for (int i = 0; i < CHECKSUM_LEN; i++) {
+            for (size_t l = 0; l < BECH32_BATCH_LANES; l++) {
+                chk[l] = polymod_step(chk[l], 0);
+            }
+        }
+
+        for (size_t l = 0; l < n; l++) {
+            for (size_t i = 0; i < CARDANO_ADDR_DATA5_LEN; i++) {
+                data5[i] = lanes[i][l];
+            }
+            write_address(out + (base + l) * CARDANO_ADDR_BUF_LEN, hrp, data5, chk[l] ^ 1);
+        }
+    }
+}
+
+size_t decodeCardanoAddressBatch(
+    const char* const* addresses, size_t count,
+    uint8_t network, CardanoAddressPayload* payloads, bool* ok
+) {
+    const char* hrp = hrp_for(network);
+    const uint32_t hrpChk = hrp_polymod(hrp);
+
+    uint8_t lanes[DATA_WITH_CHECKSUM_LEN][BECH32_BATCH_LANES];
+    uint8_t values[DATA_WITH_CHECKSUM_LEN];
+    uint32_t chk[BECH32_BATCH_LANES];
+    bool parsed[BECH32_BATCH_LANES];
+    size_t valid = 0;
+
+    for (size_t base = 0; base < count; base += BECH32_BATCH_LANES) {
+        size_t n = count - base;
+        if (n > BECH32_BATCH_LANES) n = BECH32_BATCH_LANES;
+
+        for (size_t l = 0; l < BECH32_BATCH_LANES; l++) {
+            parsed[l] = l < n && split_address(addresses[base + l], hrp, values);
+            if (!parsed[l]) {
+                memset(values, 0, sizeof(values));
+            }
+            for (size_t i = 0; i < DATA_WITH_CHECKSUM_LEN; i++) {
+                lanes[i][l] = values[i];
+            }
+            chk[l] = hrpChk;
+        }
+
+        for (size_t i = 0; i < DATA_WITH_CHECKSUM_LEN; i++) {
+            for (size_t l = 0; l < BECH32_BATCH_LANES; l++) {
+                chk[l] = polymod_step(chk[l], lanes[i][l]);
+            }
+        }
+
+        for (size_t l = 0; l < n; l++) {
+            CardanoAddressPayload* p = &payloads[base + l];
+            bool good = parsed[l] && chk[l] == 1;
+            if (good) {
+                for (size_t i = 0; i < CARDANO_ADDR_DATA5_LEN; i++) {
+                    values[i] = lanes[i][l];
+                }
+                uint8_t headerNet;
+                good = data5_to_payload(values, p->pubKeyHash, p->stakeCredHash, &headerNet) &&
+                       (headerNet == 1) == (network == 1);
+            }
+            if (!good) {
+                memset(p, 0, sizeof(*p));
+            } else {
+                valid++;
+            }
+            ok[base + l] = good;
+        }
+    }
+    return valid;
+}
+
+#ifdef ARDUINO
+String encodeCardanoAddress(
+    const uint8_t* pubKeyHash,
+    const uint8_t* stakeCredHash,
+    uint8_t network
+) {
+    char buf[CARDANO_ADDR_BUF_LEN];
+    encodeCardanoAddressTo(buf, sizeof(buf), pubKeyHash, stakeCredHash, network);
+    return String(buf);
+}
+#endif
@@ -0,0 +1,764 @@
+#include "blockfrost.h"
+#include "config.h"
+#include "http_pipeline.h"
+#include "dns_cache.h"
+#include "logger.h"
+#include <WiFiClientSecure.h>
+#include <Preferences.h>
+#include <lwip/netdb.h>
+
+#define HTTP_TIMEOUT_MS 15000
+#define NO_REQUEST SIZE_MAX
+#define MAX_PROVIDERS 3
+#define HEDGE_POLL_MS 1         // socket check interval while waiting on a response
+
+// One keep-alive connection and pipeline per provider; providers[0] is the
+// primary, providers[1] the backup that slow batches are hedged on
+struct Provider {
+    ChainProvider config;
+    Client* client;
+    HttpPipeline* pipeline;
+    String headers;             // config.headers
+    String compressedHeaders;   // ... plus Accept-Encoding
+};
+
+static Provider providers[MAX_PROVIDERS];
+static size_t providerCount = 0;
+static size_t lastWinner = 0;   // provider that answered the last batch
+static bool compressionEnabled = BLOCKFROST_COMPRESSION;
+
+static HedgePolicy hedge(HEDGE_MIN_MS, HEDGE_MAX_MS, HEDGE_BUDGET_PCT, HEDGE_BUDGET_BURST);
+static uint32_t pollCount = 0;
+static bool crossCheckSuspect = false;  // last cross-check disagreed
+static bool awaitPrimary(size_t index, void* ctx);
+
+// Resolved addresses of the provider hosts; the primary's address that
+// last connected is kept in NVS so a reboot can connect even if DNS is down.
+static size_t resolveHost(const char* host, uint32_t* addrs, size_t maxAddrs, uint32_t* ttlSec, void* ctx);
+static uint32_t dnsClock(void*) { return millis(); }
+static DnsCache dnsCache(resolveHost, dnsClock, nullptr);
+static Preferences dnsPrefs;
+static uint32_t pollResolveMs = 0;
+
+// State shared by the response handlers of one poll
+struct Lookup {
+    AssetStateResult* results;
+    const char* const* units;       // result index -> asset unit (history: one unit)
+    const size_t* slots;            // request index -> result index
+    size_t historyCount;            // > 0: one txs response fills many results
+    size_t assetCount;              // requests of a batch that have a result slot
+    BlockCheck* check;              // nullptr: no block lookups
+    MempoolCheck* mempool;          // nullptr: no mempool lookups
+    size_t tipIndex;                // batch index of each extra lookup, or NO_REQUEST
+    size_t blockIndex;
+    size_t mempoolIndex;
+    JsonDocument filter;
+    JsonDocument extraFilter;       // for the extra lookups of a batch
+    unsigned long start;
+    uint32_t minFreeHeap;
+    bool compressed;
+};
+
+// lwIP's getaddrinfo does not report record TTLs, so every answer is
+// cached for BLOCKFROST_DNS_TTL_S. IP literals never expire.
+static size_t resolveHost(const char* host, uint32_t* addrs, size_t maxAddrs, uint32_t* ttlSec, void*) {
+    IPAddress literal;
+    if (literal.fromString(host)) {
+        addrs[0] = (uint32_t)literal;
+        *ttlSec = DNS_CACHE_MAX_TTL_S;
+        return 1;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &res) != 0 || res == nullptr) return 0;
+
+    size_t n = 0;
+    for (struct addrinfo* ai = res; ai != nullptr && n < maxAddrs; ai = ai->ai_next) {
+        if (ai->ai_family != AF_INET) continue;
+        addrs[n++] = ((struct sockaddr_in*)ai->ai_addr)->sin_addr.s_addr;
+    }
+    freeaddrinfo(res);
+    *ttlSec = BLOCKFROST_DNS_TTL_S;
+    return n;
+}
+
+static void persistAddress(const char* host, uint32_t addr, void*) {
+    if (providerCount > 0 && strcmp(host, providers[0].config.host) == 0) dnsPrefs.putUInt("blockfrost", addr);
+}
+
+// Connect a provider's client through the DNS cache, trying each A record once
+static bool connectApi(Client& client, void* ctx) {
+    const ChainProvider& cfg = static_cast<Provider*>(ctx)->config;
+    size_t attempts = 1;
+    for (size_t i = 0; i < attempts; i++) {
+        uint32_t addr;
+        uint32_t resolveMs;
+        bool found = dnsCache.lookup(cfg.host, &addr, &resolveMs);
+        pollResolveMs += resolveMs;
+        if (!found) return false;
+        if (i == 0) attempts = dnsCache.addressCount(cfg.host);
+
+        IPAddress ip(addr);
+        bool ok;
+        if (cfg.tls) {
+            // The host name is still needed for SNI
+            ok = static_cast<WiFiClientSecure&>(client).connect(ip, cfg.port, cfg.host, nullptr, nullptr, nullptr);
+        } else {
+            ok = client.connect(ip, cfg.port);
+        }
+        if (ok) {
+            dnsCache.reportSuccess(cfg.host, addr);
+            return true;
+        }
+        LOG_WARN("[dns] connect to %s failed", ip.toString().c_str());
+        dnsCache.reportFailure(cfg.host, addr);
+    }
+    return false;
+}
+
+void initBlockfrost() {
+    // Built here rather than as a static table: entries may name variables
+    const ChainProvider configs[] = CHAIN_PROVIDERS;
+    providerCount = 0;
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]) && providerCount < MAX_PROVIDERS; i++) {
+        if (configs[i].port == 0) continue;
+        Provider& p = providers[providerCount++];
+        p.config = configs[i];
+        if (p.config.tls) {
+            WiFiClientSecure* secure = new WiFiClientSecure();
+            secure->setInsecure();
+            secure->setTimeout(HTTP_TIMEOUT_MS / 1000);     // seconds on arduino-esp32
+            p.client = secure;
+        } else {
+            WiFiClient* plain = new WiFiClient();           // e.g. a local stand-in
+            plain->setTimeout(HTTP_TIMEOUT_MS / 1000);
+            p.client = plain;
+        }
+        p.pipeline = new HttpPipeline(*p.client, p.config.host, p.config.port);
+        p.pipeline->setConnector(connectApi, &p);
+        if (providerCount == 1) p.pipeline->setAwait(awaitPrimary, nullptr);
+        p.headers = p.config.headers;
+        p.compressedHeaders = p.headers + "Accept-Encoding: gzip, deflate\r\n";
+    }
+
+    dnsPrefs.begin("dns", false);
+    uint32_t pinned = dnsPrefs.getUInt("blockfrost", 0);
+    if (pinned != 0 && providerCount > 0) dnsCache.seed(providers[0].config.host, pinned);
+    dnsCache.onPin(persistAddress);
+}
+
+void refreshBlockfrostDns() {
+    dnsCache.refresh();
+}
+
+uint32_t blockfrostDnsRefreshInMs() {
+    return dnsCache.msUntilRefresh();
+}
+
+void setBlockfrostCompression(bool enabled) {
+    compressionEnabled = enabled;
+}
+
+bool blockfrostCompression() {
+    return compressionEnabled;
+}
+
+const HedgePolicy& blockfrostHedge() {
+    return hedge;
+}
+
+const char* blockfrostProviderName(size_t index) {
+    return index < providerCount ? providers[index].config.name : nullptr;
+}
+
+void writeBlockfrostMetrics(Print& out) {
+    const HedgeStats& h = hedge.stats();
+    hedge.waits().writeMetrics(out, "api_response_wait_ms");
+    out.printf("api_providers %u\n", (unsigned)providerCount);
+    out.printf("api_hedge_delay_ms %u\n", hedge.delayMs());
+    out.printf("api_batches_total %u\n", h.batches);
+    out.printf("api_hedged_total %u\n", h.hedged);
+    out.printf("api_hedge_backup_wins_total %u\n", h.backupWins);
+    out.printf("api_hedge_denied_total %u\n", h.denied);
+    out.printf("api_failovers_total %u\n", h.failovers);
+    out.printf("api_crosschecks_total %u\n", h.crossChecks);
+    out.printf("api_crosscheck_mismatches_total %u\n", h.mismatches);
+}
+
+static const char* requestHeaders(const Provider& p) {
+    return compressionEnabled ? p.compressedHeaders.c_str() : p.headers.c_str();
+}
+
+// Wait until one of the pipelines has response bytes; -1 after `timeoutMs`
+static int firstResponding(HttpPipeline* a, HttpPipeline* b, unsigned long start, uint32_t timeoutMs) {
+    while (true) {
+        if (a->responding()) return 0;
+        if (b != nullptr && b->responding()) return 1;
+        if (millis() - start >= timeoutMs) return -1;
+        delay(HEDGE_POLL_MS);
+    }
+}
+
+// The batch being read from the primary. A response that is later than
+// the hedge delay has the rest of the batch, [from, count), sent to the
+// backup too; whichever answers first is read and the other closed.
+struct Race {
+    bool active;
+    const String* paths;
+    size_t count;
+    size_t from;            // NO_REQUEST until hedged (at most once a batch)
+    bool backupWon;
+};
+
+static Race race = {false, nullptr, 0, NO_REQUEST, false};
+
+static bool awaitPrimary(size_t index, void*) {
+    if (!race.active) return true;
+    HttpPipeline* primary = providers[0].pipeline;
+    Provider& backup = providers[1];
+    unsigned long start = millis();
+    uint32_t delayMs = hedge.delayMs();
+
+    if (firstResponding(primary, nullptr, start, delayMs) >= 0 || race.from != NO_REQUEST ||
+        !hedge.tryHedge() || backup.pipeline->send(race.paths + index, race.count - index, requestHeaders(backup)) == 0) {
+        firstResponding(primary, nullptr, start, HTTP_TIMEOUT_MS);
+        hedge.recordWait(millis() - start);
+        return true;
+    }
+
+    // Both silent until the timeout: keep reading the primary, which then times out
+    race.from = index;
+    race.backupWon = firstResponding(primary, backup.pipeline, start, HTTP_TIMEOUT_MS) == 1;
+    uint32_t waitMs = millis() - start;
+    hedge.recordWait(waitMs);   // when the backup won, the primary took at least this long
+    LOG_INFO("[hedge] winner=%s wait=%ums delay=%ums request=%u/%u",
+             race.backupWon ? backup.config.name : providers[0].config.name, waitMs, delayMs,
+             (unsigned)index, (unsigned)race.count);
+    if (!race.backupWon) {
+        backup.pipeline->cancel();
+        return true;
+    }
+    hedge.stats().backupWins++;
+    return false;
+}
+
+// Backup responses to a hedged batch, numbered as in the full batch
+struct Offset {
+    HttpResponseHandler handler;
+    void* ctx;
+    size_t from;
+};
+
+static void onOffset(size_t index, const HttpResponseHead& head, HttpBodyStream& body, void* ctx) {
+    Offset& o = *static_cast<Offset*>(ctx);
+    o.handler(o.from + index, head, body, o.ctx);
+}
+
+// Run a batch on the primary, hedging late responses on the backup (see
+// Race). Handlers see each response once, from whichever provider won.
+static size_t hedgedRun(const String* paths, size_t n, HttpResponseHandler handler, void* ctx) {
+    Provider& primary = providers[0];
+    lastWinner = 0;
+    if (providerCount < 2) {
+        return primary.pipeline->run(paths, n, requestHeaders(primary), handler, ctx);
+    }
+
+    Provider& backup = providers[1];
+    hedge.onBatch();
+    if (primary.pipeline->send(paths, n, requestHeaders(primary)) == 0) {
+        hedge.stats().failovers++;
+        lastWinner = 1;
+        LOG_WARN("[hedge] %s unreachable, using %s", primary.config.name, backup.config.name);
+        return backup.pipeline->run(paths, n, requestHeaders(backup), handler, ctx);
+    }
+
+    race = {true, paths, n, NO_REQUEST, false};
+    size_t done = primary.pipeline->receive(paths, n, requestHeaders(primary), handler, ctx);
+    race.active = false;
+    if (!race.backupWon) return done;
+
+    lastWinner = 1;
+    Offset offset = {handler, ctx, race.from};
+    return race.from + backup.pipeline->receive(paths + race.from, n - race.from, requestHeaders(backup),
+                                                onOffset, &offset);
+}
+
+static void sampleHeap(Lookup& lookup) {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < lookup.minFreeHeap) lookup.minFreeHeap = freeHeap;
+}
+
+// Stream a response body through `filter` into `doc`.
+// Sets `error` and returns false on HTTP, inflate or JSON errors.
+static bool readJson(const char* label, const HttpResponseHead& head, HttpBodyStream& body,
+                     Lookup& lookup, JsonDocument& filter, JsonDocument& doc, String& error) {
+    lookup.compressed |= head.compressed;
+    if (head.status != 200) {
+        error = String(label) + " HTTP " + String(head.status);
+        return false;
+    }
+
+    DeserializationError err = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+    sampleHeap(lookup);
+    if (body.error()) {
+        error = "Inflate error: " + String(body.error());
+        return false;
+    }
+    if (err) {
+        error = "JSON parse error: " + String(err.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void setTxsFilter(Lookup& lookup) {
+    lookup.filter.clear();
+    lookup.filter[0]["tx_hash"] = true;
+    lookup.filter[0]["block_height"] = true;
+    lookup.filter[0]["block_time"] = true;
+}
+
+// Step 1 response: latest tx_hash (or the newest historyCount of them)
+static void onAssetTxs(size_t index, const HttpResponseHead& head, HttpBodyStream& body, void* ctx) {
+    Lookup& lookup = *static_cast<Lookup*>(ctx);
+    AssetStateResult& first = lookup.results[lookup.slots[index]];
+
+    JsonDocument doc;
+    if (!readJson("Asset txs", head, body, lookup, lookup.filter, doc, first.error)) return;
+
+    JsonArray txArray = doc.as<JsonArray>();
+    if (txArray.size() == 0) {
+        first.error = "No transactions found";
+        return;
+    }
+
+    size_t n = lookup.historyCount > 0 ? lookup.historyCount : 1;
+    for (size_t i = 0; i < n && i < txArray.size(); i++) {
+        AssetStateResult& result = lookup.results[lookup.slots[index] + i];
+        JsonObject tx = txArray[i];
+        result.txHash = tx["tx_hash"].as<String>();
+        result.blockHeight = tx["block_height"].as<uint32_t>();
+        result.blockTime = tx["block_time"].as<uint32_t>();
+        result.slot = result.blockTime > CHAIN_SLOT_ZERO_TIME ? result.blockTime - CHAIN_SLOT_ZERO_TIME : 0;
+    }
+}
+
+// Step 1 block lookups: the tip, or the block being re-checked
+static void onBlock(bool reread, const HttpResponseHead& head, HttpBodyStream& body, Lookup& lookup) {
+    BlockCheck& check = *lookup.check;
+
+    // No block at that height (any more): the chain rolled back past it
+    if (reread && head.status == 404) {
+        check.found = false;
+        return;
+    }
+
+    JsonDocument doc;
+    if (!readJson(reread ? "Block" : "Tip", head, body, lookup, lookup.extraFilter, doc, check.error)) {
+        check.success = false;
+        return;
+    }
+    if (!reread) {
+        check.tipHeight = doc["height"].as<uint32_t>();
+        check.tipSlot = doc["slot"].as<uint32_t>();
+    } else {
+        check.found = doc["height"].as<uint32_t>() == check.height;
+        check.hash = doc["hash"].as<String>();
+    }
+}
+
+// Step 1 mempool lookup: hashes of the pending txs at the address
+static void onMempoolList(const HttpResponseHead& head, HttpBodyStream& body, Lookup& lookup) {
+    MempoolCheck& mempool = *lookup.mempool;
+    if (head.status == 404) return;     // nothing pending
+
+    JsonDocument doc;
+    if (!readJson("Mempool", head, body, lookup, lookup.filter, doc, mempool.error)) {
+        mempool.success = false;
+        return;
+    }
+    JsonArray txs = doc.as<JsonArray>();
+    mempool.count = txs.size();
+    for (size_t i = 0; i < mempool.count && i < MEMPOOL_MAX_TXS; i++) {
+        mempool.txs[i].txHash = txs[i]["tx_hash"].as<String>();
+    }
+}
+
+static void onStep1(size_t index, const HttpResponseHead& head, HttpBodyStream& body, void* ctx) {
+    Lookup& lookup = *static_cast<Lookup*>(ctx);
+    if (index < lookup.assetCount) {
+        onAssetTxs(index, head, body, ctx);
+    } else if (index == lookup.mempoolIndex) {
+        onMempoolList(head, body, lookup);
+    } else {
+        onBlock(index == lookup.blockIndex, head, body, lookup);
+    }
+}
+
+// Asset unit a result tracks
+static const char* unitOf(const Lookup& lookup, size_t result) {
+    return lookup.units[lookup.historyCount > 0 ? 0 : result];
+}
+
+// True if a UTxO's amount includes `unit`
+static bool holds(JsonObject utxo, const char* unit) {
+    JsonArray amount = utxo["amount"].as<JsonArray>();
+    for (size_t i = 0; i < amount.size(); i++) {
+        const char* assetUnit = amount[i]["unit"].as<const char*>();
+        if (assetUnit && strcmp(assetUnit, unit) == 0) return true;
+    }
+    return false;
+}
+
+// Step 2 mempool lookup: which UTxO a pending tx spends, and its new datum
+static void onMempoolTx(size_t index, const HttpResponseHead& head, HttpBodyStream& body, Lookup& lookup) {
+    MempoolCheck& mempool = *lookup.mempool;
+    MempoolTx& tx = mempool.txs[index];
+    if (head.status == 404) return;     // left the mempool since it was listed
+
+    JsonDocument doc;
+    if (!readJson("Mempool tx", head, body, lookup, lookup.extraFilter, doc, mempool.error)) {
+        mempool.success = false;
+        return;
+    }
+    // Other locker tokens can sit at the same script address: only the
+    // UTxOs that carry the watched asset count
+    const char* unit = unitOf(lookup, 0);
+    JsonArray inputs = doc["inputs"].as<JsonArray>();
+    for (size_t i = 0; i < inputs.size(); i++) {
+        JsonObject input = inputs[i];
+        if (input["collateral"].as<bool>() || input["reference"].as<bool>()) continue;
+        if (mempool.address != input["address"].as<const char*>()) continue;
+        if (!holds(input, unit)) continue;
+        tx.spends = input["tx_hash"].as<String>();
+        tx.spendsIndex = input["output_index"].as<uint16_t>();
+        break;
+    }
+    JsonArray outputs = doc["outputs"].as<JsonArray>();
+    for (size_t i = 0; i < outputs.size(); i++) {
+        JsonObject output = outputs[i];
+        if (mempool.address != output["address"].as<const char*>()) continue;
+        if (!holds(output, unit)) continue;
+        if (!output["inline_datum"].is<const char*>()) continue;
+        tx.inlineDatum = output["inline_datum"].as<String>();
+        break;
+    }
+}
+
+// Step 2 response: inline_datum of the output holding the asset
+static void onTxUtxos(size_t index, const HttpResponseHead& head, HttpBodyStream& body, void* ctx) {
+    Lookup& lookup = *static_cast<Lookup*>(ctx);
+    AssetStateResult& result = lookup.results[lookup.slots[index]];
+
+    JsonDocument doc;
+    if (!readJson("Tx utxos", head, body, lookup, lookup.filter, doc, result.error)) return;
+
+    // The locker UTxO is the output carrying the asset, wherever it sits
+    const char* unit = unitOf(lookup, lookup.slots[index]);
+    JsonArray outputs = doc["outputs"].as<JsonArray>();
+    for (size_t i = 0; i < outputs.size(); i++) {
+        JsonObject output = outputs[i];
+        if (!holds(output, unit)) continue;
+        result.address = output["address"].as<String>();
+        result.outputIndex = output["output_index"].as<uint16_t>();
+        if (output["inline_datum"].is<const char*>()) {
+            result.inlineDatum = output["inline_datum"].as<String>();
+        }
+        break;
+    }
+
+    if (result.address.length() == 0) {
+        result.error = "Asset not in tx outputs";
+        return;
+    }
+    if (result.inlineDatum.length() == 0) {
+        result.error = "No inline_datum in outputs";
+        return;
+    }
+
+    result.stats.datumMs = millis() - lookup.start;
+    result.success = true;
+}
+
+// Run one pipelined batch; requests that never got an answer are
+// reported like a transport error on a single GET. Requests past
+// `nSlots` have no result slot (extra lookups); returns the answered count.
+static size_t runBatch(const String* paths, const size_t* slots, size_t n, size_t nSlots, const char* label,
+                       HttpResponseHandler handler, Lookup& lookup) {
+    lookup.slots = slots;
+    size_t answered = hedgedRun(paths, n, handler, &lookup);
+    for (size_t i = answered; i < nSlots; i++) {
+        lookup.results[slots[i]].error = String(label) + " HTTP -1";
+    }
+    return answered;
+}
+
+// Cross-check response: the other provider's newest tx_hash for an asset
+static void onCrossCheck(size_t index, const HttpResponseHead& head, HttpBodyStream& body, void* ctx) {
+    String* hashes = static_cast<String*>(ctx);
+    if (head.status != 200) return;
+
+    JsonDocument filter;
+    filter[0]["tx_hash"] = true;
+    JsonDocument doc;
+    if (deserializeJson(doc, body, DeserializationOption::Filter(filter)) || body.error()) return;
+    hashes[index] = doc[0]["tx_hash"].as<String>();
+}
+
+static bool crossCheckDue() {
+    if (providerCount < 2 || HEDGE_CROSSCHECK_POLLS == 0) return false;
+    pollCount++;
+    return crossCheckSuspect || pollCount % HEDGE_CROSSCHECK_POLLS == 0;
+}
+
+// Ask the provider that did not answer step 1 for the same assets and
+// compare tx_hash. A single disagreement is usually a block that reached
+// one indexer first, so it is re-checked on the next poll and only counted
+// when it persists.
+static void crossCheck(const String* paths, size_t count, const AssetStateResult* results) {
+    Provider& other = providers[lastWinner == 0 ? 1 : 0];
+    String* hashes = new String[count];
+    size_t answered = other.pipeline->run(paths, count, requestHeaders(other), onCrossCheck, hashes);
+
+    bool agree = true;
+    for (size_t i = 0; i < answered; i++) {
+        if (results[i].txHash.length() == 0 || hashes[i].length() == 0) continue;
+        if (results[i].txHash == hashes[i]) continue;
+        agree = false;
+        if (crossCheckSuspect) {
+            LOG_WARN("[hedge] cross-check mismatch asset=%u %s=%s %s=%s", (unsigned)i,
+                     providers[lastWinner].config.name, results[i].txHash.c_str(),
+                     other.config.name, hashes[i].c_str());
+        }
+    }
+    hedge.stats().crossChecks++;
+    if (!agree && crossCheckSuspect) hedge.stats().mismatches++;
+    crossCheckSuspect = !agree && !crossCheckSuspect;
+    delete[] hashes;
+}
+
+static void onStep2(size_t index, const HttpResponseHead& head, HttpBodyStream& body, void* ctx) {
+    Lookup& lookup = *static_cast<Lookup*>(ctx);
+    if (index < lookup.assetCount) {
+        onTxUtxos(index, head, body, ctx);
+    } else {
+        onMempoolTx(index - lookup.assetCount, head, body, lookup);
+    }
+}
+
+// Step 2 for every result that has a tx_hash, and for each pending tx
+static void fetchUtxos(AssetStateResult* results, size_t count, Lookup& lookup) {
+    MempoolCheck* mempool = lookup.mempool;
+    size_t pending = mempool == nullptr || !mempool->success ? 0
+        : mempool->count < MEMPOOL_MAX_TXS ? mempool->count : MEMPOOL_MAX_TXS;
+    String* paths = new String[count + pending];
+    size_t* slots = new size_t[count];
+    size_t n = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].error.length() > 0 || results[i].txHash.length() == 0) continue;
+        paths[n] = "/api/v0/txs/";
+        paths[n] += results[i].txHash;
+        paths[n] += "/utxos";
+        slots[n++] = i;
+    }
+    for (size_t i = 0; i < pending; i++) {
+        paths[n + i] = "/api/v0/mempool/";
+        paths[n + i] += mempool->txs[i].txHash;
+    }
+
+    lookup.filter.clear();
+    lookup.filter["outputs"][0]["address"] = true;
+    lookup.filter["outputs"][0]["amount"][0]["unit"] = true;
+    lookup.filter["outputs"][0]["output_index"] = true;
+    lookup.filter["outputs"][0]["inline_datum"] = true;
+    if (pending > 0) {
+        lookup.extraFilter.clear();
+        lookup.extraFilter["inputs"][0]["address"] = true;
+        lookup.extraFilter["inputs"][0]["amount"][0]["unit"] = true;
+        lookup.extraFilter["inputs"][0]["tx_hash"] = true;
+        lookup.extraFilter["inputs"][0]["output_index"] = true;
+        lookup.extraFilter["inputs"][0]["collateral"] = true;
+        lookup.extraFilter["inputs"][0]["reference"] = true;
+        lookup.extraFilter["outputs"][0]["address"] = true;
+        lookup.extraFilter["outputs"][0]["amount"][0]["unit"] = true;
+        lookup.extraFilter["outputs"][0]["inline_datum"] = true;
+    }
+    lookup.assetCount = n;
+    size_t answered = runBatch(paths, slots, n + pending, n, "Tx utxos", onStep2, lookup);
+    if (pending > 0 && answered < n + pending) {
+        mempool->success = false;
+        mempool->error = "Mempool tx HTTP -1";
+    }
+
+    delete[] paths;
+    delete[] slots;
+}
+
+// Copy the poll's statistics into each result
+static void endLookup(AssetStateResult* results, size_t count, const Lookup& lookup) {
+    PipelineStats ps = {0, 0, 0, 0, 0, 0, 0};
+    for (size_t p = 0; p < providerCount; p++) {
+        const PipelineStats& s = providers[p].pipeline->stats();
+        ps.wireBytes += s.wireBytes;
+        ps.bodyBytes += s.bodyBytes;
+        ps.requests += s.requests;
+        ps.roundTrips += s.roundTrips;
+        ps.connects += s.connects;
+        ps.connectMs += s.connectMs;
+        ps.waitMs += s.waitMs;
+    }
+    for (size_t i = 0; i < count; i++) {
+        FetchStats& stats = results[i].stats;
+        stats.wireBytes = ps.wireBytes;
+        stats.bodyBytes = ps.bodyBytes;
+        stats.minFreeHeap = lookup.minFreeHeap;
+        stats.compressed = lookup.compressed;
+        stats.requests = ps.requests;
+        stats.roundTrips = ps.roundTrips;
+        stats.connects = ps.connects;
+        stats.connectMs = ps.connectMs;
+        stats.resolveMs = pollResolveMs;
+        stats.waitMs = ps.waitMs;
+    }
+}
+
+static void beginLookup(Lookup& lookup, const char* const* units, AssetStateResult* results, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        results[i] = {false, "", "", 0, 0, 0, 0, "", "", {0, 0, 0, 0, false, 0, 0, 0, 0, 0, 0}};
+    }
+    for (size_t p = 0; p < providerCount; p++) providers[p].pipeline->resetStats();
+    pollResolveMs = 0;
+    lookup.results = results;
+    lookup.units = units;
+    lookup.slots = nullptr;
+    lookup.historyCount = 0;
+    lookup.assetCount = count;
+    lookup.check = nullptr;
+    lookup.mempool = nullptr;
+    lookup.tipIndex = NO_REQUEST;
+    lookup.blockIndex = NO_REQUEST;
+    lookup.mempoolIndex = NO_REQUEST;
+    lookup.start = millis();
+    lookup.minFreeHeap = ESP.getFreeHeap();
+    lookup.compressed = false;
+}
+
+// Fetch asset state following monitor.ts approach:
+// 1. GET /assets/{unit}/transactions -> get latest tx_hash
+//    (plus GET /blocks/latest, /blocks/{height}, /mempool/addresses/{address})
+// 2. GET /txs/{hash}/utxos -> get inline_datum from the output holding the asset
+//    (plus GET /mempool/{hash} for each pending tx)
+static void fetchStates(const char* const* assetUnits, size_t count, AssetStateResult* results,
+                        BlockCheck* check, MempoolCheck* mempool) {
+    Lookup lookup;
+    beginLookup(lookup, assetUnits, results, count);
+
+    // Step 1: Get asset transactions, one pipelined batch for all assets
+    String* paths = new String[count + 3];
+    size_t* slots = new size_t[count];
+    for (size_t i = 0; i < count; i++) {
+        paths[i] = "/api/v0/assets/";
+        paths[i] += assetUnits[i];
+        paths[i] += "/transactions?order=desc&count=1";
+        slots[i] = i;
+    }
+    size_t n = count;
+    if (check != nullptr) {
+        check->success = true;
+        check->error = "";
+        check->tipHeight = 0;
+        check->tipSlot = 0;
+        check->found = false;
+        check->hash = "";
+        lookup.check = check;
+        lookup.extraFilter["height"] = true;
+        lookup.extraFilter["slot"] = true;
+        lookup.extraFilter["hash"] = true;
+        lookup.tipIndex = n;
+        paths[n++] = "/api/v0/blocks/latest";
+        if (check->height > 0) {
+            lookup.blockIndex = n;
+            paths[n] = "/api/v0/blocks/";
+            paths[n++] += String((unsigned)check->height);
+        }
+    }
+    if (mempool != nullptr) {
+        mempool->success = mempool->address.length() > 0;
+        mempool->error = mempool->success ? "" : "No address to watch";
+        mempool->count = 0;
+        for (size_t i = 0; i < MEMPOOL_MAX_TXS; i++) mempool->txs[i] = {"", "", 0, ""};
+        if (mempool->success) {
+            lookup.mempool = mempool;
+            lookup.mempoolIndex = n;
+            paths[n] = "/api/v0/mempool/addresses/";
+            paths[n++] += mempool->address;
+        }
+    }
+
+    // Filters keep only the fields we read, so the document stays small
+    setTxsFilter(lookup);
+    size_t answered = runBatch(paths, slots, n, count, "Asset txs", onStep1, lookup);
+    size_t lastBlock = lookup.blockIndex != NO_REQUEST ? lookup.blockIndex : lookup.tipIndex;
+    if (check != nullptr && answered <= lastBlock) {
+        check->success = false;
+        check->error = "Tip HTTP -1";
+    }
+    if (lookup.mempool != nullptr && answered <= lookup.mempoolIndex) {
+        mempool->success = false;
+        mempool->error = "Mempool HTTP -1";
+    }
+    if (count > 0 && crossCheckDue()) crossCheck(paths, count, results);
+    delete[] paths;
+    delete[] slots;
+
+    // Step 2: Get transaction UTXOs
+    fetchUtxos(results, count, lookup);
+    endLookup(results, count, lookup);
+}
+
+void fetchAssetStates(const char* const* assetUnits, size_t count, AssetStateResult* results) {
+    fetchStates(assetUnits, count, results, nullptr, nullptr);
+}
+
+AssetStateResult fetchAssetState(const char* assetUnit) {
+    AssetStateResult result;
+    fetchStates(&assetUnit, 1, &result, nullptr, nullptr);
+    return result;
+}
+
+AssetStateResult fetchAssetState(const char* assetUnit, BlockCheck* check, MempoolCheck* mempool) {
+    AssetStateResult result;
+    fetchStates(&assetUnit, 1, &result, check, mempool);
+    return result;
+}
+
+size_t fetchAssetHistory(const char* assetUnit, AssetStateResult* results, size_t count) {
+    if (count == 0) return 0;
+    if (count > 100) count = 100;
+
+    Lookup lookup;
+    beginLookup(lookup, &assetUnit, results, count);
+    lookup.historyCount = count;
+
+    String path = "/api/v0/assets/";
+    path += assetUnit;
+    path += "/transactions?order=desc&count=";
+    path += String((unsigned)count);
+    size_t slot = 0;
+
+    setTxsFilter(lookup);
+    runBatch(&path, &slot, 1, 1, "Asset txs", onAssetTxs, lookup);
+
+    size_t filled = 0;
+    if (results[0].error.length() == 0) {
+        while (filled < count && results[filled].txHash.length() > 0) filled++;
+        fetchUtxos(results, filled, lookup);
+    }
+    endLookup(results, count, lookup);
+    return filled;
+}
@@ -0,0 +1,68 @@
+// Plutus datum parser on top of the generated locker datum decoder
+// Parses: Tag121[ Tag121[pubKeyHash, stakeCredHash], lockStatus ]
+
+#include "datum_parser.h"
+#include "bech32.h"
+#include "locker_datum.h"
+
+bool hexToBytes(const String& hex, uint8_t* out, size_t len) {
+    if (hex.length() != len * 2) return false;
+
+    for (size_t i = 0; i < len; i++) {
+        char high = hex.charAt(i * 2);
+        char low = hex.charAt(i * 2 + 1);
+
+        uint8_t h = (high >= 'a') ? (high - 'a' + 10) :
+                    (high >= 'A') ? (high - 'A' + 10) : (high - '0');
+        uint8_t l = (low >= 'a') ? (low - 'a' + 10) :
+                    (low >= 'A') ? (low - 'A' + 10) : (low - '0');
+
+        out[i] = (h << 4) | l;
+    }
+    return true;
+}
+
+DatumResult parseDatum(const String& hexDatum, uint8_t network) {
+    DatumResult result = {};
+    result.success = false;
+    memset(result.pubKeyHash, 0, 28);
+    memset(result.stakeCredHash, 0, 28);
+
+    if (hexDatum.length() == 0) {
+        result.error = "Empty datum";
+        return result;
+    }
+
+    // Convert hex to bytes
+    size_t byteLen = hexDatum.length() / 2;
+    uint8_t* bytes = new uint8_t[byteLen];
+
+    if (!hexToBytes(hexDatum, bytes, byteLen)) {
+        result.error = "Invalid hex";
+        delete[] bytes;
+        return result;
+    }
+
+    // Decoder generated from the locker blueprint (tools/gen_datum.py)
+    LockerDatum datum;
+    const char* error = nullptr;
+    if (decodeLockerDatum(bytes, byteLen, &datum, &error) == PLUTUS_FAILED) {
+        result.error = error;
+        delete[] bytes;
+        return result;
+    }
+    memcpy(result.pubKeyHash, datum.authority.payment, 28);
+    memcpy(result.stakeCredHash, datum.authority.stake, 28);
+    result.isLocked = (datum.isLocked == 1);
+
+    // Encode bech32 address
+    result.authorityAddress = encodeCardanoAddress(
+        result.pubKeyHash,
+        result.stakeCredHash,
+        network
+    );
+
+    result.success = true;
+    delete[] bytes;
+    return result;
+}
@@ -0,0 +1,193 @@
+// Resolver cache with TTLs, A-record failover and background refresh
+
+#include "dns_cache.h"
+#include <string.h>
+
+// millis() wraps after ~49 days; compare through a signed difference
+static bool reached(uint32_t now, uint32_t deadline) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+// A longer name would be cut to fit an entry: it would never match again,
+// each lookup would evict a real entry, and the resolver would get the cut name
+static bool cacheable(const char* host) {
+    return strlen(host) < DNS_CACHE_HOST_LEN;
+}
+
+DnsCache::DnsCache(DnsResolveFn resolve, DnsClockFn clock, void* c)
+    : resolveFn(resolve), clockFn(clock), pinFn(nullptr), ctx(c) {
+    memset(entries, 0, sizeof(entries));
+    memset(&counters, 0, sizeof(counters));
+}
+
+DnsCache::Entry* DnsCache::find(const char* host) {
+    if (!cacheable(host)) return nullptr;
+    for (size_t i = 0; i < DNS_CACHE_HOSTS; i++) {
+        if (entries[i].host[0] && strcmp(entries[i].host, host) == 0) return &entries[i];
+    }
+    return nullptr;
+}
+
+const DnsCache::Entry* DnsCache::find(const char* host) const {
+    return const_cast<DnsCache*>(this)->find(host);
+}
+
+// Existing entry for `host`, else a free slot, else the least recently used.
+// `host` must be cacheable().
+DnsCache::Entry* DnsCache::claim(const char* host) {
+    Entry* e = find(host);
+    if (e) return e;
+
+    uint32_t now = clockFn(ctx);
+    Entry* victim = &entries[0];
+    for (size_t i = 0; i < DNS_CACHE_HOSTS; i++) {
+        if (!entries[i].host[0]) { victim = &entries[i]; break; }
+        if (now - entries[i].lastUsedMs > now - victim->lastUsedMs) victim = &entries[i];
+    }
+    memset(victim, 0, sizeof(Entry));
+    strncpy(victim->host, host, DNS_CACHE_HOST_LEN - 1);
+    victim->expiresMs = now;
+    victim->retryMs = now;
+    victim->lastUsedMs = now;
+    return victim;
+}
+
+bool DnsCache::resolve(Entry* e, uint32_t* resolveMs) {
+    uint32_t addrs[DNS_CACHE_MAX_ADDRS];
+    uint32_t ttl = 0;
+    uint32_t start = clockFn(ctx);
+    size_t n = resolveFn(e->host, addrs, DNS_CACHE_MAX_ADDRS, &ttl, ctx);
+    uint32_t now = clockFn(ctx);
+
+    counters.resolves++;
+    counters.lastResolveMs = now - start;
+    if (resolveMs) *resolveMs += now - start;
+
+    if (n == 0) {
+        // Keep whatever we had and don't hammer the resolver
+        counters.failures++;
+        e->retryMs = now + DNS_CACHE_RETRY_MS;
+        return false;
+    }
+    if (n > DNS_CACHE_MAX_ADDRS) n = DNS_CACHE_MAX_ADDRS;
+    if (ttl < DNS_CACHE_MIN_TTL_S) ttl = DNS_CACHE_MIN_TTL_S;
+    if (ttl > DNS_CACHE_MAX_TTL_S) ttl = DNS_CACHE_MAX_TTL_S;
+
+    memcpy(e->addrs, addrs, n * sizeof(uint32_t));
+    e->count = n;
+    e->failed = 0;
+    e->expiresMs = now + ttl * 1000;
+    e->retryMs = now;
+
+    // Start from the address that last worked if it is still published
+    e->current = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (addrs[i] == e->pinned) { e->current = i; break; }
+    }
+    return true;
+}
+
+// Resolve a host that cannot be cached, first address only
+bool DnsCache::resolveUncached(const char* host, uint32_t* addr, uint32_t* resolveMs) {
+    uint32_t addrs[DNS_CACHE_MAX_ADDRS];
+    uint32_t ttl = 0;
+    uint32_t start = clockFn(ctx);
+    size_t n = resolveFn(host, addrs, DNS_CACHE_MAX_ADDRS, &ttl, ctx);
+    uint32_t now = clockFn(ctx);
+
+    counters.resolves++;
+    counters.uncached++;
+    counters.lastResolveMs = now - start;
+    if (resolveMs) *resolveMs += now - start;
+
+    if (n == 0) {
+        counters.failures++;
+        return false;
+    }
+    *addr = addrs[0];
+    return true;
+}
+
+void DnsCache::seed(const char* host, uint32_t addr) {
+    if (!cacheable(host)) return;
+    Entry* e = claim(host);
+    e->addrs[0] = addr;
+    e->count = 1;
+    e->current = 0;
+    e->pinned = addr;
+}
+
+bool DnsCache::lookup(const char* host, uint32_t* addr, uint32_t* resolveMs) {
+    if (resolveMs) *resolveMs = 0;
+    if (!cacheable(host)) return resolveUncached(host, addr, resolveMs);
+    Entry* e = claim(host);
+    uint32_t now = clockFn(ctx);
+    e->lastUsedMs = now;
+
+    if (e->count > 0 && !reached(now, e->expiresMs)) {
+        counters.hits++;
+    } else if (e->count == 0 || reached(now, e->retryMs)) {
+        if (!resolve(e, resolveMs)) {
+            if (e->count == 0) return false;
+            counters.staleUses++;
+        }
+    } else {
+        counters.staleUses++;
+    }
+
+    *addr = e->addrs[e->current];
+    return true;
+}
+
+size_t DnsCache::addressCount(const char* host) const {
+    const Entry* e = find(host);
+    return e ? e->count : 0;
+}
+
+void DnsCache::reportFailure(const char* host, uint32_t addr) {
+    Entry* e = find(host);
+    if (!e || e->count == 0 || e->addrs[e->current] != addr) return;
+
+    e->current = (e->current + 1) % e->count;
+    // Every address failed once: the records may have moved, re-resolve
+    if (++e->failed >= e->count) {
+        e->failed = 0;
+        e->expiresMs = clockFn(ctx);
+    }
+}
+
+void DnsCache::reportSuccess(const char* host, uint32_t addr) {
+    Entry* e = find(host);
+    if (!e) return;
+    e->failed = 0;
+    if (e->pinned == addr) return;
+    e->pinned = addr;
+    if (pinFn) pinFn(e->host, addr, ctx);
+}
+
+bool DnsCache::refresh() {
+    uint32_t now = clockFn(ctx);
+    for (size_t i = 0; i < DNS_CACHE_HOSTS; i++) {
+        Entry* e = &entries[i];
+        if (!e->host[0] || e->count == 0) continue;
+        if (!reached(now, e->retryMs)) continue;
+        if (!reached(now + DNS_CACHE_REFRESH_MARGIN_MS, e->expiresMs)) continue;
+        resolve(e, nullptr);
+        return true;    // at most one resolver call per idle slot
+    }
+    return false;
+}
+
+uint32_t DnsCache::msUntilRefresh() const {
+    uint32_t now = clockFn(ctx);
+    uint32_t best = UINT32_MAX;
+    for (size_t i = 0; i < DNS_CACHE_HOSTS; i++) {
+        const Entry* e = &entries[i];
+        if (!e->host[0] || e->count == 0) continue;
+        uint32_t due = e->expiresMs - DNS_CACHE_REFRESH_MARGIN_MS;
+        if (!reached(due, e->retryMs)) due = e->retryMs;
+        uint32_t wait = reached(now, due) ? 0 : due - now;
+        if (wait < best) best = wait;
+    }
+    return best;
+}
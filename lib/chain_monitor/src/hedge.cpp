@@ -0,0 +1,40 @@
+// Adaptive hedge delay and hedging budget
+
+#include "hedge.h"
+#include <string.h>
+
+#define TOKEN 1000
+
+HedgePolicy::HedgePolicy(uint32_t min, uint32_t max, uint32_t budgetPct, uint32_t burst)
+    : minMs(min), maxMs(max), earn(budgetPct * TOKEN / 100), cap(burst * TOKEN),
+      tokens(burst * TOKEN), firstByte(max) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+uint32_t HedgePolicy::delayMs() const {
+    LatencySummary s = firstByte.summary();
+    if (s.count < HEDGE_MIN_SAMPLES) return maxMs;
+    if (s.p95 < minMs) return minMs;
+    if (s.p95 > maxMs) return maxMs;
+    return s.p95;
+}
+
+void HedgePolicy::onBatch() {
+    counters.batches++;
+    tokens += earn;
+    if (tokens > cap) tokens = cap;
+}
+
+void HedgePolicy::recordWait(uint32_t ms) {
+    firstByte.record(ms);
+}
+
+bool HedgePolicy::tryHedge() {
+    if (tokens < TOKEN) {
+        counters.denied++;
+        return false;
+    }
+    tokens -= TOKEN;
+    counters.hedged++;
+    return true;
+}
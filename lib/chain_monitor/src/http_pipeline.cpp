@@ -0,0 +1,120 @@
+// HTTP/1.1 pipelined GETs over one keep-alive connection
+
+#include "http_pipeline.h"
+
+// Give up after this many batches in a row that produced no response
+#define MAX_EMPTY_BATCHES 2
+
+HttpPipeline::HttpPipeline(Client& c, const char* h, uint16_t p)
+    : client(c), host(h), port(p), connector(nullptr), connectorCtx(nullptr), await(nullptr), awaitCtx(nullptr),
+      pending(false), sent(0), batchEnd(0), batchStart(0) {
+    resetStats();
+}
+
+void HttpPipeline::resetStats() {
+    counters = {0, 0, 0, 0, 0, 0, 0};
+}
+
+void HttpPipeline::setConnector(HttpConnectFn fn, void* ctx) {
+    connector = fn;
+    connectorCtx = ctx;
+}
+
+void HttpPipeline::setAwait(HttpAwaitFn fn, void* ctx) {
+    await = fn;
+    awaitCtx = ctx;
+}
+
+bool HttpPipeline::ensureConnected() {
+    if (client.connected()) return true;
+    client.stop();
+    unsigned long start = millis();
+    bool ok = connector ? connector(client, connectorCtx) : client.connect(host, port);
+    counters.connectMs += millis() - start;
+    if (!ok) return false;
+    counters.connects++;
+    return true;
+}
+
+// Connect if needed and write requests [from, batchEnd) back to back
+bool HttpPipeline::writeBatch(const String* paths, size_t from, size_t count, const char* headers) {
+    if (!ensureConnected()) return false;
+    batchEnd = from + HTTP_PIPELINE_DEPTH;
+    if (batchEnd > count) batchEnd = count;
+    sent = from;
+    while (sent < batchEnd && httpSendGet(client, host, paths[sent], headers)) {
+        sent++;
+    }
+    counters.roundTrips++;
+    batchStart = millis();
+    return true;
+}
+
+size_t HttpPipeline::send(const String* paths, size_t count, const char* headers) {
+    pending = count > 0 && writeBatch(paths, 0, count, headers);
+    return pending ? sent : 0;
+}
+
+bool HttpPipeline::responding() {
+    return client.available() > 0 || !client.connected();
+}
+
+void HttpPipeline::cancel() {
+    pending = false;
+    client.stop();
+}
+
+size_t HttpPipeline::run(const String* paths, size_t count, const char* headers,
+                         HttpResponseHandler handler, void* ctx) {
+    send(paths, count, headers);
+    if (!pending) return 0;     // no connection
+    return receive(paths, count, headers, handler, ctx);
+}
+
+size_t HttpPipeline::receive(const String* paths, size_t count, const char* headers,
+                             HttpResponseHandler handler, void* ctx) {
+    size_t done = 0;
+    int emptyBatches = 0;
+    bool stopped = false;
+
+    while (done < count && emptyBatches < MAX_EMPTY_BATCHES && !stopped) {
+        // The first batch may already be on the wire from send()
+        if (!pending && !writeBatch(paths, done, count, headers)) break;
+        pending = false;
+
+        // Read the responses in request order
+        size_t received = 0;
+        bool complete = sent == batchEnd;   // a short write leaves part of a request on the wire
+        bool reusable = true;
+        while (done < sent) {
+            if (await != nullptr && !await(done, awaitCtx)) {
+                stopped = true;
+                reusable = false;
+                break;
+            }
+            HttpResponseHead head = httpReadHead(client);
+            if (received == 0) counters.waitMs += millis() - batchStart;
+            if (head.status < 0 ||
+                !body.begin(client, head.contentLength, head.chunked, head.compressed)) {
+                reusable = false;
+                break;
+            }
+            handler(done, head, body, ctx);
+            reusable = head.keepAlive && body.drain();
+            counters.wireBytes += body.wireBytes();
+            counters.bodyBytes += body.bodyBytes();
+            body.end();
+            counters.requests++;
+            received++;
+            done++;
+
+            // The server is closing: anything still in flight is re-sent
+            if (!reusable) break;
+        }
+
+        emptyBatches = received == 0 ? emptyBatches + 1 : 0;
+        if (!reusable || !complete) client.stop();
+    }
+    pending = false;
+    return done;
+}
@@ -0,0 +1,232 @@
+// Minimal HTTP/1.1 GET + response body decoding (chunked, gzip/deflate)
+
+#include "http_stream.h"
+#include <strings.h>
+
+bool httpSendGet(Client& client, const char* host, const String& path, const char* extraHeaders) {
+    String req;
+    req.reserve(128 + path.length());
+    req += "GET ";
+    req += path;
+    req += " HTTP/1.1\r\nHost: ";
+    req += host;
+    req += "\r\nUser-Agent: ESP32HTTPClient\r\nConnection: keep-alive\r\n";
+    if (extraHeaders) req += extraHeaders;
+    req += "\r\n";
+    return client.write((const uint8_t*)req.c_str(), req.length()) == req.length();
+}
+
+// Read one line without its CRLF. Returns the length, or -1 on timeout.
+// A line longer than the buffer is cut, and the rest of it up to the
+// newline is read and dropped.
+static int readLine(Client& client, char* line, size_t size) {
+    size_t n = 0;
+    bool any = false;
+    char c;
+    while (client.readBytes(&c, 1) == 1) {
+        any = true;
+        if (c == '\n') break;
+        if (n < size - 1) line[n++] = c;
+    }
+    if (!any) return -1;
+    if (n > 0 && line[n - 1] == '\r') n--;
+    line[n] = '\0';
+    return n;
+}
+
+// Case-insensitive search for `token` in a comma-separated header value
+static bool hasToken(const char* value, const char* token) {
+    size_t len = strlen(token);
+    for (const char* p = value; *p; p++) {
+        if (strncasecmp(p, token, len) == 0) return true;
+    }
+    return false;
+}
+
+HttpResponseHead httpReadHead(Client& client) {
+    HttpResponseHead head = {-1, -1, false, false, false};
+    char line[160];
+
+    int len = readLine(client, line, sizeof(line));
+    if (len < 12 || strncmp(line, "HTTP/1.", 7) != 0) return head;
+    head.status = atoi(line + 9);
+    head.keepAlive = line[7] == '1';    // HTTP/1.1 is persistent by default
+
+    while ((len = readLine(client, line, sizeof(line))) > 0) {
+        char* value = strchr(line, ':');
+        if (!value) continue;
+        *value++ = '\0';
+        while (*value == ' ') value++;
+
+        if (strcasecmp(line, "Content-Length") == 0) {
+            head.contentLength = atol(value);
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+            head.chunked = hasToken(value, "chunked");
+        } else if (strcasecmp(line, "Content-Encoding") == 0) {
+            head.compressed = hasToken(value, "gzip") || hasToken(value, "deflate");
+        } else if (strcasecmp(line, "Connection") == 0) {
+            if (hasToken(value, "close")) head.keepAlive = false;
+            else if (hasToken(value, "keep-alive")) head.keepAlive = true;
+        }
+    }
+    if (len < 0) {
+        head.status = -1;
+    } else if (!head.chunked && head.contentLength < 0) {
+        head.keepAlive = false;         // body ends when the server closes
+    }
+    return head;
+}
+
+HttpBodyStream::HttpBodyStream() {
+    src = nullptr;
+    end();
+}
+
+bool HttpBodyStream::begin(Stream& source, int32_t contentLength, bool isChunked, bool inflate) {
+    end();
+    src = &source;
+    remaining = isChunked ? 0 : contentLength;
+    chunked = isChunked;
+    firstChunk = true;
+    finished = false;
+    rawDone = false;
+    if (inflate && !inflater.begin(Inflater::AUTO, pull, this)) {
+        return false;
+    }
+    inflating = inflate;
+    return true;
+}
+
+void HttpBodyStream::end() {
+    inflater.end();
+    remaining = -1;
+    chunked = false;
+    firstChunk = true;
+    inflating = false;
+    finished = true;
+    rawDone = true;
+    peeked = -1;
+    bufPos = 0;
+    bufLen = 0;
+    wire = 0;
+    body = 0;
+}
+
+// Next byte off the socket. At most `limit` bytes are read ahead so the
+// buffer never holds bytes that belong to the next response.
+int HttpBodyStream::rawByte(size_t limit) {
+    if (bufPos == bufLen) {
+        size_t want = sizeof(buf);
+        if (limit < want) want = limit;
+        int avail = src->available();
+        if (avail <= 0) {
+            want = 1;   // wait up to the stream timeout for one byte
+        } else if ((size_t)avail < want) {
+            want = avail;
+        }
+        bufLen = src->readBytes(buf, want);
+        bufPos = 0;
+        if (bufLen == 0) return -1;
+        wire += bufLen;
+    }
+    return buf[bufPos++];
+}
+
+// Parse "<hex size>[;ext]\r\n". A zero-size chunk ends the body, after
+// which any trailer lines are skipped.
+bool HttpBodyStream::readChunkHeader() {
+    if (!firstChunk) {
+        if (rawByte(1) != '\r' || rawByte(1) != '\n') return false;
+    }
+    firstChunk = false;
+
+    int32_t size = 0;
+    bool inExtension = false;
+    int c;
+    while ((c = rawByte(1)) >= 0 && c != '\r') {
+        if (c == ';') inExtension = true;
+        if (inExtension) continue;
+        int digit = (c >= '0' && c <= '9') ? c - '0' :
+                    (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                    (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (digit < 0 || size > 0x7ffffff) return false;
+        size = (size << 4) | digit;
+    }
+    if (c < 0 || rawByte(1) != '\n') return false;
+
+    if (size == 0) {
+        int lineLen = 0;
+        while ((c = rawByte(1)) >= 0) {
+            if (c == '\n') {
+                if (lineLen == 0) break;
+                lineLen = 0;
+            } else if (c != '\r') {
+                lineLen++;
+            }
+        }
+        return false;
+    }
+    remaining = size;
+    return true;
+}
+
+// Next byte of the body as sent (still content-encoded)
+int HttpBodyStream::bodyByte() {
+    if (rawDone) return -1;
+    if (remaining == 0 && (!chunked || !readChunkHeader())) {
+        rawDone = true;
+        return -1;
+    }
+    int c = rawByte(remaining < 0 ? sizeof(buf) : (size_t)remaining);
+    if (c < 0) {
+        rawDone = true;
+        return -1;
+    }
+    if (remaining > 0) remaining--;
+    return c;
+}
+
+int HttpBodyStream::pull(void* ctx) {
+    return static_cast<HttpBodyStream*>(ctx)->bodyByte();
+}
+
+int HttpBodyStream::decodedByte() {
+    if (finished) return -1;
+    int c = inflating ? inflater.read() : bodyByte();
+    if (c < 0) {
+        finished = true;
+        return -1;
+    }
+    body++;
+    return c;
+}
+
+int HttpBodyStream::available() {
+    return (peeked >= 0 || !finished) ? 1 : 0;
+}
+
+int HttpBodyStream::read() {
+    if (peeked >= 0) {
+        int c = peeked;
+        peeked = -1;
+        return c;
+    }
+    return decodedByte();
+}
+
+int HttpBodyStream::peek() {
+    if (peeked < 0) peeked = decodedByte();
+    return peeked;
+}
+
+bool HttpBodyStream::drain() {
+    if (!chunked && remaining < 0) return false;
+    if (inflating) {
+        // Let the inflater consume the gzip/zlib trailer
+        while (inflater.read() >= 0) body++;
+        while (bodyByte() >= 0) {}
+    } else {
+        while (bodyByte() >= 0) body++;
+    }
+    return true;
+}
@@ -0,0 +1,412 @@
+// Streaming DEFLATE decoder (RFC 1950/1951/1952)
+// Ported from zlib's contrib/puff (Mark Adler), made resumable per byte
+
+#include "inflate.h"
+#include <new>
+
+#define WINDOW_SIZE (1UL << INFLATE_WINDOW_BITS)
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+
+// Base lengths and extra bits for length codes 257..285
+static const uint16_t LENS[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LEXT[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+// Base offsets and extra bits for distance codes 0..29
+static const uint16_t DISTS[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+static const uint8_t DEXT[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+// Order of code length code lengths in a dynamic block header
+static const uint8_t ORDER[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+// CRC-32 (gzip) four bits at a time, keeps the table at 64 bytes
+static const uint32_t CRC_NIBBLE[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+Inflater::Inflater() : window(nullptr) {
+    end();
+}
+
+Inflater::~Inflater() {
+    end();
+}
+
+bool Inflater::begin(Format fmt, InflateSource src, void* ctx) {
+    end();
+    window = new (std::nothrow) uint8_t[WINDOW_SIZE];
+    if (!window) {
+        fail("Out of memory for window");
+        return false;
+    }
+    source = src;
+    sourceCtx = ctx;
+    format = fmt;
+    state = HEADER;
+    err = nullptr;
+    return true;
+}
+
+void Inflater::end() {
+    delete[] window;
+    window = nullptr;
+    source = nullptr;
+    sourceCtx = nullptr;
+    state = DONE;
+    err = nullptr;
+    bitbuf = 0;
+    bitcnt = 0;
+    lastBlock = false;
+    storedLeft = 0;
+    copyLen = 0;
+    copyDist = 0;
+    winPos = 0;
+    total = 0;
+    check = 0;
+    pushbackLen = 0;
+}
+
+bool Inflater::fail(const char* msg) {
+    if (state != FAILED) {
+        err = msg;
+        state = FAILED;
+    }
+    return false;
+}
+
+int Inflater::needByte() {
+    if (pushbackLen > 0) {
+        int c = pushback[0];
+        pushback[0] = pushback[1];
+        pushbackLen--;
+        return c;
+    }
+    int c = source(sourceCtx);
+    if (c < 0) {
+        fail("Truncated stream");
+        return -1;
+    }
+    return c;
+}
+
+// Return `need` bits LSB-first. On truncation the stream is failed and 0
+// returned; callers check `state` at the end of each header.
+int Inflater::bits(int need) {
+    while (bitcnt < need) {
+        int c = needByte();
+        if (c < 0) return 0;
+        bitbuf |= (uint32_t)c << bitcnt;
+        bitcnt += 8;
+    }
+    int val = bitbuf & ((1UL << need) - 1);
+    bitbuf >>= need;
+    bitcnt -= need;
+    return val;
+}
+
+// Canonical Huffman decode one bit at a time (puff's slow decode)
+int Inflater::decode(const Huffman* h) {
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= 15; len++) {
+        code |= bits(1);
+        if (state == FAILED) return -1;
+        int count = h->count[len];
+        if (code - count < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    fail("Invalid Huffman code");
+    return -1;
+}
+
+// Build a decoding table from code lengths. Returns 0 for a complete
+// code, > 0 for an incomplete one, < 0 for an over-subscribed one.
+int Inflater::construct(Huffman* h, const uint8_t* length, int n) {
+    for (int len = 0; len <= 15; len++) h->count[len] = 0;
+    for (int sym = 0; sym < n; sym++) h->count[length[sym]]++;
+    if (h->count[0] == n) return 0;
+
+    int left = 1;
+    for (int len = 1; len <= 15; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) return left;
+    }
+
+    uint16_t offs[16];
+    offs[1] = 0;
+    for (int len = 1; len < 15; len++) offs[len + 1] = offs[len] + h->count[len];
+    for (int sym = 0; sym < n; sym++) {
+        if (length[sym] != 0) h->symbol[offs[length[sym]]++] = sym;
+    }
+    return left;
+}
+
+bool Inflater::readHeader() {
+    if (format == RAW) return true;
+
+    int b0 = needByte();
+    int b1 = needByte();
+    if (state == FAILED) return false;
+
+    bool isGzip = b0 == 0x1f && b1 == 0x8b;
+    bool isZlib = (b0 & 0x0f) == 8 && (b0 >> 4) <= 7 && ((b0 << 8) | b1) % 31 == 0;
+    if (format == AUTO) {
+        if (isGzip) {
+            format = GZIP;
+        } else if (isZlib) {
+            format = ZLIB;
+        } else {
+            // Some servers send raw deflate for "Content-Encoding: deflate"
+            pushback[0] = b0;
+            pushback[1] = b1;
+            pushbackLen = 2;
+            format = RAW;
+            return true;
+        }
+    }
+
+    if (format == GZIP) {
+        if (!isGzip || needByte() != 8) return fail("Bad gzip header");
+        int flags = needByte();
+        for (int i = 0; i < 6; i++) needByte();          // MTIME, XFL, OS
+        if (flags & 0x04) {                                // FEXTRA
+            int xlen = needByte();
+            xlen |= needByte() << 8;
+            while (xlen-- > 0 && state != FAILED) needByte();
+        }
+        if (flags & 0x08) {                                // FNAME
+            while (needByte() > 0) {}
+        }
+        if (flags & 0x10) {                                // FCOMMENT
+            while (needByte() > 0) {}
+        }
+        if (flags & 0x02) {                                // FHCRC
+            needByte();
+            needByte();
+        }
+        check = 0xffffffff;
+    } else {
+        if (!isZlib) return fail("Bad zlib header");
+        if (b1 & 0x20) return fail("Preset dictionary not supported");
+        check = 1;
+    }
+    return state != FAILED;
+}
+
+bool Inflater::readTrailer() {
+    // Trailer starts on a byte boundary
+    bitbuf = 0;
+    bitcnt = 0;
+
+    if (format == GZIP) {
+        uint32_t crc = 0, isize = 0;
+        for (int i = 0; i < 4; i++) crc |= (uint32_t)needByte() << (8 * i);
+        for (int i = 0; i < 4; i++) isize |= (uint32_t)needByte() << (8 * i);
+        if (state == FAILED) return false;
+        if (crc != (check ^ 0xffffffff) || isize != total) {
+            return fail("gzip CRC mismatch");
+        }
+    } else if (format == ZLIB) {
+        uint32_t adler = 0;
+        for (int i = 0; i < 4; i++) adler = (adler << 8) | (uint8_t)needByte();
+        if (state == FAILED) return false;
+        if (adler != check) return fail("zlib Adler-32 mismatch");
+    }
+    return true;
+}
+
+bool Inflater::buildDynamic() {
+    uint8_t lengths[286 + 30];
+    Huffman lencodes;
+
+    int nlen = bits(5) + 257;
+    int ndist = bits(5) + 1;
+    int ncode = bits(4) + 4;
+    if (nlen > 286 || ndist > 30) return fail("Bad dynamic block counts");
+
+    for (int i = 0; i < 19; i++) {
+        lengths[ORDER[i]] = i < ncode ? bits(3) : 0;
+    }
+    if (state == FAILED) return false;
+    if (construct(&lencodes, lengths, 19) != 0) return fail("Incomplete code length code");
+
+    int index = 0;
+    while (index < nlen + ndist) {
+        int sym = decode(&lencodes);
+        if (sym < 0) return false;
+        if (sym < 16) {
+            lengths[index++] = sym;
+            continue;
+        }
+        uint8_t len = 0;
+        if (sym == 16) {
+            if (index == 0) return fail("Repeat with no first length");
+            len = lengths[index - 1];
+            sym = 3 + bits(2);
+        } else if (sym == 17) {
+            sym = 3 + bits(3);
+        } else {
+            sym = 11 + bits(7);
+        }
+        if (index + sym > nlen + ndist) return fail("Too many code lengths");
+        while (sym--) lengths[index++] = len;
+    }
+    if (state == FAILED) return false;
+    if (lengths[256] == 0) return fail("No end-of-block code");
+
+    int left = construct(&lencode, lengths, nlen);
+    if (left < 0 || (left > 0 && nlen - lencode.count[0] != 1)) {
+        return fail("Bad literal/length code");
+    }
+    left = construct(&distcode, lengths + nlen, ndist);
+    if (left < 0 || (left > 0 && ndist - distcode.count[0] != 1)) {
+        return fail("Bad distance code");
+    }
+    return true;
+}
+
+bool Inflater::startBlock() {
+    lastBlock = bits(1);
+    int type = bits(2);
+    if (state == FAILED) return false;
+
+    if (type == 0) {
+        // Stored block: skip to byte boundary, then LEN / NLEN
+        bitbuf = 0;
+        bitcnt = 0;
+        uint32_t len = needByte();
+        len |= needByte() << 8;
+        uint32_t nlen = needByte();
+        nlen |= needByte() << 8;
+        if (state == FAILED) return false;
+        if (len != (~nlen & 0xffff)) return fail("Stored block length mismatch");
+        storedLeft = len;
+        state = STORED;
+    } else if (type == 1) {
+        uint8_t lengths[288];
+        int sym = 0;
+        for (; sym < 144; sym++) lengths[sym] = 8;
+        for (; sym < 256; sym++) lengths[sym] = 9;
+        for (; sym < 280; sym++) lengths[sym] = 7;
+        for (; sym < 288; sym++) lengths[sym] = 8;
+        construct(&lencode, lengths, 288);
+        for (sym = 0; sym < 30; sym++) lengths[sym] = 5;
+        construct(&distcode, lengths, 30);
+        state = CODES;
+    } else if (type == 2) {
+        if (!buildDynamic()) return false;
+        state = CODES;
+    } else {
+        return fail("Invalid block type");
+    }
+    return true;
+}
+
+int Inflater::emit(uint8_t b) {
+    window[winPos & WINDOW_MASK] = b;
+    winPos++;
+    total++;
+    if (format == GZIP) {
+        check ^= b;
+        check = (check >> 4) ^ CRC_NIBBLE[check & 15];
+        check = (check >> 4) ^ CRC_NIBBLE[check & 15];
+    } else if (format == ZLIB) {
+        uint32_t a = ((check & 0xffff) + b) % 65521;
+        uint32_t s = ((check >> 16) + a) % 65521;
+        check = (s << 16) | a;
+    }
+    return b;
+}
+
+int Inflater::read() {
+    for (;;) {
+        switch (state) {
+        case HEADER:
+            if (!readHeader()) return -1;
+            state = BLOCK;
+            break;
+
+        case BLOCK:
+            if (!startBlock()) return -1;
+            break;
+
+        case STORED: {
+            if (storedLeft == 0) {
+                state = lastBlock ? TRAILER : BLOCK;
+                break;
+            }
+            int c = needByte();
+            if (c < 0) return -1;
+            storedLeft--;
+            return emit(c);
+        }
+
+        case CODES: {
+            if (copyLen > 0) {
+                copyLen--;
+                return emit(window[(winPos - copyDist) & WINDOW_MASK]);
+            }
+            int sym = decode(&lencode);
+            if (sym < 0) return -1;
+            if (sym < 256) return emit(sym);
+            if (sym == 256) {
+                state = lastBlock ? TRAILER : BLOCK;
+                break;
+            }
+            sym -= 257;
+            if (sym >= 29) {
+                fail("Invalid length symbol");
+                return -1;
+            }
+            uint32_t len = LENS[sym] + bits(LEXT[sym]);
+            int dsym = decode(&distcode);
+            if (dsym < 0) return -1;
+            if (dsym >= 30) {
+                fail("Invalid distance symbol");
+                return -1;
+            }
+            uint32_t dist = DISTS[dsym] + bits(DEXT[dsym]);
+            if (state == FAILED) return -1;
+            if (dist > total) {
+                fail("Distance too far back");
+                return -1;
+            }
+            if (dist > WINDOW_SIZE) {
+                fail("Distance exceeds window");
+                return -1;
+            }
+            copyLen = len;
+            copyDist = dist;
+            break;
+        }
+
+        case TRAILER:
+            if (!readTrailer()) return -1;
+            state = DONE;
+            break;
+
+        case DONE:
+        case FAILED:
+            return -1;
+        }
+    }
+}
@@ -0,0 +1,80 @@
+// Rolling latency percentiles and SLO accounting
+
+#include "latency.h"
+#include <string.h>
+
+const uint32_t LatencyTracker::bucketBounds[LATENCY_BUCKETS] = {
+    1000, 2000, 5000, 10000, 15000, 20000, 30000, 60000, 120000, UINT32_MAX
+};
+
+LatencyTracker::LatencyTracker(uint32_t slo)
+    : sloMs(slo), next(0), events(0), sloBreaches(0), sumMs(0) {
+    memset(window, 0, sizeof(window));
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void LatencyTracker::record(uint32_t ms) {
+    window[next] = ms;
+    next = (next + 1) % LATENCY_WINDOW;
+    events++;
+    sumMs += ms;
+    if (ms > sloMs) sloBreaches++;
+
+    size_t b = 0;
+    while (ms > bucketBounds[b]) b++;
+    buckets[b]++;
+}
+
+// Nearest-rank percentile of a sorted array
+static uint32_t percentile(const uint32_t* sorted, size_t n, uint32_t pct) {
+    size_t rank = (n * pct + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+LatencySummary LatencyTracker::summary() const {
+    LatencySummary s = {0, 0, 0, 0, 0};
+    size_t n = events < LATENCY_WINDOW ? events : LATENCY_WINDOW;
+    if (n == 0) return s;
+
+    // Insertion sort: the window is small and mostly this runs once per event
+    uint32_t sorted[LATENCY_WINDOW];
+    for (size_t i = 0; i < n; i++) {
+        uint32_t v = window[i];
+        size_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    s.count = n;
+    s.p50 = percentile(sorted, n, 50);
+    s.p95 = percentile(sorted, n, 95);
+    s.p99 = percentile(sorted, n, 99);
+    s.max = sorted[n - 1];
+    return s;
+}
+
+#ifdef ARDUINO
+void LatencyTracker::writeMetrics(Print& out, const char* name) const {
+    LatencySummary s = summary();
+    out.printf("# TYPE %s histogram\n", name);
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        cumulative += buckets[i];
+        if (bucketBounds[i] == UINT32_MAX) {
+            out.printf("%s_bucket{le=\"+Inf\"} %u\n", name, cumulative);
+        } else {
+            out.printf("%s_bucket{le=\"%u\"} %u\n", name, bucketBounds[i], cumulative);
+        }
+    }
+    out.printf("%s_sum %llu\n", name, (unsigned long long)sumMs);
+    out.printf("%s_count %u\n", name, events);
+    out.printf("%s_window{quantile=\"0.5\"} %u\n", name, s.p50);
+    out.printf("%s_window{quantile=\"0.95\"} %u\n", name, s.p95);
+    out.printf("%s_window{quantile=\"0.99\"} %u\n", name, s.p99);
+    out.printf("%s_slo_ms %u\n", name, sloMs);
+    out.printf("%s_slo_breaches_total %u\n", name, sloBreaches);
+}
+#endif
@@ -0,0 +1,49 @@
+// Generated by tools/gen_datum.py from plutus.json (htlabs/iot2 0.0.0). Do not edit.
+
+#include "locker_datum.h"
+#include <string.h>
+
+static bool walkLockerAddress(PlutusReader& r, LockerAddress* out) {
+    uint32_t index;
+    if (!r.constr(&index)) return false;
+    if (index != 0) return r.fail("Address: unexpected constructor");
+    if (!r.beginList()) return false;
+    if (!r.bytes(out->payment, 28)) return false;
+    if (!r.bytes(out->stake, 28)) return false;
+    return r.endList();
+}
+
+static bool walkLockerDatum(PlutusReader& r, LockerDatum* out) {
+    uint32_t index;
+    if (!r.constr(&index)) return false;
+    if (index != 0) return r.fail("Datum: unexpected constructor");
+    if (!r.beginList()) return false;
+    if (!walkLockerAddress(r, &out->authority)) return false;
+    if (!r.integer(&out->isLocked)) return false;
+    return r.endList();
+}
+
+// d8 79 9f d8 79 9f 58 1c <authority.payment:28> 58 1c <authority.stake:28> ff <isLocked:int> ff
+static constexpr uint8_t lockerDatumHead0[] = {0xd8, 0x79, 0x9f, 0xd8, 0x79, 0x9f, 0x58, 0x1c};
+static constexpr uint8_t lockerDatumHead1[] = {0x58, 0x1c};
+static_assert(LOCKER_DATUM_FIXED_LEN == 69, "fixed layout size");
+
+static bool fixedLockerDatum(const uint8_t* p, size_t len, LockerDatum* out) {
+    if (len != LOCKER_DATUM_FIXED_LEN) return false;
+    if (memcmp(p + 0, lockerDatumHead0, sizeof(lockerDatumHead0)) != 0) return false;
+    memcpy(out->authority.payment, p + 8, 28);
+    if (memcmp(p + 36, lockerDatumHead1, sizeof(lockerDatumHead1)) != 0) return false;
+    memcpy(out->authority.stake, p + 38, 28);
+    if (p[66] != 0xff) return false;
+    if (!plutusTinyInt(p[67], &out->isLocked)) return false;
+    if (p[68] != 0xff) return false;
+    return true;
+}
+
+PlutusPath decodeLockerDatum(const uint8_t* data, size_t len, LockerDatum* out, const char** error) {
+    if (fixedLockerDatum(data, len, out)) return PLUTUS_FIXED;
+    PlutusReader r(data, len);
+    if (walkLockerDatum(r, out) && (r.done() || r.fail("Trailing bytes after datum"))) return PLUTUS_WALK;
+    *error = r.error();
+    return PLUTUS_FAILED;
+}
@@ -0,0 +1,124 @@
+// Firmware log: telemetry ring producer, Serial drain task
+
+#include "config.h"
+#include "logger.h"
+
+#if TELEMETRY_TASK
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+#define DRAIN_INTERVAL_MS 20
+
+static uint8_t ringStorage[TELEMETRY_RING_BYTES];
+static TelemetryRing ring(ringStorage, TELEMETRY_RING_BYTES);
+static volatile bool binaryOutput = TELEMETRY_BINARY;
+
+// Consumer side: everything queued, as frames or as text lines
+static void drain() {
+    // A leading delimiter separates the frame from any text printed before it
+    uint8_t frame[TLM_MAX_FRAME + 1];
+    frame[0] = 0;
+    size_t n;
+    while ((n = ring.nextFrame(frame + 1)) > 0) {
+        if (binaryOutput) {
+            Serial.write(frame, n + 1);
+            continue;
+        }
+        uint8_t scratch[TLM_MAX_RECORD];
+        TlmRecord rec;
+        if (!tlmDecode(frame + 1, n - 1, scratch, &rec)) continue;
+        char line[TLM_MAX_LINE];
+        size_t len = tlmFormat(rec, line, sizeof(line) - 1);
+        line[len++] = '\n';
+        Serial.write((const uint8_t*)line, len);
+    }
+}
+
+#if TELEMETRY_TASK
+static void drainTask(void*) {
+    while (true) {
+        drain();
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL_MS));
+    }
+}
+#endif
+
+void initLogger() {
+#if TELEMETRY_TASK
+    xTaskCreate(drainTask, "telemetry", 4096, nullptr, 1, nullptr);
+#endif
+}
+
+void serviceLogger() {
+#if !TELEMETRY_TASK
+    drain();
+#endif
+}
+
+void flushLogger(uint32_t maxMs) {
+    unsigned long start = millis();
+    while (ring.pending() > 0 && millis() - start < maxMs) {
+#if TELEMETRY_TASK
+        delay(1);
+#else
+        drain();
+#endif
+    }
+}
+
+void setLogBinary(bool enabled) {
+    binaryOutput = enabled;
+}
+
+bool logBinary() {
+    return binaryOutput;
+}
+
+void logRecord(uint8_t type, uint8_t level, const uint8_t* payload, size_t len) {
+    ring.push(type, level, millis(), payload, len);
+}
+
+void logText(uint8_t level, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    ring.text(level, millis(), fmt, args);
+    va_end(args);
+}
+
+void logFetch(const FetchStats& stats) {
+    if (TELEMETRY_LEVEL > TLM_INFO) return;
+    TlmFetch f = {stats.compressed, stats.wireBytes, stats.bodyBytes, stats.datumMs, stats.minFreeHeap,
+                  stats.requests, stats.roundTrips, stats.connects, stats.connectMs,
+                  stats.resolveMs, stats.waitMs};
+    uint8_t payload[TLM_MAX_PAYLOAD];
+    logRecord(TLM_FETCH, TLM_INFO, payload, tlmPackFetch(payload, f));
+}
+
+void logState(const DatumResult& datum, uint8_t network) {
+    if (TELEMETRY_LEVEL > TLM_INFO) return;
+    TlmState s;
+    s.network = network;
+    s.isLocked = datum.isLocked;
+    memcpy(s.pubKeyHash, datum.pubKeyHash, 28);
+    memcpy(s.stakeCredHash, datum.stakeCredHash, 28);
+    uint8_t payload[TLM_MAX_PAYLOAD];
+    logRecord(TLM_STATE, TLM_INFO, payload, tlmPackState(payload, s));
+}
+
+void logEnergy(const EnergyReport& e) {
+    if (TELEMETRY_LEVEL > TLM_INFO) return;
+    TlmEnergy t = {e.ms[POWER_ACTIVE], e.ms[POWER_IDLE], e.ms[POWER_SLEEP], e.wakes, e.wakeMs,
+                   e.chargeUas, e.energyMj, e.avgUa};
+    uint8_t payload[TLM_MAX_PAYLOAD];
+    logRecord(TLM_ENERGY, TLM_INFO, payload, tlmPackEnergy(payload, t));
+}
+
+void writeLoggerMetrics(Print& out) {
+    const TelemetryStats& s = ring.stats();
+    out.printf("telemetry_binary %d\n", binaryOutput ? 1 : 0);
+    out.printf("telemetry_records_total %u\n", s.records);
+    out.printf("telemetry_dropped_total %u\n", s.dropped);
+    out.printf("telemetry_bytes_total %u\n", s.bytes);
+    out.printf("telemetry_ring_high_water_bytes %u\n", s.highWater);
+}
@@ -0,0 +1,223 @@
+// Plutus data CBOR reader for the generated datum decoders
+
+#include "plutus_data.h"
+#include <string.h>
+
+#define MAJOR_UINT 0
+#define MAJOR_NEGINT 1
+#define MAJOR_BYTES 2
+#define MAJOR_TEXT 3
+#define MAJOR_ARRAY 4
+#define MAJOR_MAP 5
+#define MAJOR_TAG 6
+#define MAJOR_SIMPLE 7
+
+#define BREAK 0xff
+
+PlutusReader::PlutusReader(const uint8_t* data, size_t len)
+    : pos(data), end(data + len), failed(false), message(nullptr), depth(0) {}
+
+bool PlutusReader::fail(const char* m) {
+    if (!failed) {
+        failed = true;
+        message = m;
+    }
+    return false;
+}
+
+// Initial byte and argument of the next item
+bool PlutusReader::head(uint8_t* major, uint64_t* arg, bool* indefinite) {
+    if (failed) return false;
+    if (pos >= end) return fail("Unexpected end of datum");
+
+    uint8_t ib = *pos++;
+    uint8_t info = ib & 0x1f;
+    *major = ib >> 5;
+    *indefinite = false;
+
+    if (info < 24) {
+        *arg = info;
+        return true;
+    }
+    if (info == 31) {
+        if (*major != MAJOR_BYTES && *major != MAJOR_TEXT &&
+            *major != MAJOR_ARRAY && *major != MAJOR_MAP) {
+            return fail("Unexpected break");
+        }
+        *indefinite = true;
+        *arg = 0;
+        return true;
+    }
+    if (info > 27) return fail("Reserved CBOR header");
+
+    size_t n = (size_t)1 << (info - 24);
+    if ((size_t)(end - pos) < n) return fail("Unexpected end of datum");
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) v = (v << 8) | *pos++;
+    *arg = v;
+    return true;
+}
+
+bool PlutusReader::constrSlow(uint32_t* index) {
+    uint8_t major;
+    uint64_t tag;
+    bool indefinite;
+    if (!head(&major, &tag, &indefinite)) return false;
+    if (major != MAJOR_TAG) return fail("Expected constructor tag");
+
+    if (tag >= 121 && tag <= 127) {
+        *index = tag - 121;
+    } else if (tag >= 1280 && tag <= 1400) {
+        *index = tag - 1280 + 7;
+    } else if (tag == 102) {
+        // General form: [index, fields]
+        uint64_t n;
+        if (!head(&major, &n, &indefinite)) return false;
+        if (major != MAJOR_ARRAY || indefinite || n != 2) return fail("Expected [index, fields]");
+        uint64_t v;
+        if (!head(&major, &v, &indefinite)) return false;
+        if (major != MAJOR_UINT || v > UINT32_MAX) return fail("Bad constructor index");
+        *index = v;
+    } else {
+        return fail("Unexpected tag");
+    }
+    // The field list that follows counts as the item in the enclosing list
+    return true;
+}
+
+bool PlutusReader::beginListSlow() {
+    uint8_t major;
+    uint64_t n;
+    bool indefinite;
+    if (!head(&major, &n, &indefinite)) return false;
+    if (major != MAJOR_ARRAY) return fail("Expected list");
+    item();
+    if (depth >= PLUTUS_MAX_DEPTH) return fail("Datum nested too deeply");
+    remaining[depth++] = indefinite ? -1 : (int64_t)n;
+    return true;
+}
+
+bool PlutusReader::more() {
+    if (failed || depth == 0) return false;
+    int64_t left = remaining[depth - 1];
+    if (left >= 0) return left > 0;
+    return pos < end && *pos != BREAK;
+}
+
+bool PlutusReader::endList() {
+    if (failed) return false;
+    if (depth == 0) return fail("No list to close");
+    int64_t left = remaining[depth - 1];
+    if (left > 0) return fail("List has more items than expected");
+    if (left < 0) {
+        if (pos >= end) return fail("Unexpected end of datum");
+        if (*pos != BREAK) return fail("List has more items than expected");
+        pos++;
+    }
+    depth--;
+    return true;
+}
+
+bool PlutusReader::bytesUpTo(uint8_t* out, size_t max, size_t* len) {
+    uint8_t major;
+    uint64_t n;
+    bool indefinite;
+    if (!head(&major, &n, &indefinite)) return false;
+    if (major != MAJOR_BYTES) return fail("Expected bytes");
+    item();
+
+    if (!indefinite) {
+        if (n > max) return fail("Bytes longer than expected");
+        if ((uint64_t)(end - pos) < n) return fail("Unexpected end of datum");
+        memcpy(out, pos, n);
+        pos += n;
+        *len = n;
+        return true;
+    }
+
+    // Plutus splits byte strings over 64 bytes into chunks
+    size_t total = 0;
+    for (;;) {
+        if (pos >= end) return fail("Unexpected end of datum");
+        if (*pos == BREAK) {
+            pos++;
+            break;
+        }
+        if (!head(&major, &n, &indefinite)) return false;
+        if (major != MAJOR_BYTES || indefinite) return fail("Bad byte string chunk");
+        if (n > max - total) return fail("Bytes longer than expected");
+        if ((uint64_t)(end - pos) < n) return fail("Unexpected end of datum");
+        memcpy(out + total, pos, n);
+        pos += n;
+        total += n;
+    }
+    *len = total;
+    return true;
+}
+
+bool PlutusReader::bytesSlow(uint8_t* out, size_t len) {
+    size_t got;
+    if (!bytesUpTo(out, len, &got)) return false;
+    if (got != len) return fail("Bytes shorter than expected");
+    return true;
+}
+
+bool PlutusReader::integerSlow(int64_t* value) {
+    uint8_t major;
+    uint64_t n;
+    bool indefinite;
+    if (!head(&major, &n, &indefinite)) return false;
+    if (major == MAJOR_TAG && (n == 2 || n == 3)) return fail("Integer out of range");
+    if (major != MAJOR_UINT && major != MAJOR_NEGINT) return fail("Expected integer");
+    if (n > (uint64_t)INT64_MAX) return fail("Integer out of range");
+    item();
+    *value = major == MAJOR_UINT ? (int64_t)n : -1 - (int64_t)n;
+    return true;
+}
+
+bool PlutusReader::skipItem(int level) {
+    if (level > PLUTUS_MAX_DEPTH) return fail("Datum nested too deeply");
+    uint8_t major;
+    uint64_t n;
+    bool indefinite;
+    if (!head(&major, &n, &indefinite)) return false;
+
+    switch (major) {
+    case MAJOR_UINT:
+    case MAJOR_NEGINT:
+    case MAJOR_SIMPLE:
+        return true;
+    case MAJOR_TAG:
+        return skipItem(level + 1);
+    case MAJOR_BYTES:
+    case MAJOR_TEXT:
+        if (!indefinite) {
+            if ((uint64_t)(end - pos) < n) return fail("Unexpected end of datum");
+            pos += n;
+            return true;
+        }
+        break;
+    default:        // array or map
+        if (!indefinite) {
+            uint64_t items = major == MAJOR_MAP ? n * 2 : n;
+            for (uint64_t i = 0; i < items; i++) {
+                if (!skipItem(level + 1)) return false;
+            }
+            return true;
+        }
+        break;
+    }
+    // Indefinite: items (or chunks) up to the break
+    while (pos < end && *pos != BREAK) {
+        if (!skipItem(level + 1)) return false;
+    }
+    if (pos >= end) return fail("Unexpected end of datum");
+    pos++;
+    return true;
+}
+
+bool PlutusReader::skip() {
+    if (!skipItem(0)) return false;
+    item();
+    return true;
+}
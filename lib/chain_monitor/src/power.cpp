@@ -0,0 +1,102 @@
+#include "power.h"
+#include "config.h"
+#include "logger.h"
+#include <WiFi.h>
+#include <esp_idf_version.h>
+#include <esp_pm.h>
+
+// Upper bound on waiting for WiFi after a wake-up
+#define READY_TIMEOUT_MS 3000
+// ... and on letting queued log records out before sleeping
+#define LOG_FLUSH_MS 200
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+typedef esp_pm_config_t PmConfig;
+#elif CONFIG_IDF_TARGET_ESP32C3
+typedef esp_pm_config_esp32c3_t PmConfig;
+#else
+typedef esp_pm_config_esp32_t PmConfig;
+#endif
+
+static const uint32_t currentUa[POWER_STATES] = {
+    POWER_ACTIVE_UA, POWER_IDLE_UA, POWER_SLEEP_UA
+};
+static EnergyMeter meter(currentUa, POWER_SUPPLY_MV, powerClock, nullptr);
+static bool lowPowerEnabled = LOW_POWER_MODE;
+static bool autoLightSleep = false;
+
+uint32_t powerClock(void*) {
+    return millis();
+}
+
+void initPower() {
+    setLowPower(lowPowerEnabled);
+}
+
+// Automatic light sleep: the idle task halts the CPU whenever every task is
+// blocked, and the modem still wakes for DTIM beacons, so the station stays
+// associated. A direct esp_light_sleep_start() would switch the radio off
+// and the AP would drop us. Needs a framework built with CONFIG_PM_ENABLE
+// and CONFIG_FREERTOS_USE_TICKLESS_IDLE.
+static bool configureLightSleep(bool enabled) {
+    PmConfig pm = {};
+    pm.max_freq_mhz = getCpuFrequencyMhz();
+    pm.min_freq_mhz = enabled ? getXtalFrequencyMhz() : pm.max_freq_mhz;
+    pm.light_sleep_enable = enabled;
+    return esp_pm_configure(&pm) == ESP_OK;
+}
+
+void setLowPower(bool enabled) {
+    lowPowerEnabled = enabled;
+    // Max modem sleep skips DTIM beacons while idle; min keeps latency down
+    WiFi.setSleep(enabled ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+    autoLightSleep = configureLightSleep(enabled) && enabled;
+    if (enabled && !autoLightSleep) {
+        LOG_WARN("[power] automatic light sleep unavailable, idling in modem sleep");
+    }
+}
+
+bool lowPower() {
+    return lowPowerEnabled;
+}
+
+void powerBeginPoll() {
+    meter.enter(POWER_ACTIVE);
+}
+
+void powerEndPoll() {
+    meter.enter(POWER_IDLE);
+}
+
+// Block for `ms` so the idle task light-sleeps between DTIM beacons, then
+// make sure WiFi is still usable
+static void lightSleep(uint32_t ms) {
+    if (ms > LOW_POWER_MAX_SLEEP_MS) ms = LOW_POWER_MAX_SLEEP_MS;
+
+    flushLogger(LOG_FLUSH_MS);
+    Serial.flush();                 // UART output stops during sleep
+    meter.enter(POWER_SLEEP);
+    delay(ms);
+    meter.enter(POWER_IDLE);
+
+    unsigned long wake = millis();
+    while (WiFi.status() != WL_CONNECTED && millis() - wake < READY_TIMEOUT_MS) {
+        delay(1);
+    }
+    meter.addWake(millis() - wake);
+}
+
+void powerIdle(uint32_t ms) {
+    if (autoLightSleep && ms >= LOW_POWER_MIN_SLEEP_MS) {
+        lightSleep(ms);
+        return;
+    }
+
+    // Awake: same 10 ms cadence as before, but never past the deadline
+    if (ms > 10) ms = 10;
+    if (ms > 0) delay(ms);
+}
+
+EnergyReport powerTakeReport() {
+    return meter.take();
+}
@@ -0,0 +1,95 @@
+// Loop deadlines and energy accounting
+
+#include "scheduler.h"
+#include <string.h>
+
+DeadlineScheduler::DeadlineScheduler(SchedClockFn clock, void* c)
+    : clockFn(clock), ctx(c), count(0) {
+    memset(deadlines, 0, sizeof(deadlines));
+}
+
+int DeadlineScheduler::add(const char* name, uint32_t periodMs) {
+    if (count >= SCHED_MAX_DEADLINES) return -1;
+    int id = count++;
+    deadlines[id].name = name;
+    deadlines[id].periodMs = periodMs;
+    if (periodMs > 0) arm(id, periodMs);
+    return id;
+}
+
+void DeadlineScheduler::arm(int id, uint32_t inMs) {
+    deadlines[id].atMs = clockFn(ctx) + inMs;
+    deadlines[id].armed = true;
+}
+
+void DeadlineScheduler::disarm(int id) {
+    deadlines[id].armed = false;
+}
+
+bool DeadlineScheduler::due(int id) const {
+    const Deadline& d = deadlines[id];
+    // Signed difference survives the millis() wrap
+    return d.armed && (int32_t)(clockFn(ctx) - d.atMs) >= 0;
+}
+
+uint32_t DeadlineScheduler::msUntilNext(int* id) const {
+    uint32_t now = clockFn(ctx);
+    uint32_t best = UINT32_MAX;
+    int bestId = -1;
+    for (size_t i = 0; i < count; i++) {
+        if (!deadlines[i].armed) continue;
+        int32_t left = (int32_t)(deadlines[i].atMs - now);
+        uint32_t wait = left > 0 ? (uint32_t)left : 0;
+        if (wait < best) {
+            best = wait;
+            bestId = i;
+        }
+    }
+    if (id) *id = bestId;
+    return best;
+}
+
+EnergyMeter::EnergyMeter(const uint32_t* ua, uint32_t mv, SchedClockFn clock, void* c)
+    : currentUa(ua), supplyMv(mv), clockFn(clock), ctx(c),
+      current(POWER_IDLE), since(clock(c)), wakes(0), wakeMs(0) {
+    memset(stateMs, 0, sizeof(stateMs));
+}
+
+void EnergyMeter::close() {
+    uint32_t now = clockFn(ctx);
+    stateMs[current] += now - since;
+    since = now;
+}
+
+void EnergyMeter::enter(PowerState state) {
+    close();
+    current = state;
+}
+
+void EnergyMeter::addWake(uint32_t readyMs) {
+    wakes++;
+    wakeMs += readyMs;
+}
+
+EnergyReport EnergyMeter::take() {
+    close();
+
+    EnergyReport report;
+    uint64_t totalMs = 0;
+    uint64_t uaMs = 0;
+    for (int s = 0; s < POWER_STATES; s++) {
+        report.ms[s] = stateMs[s];
+        totalMs += stateMs[s];
+        uaMs += stateMs[s] * currentUa[s];
+    }
+    report.wakes = wakes;
+    report.wakeMs = wakeMs;
+    report.chargeUas = uaMs / 1000;
+    report.energyMj = uaMs * supplyMv / 1000000000ULL;
+    report.avgUa = totalMs > 0 ? uaMs / totalMs : 0;
+
+    memset(stateMs, 0, sizeof(stateMs));
+    wakes = 0;
+    wakeMs = 0;
+    return report;
+}
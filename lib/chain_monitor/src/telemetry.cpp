@@ -0,0 +1,258 @@
+// Binary telemetry: record layouts, COBS framing, SPSC frame ring
+
+#include "telemetry.h"
+#include "bech32.h"
+#include <stdio.h>
+#include <string.h>
+
+// ---- payload layouts ----
+
+static uint8_t* put16(uint8_t* p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t* put32(uint8_t* p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+#define FETCH_LEN 35
+#define STATE_LEN 58
+#define ENERGY_LEN 32
+
+size_t tlmPackFetch(uint8_t* out, const TlmFetch& f) {
+    uint8_t* p = out;
+    *p++ = f.compressed ? 1 : 0;
+    p = put32(p, f.wireBytes);
+    p = put32(p, f.bodyBytes);
+    p = put32(p, f.datumMs);
+    p = put32(p, f.minFreeHeap);
+    p = put16(p, f.requests);
+    p = put16(p, f.roundTrips);
+    p = put16(p, f.connects);
+    p = put32(p, f.connectMs);
+    p = put32(p, f.resolveMs);
+    p = put32(p, f.waitMs);
+    return p - out;
+}
+
+size_t tlmPackState(uint8_t* out, const TlmState& s) {
+    out[0] = s.network;
+    out[1] = s.isLocked ? 1 : 0;
+    memcpy(out + 2, s.pubKeyHash, 28);
+    memcpy(out + 30, s.stakeCredHash, 28);
+    return STATE_LEN;
+}
+
+size_t tlmPackEnergy(uint8_t* out, const TlmEnergy& e) {
+    uint8_t* p = out;
+    p = put32(p, e.activeMs);
+    p = put32(p, e.idleMs);
+    p = put32(p, e.sleepMs);
+    p = put32(p, e.wakes);
+    p = put32(p, e.wakeMs);
+    p = put32(p, e.chargeUas);
+    p = put32(p, e.energyMj);
+    p = put32(p, e.avgUa);
+    return p - out;
+}
+
+// ---- framing ----
+
+// CRC-8, polynomial 0x07, a table lookup per byte
+static const uint8_t CRC8_TABLE[256] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+    0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+    0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+    0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+    0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+    0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+    0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+    0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+    0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+    0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+    0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3,
+};
+
+static uint8_t crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) crc = CRC8_TABLE[crc ^ data[i]];
+    return crc;
+}
+
+// Consistent overhead byte stuffing: every 0x00 becomes the distance to
+// the next one, so the output has none
+static size_t cobsEncode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t codeAt = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] != 0) {
+            out[o++] = in[i];
+            code++;
+        }
+        if (in[i] == 0 || code == 0xFF) {
+            out[codeAt] = code;
+            codeAt = o++;
+            code = 1;
+        }
+    }
+    out[codeAt] = code;
+    return o;
+}
+
+static size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out, size_t max) {
+    size_t o = 0;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len || o + code > max + 1) return SIZE_MAX;
+        for (uint8_t k = 1; k < code; k++) {
+            if (in[i] == 0) return SIZE_MAX;
+            out[o++] = in[i++];
+        }
+        if (code < 0xFF && i < len) {
+            if (o >= max) return SIZE_MAX;
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+size_t tlmEncode(uint8_t* frame, uint8_t type, uint8_t level, uint32_t timeMs,
+                 const uint8_t* payload, size_t len) {
+    if (len > TLM_MAX_PAYLOAD) len = TLM_MAX_PAYLOAD;
+    uint8_t rec[TLM_MAX_RECORD];
+    rec[0] = type;
+    rec[1] = level;
+    put32(rec + 2, timeMs);
+    memcpy(rec + TLM_HEADER_LEN, payload, len);
+    size_t n = TLM_HEADER_LEN + len;
+    rec[n] = crc8(rec, n);
+
+    size_t f = cobsEncode(rec, n + 1, frame);
+    frame[f++] = 0;
+    return f;
+}
+
+bool tlmDecode(const uint8_t* frame, size_t len, uint8_t* scratch, TlmRecord* rec) {
+    size_t n = cobsDecode(frame, len, scratch, TLM_MAX_RECORD);
+    if (n == SIZE_MAX || n < TLM_HEADER_LEN + 1) return false;
+    if (crc8(scratch, n - 1) != scratch[n - 1]) return false;
+
+    rec->type = scratch[0];
+    rec->level = scratch[1];
+    rec->timeMs = get32(scratch + 2);
+    rec->payload = scratch + TLM_HEADER_LEN;
+    rec->len = n - 1 - TLM_HEADER_LEN;
+    return rec->level <= TLM_ERROR;
+}
+
+const char* tlmLevelName(uint8_t level) {
+    static const char* const names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+    return level <= TLM_ERROR ? names[level] : "?";
+}
+
+// ---- text rendering (same lines as the firmware's text log) ----
+
+size_t tlmFormat(const TlmRecord& rec, char* out, size_t size) {
+    const uint8_t* p = rec.payload;
+    int n = -1;
+
+    if (rec.type == TLM_TEXT) {
+        n = snprintf(out, size, "%.*s", (int)rec.len, (const char*)p);
+    } else if (rec.type == TLM_FETCH && rec.len >= FETCH_LEN) {
+        n = snprintf(out, size, "[fetch] %s wire=%uB body=%uB datum=%ums heap_min=%u "
+            "req=%u rtt=%u conn=%u/%ums dns=%ums wait=%ums",
+            p[0] ? "gzip" : "identity",
+            (unsigned)get32(p + 1), (unsigned)get32(p + 5), (unsigned)get32(p + 9), (unsigned)get32(p + 13),
+            get16(p + 17), get16(p + 19), get16(p + 21), (unsigned)get32(p + 23),
+            (unsigned)get32(p + 27), (unsigned)get32(p + 31));
+    } else if (rec.type == TLM_STATE && rec.len >= STATE_LEN) {
+        char address[CARDANO_ADDR_BUF_LEN];
+        if (encodeCardanoAddressTo(address, sizeof(address), p + 2, p + 30, p[0]) == 0) address[0] = '\0';
+        n = snprintf(out, size, "Authority: %s | Locked: %s", address, p[1] ? "true" : "false");
+    } else if (rec.type == TLM_ENERGY && rec.len >= ENERGY_LEN) {
+        n = snprintf(out, size, "[energy] active=%ums idle=%ums sleep=%ums wake=%u/%ums "
+            "charge=%uuAs (%umJ) avg=%uuA",
+            (unsigned)get32(p), (unsigned)get32(p + 4), (unsigned)get32(p + 8), (unsigned)get32(p + 12),
+            (unsigned)get32(p + 16), (unsigned)get32(p + 20), (unsigned)get32(p + 24), (unsigned)get32(p + 28));
+    } else {
+        n = snprintf(out, size, "[tlm] unknown record type=%u len=%u", rec.type, (unsigned)rec.len);
+    }
+    if (n < 0) n = 0;
+    return (size_t)n < size ? n : size - 1;
+}
+
+// ---- ring ----
+
+TelemetryRing::TelemetryRing(uint8_t* storage, uint32_t size)
+    : buf(storage), mask(size - 1), head(0), tail(0) {
+    memset(&counters, 0, sizeof(counters));
+}
+
+bool TelemetryRing::push(uint8_t type, uint8_t level, uint32_t timeMs, const uint8_t* payload, size_t len) {
+    uint8_t frame[TLM_MAX_FRAME];
+    size_t n = tlmEncode(frame, type, level, timeMs, payload, len);
+
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t used = h - tail.load(std::memory_order_acquire);
+    if (used + n > mask + 1) {
+        counters.dropped++;
+        return false;
+    }
+    uint32_t at = h & mask;
+    uint32_t first = n < mask + 1 - at ? n : mask + 1 - at;
+    memcpy(buf + at, frame, first);
+    memcpy(buf, frame + first, n - first);
+    head.store(h + n, std::memory_order_release);
+
+    counters.records++;
+    counters.bytes += n;
+    if (used + n > counters.highWater) counters.highWater = used + n;
+    return true;
+}
+
+bool TelemetryRing::text(uint8_t level, uint32_t timeMs, const char* fmt, va_list args) {
+    char line[TLM_MAX_PAYLOAD + 1];
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    if (n < 0) return false;
+    if (n > TLM_MAX_PAYLOAD) n = TLM_MAX_PAYLOAD;
+    return push(TLM_TEXT, level, timeMs, (const uint8_t*)line, n);
+}
+
+size_t TelemetryRing::nextFrame(uint8_t* out) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+    size_t n = 0;
+    while (t != h && n < TLM_MAX_FRAME) {
+        uint8_t b = buf[t & mask];
+        out[n++] = b;
+        t++;
+        if (b == 0) break;
+    }
+    tail.store(t, std::memory_order_release);
+    return n;
+}
+
+uint32_t TelemetryRing::pending() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
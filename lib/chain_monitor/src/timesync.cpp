@@ -0,0 +1,21 @@
+#include "timesync.h"
+#include "config.h"
+#include <sys/time.h>
+#include <time.h>
+
+// Any time before this means SNTP has not answered yet (clock starts at 1970)
+#define MIN_VALID_EPOCH 1700000000
+
+void initTimeSync() {
+    configTime(0, 0, NTP_SERVER_1, NTP_SERVER_2);   // UTC, no DST
+}
+
+bool timeSynced() {
+    return time(nullptr) > MIN_VALID_EPOCH;
+}
+
+uint64_t wallClockMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
@@ -0,0 +1,454 @@
+#!/usr/bin/env python3
+"""Generate typed C++ datum decoders from a CIP-57 blueprint (plutus.json).
+
+For every validator datum in the blueprint this writes a struct per
+constructor type and a decode<Name>Datum() function with two paths:
+
+  - fixed layout: when the datum has the expected lengths, the decoder
+    compares the CBOR header bytes against constexpr templates and copies
+    fields from known offsets;
+  - general walk: otherwise (definite-length lists, multi-byte integers,
+    chunked bytes, ...) it walks the data with PlutusReader.
+
+Usage:
+  tools/gen_datum.py <plutus.json> <name> [--include DIR] [--src DIR] [--check]
+
+  <name>     prefix for types and files: "locker" -> LockerDatum,
+             include/locker_datum.h, src/locker_datum.cpp
+  --check    exit 1 if the generated files are out of date
+
+As a PlatformIO pre-script it regenerates from the project options
+custom_datum_blueprint and custom_datum_name before every build, and only
+rewrites files whose content changed. custom_datum_include and
+custom_datum_src (relative to the project) place the output somewhere other
+than the project's include/ and src/, e.g. in this library.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+# "bytes" schemas carry no length; these well-known ones have one
+KNOWN_BYTES = {
+    "VerificationKeyHash": 28,
+    "ScriptHash": 28,
+    "PolicyId": 28,
+    "StakePoolId": 28,
+    "DataHash": 32,
+    "TransactionId": 32,
+    "Hash<Blake2b_224>": 28,
+    "Hash<Blake2b_256>": 32,
+}
+MAX_BYTES = 64      # storage for byte fields of unknown length
+MAX_ITEMS = 8       # storage for list fields
+
+
+class BlueprintError(Exception):
+    pass
+
+
+def camel(name, upper=False):
+    parts = [p for p in re.split(r"[^0-9A-Za-z]+", name) if p]
+    out = "".join(p[:1].upper() + p[1:] for p in parts)
+    if not upper and out:
+        out = out[0].lower() + out[1:]
+    return out or "value"
+
+
+def macro(name):
+    return re.sub(r"(?<=[a-z0-9])(?=[A-Z])", "_", name).upper()
+
+
+class Generator:
+    def __init__(self, blueprint, name):
+        self.bp = blueprint
+        self.prefix = camel(name, upper=True)
+        self.defs = blueprint.get("definitions", {})
+        self.structs = []           # (c name, definition key, schema), dependency order
+        self.seen = {}              # definition key -> c name
+
+    def resolve(self, schema):
+        while "$ref" in schema:
+            key = schema["$ref"].split("#/definitions/")[-1].replace("~1", "/").replace("~0", "~")
+            if key not in self.defs:
+                raise BlueprintError("unknown definition " + key)
+            schema = dict(self.defs[key], _key=key)
+        return schema
+
+    def variants(self, schema):
+        if schema.get("dataType") == "constructor":
+            return [schema]
+        return schema.get("anyOf")
+
+    # ---- C types ----
+
+    def byte_len(self, schema):
+        if schema.get("minLength") is not None and schema.get("minLength") == schema.get("maxLength"):
+            return schema["minLength"]
+        return KNOWN_BYTES.get(schema.get("title"))
+
+    def struct_name(self, schema):
+        key = schema.get("_key") or schema.get("title")
+        if key in self.seen:
+            return self.seen[key]
+        title = schema.get("title") or key.split("/")[-1]
+        cname = self.prefix + camel(title, upper=True)
+        if cname in self.seen.values():
+            cname = self.prefix + camel(key, upper=True)
+        self.seen[key] = cname
+        # Fields first, so structs are emitted after the ones they contain
+        for v in self.variants(schema):
+            for f in v.get("fields", []):
+                self.field_type(self.resolve(f))
+        self.structs.append((cname, key, schema))
+        return cname
+
+    def field_type(self, schema):
+        """(c type, array suffix, comment) for one field"""
+        dt = schema.get("dataType")
+        if dt == "integer":
+            return ("int64_t", "", "")
+        if dt == "bytes":
+            n = self.byte_len(schema)
+            comment = schema.get("title", "")
+            return ("uint8_t", "[%d]" % (n if n is not None else MAX_BYTES), comment)
+        if dt == "list":
+            items = schema.get("items")
+            if not isinstance(items, dict):
+                raise BlueprintError("tuples are not supported")
+            t, suffix, _ = self.field_type(self.resolve(items))
+            if suffix:
+                raise BlueprintError("lists of bytes or lists are not supported")
+            return (t, "[%d]" % MAX_ITEMS, "list")
+        if dt == "map":
+            raise BlueprintError("maps are not supported")
+        vs = self.variants(schema)
+        if vs is None:
+            raise BlueprintError("opaque Data fields are not supported (%s)" % schema.get("title"))
+        if self.is_enum(schema):
+            names = ", ".join("%d %s" % (v["index"], v.get("title", "")) for v in vs)
+            return ("uint32_t", "", "%s (%s)" % (schema.get("title", "constructor"), names))
+        return (self.struct_name(schema), "", "")
+
+    def is_enum(self, schema):
+        """Several constructors, none with fields (Bool, enums)"""
+        vs = self.variants(schema)
+        return vs is not None and len(vs) > 1 and all(not v.get("fields") for v in vs)
+
+    # ---- fixed layout ----
+
+    def constr_header(self, index):
+        if index < 7:
+            return [0xd8, 121 + index]
+        if index < 128:
+            tag = 1280 + index - 7
+            return [0xd9, tag >> 8, tag & 0xff]
+        return None
+
+    def layout(self, schema, path):
+        """Byte template of the common encoding: list of ('lit', [bytes]),
+        ('copy', path, n) and ('int', path); None if the size varies."""
+        dt = schema.get("dataType")
+        if dt == "integer":
+            return [("int", path)]
+        if dt == "bytes":
+            n = self.byte_len(schema)
+            if n is None or n > 64:
+                return None
+            head = [0x40 + n] if n < 24 else [0x58, n]
+            return [("lit", head)] + ([("copy", path, n)] if n else [])
+        vs = self.variants(schema)
+        if dt in ("list", "map") or vs is None or len(vs) != 1:
+            return None
+        v = vs[0]
+        head = self.constr_header(v["index"])
+        if head is None:
+            return None
+        fields = v.get("fields", [])
+        if not fields:
+            return [("lit", head + [0x80])]
+        ops = [("lit", head + [0x9f])]
+        for f in fields:
+            sub = self.layout(self.resolve(f), path + [camel(f.get("title", "value"))])
+            if sub is None:
+                return None
+            ops += sub
+        ops.append(("lit", [0xff]))
+        return ops
+
+    # ---- emitters ----
+
+    def emit_struct(self, cname, key, schema):
+        out = ["// %s" % key]
+        vs = self.variants(schema)
+        if len(vs) == 1:
+            out.append("struct %s {" % cname)
+            out += self.emit_fields(vs[0].get("fields", []), "    ")
+            if not vs[0].get("fields"):
+                out.append("    uint8_t unused;")
+            out.append("};")
+            return out
+        out.append("struct %s {" % cname)
+        out.append("    uint32_t constructor;")
+        for v in vs:
+            if not v.get("fields"):
+                continue
+            out.append("    struct {")
+            out += self.emit_fields(v["fields"], "        ")
+            out.append("    } %s;" % camel(v.get("title", "variant%d" % v["index"])))
+        out.append("};")
+        consts = ["#define %s_%s %d" % (macro(cname), macro(camel(v.get("title", "v%d" % v["index"]), True)), v["index"])
+                  for v in vs]
+        return out + consts
+
+    def emit_fields(self, fields, indent):
+        lines = []
+        for f in fields:
+            name = camel(f.get("title", "value"))
+            t, suffix, comment = self.field_type(self.resolve(f))
+            decl = "%s%s %s%s;" % (indent, t, name, suffix)
+            if comment:
+                decl = decl.ljust(36) + "// " + comment
+            lines.append(decl)
+            schema = self.resolve(f)
+            if schema.get("dataType") == "list" or (schema.get("dataType") == "bytes" and self.byte_len(schema) is None):
+                lines.append("%ssize_t %sLen;" % (indent, name))
+        return lines
+
+    def read_field(self, schema, target, label, indent):
+        """Lines that read one value into `target` (an lvalue)"""
+        dt = schema.get("dataType")
+        if dt == "integer":
+            return ["%sif (!r.integer(&%s)) return false;" % (indent, target)]
+        if dt == "bytes":
+            n = self.byte_len(schema)
+            if n is not None:
+                return ["%sif (!r.bytes(%s, %d)) return false;" % (indent, target, n)]
+            return ["%sif (!r.bytesUpTo(%s, %d, &%sLen)) return false;" % (indent, target, MAX_BYTES, target)]
+        if dt == "list":
+            item = self.resolve(schema["items"])
+            return [
+                "%sif (!r.beginList()) return false;" % indent,
+                "%s%sLen = 0;" % (indent, target),
+                "%swhile (r.more()) {" % indent,
+                "%s    if (%sLen == %d) return r.fail(\"%s: too many items\");" % (indent, target, MAX_ITEMS, label),
+            ] + self.read_field(item, "%s[%sLen]" % (target, target), label, indent + "    ") + [
+                "%s    %sLen++;" % (indent, target),
+                "%s}" % indent,
+                "%sif (!r.endList()) return false;" % indent,
+            ]
+        t, _, _ = self.field_type(schema)
+        if self.is_enum(schema):
+            return [
+                "%sif (!r.constr(&%s) || !r.beginList() || !r.endList()) return false;" % (indent, target),
+                "%sif (%s >= %d) return r.fail(\"%s: unknown constructor\");" % (indent, target, len(self.variants(schema)), label),
+            ]
+        return ["%sif (!walk%s(r, &%s)) return false;" % (indent, t, target)]
+
+    def emit_walk(self, cname, schema):
+        title = schema.get("title", cname)
+        out = ["static bool walk%s(PlutusReader& r, %s* out) {" % (cname, cname)]
+        vs = self.variants(schema)
+        if len(vs) == 1:
+            v = vs[0]
+            out += [
+                "    uint32_t index;",
+                "    if (!r.constr(&index)) return false;",
+                "    if (index != %d) return r.fail(\"%s: unexpected constructor\");" % (v["index"], title),
+                "    if (!r.beginList()) return false;",
+            ]
+            for f in v.get("fields", []):
+                out += self.read_field(self.resolve(f), "out->" + camel(f.get("title", "value")),
+                                       "%s.%s" % (title, f.get("title", "value")), "    ")
+            out += ["    return r.endList();", "}"]
+            return out
+        out += [
+            "    if (!r.constr(&out->constructor) || !r.beginList()) return false;",
+            "    switch (out->constructor) {",
+        ]
+        for v in vs:
+            out.append("    case %d:" % v["index"])
+            member = camel(v.get("title", "variant%d" % v["index"]))
+            for f in v.get("fields", []):
+                out += self.read_field(self.resolve(f), "out->%s.%s" % (member, camel(f.get("title", "value"))),
+                                       "%s.%s" % (title, f.get("title", "value")), "        ")
+            out.append("        break;")
+        out += [
+            "    default:",
+            "        return r.fail(\"%s: unknown constructor\");" % title,
+            "    }",
+            "    return r.endList();",
+            "}",
+        ]
+        return out
+
+    def emit_fixed(self, cname, ops):
+        """Fast path: compare literal runs, copy fields at constant offsets"""
+        merged = []
+        for op in ops:
+            if op[0] == "lit" and merged and merged[-1][0] == "lit":
+                merged[-1] = ("lit", merged[-1][1] + op[1])
+            else:
+                merged.append(op)
+        lits, body = [], []
+        offset = 0
+        template = []
+        for op in merged:
+            if op[0] == "lit":
+                data = op[1]
+                template.append(" ".join("%02x" % b for b in data))
+                if len(data) == 1:
+                    body.append("    if (p[%d] != 0x%02x) return false;" % (offset, data[0]))
+                else:
+                    lit = "%sHead%d" % (camel(cname), len(lits))
+                    lits.append("static constexpr uint8_t %s[] = {%s};" % (lit, ", ".join("0x%02x" % b for b in data)))
+                    body.append("    if (memcmp(p + %d, %s, sizeof(%s)) != 0) return false;" % (offset, lit, lit))
+                offset += len(data)
+            elif op[0] == "copy":
+                template.append("<%s:%d>" % (".".join(op[1]), op[2]))
+                body.append("    memcpy(out->%s, p + %d, %d);" % (".".join(op[1]), offset, op[2]))
+                offset += op[2]
+            else:
+                template.append("<%s:int>" % ".".join(op[1]))
+                body.append("    if (!plutusTinyInt(p[%d], &out->%s)) return false;" % (offset, ".".join(op[1])))
+                offset += 1
+        fixed_len = "%s_FIXED_LEN" % macro(cname)
+        out = ["// %s" % " ".join(template)]
+        out += lits
+        out += ["static_assert(%s == %d, \"fixed layout size\");" % (fixed_len, offset), ""]
+        out += [
+            "static bool fixed%s(const uint8_t* p, size_t len, %s* out) {" % (cname, cname),
+            "    if (len != %s) return false;" % fixed_len,
+        ] + body + ["    return true;", "}"]
+        return out, offset
+
+    def generate(self, name):
+        datums = []
+        for v in self.bp.get("validators", []):
+            d = v.get("datum")
+            if not d or "schema" not in d:
+                continue
+            schema = self.resolve(d["schema"])
+            if self.variants(schema) is None:
+                raise BlueprintError("datum of %s is not a constructor type" % v["title"])
+            key = schema.get("_key")
+            if key not in [k for k, _, _ in datums]:
+                datums.append((key, schema, v["title"]))
+        if not datums:
+            raise BlueprintError("no validator datums in blueprint")
+
+        top = []
+        for key, schema, validator in datums:
+            self.struct_name(schema)
+            top.append((self.seen[key], schema, validator))
+
+        pre = self.bp.get("preamble", {})
+        origin = "%s %s" % (pre.get("title", "blueprint"), pre.get("version", ""))
+        stem = "%s_datum" % name
+        guard = stem.upper() + "_H"
+
+        h = [
+            "#ifndef " + guard,
+            "#define " + guard,
+            "",
+            "// Generated by tools/gen_datum.py from plutus.json (%s). Do not edit." % origin.strip(),
+            "",
+            "#include \"plutus_data.h\"",
+            "",
+        ]
+        for cname, key, schema in self.structs:
+            h += self.emit_struct(cname, key, schema) + [""]
+
+        c = [
+            "// Generated by tools/gen_datum.py from plutus.json (%s). Do not edit." % origin.strip(),
+            "",
+            "#include \"%s.h\"" % stem,
+            "#include <string.h>",
+            "",
+        ]
+        for cname, key, schema in self.structs:
+            c += self.emit_walk(cname, schema) + [""]
+
+        for cname, schema, validator in top:
+            ops = self.layout(schema, [])
+            if ops is not None:
+                fixed, size = self.emit_fixed(cname, ops)
+                h.append("// Encoded size of %s when every field has its expected length" % cname)
+                h.append("#define %s_FIXED_LEN %d" % (macro(cname), size))
+                h.append("")
+                c += fixed + [""]
+            h += [
+                "// Datum of %s. Sets `error` when PLUTUS_FAILED is returned." % validator,
+                "PlutusPath decode%s(const uint8_t* data, size_t len, %s* out, const char** error);" % (cname, cname),
+                "",
+            ]
+            c += ["PlutusPath decode%s(const uint8_t* data, size_t len, %s* out, const char** error) {" % (cname, cname)]
+            if ops is not None:
+                c.append("    if (fixed%s(data, len, out)) return PLUTUS_FIXED;" % cname)
+            c += [
+                "    PlutusReader r(data, len);",
+                "    if (walk%s(r, out) && (r.done() || r.fail(\"Trailing bytes after datum\"))) return PLUTUS_WALK;" % cname,
+                "    *error = r.error();",
+                "    return PLUTUS_FAILED;",
+                "}",
+                "",
+            ]
+        h.append("#endif")
+        return {stem + ".h": "\n".join(h) + "\n", stem + ".cpp": "\n".join(c).rstrip("\n") + "\n"}
+
+
+def write_outputs(files, include_dir, src_dir, check):
+    stale = []
+    for fname, text in files.items():
+        path = os.path.join(include_dir if fname.endswith(".h") else src_dir, fname)
+        old = open(path).read() if os.path.exists(path) else None
+        if old == text:
+            continue
+        stale.append(path)
+        if not check:
+            with open(path, "w") as f:
+                f.write(text)
+    return stale
+
+
+def run(blueprint_path, name, include_dir, src_dir, check=False):
+    with open(blueprint_path) as f:
+        blueprint = json.load(f)
+    files = Generator(blueprint, name).generate(name)
+    return write_outputs(files, include_dir, src_dir, check)
+
+
+def main(argv):
+    ap = argparse.ArgumentParser(description="Generate datum decoders from a CIP-57 blueprint")
+    ap.add_argument("blueprint")
+    ap.add_argument("name")
+    ap.add_argument("--include", default="include")
+    ap.add_argument("--src", default="src")
+    ap.add_argument("--check", action="store_true")
+    args = ap.parse_args(argv)
+    try:
+        stale = run(args.blueprint, args.name, args.include, args.src, args.check)
+    except BlueprintError as e:
+        print("gen_datum: %s" % e, file=sys.stderr)
+        return 1
+    for path in stale:
+        print("%s %s" % ("stale" if args.check else "wrote", path))
+    return 1 if args.check and stale else 0
+
+
+try:
+    Import("env")   # noqa: F821 -- defined when run as a PlatformIO extra script
+except NameError:
+    env = None
+
+if env is not None:
+    project = env["PROJECT_DIR"]
+    blueprint = os.path.join(project, env.GetProjectOption("custom_datum_blueprint"))
+    include = os.path.join(project, env.GetProjectOption("custom_datum_include", env["PROJECT_INCLUDE_DIR"]))
+    src = os.path.join(project, env.GetProjectOption("custom_datum_src", env["PROJECT_SRC_DIR"]))
+    for path in run(blueprint, env.GetProjectOption("custom_datum_name"), include, src):
+        print("gen_datum: wrote " + path)
+elif __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,240 @@
+// Host benchmark: one poll through Monitor<> vs the hand-written loop the
+// two firmwares had before sharing it.
+//
+// Both run the same poll over the same canned Blockfrost result: the
+// locker datum is decoded for real (parseDatum -> the generated decoder),
+// every 16th poll brings a new tx hash (latency recorded and logged), and
+// the fetch and the logger are out-of-line stubs, as they sit in other
+// translation units on the device. Outputs are checked to match before
+// timing.
+//
+// Build (from lib/chain_monitor/, String from the fleet simulator's shim,
+// ArduinoJson from `pio pkg install` in iot3-vending-machines/):
+//   S=../../iot3-vending-machines J=$S/.pio/libdeps/seeed_xiao_esp32c3/ArduinoJson/src
+//   g++ -std=gnu++17 -O2 -DARDUINO=10800 -I$S/tools/fleet_sim/shim -I$S/include -Iinclude -I$J
+//     tools/monitor_bench.cpp src/datum_parser.cpp src/locker_datum.cpp src/plutus_data.cpp
+//     src/bech32.cpp src/latency.cpp src/scheduler.cpp -o monitor_bench
+//
+// Usage: ./monitor_bench [polls]    (default 2000000)
+// Code size: nm -C --size-sort monitor_bench | grep -E 'directPoll|monitorPoll'
+
+#include "config.h"
+#include "monitor.h"
+#include "scheduler.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define NOINLINE __attribute__((noinline))
+
+// ---- firmware stubs (logger, clock) ----
+
+static uint32_t logLines;
+static uint32_t statesLogged;
+static uint32_t lockedSeen;
+static uint64_t nowMs = 1760000000000ULL;
+
+NOINLINE void logText(uint8_t, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    va_end(ap);
+    logLines += fmt[0] != 0;
+}
+NOINLINE void logFetch(const FetchStats& stats) { logLines += stats.requests > 0; }
+NOINLINE void logState(const DatumResult& datum, uint8_t) {
+    statesLogged++;
+    lockedSeen += datum.isLocked;
+}
+bool timeSynced() { return true; }
+uint64_t wallClockMs() { return nowMs; }
+unsigned long millis() { return (unsigned long)nowMs; }
+
+// ---- canned fetch ----
+
+static AssetStateResult canned[2];
+static uint32_t fetches;
+
+static String datumHex(uint8_t fill, bool locked) {
+    static const char digits[] = "0123456789abcdef";
+    String hex = "d8799fd8799f";
+    for (int k = 0; k < 2; k++) {
+        hex += "581c";
+        for (int i = 0; i < 28; i++) {
+            uint8_t b = fill + k * 28 + i;
+            hex += digits[b >> 4];
+            hex += digits[b & 15];
+        }
+    }
+    hex += locked ? "ff01ff" : "ff00ff";
+    return hex;
+}
+
+static void initCanned() {
+    for (int i = 0; i < 2; i++) {
+        AssetStateResult& s = canned[i];
+        s.success = true;
+        s.txHash = i ? "9f1c0e8a2b7d4c6e8f0a1b2c3d4e5f60718293a4b5c6d7e8f90a1b2c3d4e5f60"
+                     : "4e2d7c1a9b8f6e5d4c3b2a1908f7e6d5c4b3a2918f7e6d5c4b3a291807f6e5d4";
+        s.blockHeight = 3000000 + i;
+        s.blockTime = (uint32_t)(nowMs / 1000) - 20;
+        s.slot = 71234567 + i;
+        s.inlineDatum = datumHex(0x10, i == 0);
+        s.address = "addr_test1wqag3rt979nep9g2wtdwu8mr4gz6m4kjdpp5zp705km8wys6t2kla";
+        s.stats.requests = 3;
+        s.stats.roundTrips = 2;
+    }
+}
+
+// A new tx every 16 polls, returned by value like fetchAssetState()
+NOINLINE AssetStateResult fakeFetch() {
+    return canned[(fetches++ >> 4) & 1];
+}
+
+// ---- before: the firmware's own poll (iot2 main.cpp) ----
+
+static LatencyTracker directLatency(CHAIN_LATENCY_SLO_MS);
+static String directLastTxHash;
+
+static void trackChainEvent(const AssetStateResult& state) {
+    bool isNew = directLastTxHash.length() > 0 && state.txHash != directLastTxHash;
+    directLastTxHash = state.txHash;
+    if (!isNew) return;
+
+    uint32_t ms;
+    if (!sinceBlock(state.blockTime, &ms)) {
+        LOG_WARN("[latency] clock not synced, event not timed");
+        return;
+    }
+    directLatency.record(ms);
+
+    LatencySummary s = directLatency.summary();
+    LOG_INFO("[latency] slot=%u block->detect=%ums%s p50=%u p95=%u p99=%u breaches=%u",
+        state.slot, ms, ms > CHAIN_LATENCY_SLO_MS ? " SLO BREACH" : "",
+        s.p50, s.p95, s.p99, directLatency.breaches());
+}
+
+NOINLINE void directPoll() {
+    AssetStateResult state = fakeFetch();
+
+    if (!state.success) {
+        LOG_WARN("Asset state error: %s", state.error.c_str());
+        return;
+    }
+
+    logFetch(state.stats);
+
+    trackChainEvent(state);
+    DatumResult datum = parseDatum(state.inlineDatum, 0);
+
+    if (datum.success) {
+        logState(datum, 0);
+    } else {
+        LOG_WARN("Datum error: %s", datum.error.c_str());
+    }
+}
+
+// ---- after: Monitor<> with the same parts ----
+
+struct CannedTransport {
+    AssetStateResult fetch() { return fakeFetch(); }
+    uint32_t dnsRefreshInMs() { return UINT32_MAX; }
+    void refreshDns() {}
+};
+
+static uint32_t benchClock(void*) { return (uint32_t)nowMs; }
+
+static DeadlineScheduler scheduler(benchClock, nullptr);
+static CannedTransport transport;
+static LockerDecoder decoder = { 0 };
+static LogActuator actuator = { 0 };
+static Monitor<CannedTransport, LockerDecoder, LogActuator, DeadlineScheduler>
+    monitor(transport, decoder, actuator, scheduler, CHAIN_LATENCY_SLO_MS);
+
+NOINLINE void monitorPoll() {
+    monitor.poll();
+}
+
+// ---- driver ----
+
+struct Outcome {
+    uint32_t lines;
+    uint32_t states;
+    uint32_t locked;
+    uint32_t events;
+};
+
+static Outcome run(void (*poll)(), int n, const LatencyTracker& latency) {
+    logLines = statesLogged = lockedSeen = 0;
+    fetches = 0;
+    uint32_t before = latency.total();
+    for (int i = 0; i < n; i++) poll();
+    return { logLines, statesLogged, lockedSeen, latency.total() - before };
+}
+
+struct Timing {
+    double ns;
+    double cycles;
+};
+
+static Timing timePolls(void (*poll)(), int n) {
+    fetches = 0;
+    auto t0 = std::chrono::steady_clock::now();
+#if HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (int i = 0; i < n; i++) poll();
+#if HAVE_TSC
+    uint64_t c1 = __rdtsc();
+#endif
+    auto t1 = std::chrono::steady_clock::now();
+    Timing t;
+    t.ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+#if HAVE_TSC
+    t.cycles = (double)(c1 - c0) / n;
+#else
+    t.cycles = 0;
+#endif
+    return t;
+}
+
+int main(int argc, char** argv) {
+    int polls = argc > 1 ? atoi(argv[1]) : 2000000;
+    if (polls < 64) polls = 64;
+    initCanned();
+
+    Outcome a = run(directPoll, 4096, directLatency);
+    Outcome b = run(monitorPoll, 4096, monitor.detectLatency());
+    if (a.lines != b.lines || a.states != b.states || a.locked != b.locked || a.events != b.events) {
+        fprintf(stderr, "mismatch: direct lines=%u states=%u locked=%u events=%u, "
+            "monitor lines=%u states=%u locked=%u events=%u\n",
+            a.lines, a.states, a.locked, a.events, b.lines, b.states, b.locked, b.events);
+        return 1;
+    }
+    printf("check: %u polls, %u states (%u locked), %u chain events, %u log lines: identical\n",
+        4096, a.states, a.locked, a.events, a.lines);
+
+    // Interleaved rounds, best of each, so frequency changes hit both alike
+    Timing best[2] = { { 1e18, 1e18 }, { 1e18, 1e18 } };
+    void (*polls2[2])() = { directPoll, monitorPoll };
+    for (int round = 0; round < 5; round++) {
+        for (int k = 0; k < 2; k++) {
+            Timing t = timePolls(polls2[k], polls / 5);
+            if (t.ns < best[k].ns) best[k].ns = t.ns;
+            if (t.cycles < best[k].cycles) best[k].cycles = t.cycles;
+        }
+    }
+
+    printf("%-10s %12s %14s\n", "poll", "ns/poll", "cycles/poll");
+    const char* names[2] = { "direct", "Monitor<>" };
+    for (int k = 0; k < 2; k++) {
+        printf("%-10s %12.1f %14.0f\n", names[k], best[k].ns, best[k].cycles);
+    }
+    printf("Monitor<>/direct: %.3f\n", best[1].ns / best[0].ns);
+    return 0;
+}